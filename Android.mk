@@ -16,6 +16,7 @@ INTERMEDIATES := $(call local-intermediates-dir)
 
 LOCAL_SRC_FILES := \
     googleurl/src/gurl.cc \
+    googleurl/src/gurl_view.cc \
     googleurl/src/url_canon_etc.cc \
     googleurl/src/url_canon_fileurl.cc \
     googleurl/src/url_canon_host.cc \
@@ -41,7 +42,9 @@ LOCAL_SRC_FILES := \
     android/net/android_network_library_impl.cc \
     android/ui/base/l10n/l10n_util.cc \
     \
+    app/sql/async_connection.cc \
     app/sql/connection.cc \
+    app/sql/deferred_committer.cc \
     app/sql/meta_table.cc \
     app/sql/statement.cc \
     app/sql/transaction.cc \
@@ -54,6 +57,7 @@ endif
 LOCAL_SRC_FILES += \
     base/at_exit.cc \
     base/base64.cc \
+    base/cpu.cc \
     base/environment.cc \
     base/file_descriptor_shuffle.cc \
     base/file_path.cc \
@@ -66,10 +70,12 @@ LOCAL_SRC_FILES += \
     base/message_loop_proxy_impl.cc \
     base/message_pump.cc \
     base/message_pump_default.cc \
+    base/message_pump_epoll.cc \
     base/message_pump_libevent.cc \
     base/md5.cc \
     base/native_library_linux.cc \
     base/pickle.cc \
+    base/pickled_value_serializer.cc \
     base/platform_file.cc \
     base/platform_file_posix.cc \
     base/process_posix.cc \
@@ -80,11 +86,13 @@ LOCAL_SRC_FILES += \
     base/rand_util_posix.cc \
     base/safe_strerror_posix.cc \
     base/sha1_portable.cc \
+    base/sha_simd.cc \
     base/shared_memory_posix.cc \
     base/string_number_conversions.cc \
     base/string_piece.cc \
     base/string_split.cc \
     base/string_util.cc \
+    base/string_util_simd.cc \
     base/string16.cc \
     base/stringprintf.cc \
     base/sys_info_linux.cc \
@@ -94,6 +102,7 @@ LOCAL_SRC_FILES += \
     base/time.cc \
     base/time_posix.cc \
     base/timer.cc \
+    base/timer_wheel.cc \
     base/tracked.cc \
     base/tracked_objects.cc \
     base/utf_offset_string_conversions.cc \
@@ -105,12 +114,15 @@ LOCAL_SRC_FILES += \
     base/debug/debugger_posix.cc \
     base/debug/stack_trace.cc \
     base/debug/stack_trace_posix.cc \
+    base/debug/trace_recorder.cc \
     \
     base/i18n/file_util_icu.cc \
     base/i18n/icu_string_conversions.cc \
     base/i18n/time_formatting.cc \
     \
+    base/json/json_arena.cc \
     base/json/json_reader.cc \
+    base/json/json_stream_parser.cc \
     base/json/json_writer.cc \
     base/json/string_escape.cc \
     \
@@ -176,6 +188,7 @@ LOCAL_SRC_FILES += \
     net/base/host_resolver.cc \
     net/base/host_resolver_impl.cc \
     net/base/host_resolver_proc.cc \
+    net/base/interned_url.cc \
     net/base/io_buffer.cc \
     net/base/ip_endpoint.cc \
     net/base/mime_util.cc \
@@ -193,6 +206,7 @@ LOCAL_SRC_FILES += \
     net/base/pem_tokenizer.cc \
     net/base/platform_mime_util_android.cc \
     net/base/registry_controlled_domain.cc \
+    net/base/sdch_dictionary_disk_store.cc \
     net/base/sdch_manager.cc \
     net/base/sdch_filter.cc \
     net/base/ssl_cert_request_info.cc \
@@ -482,6 +496,12 @@ $(GEN):
 LOCAL_GENERATED_SOURCES += $(GEN)
 
 LOCAL_CFLAGS := -DHAVE_CONFIG_H -DANDROID -DEXPAT_RELATIVE_PATH -DALLOW_QUOTED_COOKIE_VALUES -DCOMPONENT_BUILD -DGURL_DLL
+
+# MessageLoopForIO uses libevent unless the board opts in to the epoll pump
+# with CHROMIUM_USE_EPOLL_MESSAGE_PUMP := true.
+ifeq ($(CHROMIUM_USE_EPOLL_MESSAGE_PUMP),true)
+LOCAL_CFLAGS += -DUSE_EPOLL_MESSAGE_PUMP
+endif
 LOCAL_CPPFLAGS := -Wno-sign-promo -Wno-missing-field-initializers -fvisibility-inlines-hidden
 
 # Just a few definitions not provided by bionic.
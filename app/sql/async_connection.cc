@@ -0,0 +1,128 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "app/sql/async_connection.h"
+
+#include "app/sql/connection.h"
+#include "base/logging.h"
+#include "base/message_loop_proxy.h"
+#include "base/metrics/histogram.h"
+#include "base/task.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/time.h"
+
+namespace sql {
+
+// Creates the Connection when the database thread starts, and closes it when
+// the thread stops, after its last task has run.
+class AsyncConnection::DatabaseThread : public base::Thread {
+ public:
+  explicit DatabaseThread(const std::string& name)
+      : base::Thread(name.c_str()) {
+  }
+
+  // CleanUp() is only called by a Stop() made from here.
+  virtual ~DatabaseThread() {
+    Stop();
+  }
+
+  Connection* connection() { return connection_.get(); }
+
+ protected:
+  virtual void Init() {
+    connection_.reset(new Connection);
+  }
+
+  virtual void CleanUp() {
+    connection_.reset();
+  }
+
+ private:
+  scoped_ptr<Connection> connection_;
+
+  DISALLOW_COPY_AND_ASSIGN(DatabaseThread);
+};
+
+// Runs a query on the database thread and posts its reply. Deleting it without
+// running it, when the database thread is gone, deletes both.
+class AsyncConnection::QueryTask : public Task {
+ public:
+  QueryTask(AsyncConnection* connection, QueryCallback* query, Task* reply)
+      : connection_(connection),
+        query_(query),
+        reply_(reply),
+        reply_loop_(base::MessageLoopProxy::CreateForCurrentThread()),
+        post_time_(base::TimeTicks::Now()) {
+  }
+
+  virtual void Run() {
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    connection_->queue_time_->AddTime(start_time - post_time_);
+    Connection* db = connection_->thread_->connection();
+    DCHECK(db);
+    query_->Run(db);
+    connection_->query_time_->AddTime(base::TimeTicks::Now() - start_time);
+    if (reply_.get())
+      reply_loop_->PostTask(FROM_HERE, reply_.release());
+  }
+
+ private:
+  AsyncConnection* connection_;
+  scoped_ptr<QueryCallback> query_;
+  scoped_ptr<Task> reply_;
+  scoped_refptr<base::MessageLoopProxy> reply_loop_;
+  const base::TimeTicks post_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(QueryTask);
+};
+
+AsyncConnection::AsyncConnection(const std::string& name)
+    : name_(name),
+      thread_(new DatabaseThread(name)),
+      queue_time_(base::Histogram::FactoryTimeGet(
+          name + ".QueueTime", base::TimeDelta::FromMilliseconds(1),
+          base::TimeDelta::FromSeconds(10), 50,
+          base::Histogram::kUmaTargetedHistogramFlag)),
+      query_time_(base::Histogram::FactoryTimeGet(
+          name + ".QueryTime", base::TimeDelta::FromMilliseconds(1),
+          base::TimeDelta::FromSeconds(10), 50,
+          base::Histogram::kUmaTargetedHistogramFlag)) {
+}
+
+AsyncConnection::~AsyncConnection() {
+  Shutdown();
+}
+
+bool AsyncConnection::Start() {
+  DCHECK(!db_loop_);
+  if (!thread_->Start())
+    return false;
+  db_loop_ = thread_->message_loop_proxy();
+  return true;
+}
+
+void AsyncConnection::Shutdown() {
+  // Runs the tasks posted before the thread is told to quit, then closes the
+  // Connection, before returning. Queries posted later are deleted unrun.
+  thread_->Stop();
+}
+
+bool AsyncConnection::PostQuery(const tracked_objects::Location& from_here,
+                                QueryCallback* query,
+                                Task* reply) {
+  QueryTask* task = new QueryTask(this, query, reply);
+  if (!db_loop_) {
+    delete task;
+    return false;
+  }
+  // Deletes |task| if the database thread has stopped.
+  return db_loop_->PostTask(from_here, task);
+}
+
+bool AsyncConnection::RunsTasksOnCurrentThread() const {
+  return thread_->thread_id() == base::PlatformThread::CurrentId();
+}
+
+}  // namespace sql
@@ -0,0 +1,109 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef APP_SQL_ASYNC_CONNECTION_H_
+#define APP_SQL_ASYNC_CONNECTION_H_
+#pragma once
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/callback_old.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/task.h"
+
+namespace base {
+class Histogram;
+class MessageLoopProxy;
+}
+
+namespace tracked_objects {
+class Location;
+}
+
+namespace sql {
+
+class Connection;
+
+// Runs all the queries on a Connection on a database thread of its own, so
+// that the threads using it never wait for disk I/O. A query is a callback
+// that is given the Connection on the database thread, followed by an
+// optional reply task that runs on the thread that posted the query.
+//
+// Queries run one at a time, in the order they were posted. Replies to the
+// queries posted from one thread run on that thread in the same order.
+//
+// The Connection is created when the thread starts, and is not open: open and
+// configure it from the first query. It is closed and deleted on the database
+// thread by Shutdown(), after the last query has run, so every query that runs
+// gets one.
+//
+// The time queries wait for the database thread and the time they run are
+// recorded in the histograms <name>.QueueTime and <name>.QueryTime.
+//
+// Usage:
+//   class CountRows : public base::RefCountedThreadSafe<CountRows> {
+//    public:
+//     void Query(sql::Connection* db) { ... count_ = s.ColumnInt(0); }
+//     void Reply() { ... use count_ ... }
+//     ...
+//   };
+//
+//   sql::AsyncConnection db("Sqlite.Foo");
+//   db.Start();
+//   db.PostQuery(FROM_HERE, NewCallback(opener, &Opener::Open), NULL);
+//   scoped_refptr<CountRows> count(new CountRows);
+//   db.PostQuery(FROM_HERE, NewCallback(count.get(), &CountRows::Query),
+//                NewRunnableMethod(count.get(), &CountRows::Reply));
+class AsyncConnection {
+ public:
+  typedef Callback1<Connection*>::Type QueryCallback;
+
+  // |name| names the database thread and the histograms.
+  explicit AsyncConnection(const std::string& name);
+
+  // Calls Shutdown().
+  ~AsyncConnection();
+
+  // Starts the database thread. Returns true on success.
+  bool Start();
+
+  // Runs the queries already posted, closes the Connection and stops the
+  // database thread. Their replies still run later, on the threads that posted
+  // them. It is fine to call more than once.
+  void Shutdown();
+
+  // Runs |query| with the Connection on the database thread, then posts
+  // |reply|, which can be NULL, to the current thread. Takes ownership of
+  // both. Returns false, and deletes them, if the database thread isn't
+  // running.
+  bool PostQuery(const tracked_objects::Location& from_here,
+                 QueryCallback* query,
+                 Task* reply);
+
+  // Returns true when called on the database thread.
+  bool RunsTasksOnCurrentThread() const;
+
+ private:
+  class DatabaseThread;
+  class QueryTask;
+
+  const std::string name_;
+
+  // Owns the Connection, which only it uses.
+  scoped_ptr<DatabaseThread> thread_;
+
+  // Posts to the database thread, from any thread. Set by Start().
+  scoped_refptr<base::MessageLoopProxy> db_loop_;
+
+  base::Histogram* queue_time_;
+  base::Histogram* query_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncConnection);
+};
+
+}  // namespace sql
+
+#endif  // APP_SQL_ASYNC_CONNECTION_H_
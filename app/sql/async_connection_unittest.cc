@@ -0,0 +1,201 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "app/sql/async_connection.h"
+#include "app/sql/connection.h"
+#include "app/sql/statement.h"
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_temp_dir.h"
+#include "base/message_loop.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Writes increasing values to table "foo" and reads them back, from queries
+// on the database thread, and counts the replies.
+class FooQueries : public base::RefCountedThreadSafe<FooQueries> {
+ public:
+  FooQueries(sql::AsyncConnection* async, const FilePath& path)
+      : async_(async),
+        path_(path),
+        next_value_(0),
+        queries_off_thread_(0),
+        queries_without_connection_(0),
+        replies_(0),
+        replies_off_thread_(0),
+        quit_after_replies_(0),
+        reply_thread_(base::PlatformThread::CurrentId()) {
+  }
+
+  void Open(sql::Connection* db) {
+    CheckThread();
+    ASSERT_TRUE(db->Open(path_));
+    ASSERT_TRUE(db->Execute("CREATE TABLE foo (a)"));
+  }
+
+  void Insert(sql::Connection* db) {
+    CheckThread();
+    sql::Statement s(db->GetCachedStatement(SQL_FROM_HERE,
+                                            "INSERT INTO foo (a) VALUES (?)"));
+    s.BindInt(0, next_value_++);
+    ASSERT_TRUE(s.Run());
+  }
+
+  void Read(sql::Connection* db) {
+    CheckThread();
+    sql::Statement s(db->GetUniqueStatement(
+        "SELECT a FROM foo ORDER BY rowid"));
+    while (s.Step())
+      values_.push_back(s.ColumnInt(0));
+  }
+
+  // Only checks that the query was given a Connection.
+  void CheckConnection(sql::Connection* db) {
+    CheckThread();
+    if (!db)
+      ++queries_without_connection_;
+  }
+
+  void Reply() {
+    if (base::PlatformThread::CurrentId() != reply_thread_)
+      ++replies_off_thread_;
+    if (++replies_ == quit_after_replies_)
+      MessageLoop::current()->Quit();
+  }
+
+  void set_quit_after_replies(int replies) { quit_after_replies_ = replies; }
+  const std::vector<int>& values() const { return values_; }
+  int queries_off_thread() const { return queries_off_thread_; }
+  int queries_without_connection() const {
+    return queries_without_connection_;
+  }
+  int replies() const { return replies_; }
+  int replies_off_thread() const { return replies_off_thread_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<FooQueries>;
+
+  ~FooQueries() {}
+
+  void CheckThread() {
+    if (!async_->RunsTasksOnCurrentThread())
+      ++queries_off_thread_;
+  }
+
+  sql::AsyncConnection* async_;
+  const FilePath path_;
+  int next_value_;
+  std::vector<int> values_;
+  int queries_off_thread_;
+  int queries_without_connection_;
+  int replies_;
+  int replies_off_thread_;
+  int quit_after_replies_;
+  base::PlatformThreadId reply_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(FooQueries);
+};
+
+// Posts queries from another thread until |async| refuses them, signalling
+// |posted| after the first one.
+void PostUntilRefused(sql::AsyncConnection* async,
+                      scoped_refptr<FooQueries> queries,
+                      base::WaitableEvent* posted) {
+  while (async->PostQuery(
+      FROM_HERE, NewCallback(queries.get(), &FooQueries::CheckConnection),
+      NULL)) {
+    posted->Signal();
+  }
+  posted->Signal();
+}
+
+class SQLAsyncConnectionTest : public testing::Test {
+ public:
+  SQLAsyncConnectionTest() : async_("SQLAsyncConnectionTest") {}
+
+  void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    queries_ = new FooQueries(
+        &async_, temp_dir_.path().AppendASCII("SQLAsyncConnectionTest.db"));
+  }
+
+ protected:
+  bool PostQuery(void (FooQueries::*query)(sql::Connection*), bool reply) {
+    return async_.PostQuery(
+        FROM_HERE, NewCallback(queries_.get(), query),
+        reply ? NewRunnableMethod(queries_.get(), &FooQueries::Reply) : NULL);
+  }
+
+  MessageLoop message_loop_;
+  ScopedTempDir temp_dir_;
+  sql::AsyncConnection async_;
+  scoped_refptr<FooQueries> queries_;
+};
+
+}  // namespace
+
+TEST_F(SQLAsyncConnectionTest, RunsQueriesInOrder) {
+  const int kInserts = 20;
+  ASSERT_TRUE(async_.Start());
+  EXPECT_FALSE(async_.RunsTasksOnCurrentThread());
+  ASSERT_TRUE(PostQuery(&FooQueries::Open, true));
+  for (int i = 0; i < kInserts; ++i)
+    ASSERT_TRUE(PostQuery(&FooQueries::Insert, i % 2 == 0));
+  ASSERT_TRUE(PostQuery(&FooQueries::Read, true));
+  queries_->set_quit_after_replies(kInserts / 2 + 2);
+  MessageLoop::current()->Run();
+
+  ASSERT_EQ(static_cast<size_t>(kInserts), queries_->values().size());
+  for (int i = 0; i < kInserts; ++i)
+    EXPECT_EQ(i, queries_->values()[i]);
+  EXPECT_EQ(0, queries_->queries_off_thread());
+  EXPECT_EQ(kInserts / 2 + 2, queries_->replies());
+  EXPECT_EQ(0, queries_->replies_off_thread());
+}
+
+// Shutdown() runs the queries already posted, and later ones are refused.
+TEST_F(SQLAsyncConnectionTest, Shutdown) {
+  EXPECT_FALSE(PostQuery(&FooQueries::Open, false));
+  ASSERT_TRUE(async_.Start());
+  ASSERT_TRUE(PostQuery(&FooQueries::Open, false));
+  ASSERT_TRUE(PostQuery(&FooQueries::Insert, true));
+  async_.Shutdown();
+  EXPECT_FALSE(PostQuery(&FooQueries::Insert, false));
+  async_.Shutdown();
+
+  sql::Connection db;
+  ASSERT_TRUE(db.Open(
+      temp_dir_.path().AppendASCII("SQLAsyncConnectionTest.db")));
+  sql::Statement s(db.GetUniqueStatement("SELECT COUNT(*) FROM foo"));
+  ASSERT_TRUE(s.Step());
+  EXPECT_EQ(1, s.ColumnInt(0));
+
+  // The reply of the insert is still delivered to this thread.
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(1, queries_->replies());
+}
+
+// Queries posted from another thread while Shutdown() is closing the database
+// thread either run with a Connection or are refused.
+TEST_F(SQLAsyncConnectionTest, ShutdownWhilePosting) {
+  ASSERT_TRUE(async_.Start());
+  base::Thread poster("SQLAsyncConnectionTestPoster");
+  ASSERT_TRUE(poster.Start());
+  base::WaitableEvent posted(false, false);
+  poster.message_loop()->PostTask(FROM_HERE, NewRunnableFunction(
+      &PostUntilRefused, &async_, queries_, &posted));
+  posted.Wait();
+  async_.Shutdown();
+  poster.Stop();
+
+  EXPECT_EQ(0, queries_->queries_off_thread());
+  EXPECT_EQ(0, queries_->queries_without_connection());
+}
@@ -8,6 +8,7 @@
 
 #include "app/sql/statement.h"
 #include "base/file_path.h"
+#include "base/format_macros.h"
 #include "base/logging.h"
 #include "base/string_util.h"
 #include "base/utf_string_conversions.h"
@@ -90,6 +91,8 @@ Connection::Connection()
       page_size_(0),
       cache_size_(0),
       exclusive_locking_(false),
+      write_ahead_logging_(false),
+      mmap_size_(0),
       transaction_nesting_(0),
       needs_rollback_(false) {
 }
@@ -379,6 +382,30 @@ bool Connection::OpenInternal(const std::string& file_name) {
       NOTREACHED() << "Could not set cache size: " << GetErrorMessage();
   }
 
+  if (mmap_size_ != 0) {
+    const std::string sql = StringPrintf("PRAGMA mmap_size=%" PRId64,
+                                         mmap_size_);
+    if (!ExecuteWithTimeout(sql.c_str(), kBusyTimeout))
+      NOTREACHED() << "Could not set mmap size: " << GetErrorMessage();
+  }
+
+  // This comes after the page size, which can't change once the database is
+  // in write-ahead logging mode.
+  if (write_ahead_logging_) {
+    ScopedBusyTimeout busy_timeout(db_);
+    busy_timeout.SetTimeout(kBusyTimeout);
+    // The pragma returns the resulting mode, which stays "memory" for
+    // in-memory databases.
+    Statement journal_mode(GetUniqueStatement("PRAGMA journal_mode=WAL"));
+    if (!journal_mode || !journal_mode.Step()) {
+      NOTREACHED() << "Could not set journal mode: " << GetErrorMessage();
+    } else if (journal_mode.ColumnString(0) == "wal") {
+      journal_mode.Reset();
+      if (!Execute("PRAGMA synchronous=NORMAL"))
+        NOTREACHED() << "Could not set synchronous: " << GetErrorMessage();
+    }
+  }
+
   return true;
 }
 
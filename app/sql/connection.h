@@ -137,6 +137,22 @@ class Connection {
   // This must be called before Open() to have an effect.
   void set_exclusive_locking() { exclusive_locking_ = true; }
 
+  // Puts the database in write-ahead logging mode. Commits then append to a
+  // log instead of writing pages twice through a rollback journal, and the
+  // log is only synced to disk when it is checkpointed into the database
+  // (synchronous=NORMAL). A power failure may lose the last commits, but
+  // doesn't corrupt the database. The mode is persistent: the database keeps
+  // it when opened again, and needs sqlite 3.7.0 or later to be read.
+  //
+  // This must be called before Open() to have an effect. It has none on
+  // in-memory databases.
+  void set_write_ahead_logging() { write_ahead_logging_ = true; }
+
+  // Sets how many bytes of the database file sqlite may read through a memory
+  // mapping rather than read() calls. Versions of sqlite before 3.7.17 ignore
+  // it. This must be called before Open() to have an effect.
+  void set_mmap_size(int64 mmap_size) { mmap_size_ = mmap_size; }
+
   // Sets the object that will handle errors. Recomended that it should be set
   // before calling Open(). If not set, the default is to ignore errors on
   // release and assert on debug builds.
@@ -354,6 +370,8 @@ class Connection {
   int page_size_;
   int cache_size_;
   bool exclusive_locking_;
+  bool write_ahead_logging_;
+  int64 mmap_size_;
 
   // All cached statements. Keeping a reference to these statements means that
   // they'll remain active.
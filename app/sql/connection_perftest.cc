@@ -0,0 +1,121 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "app/sql/connection.h"
+#include "app/sql/deferred_committer.h"
+#include "app/sql/statement.h"
+#include "base/memory/scoped_temp_dir.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kRows = 2000;
+
+enum Options {
+  OPTIONS_DEFAULT = 0,
+  OPTIONS_WRITE_AHEAD_LOGGING = 1 << 0,
+  OPTIONS_MMAP = 1 << 1,
+};
+
+class SQLConnectionPerfTest : public testing::Test {
+ public:
+  void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+ protected:
+  // Opens a new database with |options| and a table "foo" in |db|.
+  void OpenDatabase(const char* name, int options, sql::Connection* db) {
+    db->set_page_size(4096);
+    db->set_cache_size(512);
+    if (options & OPTIONS_WRITE_AHEAD_LOGGING)
+      db->set_write_ahead_logging();
+    if (options & OPTIONS_MMAP)
+      db->set_mmap_size(64 * 1024 * 1024);
+    ASSERT_TRUE(db->Open(temp_dir_.path().AppendASCII(name)));
+    ASSERT_TRUE(db->Execute(
+        "CREATE TABLE foo (id INTEGER PRIMARY KEY, value TEXT)"));
+  }
+
+  // Inserts kRows rows into "foo", each in its own transaction unless
+  // |committer| groups them, and logs the rows inserted per second.
+  void InsertRows(const char* name, sql::Connection* db,
+                  sql::DeferredCommitter* committer) {
+    PerfTimer timer;
+    for (int i = 0; i < kRows; ++i) {
+      if (committer) {
+        ASSERT_TRUE(committer->WillWrite());
+      }
+      sql::Statement s(db->GetCachedStatement(
+          SQL_FROM_HERE, "INSERT INTO foo (id, value) VALUES (?, ?)"));
+      s.BindInt(0, i);
+      s.BindString(1, base::StringPrintf("value %d", i));
+      ASSERT_TRUE(s.Run());
+    }
+    if (committer) {
+      ASSERT_TRUE(committer->Commit());
+    }
+    LogPerfResult(name, kRows / timer.Elapsed().InSecondsF(), "rows/s");
+  }
+
+  // Looks rows of "foo" up by id, and logs the lookups per second.
+  void LookUpRows(const char* name, sql::Connection* db) {
+    const int kLookups = 50000;
+    PerfTimer timer;
+    for (int i = 0; i < kLookups; ++i) {
+      sql::Statement s(db->GetCachedStatement(
+          SQL_FROM_HERE, "SELECT value FROM foo WHERE id=?"));
+      s.BindInt(0, (i * 7919) % kRows);
+      ASSERT_TRUE(s.Step());
+    }
+    LogPerfResult(name, kLookups / timer.Elapsed().InSecondsF(), "lookups/s");
+  }
+
+  ScopedTempDir temp_dir_;
+};
+
+}  // namespace
+
+TEST_F(SQLConnectionPerfTest, Insert) {
+  const base::TimeDelta kCommitDelay = base::TimeDelta::FromSeconds(10);
+  {
+    sql::Connection db;
+    OpenDatabase("rollback.db", OPTIONS_DEFAULT, &db);
+    InsertRows("SQL_Insert_rollback_journal", &db, NULL);
+  }
+  {
+    sql::Connection db;
+    OpenDatabase("wal.db", OPTIONS_WRITE_AHEAD_LOGGING, &db);
+    InsertRows("SQL_Insert_wal", &db, NULL);
+  }
+  {
+    sql::Connection db;
+    OpenDatabase("deferred.db", OPTIONS_DEFAULT, &db);
+    sql::DeferredCommitter committer(&db, kCommitDelay, 100);
+    InsertRows("SQL_Insert_rollback_journal_deferred", &db, &committer);
+  }
+  {
+    sql::Connection db;
+    OpenDatabase("wal_deferred.db", OPTIONS_WRITE_AHEAD_LOGGING, &db);
+    sql::DeferredCommitter committer(&db, kCommitDelay, 100);
+    InsertRows("SQL_Insert_wal_deferred", &db, &committer);
+  }
+}
+
+TEST_F(SQLConnectionPerfTest, LookUp) {
+  const int kOptions[] = { OPTIONS_DEFAULT, OPTIONS_MMAP };
+  const char* const kNames[] = { "SQL_LookUp", "SQL_LookUp_mmap" };
+  for (size_t i = 0; i < arraysize(kOptions); ++i) {
+    sql::Connection db;
+    OpenDatabase(kNames[i], kOptions[i], &db);
+    sql::DeferredCommitter committer(&db, base::TimeDelta::FromSeconds(10),
+                                     kRows);
+    InsertRows(base::StringPrintf("%s_setup", kNames[i]).c_str(), &db,
+               &committer);
+    LookUpRows(kNames[i], &db);
+  }
+}
@@ -104,3 +104,33 @@ TEST_F(SQLConnectionTest, GetLastInsertRowId) {
   EXPECT_EQ(12, s.ColumnInt(0));
 }
 
+
+TEST(SQLConnectionOptionsTest, WriteAheadLogging) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath path = temp_dir.path().AppendASCII("SQLConnectionTest.db");
+  {
+    sql::Connection db;
+    db.set_page_size(4096);
+    db.set_cache_size(64);
+    db.set_mmap_size(1024 * 1024);
+    db.set_write_ahead_logging();
+    ASSERT_TRUE(db.Open(path));
+    ASSERT_TRUE(db.Execute("CREATE TABLE foo (a, b)"));
+    ASSERT_TRUE(db.Execute("INSERT INTO foo(a, b) VALUES (12, 13)"));
+
+    sql::Statement s(db.GetUniqueStatement("PRAGMA journal_mode"));
+    ASSERT_TRUE(s.Step());
+    EXPECT_EQ("wal", s.ColumnString(0));
+  }
+
+  // The mode is kept by the database.
+  sql::Connection db;
+  ASSERT_TRUE(db.Open(path));
+  sql::Statement s(db.GetUniqueStatement("PRAGMA journal_mode"));
+  ASSERT_TRUE(s.Step());
+  EXPECT_EQ("wal", s.ColumnString(0));
+  sql::Statement count(db.GetUniqueStatement("SELECT count(*) FROM foo"));
+  ASSERT_TRUE(count.Step());
+  EXPECT_EQ(1, count.ColumnInt(0));
+}
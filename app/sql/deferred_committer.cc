@@ -0,0 +1,57 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "app/sql/deferred_committer.h"
+
+#include "app/sql/connection.h"
+#include "base/logging.h"
+#include "base/message_loop.h"
+
+namespace sql {
+
+DeferredCommitter::DeferredCommitter(Connection* connection,
+                                     base::TimeDelta commit_delay,
+                                     int max_writes)
+    : connection_(connection),
+      commit_delay_(commit_delay),
+      max_writes_(max_writes),
+      in_transaction_(false),
+      writes_(0) {
+  DCHECK_GT(max_writes, 0);
+}
+
+DeferredCommitter::~DeferredCommitter() {
+  Commit();
+}
+
+bool DeferredCommitter::WillWrite() {
+  if (in_transaction_ && writes_ >= max_writes_)
+    Commit();
+
+  if (!in_transaction_) {
+    if (!connection_->BeginTransaction())
+      return false;
+    in_transaction_ = true;
+    writes_ = 0;
+    if (MessageLoop::current())
+      commit_timer_.Start(commit_delay_, this,
+                          &DeferredCommitter::OnCommitTimer);
+  }
+  ++writes_;
+  return true;
+}
+
+bool DeferredCommitter::Commit() {
+  commit_timer_.Stop();
+  if (!in_transaction_)
+    return true;
+  in_transaction_ = false;
+  return connection_->CommitTransaction();
+}
+
+void DeferredCommitter::OnCommitTimer() {
+  Commit();
+}
+
+}  // namespace sql
@@ -0,0 +1,78 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef APP_SQL_DEFERRED_COMMITTER_H_
+#define APP_SQL_DEFERRED_COMMITTER_H_
+#pragma once
+
+#include "base/basictypes.h"
+#include "base/time.h"
+#include "base/timer.h"
+
+namespace sql {
+
+class Connection;
+
+// Groups many small writes into a few transactions, so that the database is
+// synced to disk once per group rather than once per write. The first write
+// opens a transaction, which is committed |commit_delay| later, or at the next
+// write once |max_writes| writes have been made in it.
+//
+// Usage:
+//   sql::DeferredCommitter committer(&db, base::TimeDelta::FromSeconds(10),
+//                                    100);
+//   ...
+//   committer.WillWrite();
+//   sql::Statement s(db.GetCachedStatement(SQL_FROM_HERE, "INSERT ..."));
+//   ...
+//
+// Writes made within one group are only durable once the group is committed,
+// and a nested transaction rolled back in it rolls the whole group back. The
+// delayed commit runs on the current thread's MessageLoop; without one, the
+// group is committed only after |max_writes| writes, by Commit(), or on
+// destruction.
+class DeferredCommitter {
+ public:
+  DeferredCommitter(Connection* connection,
+                    base::TimeDelta commit_delay,
+                    int max_writes);
+
+  // Commits the pending writes.
+  ~DeferredCommitter();
+
+  // Call before each write. Opens a transaction if none is pending, after
+  // committing the current one if it has reached |max_writes| writes. Returns
+  // false if no transaction could be opened, in which case the write is made
+  // on its own.
+  bool WillWrite();
+
+  // Commits the pending writes now, returning false if the commit failed. It
+  // is fine to call when nothing is pending.
+  bool Commit();
+
+  // Returns true when writes are waiting to be committed.
+  bool has_pending_writes() const { return in_transaction_; }
+
+ private:
+  // Called by |commit_timer_|.
+  void OnCommitTimer();
+
+  Connection* connection_;
+  const base::TimeDelta commit_delay_;
+  const int max_writes_;
+
+  // True when a transaction of ours is open.
+  bool in_transaction_;
+
+  // The writes made in the open transaction.
+  int writes_;
+
+  base::OneShotTimer<DeferredCommitter> commit_timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeferredCommitter);
+};
+
+}  // namespace sql
+
+#endif  // APP_SQL_DEFERRED_COMMITTER_H_
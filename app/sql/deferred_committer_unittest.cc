@@ -0,0 +1,93 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "app/sql/connection.h"
+#include "app/sql/deferred_committer.h"
+#include "app/sql/statement.h"
+#include "base/memory/scoped_temp_dir.h"
+#include "base/message_loop.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+class SQLDeferredCommitterTest : public testing::Test {
+ public:
+  SQLDeferredCommitterTest() {}
+
+  void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    ASSERT_TRUE(db_.Open(
+        temp_dir_.path().AppendASCII("SQLDeferredCommitterTest.db")));
+
+    ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+  }
+
+  void TearDown() {
+    db_.Close();
+  }
+
+  sql::Connection& db() { return db_; }
+
+  void InsertFoo(sql::DeferredCommitter* committer) {
+    EXPECT_TRUE(committer->WillWrite());
+    EXPECT_TRUE(db().Execute("INSERT INTO foo (a, b) VALUES (1, 2)"));
+  }
+
+  // Returns the number of rows in table "foo" seen by another connection, that
+  // is, the committed ones.
+  int CountCommittedFoo() {
+    sql::Connection other;
+    if (!other.Open(temp_dir_.path().AppendASCII(
+            "SQLDeferredCommitterTest.db")))
+      return -1;
+    sql::Statement count(other.GetUniqueStatement("SELECT count(*) FROM foo"));
+    if (!count.Step())
+      return -1;
+    return count.ColumnInt(0);
+  }
+
+ private:
+  ScopedTempDir temp_dir_;
+  sql::Connection db_;
+};
+
+TEST_F(SQLDeferredCommitterTest, MaxWrites) {
+  sql::DeferredCommitter committer(&db(), base::TimeDelta::FromHours(1), 3);
+  EXPECT_FALSE(committer.has_pending_writes());
+  for (int i = 0; i < 3; ++i)
+    InsertFoo(&committer);
+  EXPECT_TRUE(committer.has_pending_writes());
+  EXPECT_EQ(1, db().transaction_nesting());
+
+  // The fourth write commits the first three.
+  InsertFoo(&committer);
+  EXPECT_EQ(3, CountCommittedFoo());
+
+  EXPECT_TRUE(committer.Commit());
+  EXPECT_FALSE(committer.has_pending_writes());
+  EXPECT_EQ(0, db().transaction_nesting());
+  EXPECT_EQ(4, CountCommittedFoo());
+}
+
+TEST_F(SQLDeferredCommitterTest, CommitDelay) {
+  MessageLoop loop;
+  sql::DeferredCommitter committer(&db(), base::TimeDelta::FromMilliseconds(1),
+                                   100);
+  InsertFoo(&committer);
+  InsertFoo(&committer);
+  EXPECT_TRUE(committer.has_pending_writes());
+
+  loop.PostDelayedTask(FROM_HERE, new MessageLoop::QuitTask, 50);
+  loop.Run();
+  EXPECT_FALSE(committer.has_pending_writes());
+  EXPECT_EQ(2, CountCommittedFoo());
+}
+
+TEST_F(SQLDeferredCommitterTest, CommitOnDestruction) {
+  {
+    sql::DeferredCommitter committer(&db(), base::TimeDelta::FromHours(1),
+                                     100);
+    InsertFoo(&committer);
+  }
+  EXPECT_EQ(0, db().transaction_nesting());
+  EXPECT_EQ(1, CountCommittedFoo());
+}
@@ -114,6 +114,7 @@
         'cpu_unittest.cc',
         'debug/leak_tracker_unittest.cc',
         'debug/stack_trace_unittest.cc',
+        'debug/trace_recorder_unittest.cc',
         'debug/trace_event_win_unittest.cc',
         'dir_reader_posix_unittest.cc',
         'environment_unittest.cc',
@@ -128,7 +129,9 @@
         'i18n/file_util_icu_unittest.cc',
         'i18n/icu_string_conversions_unittest.cc',
         'i18n/rtl_unittest.cc',
+        'json/json_arena_unittest.cc',
         'json/json_reader_unittest.cc',
+        'json/json_stream_parser_unittest.cc',
         'json/json_writer_unittest.cc',
         'json/string_escape_unittest.cc',
         'lazy_instance_unittest.cc',
@@ -145,6 +148,7 @@
         'memory/weak_ptr_unittest.cc',
         'message_loop_proxy_impl_unittest.cc',
         'message_loop_unittest.cc',
+        'message_pump_epoll_unittest.cc',
         'message_pump_glib_unittest.cc',
         'metrics/field_trial_unittest.cc',
         'metrics/histogram_unittest.cc',
@@ -152,6 +156,7 @@
         'observer_list_unittest.cc',
         'path_service_unittest.cc',
         'pickle_unittest.cc',
+        'pickled_value_serializer_unittest.cc',
         'platform_file_unittest.cc',
         'pr_time_unittest.cc',
         'process_util_unittest.cc',
@@ -194,6 +199,7 @@
         'time_unittest.cc',
         'time_win_unittest.cc',
         'timer_unittest.cc',
+        'timer_wheel_unittest.cc',
         'tools_sanity_unittest.cc',
         'tracked_objects_unittest.cc',
         'tuple_unittest.cc',
@@ -249,6 +255,11 @@
             'message_pump_glib_unittest.cc',
           ]
         }],
+        ['OS != "linux"', {
+          'sources!': [
+            'message_pump_epoll_unittest.cc',
+          ],
+        }],
         # This is needed to trigger the dll copy step on windows.
         # TODO(mark): This should not be necessary.
         ['OS == "win"', {
@@ -273,6 +284,29 @@
         }],
       ],
     },
+    {
+      'target_name': 'base_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'base',
+        'test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'message_loop_perftest.cc',
+        'message_pump_epoll_perftest.cc',
+        'metrics/histogram_perftest.cc',
+        'string_util_perftest.cc',
+        'utf_string_conversions_perftest.cc',
+      ],
+      'conditions': [
+        ['OS != "linux"', {
+          'sources!': [
+            'message_pump_epoll_perftest.cc',
+          ],
+        }],
+      ],
+    },
     {
       'target_name': 'test_support_base',
       'type': '<(library)',
@@ -4,6 +4,8 @@
 
 #include "base/cpu.h"
 
+#include "build/build_config.h"
+
 #if defined(ARCH_CPU_X86_FAMILY)
 #if defined(_MSC_VER)
 #include <intrin.h>
@@ -28,6 +30,7 @@ CPU::CPU()
     has_ssse3_(false),
     has_sse41_(false),
     has_sse42_(false),
+    has_sha_(false),
     cpu_vendor_("unknown") {
   Initialize();
 }
@@ -117,6 +120,12 @@ void CPU::Initialize() {
     has_sse41_ = (cpu_info[2] & 0x00080000) != 0;
     has_sse42_ = (cpu_info[2] & 0x00100000) != 0;
   }
+
+  // The structured extended feature flags.
+  if (num_ids >= 7) {
+    __cpuidex(cpu_info, 7, 0);
+    has_sha_ = (cpu_info[1] & 0x20000000) != 0;
+  }
 #endif
 }
 
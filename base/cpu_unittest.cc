@@ -86,6 +86,12 @@ TEST(CPU, RunExtendedInstructions) {
     // Execute an SSE 4.2 instruction.
     __asm__ __volatile__("crc32 %%eax, %%eax\n" : : : "eax");
   }
+
+  if (cpu.has_sha()) {
+    // Execute a SHA instruction, sha1msg1 %xmm0, %xmm0, which older
+    // assemblers don't know.
+    __asm__ __volatile__(".byte 0x0f, 0x38, 0xc9, 0xc0\n" : : : "xmm0");
+  }
 #endif
 #endif
 }
@@ -0,0 +1,266 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/debug/trace_recorder.h"
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+#include "base/format_macros.h"
+#include "base/json/string_escape.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/process_util.h"
+#include "base/stl_util-inl.h"
+#include "base/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "base/time.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+// Phases of the trace event format, indexed by TraceRecorder::EventType.
+const char* const kPhases[] = { "B", "E", "I", "C", "S", "F" };
+
+// Creates the recorder with the default size, and leaks it since threads may
+// still be recording at shutdown.
+struct TraceRecorderTraits {
+  static const bool kAllowedToAccessOnNonjoinableThread = true;
+
+  static TraceRecorder* New(void* instance) {
+    return new (instance) TraceRecorder(
+        TraceRecorder::kDefaultEventsPerThread);
+  }
+  static void (*Delete)(void* instance);
+};
+
+void (*TraceRecorderTraits::Delete)(void* instance) = NULL;
+
+LazyInstance<TraceRecorder, TraceRecorderTraits>
+    g_trace_recorder(LINKER_INITIALIZED);
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+}  // namespace
+
+// The ring buffer of one thread.  Only that thread adds events, so adding one
+// needs no lock: the event is written, then the count is published with a
+// release store.  Readers on other threads copy the buffer and then check how
+// many events were added meanwhile, to drop those that were overwritten.
+class TraceRecorder::ThreadBuffer {
+ public:
+  ThreadBuffer(TraceRecorder* recorder, size_t size,
+               PlatformThreadId thread_id)
+      : recorder_(recorder),
+        events_(size),
+        mask_(size - 1),
+        thread_id_(thread_id),
+        count_(0),
+        full_(0) {
+    DCHECK_EQ(0u, size & mask_);
+  }
+
+  void Add(const Event& event) {
+    uint32 count = base::subtle::NoBarrier_Load(&count_);
+    events_[count & mask_] = event;
+    if (count == mask_)
+      base::subtle::NoBarrier_Store(&full_, 1);
+    base::subtle::Release_Store(&count_, count + 1);
+  }
+
+  // Appends the events in the buffer to |events|, oldest first.
+  void Copy(std::vector<Event>* events) const {
+    uint32 end = base::subtle::Acquire_Load(&count_);
+    // The count wraps after 2^32 events, hence |full_| rather than comparing
+    // it with the size.
+    uint32 available = base::subtle::NoBarrier_Load(&full_) ?
+        static_cast<uint32>(events_.size()) : end;
+    size_t first = events->size();
+    for (uint32 i = end - available; i != end; ++i)
+      events->push_back(events_[i & mask_]);
+
+    // Drop the oldest events if this thread overwrote them as they were being
+    // copied.  An Add() may also be writing the slot after the last event it
+    // published, which holds the oldest event once the buffer is full.
+    base::subtle::MemoryBarrier();
+    uint32 added = base::subtle::NoBarrier_Load(&count_) - end;
+    if (added + 1 + available > events_.size()) {
+      size_t overwritten =
+          std::min<size_t>(added + 1 + available - events_.size(), available);
+      events->erase(events->begin() + first,
+                    events->begin() + first + overwritten);
+    }
+  }
+
+  void Clear() {
+    base::subtle::NoBarrier_Store(&full_, 0);
+    base::subtle::Release_Store(&count_, 0);
+  }
+
+  TraceRecorder* recorder() const { return recorder_; }
+  PlatformThreadId thread_id() const { return thread_id_; }
+
+ private:
+  TraceRecorder* const recorder_;
+  std::vector<Event> events_;
+  const uint32 mask_;
+  const PlatformThreadId thread_id_;
+
+  // The number of events added since the last Clear(), modulo 2^32.
+  base::subtle::Atomic32 count_;
+
+  // Set once the buffer has wrapped around.
+  base::subtle::Atomic32 full_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadBuffer);
+};
+
+// static
+const size_t TraceRecorder::kDefaultEventsPerThread = 4096;
+
+// static
+const size_t TraceRecorder::kMaxExitedThreads = 16;
+
+TraceRecorder::TraceRecorder(size_t events_per_thread)
+    : events_per_thread_(RoundUpToPowerOfTwo(events_per_thread)),
+      recording_(0),
+      slot_(&OnThreadExit) {
+  DCHECK_GT(events_per_thread, 0u);
+}
+
+TraceRecorder::~TraceRecorder() {
+  slot_.Free();
+  STLDeleteElements(&buffers_);
+  STLDeleteElements(&exited_buffers_);
+}
+
+// static
+TraceRecorder* TraceRecorder::GetInstance() {
+  return g_trace_recorder.Pointer();
+}
+
+void TraceRecorder::Start() {
+  base::subtle::NoBarrier_Store(&recording_, 1);
+}
+
+void TraceRecorder::Stop() {
+  base::subtle::NoBarrier_Store(&recording_, 0);
+}
+
+void TraceRecorder::Record(EventType type, const char* category,
+                           const char* name, int64 value) {
+  Event event;
+  event.time = TimeTicks::Now().ToInternalValue();
+  event.category = category;
+  event.name = name;
+  event.value = value;
+  event.type = type;
+  GetThreadBuffer()->Add(event);
+}
+
+void TraceRecorder::Clear() {
+  DCHECK(!IsRecording());
+  AutoLock lock(lock_);
+  for (size_t i = 0; i < buffers_.size(); ++i)
+    buffers_[i]->Clear();
+  STLDeleteElements(&exited_buffers_);
+}
+
+void TraceRecorder::ExportJSON(std::string* output) const {
+  int process_id = static_cast<int>(GetCurrentProcId());
+  std::vector<Event> events;
+  std::vector<std::pair<PlatformThreadId, size_t> > thread_ends;
+  {
+    AutoLock lock(lock_);
+    for (size_t i = 0; i < exited_buffers_.size(); ++i) {
+      exited_buffers_[i]->Copy(&events);
+      thread_ends.push_back(
+          std::make_pair(exited_buffers_[i]->thread_id(), events.size()));
+    }
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      buffers_[i]->Copy(&events);
+      thread_ends.push_back(
+          std::make_pair(buffers_[i]->thread_id(), events.size()));
+    }
+  }
+
+  output->append("{\"traceEvents\":[");
+  size_t event_index = 0;
+  for (size_t i = 0; i < thread_ends.size(); ++i) {
+    int thread_id = static_cast<int>(thread_ends[i].first);
+    for (; event_index < thread_ends[i].second; ++event_index) {
+      if (event_index)
+        output->push_back(',');
+      AppendEventJSON(events[event_index], process_id, thread_id, output);
+    }
+  }
+  output->append("]}");
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::GetThreadBuffer() {
+  ThreadBuffer* buffer = static_cast<ThreadBuffer*>(slot_.Get());
+  if (!buffer) {
+    buffer = new ThreadBuffer(this, events_per_thread_,
+                              PlatformThread::CurrentId());
+    {
+      AutoLock lock(lock_);
+      buffers_.push_back(buffer);
+    }
+    slot_.Set(buffer);
+  }
+  return buffer;
+}
+
+// static
+void TraceRecorder::OnThreadExit(void* value) {
+  ThreadBuffer* buffer = static_cast<ThreadBuffer*>(value);
+  TraceRecorder* recorder = buffer->recorder();
+  AutoLock lock(recorder->lock_);
+  std::vector<ThreadBuffer*>::iterator it = std::find(
+      recorder->buffers_.begin(), recorder->buffers_.end(), buffer);
+  DCHECK(it != recorder->buffers_.end());
+  recorder->buffers_.erase(it);
+  recorder->exited_buffers_.push_back(buffer);
+  if (recorder->exited_buffers_.size() > kMaxExitedThreads) {
+    delete recorder->exited_buffers_.front();
+    recorder->exited_buffers_.pop_front();
+  }
+}
+
+// static
+void TraceRecorder::AppendEventJSON(const Event& event, int process_id,
+                                    int thread_id, std::string* output) {
+  COMPILE_ASSERT(arraysize(kPhases) == EVENT_ASYNC_END + 1,
+                 phases_match_event_types);
+  output->append("{\"cat\":");
+  JsonDoubleQuote(std::string(event.category), true, output);
+  output->append(",\"name\":");
+  JsonDoubleQuote(std::string(event.name), true, output);
+  StringAppendF(output, ",\"ph\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%" PRId64,
+                kPhases[event.type], process_id, thread_id, event.time);
+  switch (event.type) {
+    case EVENT_COUNTER:
+      StringAppendF(output, ",\"args\":{\"value\":%" PRId64 "}", event.value);
+      break;
+    case EVENT_ASYNC_BEGIN:
+    case EVENT_ASYNC_END:
+      StringAppendF(output, ",\"id\":\"%" PRIx64 "\"",
+                    static_cast<uint64>(event.value));
+      break;
+    default:
+      break;
+  }
+  output->push_back('}');
+}
+
+}  // namespace debug
+}  // namespace base
@@ -0,0 +1,218 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// TraceRecorder keeps the most recent trace events of each thread in memory,
+// in a fixed size ring buffer per thread, and exports them in the JSON format
+// read by the trace viewer (about:tracing).  Unlike TraceLog, recording an
+// event does no formatting and no I/O: a timestamp, two pointers and a value
+// are written to the calling thread's buffer, without taking a lock.  When
+// recording is off the macros below cost a load and a branch, so they can be
+// left in production builds.
+//
+// Categories and names must be string literals, or otherwise live for the
+// rest of the process, since only the pointers are kept.
+//
+// Usage:
+//   void Cache::Read() {
+//     TRACE_RECORD_SCOPED("disk_cache", "Cache::Read");
+//     ...
+//   }
+//
+//   TRACE_RECORD_ASYNC_BEGIN("net", "Connect", this);
+//   ...  // Possibly in another task.
+//   TRACE_RECORD_ASYNC_END("net", "Connect", this);
+//
+//   TRACE_RECORD_COUNTER("net", "Sockets", socket_count);
+//
+//   base::debug::TraceRecorder::GetInstance()->Start();
+//   ...
+//   std::string json;
+//   base::debug::TraceRecorder::GetInstance()->ExportJSON(&json);
+
+#ifndef BASE_DEBUG_TRACE_RECORDER_H_
+#define BASE_DEBUG_TRACE_RECORDER_H_
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/base_api.h"
+#include "base/basictypes.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local_storage.h"
+
+// Records an event of |type| (one of TraceRecorder::EventType) if recording.
+#define TRACE_RECORD(type, category, name, value) \
+  do { \
+    base::debug::TraceRecorder* trace_recorder = \
+        base::debug::TraceRecorder::GetInstance(); \
+    if (trace_recorder->IsRecording()) { \
+      trace_recorder->Record(base::debug::TraceRecorder::type, \
+                             category, name, value); \
+    } \
+  } while (0)
+
+// Begin and end events must be nested on each thread.
+#define TRACE_RECORD_BEGIN(category, name) \
+  TRACE_RECORD(EVENT_BEGIN, category, name, 0)
+#define TRACE_RECORD_END(category, name) \
+  TRACE_RECORD(EVENT_END, category, name, 0)
+
+// Records a begin event, and the matching end event at the end of the scope.
+#define TRACE_RECORD_SCOPED(category, name) \
+  base::debug::ScopedTraceRecord TRACE_RECORD_CONCAT(trace_record_, __LINE__)( \
+      category, name)
+#define TRACE_RECORD_CONCAT(a, b) TRACE_RECORD_CONCAT_INNER(a, b)
+#define TRACE_RECORD_CONCAT_INNER(a, b) a##b
+
+// Records an event with no duration.
+#define TRACE_RECORD_INSTANT(category, name) \
+  TRACE_RECORD(EVENT_INSTANT, category, name, 0)
+
+// Records the value of a counter.
+#define TRACE_RECORD_COUNTER(category, name, value) \
+  TRACE_RECORD(EVENT_COUNTER, category, name, static_cast<int64>(value))
+
+// Asynchronous events may begin and end on different threads, and need not be
+// nested.  The begin and end are matched by |name| and the pointer |id|.
+#define TRACE_RECORD_ASYNC_BEGIN(category, name, id) \
+  TRACE_RECORD(EVENT_ASYNC_BEGIN, category, name, \
+               static_cast<int64>(reinterpret_cast<intptr_t>(id)))
+#define TRACE_RECORD_ASYNC_END(category, name, id) \
+  TRACE_RECORD(EVENT_ASYNC_END, category, name, \
+               static_cast<int64>(reinterpret_cast<intptr_t>(id)))
+
+namespace base {
+namespace debug {
+
+class BASE_API TraceRecorder {
+ public:
+  enum EventType {
+    EVENT_BEGIN,
+    EVENT_END,
+    EVENT_INSTANT,
+    EVENT_COUNTER,
+    EVENT_ASYNC_BEGIN,
+    EVENT_ASYNC_END,
+  };
+
+  // The number of events each thread keeps in the recorder returned by
+  // GetInstance().
+  static const size_t kDefaultEventsPerThread;
+
+  // The number of exited threads whose events are kept, the most recently
+  // exited ones, so that threads that come and go while recording don't grow
+  // the recorder without bound.
+  static const size_t kMaxExitedThreads;
+
+  // Keeps the last |events_per_thread| events of each thread, rounded up to a
+  // power of two.  Use GetInstance() rather than creating a recorder, except
+  // in tests.
+  explicit TraceRecorder(size_t events_per_thread);
+
+  // No thread may be recording into the recorder.
+  ~TraceRecorder();
+
+  // Returns the recorder used by the TRACE_RECORD macros.
+  static TraceRecorder* GetInstance();
+
+  void Start();
+  void Stop();
+  bool IsRecording() const {
+    return base::subtle::NoBarrier_Load(&recording_) != 0;
+  }
+
+  // Appends an event to the calling thread's buffer, overwriting its oldest
+  // event if the buffer is full.  |value| is the value of a counter or the id
+  // of an asynchronous event.
+  void Record(EventType type, const char* category, const char* name,
+              int64 value);
+
+  // Discards all the events recorded so far, and frees the buffers of the
+  // threads that have exited.  Must not be called while recording.
+  void Clear();
+
+  // Appends the events of all threads to |output| as a JSON trace.  This can
+  // be called while recording: events overwritten as they are being copied
+  // are left out, and so is the oldest event of a full buffer, which the
+  // thread's next event replaces.
+  void ExportJSON(std::string* output) const;
+
+  size_t events_per_thread() const { return events_per_thread_; }
+
+ private:
+  struct Event {
+    int64 time;
+    const char* category;
+    const char* name;
+    int64 value;
+    EventType type;
+  };
+
+  class ThreadBuffer;
+
+  // Returns the calling thread's buffer, creating it if needed.
+  ThreadBuffer* GetThreadBuffer();
+
+  // Moves the buffer of a thread that is exiting to |exited_buffers_|.
+  static void OnThreadExit(void* buffer);
+
+  static void AppendEventJSON(const Event& event, int process_id,
+                              int thread_id, std::string* output);
+
+  const size_t events_per_thread_;
+
+  base::subtle::Atomic32 recording_;
+
+  // Holds each thread's ThreadBuffer.
+  base::ThreadLocalStorage::Slot slot_;
+
+  // The buffers of the running threads that have recorded an event, and of
+  // the last kMaxExitedThreads threads that exited, oldest first.  Protected
+  // by |lock_|.
+  std::vector<ThreadBuffer*> buffers_;
+  std::deque<ThreadBuffer*> exited_buffers_;
+  mutable base::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceRecorder);
+};
+
+// Records a begin event on construction and the end event on destruction.
+// Use TRACE_RECORD_SCOPED() rather than this class.
+class BASE_API ScopedTraceRecord {
+ public:
+  ScopedTraceRecord(const char* category, const char* name)
+      : category_(category),
+        name_(name),
+        recorded_(false) {
+    TraceRecorder* recorder = TraceRecorder::GetInstance();
+    if (recorder->IsRecording()) {
+      recorder->Record(TraceRecorder::EVENT_BEGIN, category, name, 0);
+      recorded_ = true;
+    }
+  }
+
+  ~ScopedTraceRecord() {
+    // Also records the end if recording stopped in between, so that the
+    // events stay nested.
+    if (recorded_) {
+      TraceRecorder::GetInstance()->Record(TraceRecorder::EVENT_END,
+                                           category_, name_, 0);
+    }
+  }
+
+ private:
+  const char* category_;
+  const char* name_;
+  bool recorded_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTraceRecord);
+};
+
+}  // namespace debug
+}  // namespace base
+
+#endif  // BASE_DEBUG_TRACE_RECORDER_H_
@@ -0,0 +1,241 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/debug/trace_recorder.h"
+
+#include <set>
+#include <string>
+
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/stl_util-inl.h"
+#include "base/threading/simple_thread.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+// Exports the events of |recorder| and returns the list of events, or NULL if
+// the output is not a valid trace.
+ListValue* ExportEvents(const TraceRecorder& recorder, Value** root) {
+  std::string json;
+  recorder.ExportJSON(&json);
+  *root = JSONReader::Read(json, false);
+  if (!*root || !(*root)->IsType(Value::TYPE_DICTIONARY))
+    return NULL;
+  ListValue* events = NULL;
+  static_cast<DictionaryValue*>(*root)->GetList("traceEvents", &events);
+  return events;
+}
+
+// Records |count| counter events valued 0 to |count| - 1.
+void RecordCounters(TraceRecorder* recorder, int count) {
+  for (int i = 0; i < count; ++i)
+    recorder->Record(TraceRecorder::EVENT_COUNTER, "test", "counter", i);
+}
+
+// Checks that the exported events are the counter values |first| to
+// |first| + |count| - 1.
+void ExpectCounters(const TraceRecorder& recorder, int first, int count) {
+  Value* root = NULL;
+  ListValue* events = ExportEvents(recorder, &root);
+  scoped_ptr<Value> scoped_root(root);
+  ASSERT_TRUE(events);
+  ASSERT_EQ(static_cast<size_t>(count), events->GetSize());
+  for (int i = 0; i < count; ++i) {
+    DictionaryValue* event = NULL;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    int value = -1;
+    EXPECT_TRUE(event->GetInteger("args.value", &value));
+    EXPECT_EQ(first + i, value);
+  }
+}
+
+std::string GetString(ListValue* events, size_t index, const char* key) {
+  DictionaryValue* event = NULL;
+  std::string value;
+  if (events->GetDictionary(index, &event))
+    event->GetString(key, &value);
+  return value;
+}
+
+class RecordDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  RecordDelegate(TraceRecorder* recorder, int count)
+      : recorder_(recorder),
+        count_(count) {
+  }
+
+  virtual void Run() {
+    for (int i = 0; i < count_; ++i)
+      recorder_->Record(TraceRecorder::EVENT_COUNTER, "test", "thread", i);
+  }
+
+ private:
+  TraceRecorder* recorder_;
+  int count_;
+};
+
+}  // namespace
+
+TEST(TraceRecorderTest, ExportJSON) {
+  TraceRecorder recorder(16);
+  int id = 0;
+  recorder.Record(TraceRecorder::EVENT_BEGIN, "test", "outer", 0);
+  recorder.Record(TraceRecorder::EVENT_INSTANT, "test", "\"quoted\"", 0);
+  recorder.Record(TraceRecorder::EVENT_COUNTER, "test", "counter", 42);
+  recorder.Record(TraceRecorder::EVENT_ASYNC_BEGIN, "test", "async",
+                  reinterpret_cast<intptr_t>(&id));
+  recorder.Record(TraceRecorder::EVENT_END, "test", "outer", 0);
+  recorder.Record(TraceRecorder::EVENT_ASYNC_END, "test", "async",
+                  reinterpret_cast<intptr_t>(&id));
+
+  Value* root = NULL;
+  ListValue* events = ExportEvents(recorder, &root);
+  scoped_ptr<Value> scoped_root(root);
+  ASSERT_TRUE(events);
+  ASSERT_EQ(6u, events->GetSize());
+
+  const char* const kPhases[] = { "B", "I", "C", "S", "E", "F" };
+  for (size_t i = 0; i < arraysize(kPhases); ++i) {
+    EXPECT_EQ(kPhases[i], GetString(events, i, "ph")) << i;
+    EXPECT_EQ("test", GetString(events, i, "cat")) << i;
+  }
+  EXPECT_EQ("outer", GetString(events, 0, "name"));
+  EXPECT_EQ("\"quoted\"", GetString(events, 1, "name"));
+
+  DictionaryValue* event = NULL;
+  ASSERT_TRUE(events->GetDictionary(2, &event));
+  int value = 0;
+  EXPECT_TRUE(event->GetInteger("args.value", &value));
+  EXPECT_EQ(42, value);
+
+  std::string begin_id = GetString(events, 3, "id");
+  EXPECT_FALSE(begin_id.empty());
+  EXPECT_EQ(begin_id, GetString(events, 5, "id"));
+
+  // Timestamps are in order.
+  double previous = 0;
+  for (size_t i = 0; i < events->GetSize(); ++i) {
+    double timestamp = 0;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    EXPECT_TRUE(event->GetDouble("ts", &timestamp));
+    EXPECT_LE(previous, timestamp);
+    previous = timestamp;
+  }
+}
+
+TEST(TraceRecorderTest, RingBuffer) {
+  // The size is rounded up to 4.
+  TraceRecorder recorder(3);
+  EXPECT_EQ(4u, recorder.events_per_thread());
+  RecordCounters(&recorder, 10);
+
+  // Only the last four events are kept, and the oldest of those is the one
+  // the next event overwrites, so it isn't exported.
+  ExpectCounters(recorder, 7, 3);
+
+  recorder.Clear();
+  std::string json;
+  recorder.ExportJSON(&json);
+  EXPECT_EQ("{\"traceEvents\":[]}", json);
+}
+
+TEST(TraceRecorderTest, FullBuffer) {
+  TraceRecorder recorder(4);
+  RecordCounters(&recorder, 3);
+  ExpectCounters(recorder, 0, 3);
+
+  // Filling the buffer exactly leaves the next event to overwrite the oldest.
+  recorder.Record(TraceRecorder::EVENT_COUNTER, "test", "counter", 3);
+  ExpectCounters(recorder, 1, 3);
+}
+
+TEST(TraceRecorderTest, Threads) {
+  TraceRecorder recorder(64);
+  const int kThreads = 4;
+  std::vector<RecordDelegate*> delegates;
+  std::vector<DelegateSimpleThread*> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    delegates.push_back(new RecordDelegate(&recorder, 100));
+    threads.push_back(new DelegateSimpleThread(delegates.back(), "trace"));
+    threads.back()->Start();
+  }
+  for (int i = 0; i < kThreads; ++i)
+    threads[i]->Join();
+  STLDeleteElements(&threads);
+  STLDeleteElements(&delegates);
+
+  // Each thread keeps its own last 64 events, even after it has exited, and
+  // the newest 63 of them are exported.
+  Value* root = NULL;
+  ListValue* events = ExportEvents(recorder, &root);
+  scoped_ptr<Value> scoped_root(root);
+  ASSERT_TRUE(events);
+  EXPECT_EQ(static_cast<size_t>(kThreads * 63), events->GetSize());
+  std::set<int> thread_ids;
+  for (size_t i = 0; i < events->GetSize(); ++i) {
+    DictionaryValue* event = NULL;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    int thread_id = 0;
+    EXPECT_TRUE(event->GetInteger("tid", &thread_id));
+    thread_ids.insert(thread_id);
+  }
+  EXPECT_EQ(static_cast<size_t>(kThreads), thread_ids.size());
+}
+
+TEST(TraceRecorderTest, ExitedThreads) {
+  TraceRecorder recorder(4);
+  const int kThreads = static_cast<int>(TraceRecorder::kMaxExitedThreads) + 4;
+  for (int i = 0; i < kThreads; ++i) {
+    RecordDelegate delegate(&recorder, 2);
+    DelegateSimpleThread thread(&delegate, "trace");
+    thread.Start();
+    thread.Join();
+  }
+
+  // Only the events of the last kMaxExitedThreads threads are kept.
+  Value* root = NULL;
+  ListValue* events = ExportEvents(recorder, &root);
+  scoped_ptr<Value> scoped_root(root);
+  ASSERT_TRUE(events);
+  EXPECT_EQ(2 * TraceRecorder::kMaxExitedThreads, events->GetSize());
+
+  recorder.Clear();
+  std::string json;
+  recorder.ExportJSON(&json);
+  EXPECT_EQ("{\"traceEvents\":[]}", json);
+}
+
+TEST(TraceRecorderTest, Macros) {
+  TraceRecorder* recorder = TraceRecorder::GetInstance();
+  EXPECT_FALSE(recorder->IsRecording());
+  TRACE_RECORD_INSTANT("test", "not recorded");
+
+  recorder->Start();
+  {
+    TRACE_RECORD_SCOPED("test", "scope");
+    TRACE_RECORD_COUNTER("test", "counter", 7u);
+    // The end of the scope is recorded even though recording stops first.
+    recorder->Stop();
+  }
+  TRACE_RECORD_INSTANT("test", "not recorded");
+
+  Value* root = NULL;
+  ListValue* events = ExportEvents(*recorder, &root);
+  scoped_ptr<Value> scoped_root(root);
+  ASSERT_TRUE(events);
+  ASSERT_EQ(3u, events->GetSize());
+  EXPECT_EQ("B", GetString(events, 0, "ph"));
+  EXPECT_EQ("C", GetString(events, 1, "ph"));
+  EXPECT_EQ("E", GetString(events, 2, "ph"));
+  EXPECT_EQ("scope", GetString(events, 2, "name"));
+  recorder->Clear();
+}
+
+}  // namespace debug
+}  // namespace base
@@ -0,0 +1,229 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_arena.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+const int JSONArena::kNoNode = -1;
+
+JSONArena::JSONArena() : allocation_count_(0) {
+  key_.offset = 0;
+  key_.length = 0;
+}
+
+JSONArena::~JSONArena() {
+}
+
+void JSONArena::Clear() {
+  nodes_.clear();
+  strings_.clear();
+  stack_.clear();
+}
+
+void JSONArena::Reserve(size_t nodes, size_t string_bytes) {
+  if (nodes > nodes_.capacity()) {
+    nodes_.reserve(nodes);
+    ++allocation_count_;
+  }
+  if (string_bytes > strings_.capacity()) {
+    strings_.reserve(string_bytes);
+    ++allocation_count_;
+  }
+}
+
+Value::ValueType JSONArena::GetType(int node) const {
+  return nodes_[node].type;
+}
+
+bool JSONArena::GetAsBoolean(int node, bool* out_value) const {
+  if (nodes_[node].type != Value::TYPE_BOOLEAN)
+    return false;
+  *out_value = nodes_[node].value.boolean;
+  return true;
+}
+
+bool JSONArena::GetAsInteger(int node, int* out_value) const {
+  if (nodes_[node].type != Value::TYPE_INTEGER)
+    return false;
+  *out_value = nodes_[node].value.integer;
+  return true;
+}
+
+bool JSONArena::GetAsDouble(int node, double* out_value) const {
+  if (nodes_[node].type == Value::TYPE_INTEGER) {
+    *out_value = nodes_[node].value.integer;
+    return true;
+  }
+  if (nodes_[node].type != Value::TYPE_DOUBLE)
+    return false;
+  *out_value = nodes_[node].value.real;
+  return true;
+}
+
+bool JSONArena::GetAsString(int node, StringPiece* out_value) const {
+  if (nodes_[node].type != Value::TYPE_STRING)
+    return false;
+  *out_value = GetString(nodes_[node].value.string);
+  return true;
+}
+
+size_t JSONArena::GetSize(int node) const {
+  DCHECK(nodes_[node].type == Value::TYPE_LIST ||
+         nodes_[node].type == Value::TYPE_DICTIONARY);
+  return nodes_[node].value.children.size;
+}
+
+int JSONArena::GetFirstChild(int node) const {
+  DCHECK(nodes_[node].type == Value::TYPE_LIST ||
+         nodes_[node].type == Value::TYPE_DICTIONARY);
+  return nodes_[node].value.children.first_child;
+}
+
+int JSONArena::GetNextSibling(int node) const {
+  return nodes_[node].next_sibling;
+}
+
+StringPiece JSONArena::GetKey(int node) const {
+  return GetString(nodes_[node].key);
+}
+
+int JSONArena::FindKey(int dictionary, const StringPiece& key) const {
+  DCHECK_EQ(Value::TYPE_DICTIONARY, nodes_[dictionary].type);
+  int found = kNoNode;
+  for (int child = GetFirstChild(dictionary); child != kNoNode;
+       child = GetNextSibling(child)) {
+    if (GetKey(child) == key)
+      found = child;
+  }
+  return found;
+}
+
+Value* JSONArena::CreateValue(int node) const {
+  const Node& n = nodes_[node];
+  switch (n.type) {
+    case Value::TYPE_NULL:
+      return Value::CreateNullValue();
+    case Value::TYPE_BOOLEAN:
+      return Value::CreateBooleanValue(n.value.boolean);
+    case Value::TYPE_INTEGER:
+      return Value::CreateIntegerValue(n.value.integer);
+    case Value::TYPE_DOUBLE:
+      return Value::CreateDoubleValue(n.value.real);
+    case Value::TYPE_STRING:
+      return Value::CreateStringValue(
+          GetString(n.value.string).as_string());
+    case Value::TYPE_LIST: {
+      ListValue* list = new ListValue;
+      for (int child = n.value.children.first_child; child != kNoNode;
+           child = GetNextSibling(child)) {
+        list->Append(CreateValue(child));
+      }
+      return list;
+    }
+    case Value::TYPE_DICTIONARY: {
+      DictionaryValue* dictionary = new DictionaryValue;
+      for (int child = n.value.children.first_child; child != kNoNode;
+           child = GetNextSibling(child)) {
+        dictionary->SetWithoutPathExpansion(GetKey(child).as_string(),
+                                            CreateValue(child));
+      }
+      return dictionary;
+    }
+    default:
+      NOTREACHED();
+      return NULL;
+  }
+}
+
+void JSONArena::OnNull() {
+  AddNode(Value::TYPE_NULL);
+}
+
+void JSONArena::OnBoolean(bool value) {
+  AddNode(Value::TYPE_BOOLEAN)->value.boolean = value;
+}
+
+void JSONArena::OnInteger(int value) {
+  AddNode(Value::TYPE_INTEGER)->value.integer = value;
+}
+
+void JSONArena::OnDouble(double value) {
+  AddNode(Value::TYPE_DOUBLE)->value.real = value;
+}
+
+void JSONArena::OnString(const StringPiece& value) {
+  StringRef ref = AddString(value);
+  AddNode(Value::TYPE_STRING)->value.string = ref;
+}
+
+void JSONArena::OnListBegin() {
+  AddNode(Value::TYPE_LIST);
+  stack_.push_back(static_cast<int>(nodes_.size()) - 1);
+}
+
+void JSONArena::OnListEnd() {
+  DCHECK(!stack_.empty());
+  stack_.pop_back();
+}
+
+void JSONArena::OnDictionaryBegin() {
+  AddNode(Value::TYPE_DICTIONARY);
+  stack_.push_back(static_cast<int>(nodes_.size()) - 1);
+}
+
+void JSONArena::OnDictionaryKey(const StringPiece& key) {
+  key_ = AddString(key);
+}
+
+void JSONArena::OnDictionaryEnd() {
+  DCHECK(!stack_.empty());
+  stack_.pop_back();
+}
+
+JSONArena::Node* JSONArena::AddNode(Value::ValueType type) {
+  if (nodes_.size() == nodes_.capacity())
+    ++allocation_count_;
+
+  int index = static_cast<int>(nodes_.size());
+  nodes_.push_back(Node());
+  Node* node = &nodes_.back();
+  node->type = type;
+  node->next_sibling = kNoNode;
+  node->key.offset = 0;
+  node->key.length = 0;
+  if (type == Value::TYPE_LIST || type == Value::TYPE_DICTIONARY) {
+    node->value.children.first_child = kNoNode;
+    node->value.children.last_child = kNoNode;
+    node->value.children.size = 0;
+  }
+
+  if (!stack_.empty()) {
+    Node* parent = &nodes_[stack_.back()];
+    if (parent->type == Value::TYPE_DICTIONARY)
+      node->key = key_;
+    if (parent->value.children.last_child == kNoNode)
+      parent->value.children.first_child = index;
+    else
+      nodes_[parent->value.children.last_child].next_sibling = index;
+    parent->value.children.last_child = index;
+    ++parent->value.children.size;
+  }
+  return node;
+}
+
+JSONArena::StringRef JSONArena::AddString(const StringPiece& str) {
+  if (strings_.size() + str.size() > strings_.capacity())
+    ++allocation_count_;
+
+  StringRef ref;
+  ref.offset = strings_.size();
+  ref.length = str.size();
+  strings_.append(str.data(), str.size());
+  return ref;
+}
+
+}  // namespace base
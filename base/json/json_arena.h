@@ -0,0 +1,148 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A read-only JSON document stored in an arena. JSONArena is a
+// JSONStreamParser delegate that stores every value as a fixed-size node in
+// one array, and every string and key in one buffer, instead of allocating a
+// Value, a std::string and a std::map node for each. Values are identified by
+// their node index. Clear() keeps both blocks so that parsing a series of
+// documents stops allocating once the largest has been seen.
+//
+// Usage:
+//   JSONArena arena;
+//   JSONStreamParser parser(&arena, true, false);
+//   if (parser.Parse(json) && parser.Finish()) {
+//     int node = arena.FindKey(arena.root(), "name");
+//     StringPiece name;
+//     if (node != JSONArena::kNoNode && arena.GetAsString(node, &name))
+//       ...
+//   }
+
+#ifndef BASE_JSON_JSON_ARENA_H_
+#define BASE_JSON_JSON_ARENA_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+#include "base/json/json_stream_parser.h"
+#include "base/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+class BASE_API JSONArena : public JSONStreamParser::Delegate {
+ public:
+  // The index of a missing node.
+  static const int kNoNode;
+
+  JSONArena();
+  virtual ~JSONArena();
+
+  // Forgets the document but keeps the memory for the next one.
+  void Clear();
+
+  // Reserves room for |nodes| values and |string_bytes| of strings and keys.
+  void Reserve(size_t nodes, size_t string_bytes);
+
+  // Returns the root value, or kNoNode if none was started.
+  int root() const { return nodes_.empty() ? kNoNode : 0; }
+
+  Value::ValueType GetType(int node) const;
+
+  // These follow the FundamentalValue and StringValue getters: they return
+  // false if the node has another type, and GetAsDouble() accepts integers.
+  // The StringPiece stays valid until the arena is cleared.
+  bool GetAsBoolean(int node, bool* out_value) const;
+  bool GetAsInteger(int node, int* out_value) const;
+  bool GetAsDouble(int node, double* out_value) const;
+  bool GetAsString(int node, StringPiece* out_value) const;
+
+  // Returns the number of values in a list or dictionary.
+  size_t GetSize(int node) const;
+
+  // Walk the values of a list or dictionary in order. Both return kNoNode at
+  // the end.
+  int GetFirstChild(int node) const;
+  int GetNextSibling(int node) const;
+
+  // Returns the key of a value in a dictionary.
+  StringPiece GetKey(int node) const;
+
+  // Returns the value stored under |key| in a dictionary, or kNoNode. As with
+  // JSONReader, the last of several equal keys wins.
+  int FindKey(int dictionary, const StringPiece& key) const;
+
+  // Builds the Value tree for |node|, the same as JSONReader would have
+  // returned. The caller owns the result.
+  Value* CreateValue(int node) const;
+
+  // Returns how many times the arena has had to allocate memory.
+  int allocation_count() const { return allocation_count_; }
+
+  // JSONStreamParser::Delegate methods:
+  virtual void OnNull();
+  virtual void OnBoolean(bool value);
+  virtual void OnInteger(int value);
+  virtual void OnDouble(double value);
+  virtual void OnString(const StringPiece& value);
+  virtual void OnListBegin();
+  virtual void OnListEnd();
+  virtual void OnDictionaryBegin();
+  virtual void OnDictionaryKey(const StringPiece& key);
+  virtual void OnDictionaryEnd();
+
+ private:
+  // A range of |strings_|.
+  struct StringRef {
+    size_t offset;
+    size_t length;
+  };
+
+  struct Node {
+    Value::ValueType type;
+    int next_sibling;
+    // Only used for values in dictionaries.
+    StringRef key;
+    union {
+      bool boolean;
+      int integer;
+      double real;
+      StringRef string;
+      struct {
+        int first_child;
+        int last_child;
+        int size;
+      } children;
+    } value;
+  };
+
+  // Appends a node of |type| to the innermost open container and returns it.
+  Node* AddNode(Value::ValueType type);
+
+  StringRef AddString(const StringPiece& str);
+
+  StringPiece GetString(const StringRef& ref) const {
+    return StringPiece(strings_.data() + ref.offset, ref.length);
+  }
+
+  std::vector<Node> nodes_;
+  std::string strings_;
+
+  // The open containers, innermost last.
+  std::vector<int> stack_;
+
+  // The key for the next value added to a dictionary.
+  StringRef key_;
+
+  int allocation_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONArena);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_ARENA_H_
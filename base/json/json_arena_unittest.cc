@@ -0,0 +1,111 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/json/json_arena.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_stream_parser.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const char kDocument[] =
+    "{\"name\": \"chromium\", \"version\": 12, \"ratio\": 0.5,"
+    " \"enabled\": true, \"nothing\": null,"
+    " \"list\": [1, \"two\", [3], {\"four\": 4}], \"name\": \"chrome\"}";
+
+bool Parse(const std::string& json, JSONArena* arena) {
+  JSONStreamParser parser(arena, true, false);
+  return parser.Parse(json) && parser.Finish();
+}
+
+}  // namespace
+
+TEST(JSONArenaTest, Accessors) {
+  JSONArena arena;
+  EXPECT_EQ(JSONArena::kNoNode, arena.root());
+  ASSERT_TRUE(Parse(kDocument, &arena));
+
+  int root = arena.root();
+  ASSERT_EQ(Value::TYPE_DICTIONARY, arena.GetType(root));
+  EXPECT_EQ(7u, arena.GetSize(root));
+
+  // The last of the two "name" keys wins.
+  StringPiece string_value;
+  int node = arena.FindKey(root, "name");
+  ASSERT_NE(JSONArena::kNoNode, node);
+  ASSERT_TRUE(arena.GetAsString(node, &string_value));
+  EXPECT_EQ("chrome", string_value);
+  EXPECT_EQ(JSONArena::kNoNode, arena.FindKey(root, "missing"));
+
+  int int_value = 0;
+  double double_value = 0;
+  node = arena.FindKey(root, "version");
+  EXPECT_TRUE(arena.GetAsInteger(node, &int_value));
+  EXPECT_EQ(12, int_value);
+  EXPECT_TRUE(arena.GetAsDouble(node, &double_value));
+  EXPECT_EQ(12.0, double_value);
+  EXPECT_FALSE(arena.GetAsString(node, &string_value));
+
+  node = arena.FindKey(root, "ratio");
+  EXPECT_FALSE(arena.GetAsInteger(node, &int_value));
+  EXPECT_TRUE(arena.GetAsDouble(node, &double_value));
+  EXPECT_EQ(0.5, double_value);
+
+  bool bool_value = false;
+  EXPECT_TRUE(arena.GetAsBoolean(arena.FindKey(root, "enabled"),
+                                 &bool_value));
+  EXPECT_TRUE(bool_value);
+  EXPECT_EQ(Value::TYPE_NULL, arena.GetType(arena.FindKey(root, "nothing")));
+
+  int list = arena.FindKey(root, "list");
+  ASSERT_EQ(Value::TYPE_LIST, arena.GetType(list));
+  EXPECT_EQ(4u, arena.GetSize(list));
+  node = arena.GetFirstChild(list);
+  EXPECT_EQ(Value::TYPE_INTEGER, arena.GetType(node));
+  node = arena.GetNextSibling(node);
+  EXPECT_TRUE(arena.GetAsString(node, &string_value));
+  EXPECT_EQ("two", string_value);
+  node = arena.GetNextSibling(node);
+  EXPECT_EQ(Value::TYPE_LIST, arena.GetType(node));
+  EXPECT_EQ(1u, arena.GetSize(node));
+  node = arena.GetNextSibling(node);
+  EXPECT_EQ("four", arena.GetKey(arena.GetFirstChild(node)));
+  EXPECT_EQ(JSONArena::kNoNode, arena.GetNextSibling(node));
+}
+
+TEST(JSONArenaTest, CreateValue) {
+  JSONArena arena;
+  ASSERT_TRUE(Parse(kDocument, &arena));
+  scoped_ptr<Value> expected(JSONReader::Read(kDocument, false));
+  ASSERT_TRUE(expected.get());
+  scoped_ptr<Value> value(arena.CreateValue(arena.root()));
+  ASSERT_TRUE(value.get());
+  EXPECT_TRUE(expected->Equals(value.get()));
+}
+
+TEST(JSONArenaTest, ReusesMemory) {
+  JSONArena arena;
+  ASSERT_TRUE(Parse(kDocument, &arena));
+  int allocations = arena.allocation_count();
+  EXPECT_GT(allocations, 0);
+  for (int i = 0; i < 3; ++i) {
+    arena.Clear();
+    EXPECT_EQ(JSONArena::kNoNode, arena.root());
+    ASSERT_TRUE(Parse(kDocument, &arena));
+  }
+  EXPECT_EQ(allocations, arena.allocation_count());
+
+  JSONArena reserved;
+  reserved.Reserve(100, 1000);
+  ASSERT_TRUE(Parse(kDocument, &reserved));
+  EXPECT_EQ(2, reserved.allocation_count());
+}
+
+}  // namespace base
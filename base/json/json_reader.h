@@ -147,6 +147,7 @@ class BASE_API JSONReader {
                      bool allow_trailing_comma);
 
  private:
+  friend class JSONStreamParser;
   FRIEND_TEST(JSONReaderTest, Reading);
   FRIEND_TEST(JSONReaderTest, ErrorMessages);
 
@@ -0,0 +1,838 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_parser.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/float_util.h"
+#include "base/logging.h"
+#include "base/string_number_conversions.h"
+#include "base/string_util.h"
+#include "base/third_party/icu/icu_utf.h"
+#include "base/utf_string_conversion_utils.h"
+#include "base/values.h"
+
+namespace base {
+
+namespace {
+
+// The same limit as JSONReader's: a value may be nested in at most 99 lists
+// and dictionaries.
+const size_t kStackLimit = 100;
+
+// Returns true for the bytes that end the fast scan of a string: the closing
+// quote, an escape, a newline (for line counting) and anything that isn't
+// ASCII (for the UTF-8 check).
+inline bool IsStringSpecial(char c) {
+  return c == '"' || c == '\\' || c == '\n' ||
+         static_cast<unsigned char>(c) >= 0x80;
+}
+
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Returns the number of characters in the UTF-8 run [begin, end).
+int CountCharacters(const char* begin, const char* end) {
+  int count = 0;
+  for (const char* pos = begin; pos < end; ++pos) {
+    if ((*pos & 0xC0) != 0x80)
+      ++count;
+  }
+  return count;
+}
+
+// Reads |digits| hex digits at |pos| into |*value|.
+bool ReadHexDigits(const char* pos, int digits, uint32* value) {
+  *value = 0;
+  for (int i = 0; i < digits; ++i) {
+    if (!IsHexDigit(pos[i]))
+      return false;
+    *value = (*value << 4) + HexDigitToInt(pos[i]);
+  }
+  return true;
+}
+
+bool IsValidUTF8(const StringPiece& str) {
+  int32 length = static_cast<int32>(str.size());
+  for (int32 i = 0; i < length; ++i) {
+    uint32 code_point;
+    if (!ReadUnicodeCharacter(str.data(), length, &i, &code_point))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+JSONStreamParser::ScanState::ScanState()
+    : scanned(0),
+      run(0),
+      escaped(false),
+      is_ascii(true),
+      newlines(0),
+      last_newline(0) {
+}
+
+JSONStreamParser::JSONStreamParser(Delegate* delegate,
+                                   bool check_root,
+                                   bool allow_trailing_comma)
+    : delegate_(delegate),
+      check_root_(check_root),
+      allow_trailing_comma_(allow_trailing_comma),
+      state_(STATE_START),
+      buffer_begin_(NULL),
+      line_start_(NULL),
+      line_(0),
+      column_carry_(0),
+      error_code_(JSONReader::JSON_NO_ERROR),
+      error_line_(0),
+      error_column_(0) {
+  DCHECK(delegate_);
+}
+
+JSONStreamParser::~JSONStreamParser() {
+}
+
+bool JSONStreamParser::Parse(const char* data, size_t length) {
+  if (state_ == STATE_ERROR)
+    return false;
+  const char* stop;
+  if (pending_.empty()) {
+    if (!ParseBuffer(data, data + length, false, &stop))
+      return false;
+    pending_.assign(stop, data + length);
+    return true;
+  }
+
+  // If the held back token ends in this chunk, what is left over afterwards
+  // lies in this chunk too, so erasing the parsed part copies no byte twice.
+  pending_.append(data, length);
+  const char* begin = pending_.data();
+  if (!ParseBuffer(begin, begin + pending_.size(), false, &stop))
+    return false;
+  pending_.erase(0, stop - begin);
+  return true;
+}
+
+bool JSONStreamParser::Finish() {
+  if (state_ == STATE_ERROR)
+    return false;
+
+  const char* begin = pending_.data();
+  const char* end = begin + pending_.size();
+  const char* stop;
+  if (ParseBuffer(begin, end, true, &stop) && state_ != STATE_DONE) {
+    if (state_ == STATE_ROOT && check_root_)
+      SetErrorCode(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE, end);
+    else
+      SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, end);
+    state_ = STATE_ERROR;
+  }
+  pending_.clear();
+  return state_ == STATE_DONE;
+}
+
+std::string JSONStreamParser::GetErrorMessage() const {
+  return JSONReader::FormatErrorMessage(
+      error_line_, error_column_, JSONReader::ErrorCodeToString(error_code_));
+}
+
+bool JSONStreamParser::ParseBuffer(const char* begin,
+                                   const char* end,
+                                   bool at_end,
+                                   const char** stop) {
+  const char* pos = begin;
+  if (state_ == STATE_START) {
+    // Skip a UTF-8 byte order mark, waiting for more input if the chunk ends
+    // inside what could be one.
+    static const char kByteOrderMark[] = "\xEF\xBB\xBF";
+    size_t available = std::min<size_t>(end - pos, 3);
+    if (memcmp(pos, kByteOrderMark, available) == 0) {
+      if (available < 3 && !at_end) {
+        *stop = pos;
+        return true;
+      }
+      if (available == 3)
+        pos += 3;
+    }
+    state_ = STATE_ROOT;
+  }
+
+  buffer_begin_ = pos;
+  line_start_ = NULL;
+  while (true) {
+    // An incomplete comment leaves |pos| at its start; an incomplete token
+    // is retried from its start.
+    Result result = EatWhitespaceAndComments(&pos, end, at_end);
+    if (result == RESULT_OK) {
+      if (pos == end)
+        break;
+      const char* token = pos;
+      result = ParseToken(&pos, end, at_end);
+      if (result == RESULT_INCOMPLETE)
+        pos = token;
+    }
+
+    if (result == RESULT_ERROR) {
+      state_ = STATE_ERROR;
+      return false;
+    }
+    if (result == RESULT_INCOMPLETE) {
+      DCHECK(!at_end);
+      break;
+    }
+  }
+
+  if (!at_end) {
+    column_carry_ = line_start_ ? CountCharacters(line_start_, pos) :
+        column_carry_ + CountCharacters(buffer_begin_, pos);
+  }
+  *stop = pos;
+  return true;
+}
+
+JSONStreamParser::Result JSONStreamParser::ParseToken(const char** pos,
+                                                      const char* end,
+                                                      bool at_end) {
+  const char* token = *pos;
+  switch (state_) {
+    case STATE_ROOT:
+      if (check_root_ && *token != '[' && *token != '{') {
+        SetErrorCode(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE, token);
+        return RESULT_ERROR;
+      }
+      return ParseValue(pos, end, at_end);
+
+    case STATE_VALUE:
+      return ParseValue(pos, end, at_end);
+
+    case STATE_FIRST_ELEMENT:
+    case STATE_NEXT_ELEMENT:
+      if (*token == ']') {
+        // Trailing commas are invalid according to the JSON RFC, but some
+        // consumers need the parsing leniency, so handle accordingly.
+        if (state_ == STATE_NEXT_ELEMENT && !allow_trailing_comma_) {
+          SetErrorCode(JSONReader::JSON_TRAILING_COMMA, token);
+          return RESULT_ERROR;
+        }
+        ++*pos;
+        CloseContainer();
+        return RESULT_OK;
+      }
+      return ParseValue(pos, end, at_end);
+
+    case STATE_ELEMENT_END:
+      if (*token == ',') {
+        ++*pos;
+        state_ = STATE_NEXT_ELEMENT;
+        return RESULT_OK;
+      }
+      if (*token == ']') {
+        ++*pos;
+        CloseContainer();
+        return RESULT_OK;
+      }
+      break;
+
+    case STATE_FIRST_KEY:
+    case STATE_NEXT_KEY: {
+      if (*token == '}') {
+        if (state_ == STATE_NEXT_KEY && !allow_trailing_comma_) {
+          SetErrorCode(JSONReader::JSON_TRAILING_COMMA, token);
+          return RESULT_ERROR;
+        }
+        ++*pos;
+        CloseContainer();
+        return RESULT_OK;
+      }
+      if (*token != '"') {
+        SetErrorCode(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, token);
+        return RESULT_ERROR;
+      }
+      StringPiece key;
+      Result result = ParseString(pos, end, at_end, &key);
+      if (result == RESULT_OK) {
+        delegate_->OnDictionaryKey(key);
+        state_ = STATE_COLON;
+      }
+      return result;
+    }
+
+    case STATE_COLON:
+      if (*token == ':') {
+        ++*pos;
+        state_ = STATE_VALUE;
+        return RESULT_OK;
+      }
+      break;
+
+    case STATE_MEMBER_END:
+      if (*token == ',') {
+        ++*pos;
+        state_ = STATE_NEXT_KEY;
+        return RESULT_OK;
+      }
+      if (*token == '}') {
+        ++*pos;
+        CloseContainer();
+        return RESULT_OK;
+      }
+      break;
+
+    case STATE_DONE:
+      SetErrorCode(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, token);
+      return RESULT_ERROR;
+
+    default:
+      NOTREACHED();
+      break;
+  }
+
+  SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, token);
+  return RESULT_ERROR;
+}
+
+JSONStreamParser::Result JSONStreamParser::ParseValue(const char** pos,
+                                                      const char* end,
+                                                      bool at_end) {
+  const char* token = *pos;
+  if (stack_.size() >= kStackLimit) {
+    SetErrorCode(JSONReader::JSON_TOO_MUCH_NESTING, token);
+    return RESULT_ERROR;
+  }
+
+  Result result = RESULT_OK;
+  switch (*token) {
+    case '[':
+      ++*pos;
+      delegate_->OnListBegin();
+      stack_.push_back('[');
+      state_ = STATE_FIRST_ELEMENT;
+      return RESULT_OK;
+
+    case '{':
+      ++*pos;
+      delegate_->OnDictionaryBegin();
+      stack_.push_back('{');
+      state_ = STATE_FIRST_KEY;
+      return RESULT_OK;
+
+    case '"': {
+      StringPiece value;
+      result = ParseString(pos, end, at_end, &value);
+      if (result == RESULT_OK)
+        delegate_->OnString(value);
+      break;
+    }
+
+    case 't':
+      result = ParseLiteral(pos, end, at_end, "true", 4);
+      if (result == RESULT_OK)
+        delegate_->OnBoolean(true);
+      break;
+
+    case 'f':
+      result = ParseLiteral(pos, end, at_end, "false", 5);
+      if (result == RESULT_OK)
+        delegate_->OnBoolean(false);
+      break;
+
+    case 'n':
+      result = ParseLiteral(pos, end, at_end, "null", 4);
+      if (result == RESULT_OK)
+        delegate_->OnNull();
+      break;
+
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+      result = ParseNumber(pos, end, at_end);
+      break;
+
+    default:
+      SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, token);
+      return RESULT_ERROR;
+  }
+
+  if (result == RESULT_OK)
+    state_ = StateAfterValue();
+  return result;
+}
+
+JSONStreamParser::Result JSONStreamParser::ParseLiteral(const char** pos,
+                                                        const char* end,
+                                                        bool at_end,
+                                                        const char* literal,
+                                                        size_t length) {
+  size_t available = end - *pos;
+  if (available < length) {
+    if (!at_end && memcmp(*pos, literal, available) == 0)
+      return RESULT_INCOMPLETE;
+  } else if (memcmp(*pos, literal, length) == 0) {
+    *pos += length;
+    return RESULT_OK;
+  }
+  SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, *pos);
+  return RESULT_ERROR;
+}
+
+JSONStreamParser::Result JSONStreamParser::ParseNumber(const char** pos,
+                                                       const char* end,
+                                                       bool at_end) {
+  // According to RFC4627, a valid number is: [minus] int [frac] [exp]. A
+  // number that reaches the end of the chunk may continue in the next one.
+  const char* token = *pos;
+  const char* p = token;
+  if (*p == '-')
+    ++p;
+
+  const char* digits = p;
+  while (p < end && IsDigit(*p))
+    ++p;
+  if (p == end && !at_end)
+    return RESULT_INCOMPLETE;
+  bool valid = p != digits && (p - digits == 1 || *digits != '0');
+  bool is_integer = true;
+
+  if (valid && p < end && *p == '.') {
+    is_integer = false;
+    digits = ++p;
+    while (p < end && IsDigit(*p))
+      ++p;
+    if (p == end && !at_end)
+      return RESULT_INCOMPLETE;
+    valid = p != digits;
+  }
+
+  if (valid && p < end && (*p == 'e' || *p == 'E')) {
+    is_integer = false;
+    ++p;
+    if (p < end && (*p == '-' || *p == '+'))
+      ++p;
+    digits = p;
+    while (p < end && IsDigit(*p))
+      ++p;
+    if (p == end && !at_end)
+      return RESULT_INCOMPLETE;
+    valid = p != digits;
+  }
+
+  if (valid) {
+    // Like JSONReader, prefer an int and fall back to a double.
+    int int_value;
+    if (is_integer && StringToInt(token, p, &int_value)) {
+      delegate_->OnInteger(int_value);
+      *pos = p;
+      return RESULT_OK;
+    }
+    number_.assign(token, p);
+    double double_value;
+    if (StringToDouble(number_, &double_value) && IsFinite(double_value)) {
+      delegate_->OnDouble(double_value);
+      *pos = p;
+      return RESULT_OK;
+    }
+  }
+
+  SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, token);
+  return RESULT_ERROR;
+}
+
+JSONStreamParser::Result JSONStreamParser::ParseString(const char** pos,
+                                                       const char* end,
+                                                       bool at_end,
+                                                       StringPiece* value) {
+  const char* token = *pos;
+  const char* begin = token + 1;
+  const char* run = begin;
+  const char* p = begin;
+  bool escaped = false;
+  bool is_ascii = true;
+  int newlines = 0;
+  const char* last_newline = NULL;
+  if (resume_.scanned) {
+    // The previous chunk ended inside this string.
+    p = token + resume_.scanned;
+    run = token + resume_.run;
+    escaped = resume_.escaped;
+    is_ascii = resume_.is_ascii;
+    newlines = resume_.newlines;
+    if (newlines)
+      last_newline = token + resume_.last_newline;
+    resume_ = ScanState();
+  }
+
+  while (true) {
+    while (p < end && !IsStringSpecial(*p))
+      ++p;
+    if (p == end) {
+      if (!at_end) {
+        return SaveScan(token, p, run, escaped, is_ascii, newlines,
+                        last_newline);
+      }
+      SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, token);
+      return RESULT_ERROR;
+    }
+
+    if (*p == '"')
+      break;
+    if (*p == '\n') {
+      ++newlines;
+      last_newline = p++;
+      continue;
+    }
+    if (*p != '\\') {
+      is_ascii = false;
+      ++p;
+      continue;
+    }
+
+    // An escape. Copy what precedes it and decode it into |decoded_|.
+    if (!escaped) {
+      decoded_.clear();
+      escaped = true;
+    }
+    decoded_.append(run, p);
+    run = p;
+
+    size_t available = end - p;
+    size_t length = 2;
+    uint32 code_point = 0;
+    if (available < 2) {
+      if (!at_end) {
+        return SaveScan(token, p, run, escaped, is_ascii, newlines,
+                        last_newline);
+      }
+      SetErrorCode(JSONReader::JSON_INVALID_ESCAPE, p + 1);
+      return RESULT_ERROR;
+    }
+    switch (p[1]) {
+      case '"':
+      case '/':
+      case '\\':
+        decoded_.push_back(p[1]);
+        break;
+      case 'b':
+        decoded_.push_back('\b');
+        break;
+      case 'f':
+        decoded_.push_back('\f');
+        break;
+      case 'n':
+        decoded_.push_back('\n');
+        break;
+      case 'r':
+        decoded_.push_back('\r');
+        break;
+      case 't':
+        decoded_.push_back('\t');
+        break;
+      case 'v':
+        decoded_.push_back('\v');
+        break;
+
+      case 'x':
+        length = 4;
+        if (available < length && !at_end) {
+          return SaveScan(token, p, run, escaped, is_ascii, newlines,
+                          last_newline);
+        }
+        if (available < length || !ReadHexDigits(p + 2, 2, &code_point)) {
+          SetErrorCode(JSONReader::JSON_INVALID_ESCAPE, p + 1);
+          return RESULT_ERROR;
+        }
+        WriteUnicodeCharacter(code_point, &decoded_);
+        break;
+
+      case 'u': {
+        length = 6;
+        if (available < length && !at_end) {
+          return SaveScan(token, p, run, escaped, is_ascii, newlines,
+                          last_newline);
+        }
+        if (available < length || !ReadHexDigits(p + 2, 4, &code_point)) {
+          SetErrorCode(JSONReader::JSON_INVALID_ESCAPE, p + 1);
+          return RESULT_ERROR;
+        }
+        if (CBU16_IS_SURROGATE(code_point)) {
+          // Combine a surrogate pair; a lone surrogate can't be represented.
+          uint32 trail;
+          if (CBU16_IS_LEAD(code_point) && available < 12 && !at_end) {
+            return SaveScan(token, p, run, escaped, is_ascii, newlines,
+                            last_newline);
+          }
+          if (CBU16_IS_LEAD(code_point) && available >= 12 &&
+              p[6] == '\\' && p[7] == 'u' &&
+              ReadHexDigits(p + 8, 4, &trail) && CBU16_IS_TRAIL(trail)) {
+            code_point = CBU16_GET_SUPPLEMENTARY(code_point, trail);
+            length = 12;
+          } else {
+            code_point = 0xFFFD;
+          }
+        }
+        WriteUnicodeCharacter(code_point, &decoded_);
+        break;
+      }
+
+      default:
+        SetErrorCode(JSONReader::JSON_INVALID_ESCAPE, p + 1);
+        return RESULT_ERROR;
+    }
+    p += length;
+    run = p;
+  }
+
+  if (escaped) {
+    decoded_.append(run, p);
+    *value = decoded_;
+  } else {
+    value->set(begin, p - begin);
+  }
+
+  if (!is_ascii && !IsValidUTF8(*value)) {
+    // Like JSONReader, don't give a position for encoding errors.
+    error_code_ = JSONReader::JSON_UNSUPPORTED_ENCODING;
+    error_line_ = 0;
+    error_column_ = 0;
+    return RESULT_ERROR;
+  }
+
+  if (newlines)
+    AddLines(newlines, last_newline);
+  *pos = p + 1;
+  return RESULT_OK;
+}
+
+JSONStreamParser::Result JSONStreamParser::EatWhitespaceAndComments(
+    const char** pos, const char* end, bool at_end) {
+  const char* p = *pos;
+  while (p < end) {
+    switch (*p) {
+      case ' ':
+      case '\r':
+      case '\t':
+        ++p;
+        break;
+
+      case '\n':
+        AddLines(1, p);
+        ++p;
+        break;
+
+      case '/': {
+        // TODO(tc): This isn't in the RFC so it should be a parser flag.
+        if (end - p < 2 && !at_end) {
+          *pos = p;
+          return RESULT_INCOMPLETE;
+        }
+        if (end - p >= 2 && p[1] == '/') {
+          // Line comment, read until \n or \r.
+          const char* q = p + 2;
+          if (resume_.scanned) {
+            q = p + resume_.scanned;
+            resume_ = ScanState();
+          }
+          while (q < end && *q != '\n' && *q != '\r')
+            ++q;
+          if (q == end) {
+            if (!at_end) {
+              *pos = p;
+              return SaveScan(p, q, q, false, true, 0, NULL);
+            }
+            p = end;
+            break;
+          }
+          if (*q == '\n')
+            AddLines(1, q);
+          p = q + 1;
+        } else if (end - p >= 2 && p[1] == '*') {
+          // Block comment, read until */. Like JSONReader, an unterminated
+          // one runs to the end of the input.
+          const char* q = p + 2;
+          int newlines = 0;
+          const char* last_newline = NULL;
+          if (resume_.scanned) {
+            q = p + resume_.scanned;
+            newlines = resume_.newlines;
+            if (newlines)
+              last_newline = p + resume_.last_newline;
+            resume_ = ScanState();
+          }
+          const char* close = NULL;
+          for (; q + 1 < end; ++q) {
+            if (*q == '\n') {
+              ++newlines;
+              last_newline = q;
+            } else if (*q == '*' && q[1] == '/') {
+              close = q;
+              break;
+            }
+          }
+          if (!close) {
+            if (!at_end) {
+              *pos = p;
+              return SaveScan(p, q, q, false, true, newlines, last_newline);
+            }
+            p = end;
+            break;
+          }
+          if (newlines)
+            AddLines(newlines, last_newline);
+          p = close + 2;
+        } else {
+          // Not a comment; the token parser will reject it.
+          *pos = p;
+          return RESULT_OK;
+        }
+        break;
+      }
+
+      default:
+        *pos = p;
+        return RESULT_OK;
+    }
+  }
+  *pos = p;
+  return RESULT_OK;
+}
+
+JSONStreamParser::Result JSONStreamParser::SaveScan(const char* token,
+                                                    const char* p,
+                                                    const char* run,
+                                                    bool escaped,
+                                                    bool is_ascii,
+                                                    int newlines,
+                                                    const char* last_newline) {
+  resume_.scanned = p - token;
+  resume_.run = run - token;
+  resume_.escaped = escaped;
+  resume_.is_ascii = is_ascii;
+  resume_.newlines = newlines;
+  resume_.last_newline = newlines ? last_newline - token : 0;
+  return RESULT_INCOMPLETE;
+}
+
+void JSONStreamParser::CloseContainer() {
+  DCHECK(!stack_.empty());
+  char type = stack_.back();
+  stack_.pop_back();
+  if (type == '[')
+    delegate_->OnListEnd();
+  else
+    delegate_->OnDictionaryEnd();
+  state_ = StateAfterValue();
+}
+
+JSONStreamParser::State JSONStreamParser::StateAfterValue() const {
+  if (stack_.empty())
+    return STATE_DONE;
+  return stack_.back() == '[' ? STATE_ELEMENT_END : STATE_MEMBER_END;
+}
+
+void JSONStreamParser::AddLines(int count, const char* newline) {
+  line_ += count;
+  line_start_ = newline + 1;
+}
+
+void JSONStreamParser::SetErrorCode(JSONReader::JsonParseError error,
+                                    const char* pos) {
+  // Lines and columns are counted from 1, in characters rather than bytes.
+  int line = line_;
+  int column = line_start_ ? 0 : column_carry_;
+  const char* p = line_start_ ? line_start_ : buffer_begin_;
+  for (; p < pos; ++p) {
+    if (*p == '\n') {
+      ++line;
+      column = 0;
+    } else if ((*p & 0xC0) != 0x80) {
+      ++column;
+    }
+  }
+
+  error_code_ = error;
+  error_line_ = line + 1;
+  error_column_ = column + 1;
+}
+
+JSONValueBuilder::JSONValueBuilder() {
+}
+
+JSONValueBuilder::~JSONValueBuilder() {
+}
+
+Value* JSONValueBuilder::Release() {
+  stack_.clear();
+  return root_.release();
+}
+
+void JSONValueBuilder::OnNull() {
+  AddValue(Value::CreateNullValue());
+}
+
+void JSONValueBuilder::OnBoolean(bool value) {
+  AddValue(Value::CreateBooleanValue(value));
+}
+
+void JSONValueBuilder::OnInteger(int value) {
+  AddValue(Value::CreateIntegerValue(value));
+}
+
+void JSONValueBuilder::OnDouble(double value) {
+  AddValue(Value::CreateDoubleValue(value));
+}
+
+void JSONValueBuilder::OnString(const StringPiece& value) {
+  AddValue(Value::CreateStringValue(value.as_string()));
+}
+
+void JSONValueBuilder::OnListBegin() {
+  ListValue* list = new ListValue;
+  AddValue(list);
+  stack_.push_back(list);
+}
+
+void JSONValueBuilder::OnListEnd() {
+  DCHECK(!stack_.empty());
+  stack_.pop_back();
+}
+
+void JSONValueBuilder::OnDictionaryBegin() {
+  DictionaryValue* dictionary = new DictionaryValue;
+  AddValue(dictionary);
+  stack_.push_back(dictionary);
+}
+
+void JSONValueBuilder::OnDictionaryKey(const StringPiece& key) {
+  key_.assign(key.data(), key.size());
+}
+
+void JSONValueBuilder::OnDictionaryEnd() {
+  DCHECK(!stack_.empty());
+  stack_.pop_back();
+}
+
+void JSONValueBuilder::AddValue(Value* value) {
+  if (stack_.empty()) {
+    root_.reset(value);
+  } else if (stack_.back()->IsType(Value::TYPE_LIST)) {
+    static_cast<ListValue*>(stack_.back())->Append(value);
+  } else {
+    static_cast<DictionaryValue*>(stack_.back())->SetWithoutPathExpansion(
+        key_, value);
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,250 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A streaming (SAX-style) JSON parser. Rather than building a Value tree, it
+// reports what it finds to a Delegate as it goes, and the document can be fed
+// to it in chunks as they arrive, e.g. from disk or the network.
+//
+// The parser accepts the same input as JSONReader: UTF-8, optionally starting
+// with a byte order mark, with // and /* */ comments, the \x and \v escapes,
+// optional trailing commas, and at most 100 levels of nesting. Errors are
+// reported with the same codes and the same line and column conventions.
+//
+// Unlike JSONReader it works on the UTF-8 input directly. Strings without
+// escapes are handed to the delegate as StringPieces into the input and are
+// never copied; strings with escapes are decoded into a scratch buffer that
+// is reused for the whole document.
+//
+// Known deviations from JSONReader:
+// - Only strings are checked to be valid UTF-8; invalid bytes in comments are
+//   ignored.
+// - A \uXXXX surrogate pair is decoded as one character on all platforms.
+//
+// Usage:
+//   JSONValueBuilder builder;
+//   JSONStreamParser parser(&builder, true, false);
+//   while (ReadChunk(&chunk)) {
+//     if (!parser.Parse(chunk.data(), chunk.size()))
+//       break;
+//   }
+//   if (parser.Finish())
+//     root.reset(builder.Release());
+
+#ifndef BASE_JSON_JSON_STREAM_PARSER_H_
+#define BASE_JSON_JSON_STREAM_PARSER_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/string_piece.h"
+
+class Value;
+
+namespace base {
+
+class BASE_API JSONStreamParser {
+ public:
+  // Receives the contents of the document in order. Every value inside a
+  // dictionary is preceded by an OnDictionaryKey() call. StringPieces are only
+  // valid for the duration of the call.
+  class Delegate {
+   public:
+    virtual ~Delegate() {}
+
+    virtual void OnNull() = 0;
+    virtual void OnBoolean(bool value) = 0;
+    virtual void OnInteger(int value) = 0;
+    virtual void OnDouble(double value) = 0;
+    virtual void OnString(const StringPiece& value) = 0;
+    virtual void OnListBegin() = 0;
+    virtual void OnListEnd() = 0;
+    virtual void OnDictionaryBegin() = 0;
+    virtual void OnDictionaryKey(const StringPiece& key) = 0;
+    virtual void OnDictionaryEnd() = 0;
+  };
+
+  // If |check_root| is true the document must be a list or a dictionary, as
+  // JSONReader::Read() requires. |delegate| must outlive the parser.
+  JSONStreamParser(Delegate* delegate,
+                   bool check_root,
+                   bool allow_trailing_comma);
+  ~JSONStreamParser();
+
+  // Parses the next |length| bytes of the document. A token split across
+  // chunks is held back until the rest of it arrives; a string or comment is
+  // scanned only once however many chunks it spans. Returns false once the
+  // document is known to be invalid; error_code() then says why.
+  bool Parse(const char* data, size_t length);
+  bool Parse(const StringPiece& data) {
+    return Parse(data.data(), data.size());
+  }
+
+  // Signals the end of the document. Returns true if a complete root value
+  // and nothing else was found.
+  bool Finish();
+
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+  // Returns a message in the same format as JSONReader's.
+  std::string GetErrorMessage() const;
+
+ private:
+  enum State {
+    STATE_START,             // Nothing seen yet, not even a byte order mark.
+    STATE_ROOT,              // Expecting the root value.
+    STATE_VALUE,             // Expecting a value after ':' or ','.
+    STATE_FIRST_ELEMENT,     // After '[': a value or ']'.
+    STATE_ELEMENT_END,       // After a list element: ',' or ']'.
+    STATE_NEXT_ELEMENT,      // After ',' in a list: a value, or ']' if lenient.
+    STATE_FIRST_KEY,         // After '{': a key or '}'.
+    STATE_COLON,             // After a key.
+    STATE_MEMBER_END,        // After a dictionary value: ',' or '}'.
+    STATE_NEXT_KEY,          // After ',' in a dictionary: a key, or '}'.
+    STATE_DONE,              // The root value is complete.
+    STATE_ERROR,
+  };
+
+  // What became of an attempt to read a token.
+  enum Result {
+    RESULT_OK,
+    RESULT_INCOMPLETE,       // The token runs past the end of the chunk.
+    RESULT_ERROR,
+  };
+
+  // How far the scan of a string or comment that ran past the end of the
+  // chunk got, so that the next call resumes it there. Offsets are from the
+  // start of the token, which is where the next call starts parsing.
+  struct ScanState {
+    ScanState();
+
+    size_t scanned;       // 0 if there is nothing to resume.
+    size_t run;           // Strings: the first byte not yet in |decoded_|.
+    bool escaped;         // Strings: |decoded_| holds the string so far.
+    bool is_ascii;
+    int newlines;
+    size_t last_newline;  // Valid if |newlines| isn't 0.
+  };
+
+  // Parses [begin, end). Sets |*stop| to the start of the token running past
+  // |end|, or to |end| if there is none.
+  bool ParseBuffer(const char* begin, const char* end, bool at_end,
+                   const char** stop);
+
+  // Reads the token at |*pos| in the current state. Advances |*pos| past it on
+  // success.
+  Result ParseToken(const char** pos, const char* end, bool at_end);
+  Result ParseValue(const char** pos, const char* end, bool at_end);
+  Result ParseLiteral(const char** pos, const char* end, bool at_end,
+                      const char* literal, size_t length);
+  Result ParseNumber(const char** pos, const char* end, bool at_end);
+
+  // Reads the string starting at the quote at |*pos| into |*value|, which
+  // points either into the input or into |decoded_|.
+  Result ParseString(const char** pos, const char* end, bool at_end,
+                     StringPiece* value);
+
+  // Saves the scan of the string or comment at |token| in |resume_|, and
+  // returns RESULT_INCOMPLETE.
+  Result SaveScan(const char* token, const char* p, const char* run,
+                  bool escaped, bool is_ascii, int newlines,
+                  const char* last_newline);
+
+  // Skips whitespace and comments. Returns RESULT_INCOMPLETE, leaving |*pos|
+  // at the start of the comment, if a comment runs past |end|.
+  Result EatWhitespaceAndComments(const char** pos, const char* end,
+                                  bool at_end);
+
+  // Pops the innermost list or dictionary.
+  void CloseContainer();
+
+  // Returns the state that follows a complete value.
+  State StateAfterValue() const;
+
+  // Records that the lines ending at |newline|, the last of |count|, have
+  // been consumed.
+  void AddLines(int count, const char* newline);
+
+  void SetErrorCode(JSONReader::JsonParseError error, const char* pos);
+
+  Delegate* delegate_;
+  const bool check_root_;
+  const bool allow_trailing_comma_;
+
+  State state_;
+
+  // '[' or '{' for each open container.
+  std::vector<char> stack_;
+
+  // The unconsumed tail of the previous chunks: a token that runs past their
+  // end. The next chunk is appended to it and parsed in place, so that each
+  // byte is copied once however many chunks the token spans.
+  std::string pending_;
+
+  ScanState resume_;
+
+  // Scratch space for strings with escapes, and for numbers that aren't
+  // simple integers.
+  std::string decoded_;
+  std::string number_;
+
+  // Where the chunk being parsed starts, and where the current line started
+  // in it (NULL if it started in an earlier chunk). |column_carry_| counts
+  // the characters of the current line in earlier chunks.
+  const char* buffer_begin_;
+  const char* line_start_;
+  int line_;
+  int column_carry_;
+
+  JSONReader::JsonParseError error_code_;
+  int error_line_;
+  int error_column_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONStreamParser);
+};
+
+// A delegate that builds the same Value tree that JSONReader::Read() returns.
+class BASE_API JSONValueBuilder : public JSONStreamParser::Delegate {
+ public:
+  JSONValueBuilder();
+  virtual ~JSONValueBuilder();
+
+  // Returns the root value and passes ownership to the caller. Returns NULL if
+  // no root value was started.
+  Value* Release();
+
+  // JSONStreamParser::Delegate methods:
+  virtual void OnNull();
+  virtual void OnBoolean(bool value);
+  virtual void OnInteger(int value);
+  virtual void OnDouble(double value);
+  virtual void OnString(const StringPiece& value);
+  virtual void OnListBegin();
+  virtual void OnListEnd();
+  virtual void OnDictionaryBegin();
+  virtual void OnDictionaryKey(const StringPiece& key);
+  virtual void OnDictionaryEnd();
+
+ private:
+  // Adds |value| to the innermost open container, or makes it the root.
+  void AddValue(Value* value);
+
+  scoped_ptr<Value> root_;
+
+  // The open containers, innermost last. They are owned through |root_|.
+  std::vector<Value*> stack_;
+
+  // The key for the next value added to a dictionary.
+  std::string key_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONValueBuilder);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STREAM_PARSER_H_
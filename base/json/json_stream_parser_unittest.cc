@@ -0,0 +1,235 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "base/json/json_reader.h"
+#include "base/json/json_stream_parser.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Parses |json| in chunks of |chunk_size| bytes, or in two chunks split at
+// |split| if |chunk_size| is 0.
+Value* ParseInChunks(const std::string& json,
+                     size_t chunk_size,
+                     size_t split,
+                     bool check_root,
+                     bool allow_trailing_comma,
+                     std::string* error_message) {
+  JSONValueBuilder builder;
+  JSONStreamParser parser(&builder, check_root, allow_trailing_comma);
+  bool ok = true;
+  if (chunk_size == 0) {
+    ok = parser.Parse(json.data(), split) &&
+         parser.Parse(json.data() + split, json.size() - split);
+  } else {
+    for (size_t i = 0; ok && i < json.size(); i += chunk_size) {
+      ok = parser.Parse(json.data() + i,
+                        std::min(chunk_size, json.size() - i));
+    }
+  }
+  if (ok && parser.Finish())
+    return builder.Release();
+  *error_message = parser.GetErrorMessage();
+  return NULL;
+}
+
+// Checks that the stream parser agrees with JSONReader on |json| however the
+// document is split into chunks.
+void ExpectSameAsJSONReader(const std::string& json,
+                            bool check_root,
+                            bool allow_trailing_comma) {
+  SCOPED_TRACE(json);
+  JSONReader reader;
+  scoped_ptr<Value> expected(
+      reader.JsonToValue(json, check_root, allow_trailing_comma));
+  std::string expected_error = reader.GetErrorMessage();
+
+  for (size_t chunk_size = 0; chunk_size <= 3; ++chunk_size) {
+    size_t splits = chunk_size == 0 ? json.size() : 0;
+    for (size_t split = 0; split <= splits; ++split) {
+      SCOPED_TRACE(testing::Message() << "chunk size " << chunk_size
+                                      << ", split " << split);
+      std::string error;
+      scoped_ptr<Value> root(ParseInChunks(json, chunk_size, split,
+                                           check_root, allow_trailing_comma,
+                                           &error));
+      if (expected.get()) {
+        ASSERT_TRUE(root.get()) << error;
+        EXPECT_TRUE(expected->Equals(root.get()));
+      } else {
+        EXPECT_FALSE(root.get());
+        EXPECT_EQ(expected_error, error);
+      }
+    }
+  }
+}
+
+// Records whether strings were handed over in place.
+class StringDelegate : public JSONStreamParser::Delegate {
+ public:
+  StringDelegate(const char* begin, const char* end)
+      : begin_(begin), end_(end), strings_(0), strings_in_place_(0) {
+  }
+
+  virtual void OnNull() {}
+  virtual void OnBoolean(bool value) {}
+  virtual void OnInteger(int value) {}
+  virtual void OnDouble(double value) {}
+  virtual void OnString(const StringPiece& value) {
+    ++strings_;
+    if (value.data() >= begin_ && value.data() + value.size() <= end_)
+      ++strings_in_place_;
+    last_string_ = value.as_string();
+  }
+  virtual void OnListBegin() {}
+  virtual void OnListEnd() {}
+  virtual void OnDictionaryBegin() {}
+  virtual void OnDictionaryKey(const StringPiece& key) {}
+  virtual void OnDictionaryEnd() {}
+
+  int strings() const { return strings_; }
+  int strings_in_place() const { return strings_in_place_; }
+  const std::string& last_string() const { return last_string_; }
+
+ private:
+  const char* begin_;
+  const char* end_;
+  int strings_;
+  int strings_in_place_;
+  std::string last_string_;
+};
+
+}  // namespace
+
+TEST(JSONStreamParserTest, MatchesJSONReader) {
+  static const char* const kDocuments[] = {
+    "[]",
+    "{}",
+    "  [ 1, -2, 3.5, 1e3, -0, 0.25E-2, 2147483648, true, false, null ] ",
+    "{\"a\": {\"b\": [\"c\", {}]}, \"d\": \"\\u00e9\\n\\x41\\\\\\\"\\/\"}",
+    "/* comment */ [1, // line comment\n 2 /* another\n one */]\n// end",
+    "\xEF\xBB\xBF[\"bom\"]",
+    "[\"\xe7\xbd\x91\xe9\xa1\xb5\", \"\\u7f51\"]",
+    "{\"a\": 1, \"a\": 2}",
+    "[\"line\nbreak\", 1 2]",
+    "[\n0,\n1,\n2,\n3,4,5,6 7,\n8,\n9\n]",
+    "[\"\xe7\xbd\x91\" x]",
+    "{},{}",
+    "{foo:\"bar\"}",
+    "{\"a\" 1}",
+    "[nu]",
+    "[truex]",
+    "[\"xxx\\xq\"]",
+    "[\"xxx\\uq\"]",
+    "[\"xxx\\q\"]",
+    "[\"unterminated",
+    "[1",
+    "[1,",
+    "[01]",
+    "[1.]",
+    "[1e400]",
+    "[-]",
+    "[\"345\xb0\xa1\"]",
+    "42",
+    "",
+    "  ",
+    "[] /",
+    "[] /* unterminated",
+  };
+  for (size_t i = 0; i < arraysize(kDocuments); ++i) {
+    ExpectSameAsJSONReader(kDocuments[i], true, false);
+    ExpectSameAsJSONReader(kDocuments[i], false, false);
+  }
+
+  ExpectSameAsJSONReader("[1,]", true, false);
+  ExpectSameAsJSONReader("[1,]", true, true);
+  ExpectSameAsJSONReader("{\"foo\":\"bar\",}", true, false);
+  ExpectSameAsJSONReader("{\"foo\":\"bar\",}", true, true);
+  ExpectSameAsJSONReader("[[true], [], [false, [], [null, ]  , ], null,]",
+                         true, true);
+  ExpectSameAsJSONReader("\"root\"", false, false);
+  ExpectSameAsJSONReader(" 10 ", false, false);
+}
+
+TEST(JSONStreamParserTest, Nesting) {
+  for (int depth = 98; depth <= 101; ++depth) {
+    std::string nested_json(depth, '[');
+    nested_json.append(depth, ']');
+    ExpectSameAsJSONReader(nested_json, true, false);
+    nested_json.insert(depth, "1");
+    ExpectSameAsJSONReader(nested_json, true, false);
+  }
+}
+
+TEST(JSONStreamParserTest, ZeroCopyStrings) {
+  std::string json("[\"plain\", \"escaped\\n\", {\"key\": \"value\"}]");
+  StringDelegate delegate(json.data(), json.data() + json.size());
+  JSONStreamParser parser(&delegate, true, false);
+  ASSERT_TRUE(parser.Parse(json));
+  ASSERT_TRUE(parser.Finish());
+  EXPECT_EQ(3, delegate.strings());
+  EXPECT_EQ(2, delegate.strings_in_place());
+  EXPECT_EQ("value", delegate.last_string());
+}
+
+TEST(JSONStreamParserTest, SurrogatePairs) {
+  std::string json("[\"\\ud83d\\ude00\", \"\\ud83d\", \"\\ude00x\"]");
+  for (size_t split = 0; split <= json.size(); ++split) {
+    std::string error;
+    scoped_ptr<Value> root(ParseInChunks(json, 0, split, true, false, &error));
+    ASSERT_TRUE(root.get()) << error;
+    ListValue* list = static_cast<ListValue*>(root.get());
+    std::string value;
+    ASSERT_TRUE(list->GetString(0, &value));
+    EXPECT_EQ("\xF0\x9F\x98\x80", value);
+    ASSERT_TRUE(list->GetString(1, &value));
+    EXPECT_EQ("\xEF\xBF\xBD", value);
+    ASSERT_TRUE(list->GetString(2, &value));
+    EXPECT_EQ("\xEF\xBF\xBDx", value);
+  }
+}
+
+TEST(JSONStreamParserTest, LongTokensOneByteAtATime) {
+  // A string or comment that spans many chunks is scanned once, not once per
+  // chunk, so this doesn't take quadratic time.
+  std::string plain(1 << 20, 'a');
+  std::string escaped;
+  for (int i = 0; i < (1 << 16); ++i)
+    escaped.append("\\u00e9\xC3\xA9\\n");
+  std::string json = "// " + plain + "\n/* " + plain + "\n" + plain + " */[\"" +
+      plain + "\", \"" + escaped + "\"]";
+
+  JSONReader reader;
+  scoped_ptr<Value> expected(reader.JsonToValue(json, true, false));
+  ASSERT_TRUE(expected.get());
+  std::string error;
+  scoped_ptr<Value> root(ParseInChunks(json, 1, 0, true, false, &error));
+  ASSERT_TRUE(root.get()) << error;
+  EXPECT_TRUE(expected->Equals(root.get()));
+
+  // The lines and columns of the long tokens are still counted.
+  json.append(" x");
+  EXPECT_FALSE(reader.JsonToValue(json, true, false));
+  EXPECT_FALSE(ParseInChunks(json, 1, 0, true, false, &error));
+  EXPECT_EQ(reader.GetErrorMessage(), error);
+}
+
+TEST(JSONStreamParserTest, StopsAfterError) {
+  JSONValueBuilder builder;
+  JSONStreamParser parser(&builder, true, false);
+  EXPECT_FALSE(parser.Parse("[1 2"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, parser.error_code());
+  EXPECT_FALSE(parser.Parse("]"));
+  EXPECT_FALSE(parser.Finish());
+  EXPECT_EQ("Line: 1, column: 4, Syntax error.", parser.GetErrorMessage());
+}
+
+}  // namespace base
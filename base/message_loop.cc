@@ -12,12 +12,14 @@
 #include <algorithm>
 
 #include "base/compiler_specific.h"
+#include "base/debug/trace_recorder.h"
 #include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/message_pump_default.h"
 #include "base/metrics/histogram.h"
 #include "base/third_party/dynamic_annotations/dynamic_annotations.h"
 #include "base/threading/thread_local.h"
+#include "base/threading/thread_local_storage.h"
 
 #if defined(OS_MACOSX)
 #include "base/message_pump_mac.h"
@@ -107,6 +109,52 @@ static LPTOP_LEVEL_EXCEPTION_FILTER GetTopSEHFilter() {
 
 //------------------------------------------------------------------------------
 
+namespace {
+
+// The most IncomingTask nodes that a loop keeps for reuse.  A thread that runs
+// out of nodes takes all of them, so this also bounds each thread's cache.
+const size_t kMaxFreeIncomingTasks = 256;
+
+}  // namespace
+
+// Recycles the nodes of incoming_queue_, so that posting a task doesn't
+// allocate.  Each thread allocates from its own cache, and refills it from
+// the nodes freed by the loop it posts to, so no lock is shared between
+// loops.  The nodes cached by an exiting thread are deleted.
+class MessageLoop::IncomingTaskCache {
+ public:
+  IncomingTaskCache() : slot_(&OnThreadExit) {}
+
+  IncomingTask* Get() { return static_cast<IncomingTask*>(slot_.Get()); }
+  void Set(IncomingTask* first) { slot_.Set(first); }
+
+  // Deletes the NULL terminated list of nodes at |first|.
+  static void Delete(IncomingTask* first) {
+    while (first) {
+      IncomingTask* next = first->next;
+      delete first;
+      first = next;
+    }
+  }
+
+ private:
+  static void OnThreadExit(void* value) {
+    Delete(static_cast<IncomingTask*>(value));
+  }
+
+  base::ThreadLocalStorage::Slot slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncomingTaskCache);
+};
+
+// static
+base::LazyInstance<
+    MessageLoop::IncomingTaskCache,
+    base::LeakyLazyInstanceTraits<MessageLoop::IncomingTaskCache> >
+        MessageLoop::incoming_task_cache_(base::LINKER_INITIALIZED);
+
+//------------------------------------------------------------------------------
+
 MessageLoop::TaskObserver::TaskObserver() {
 }
 
@@ -123,11 +171,13 @@ MessageLoop::MessageLoop(Type type)
       nestable_tasks_allowed_(true),
       exception_restoration_(false),
       message_histogram_(NULL),
-      state_(NULL),
+      incoming_queue_(0),
+      free_incoming_tasks_(0),
+      free_incoming_task_count_(0),
+      state_(NULL) {
 #ifdef OS_WIN
-      os_modal_loop_(false),
+  os_modal_loop_ = false;
 #endif  // OS_WIN
-      next_sequence_num_(0) {
   DCHECK(!current()) << "should only have one message loop per thread";
   lazy_tls_ptr.Pointer()->Set(this);
 
@@ -137,13 +187,13 @@ MessageLoop::MessageLoop(Type type)
 #define MESSAGE_PUMP_IO new base::MessagePumpForIO()
 #elif defined(OS_MACOSX)
 #define MESSAGE_PUMP_UI base::MessagePumpMac::Create()
-#define MESSAGE_PUMP_IO new base::MessagePumpLibevent()
+#define MESSAGE_PUMP_IO new base::MessagePumpForIO()
 #elif defined(ANDROID)
 #define MESSAGE_PUMP_UI new base::MessagePumpDefault()
-#define MESSAGE_PUMP_IO new base::MessagePumpLibevent()
+#define MESSAGE_PUMP_IO new base::MessagePumpForIO()
 #elif defined(TOUCH_UI)
 #define MESSAGE_PUMP_UI new base::MessagePumpGlibX()
-#define MESSAGE_PUMP_IO new base::MessagePumpLibevent()
+#define MESSAGE_PUMP_IO new base::MessagePumpForIO()
 #elif defined(OS_NACL)
 // Currently NaCl doesn't have a UI or an IO MessageLoop.
 // TODO(abarth): Figure out if we need these.
@@ -151,7 +201,7 @@ MessageLoop::MessageLoop(Type type)
 #define MESSAGE_PUMP_IO NULL
 #elif defined(OS_POSIX)  // POSIX but not MACOSX.
 #define MESSAGE_PUMP_UI new base::MessagePumpForUI()
-#define MESSAGE_PUMP_IO new base::MessagePumpLibevent()
+#define MESSAGE_PUMP_IO new base::MessagePumpForIO()
 #else
 #error Not implemented
 #endif
@@ -188,6 +238,9 @@ MessageLoop::~MessageLoop() {
   }
   DCHECK(!did_work);
 
+  IncomingTaskCache::Delete(reinterpret_cast<IncomingTask*>(
+      base::subtle::NoBarrier_Load(&free_incoming_tasks_)));
+
   // Let interested parties have one last shot at accessing this.
   FOR_EACH_OBSERVER(DestructionObserver, destruction_observers_,
                     WillDestroyCurrentMessageLoop());
@@ -241,6 +294,39 @@ void MessageLoop::PostNonNestableDelayedTask(
   PostTask_Helper(from_here, task, delay_ms, false);
 }
 
+MessageLoop::DelayedTaskId MessageLoop::PostCancelableDelayedTask(
+    const tracked_objects::Location& from_here, Task* task, int64 delay_ms,
+    int64 slack_ms) {
+  DCHECK_EQ(this, current());
+  DCHECK_GE(slack_ms, 0);
+  task->SetBirthPlace(from_here);
+
+  // The task goes straight to the delayed work queue, where it can be found
+  // to cancel it.  That doesn't starve other threads' tasks, since it is only
+  // run when due, from DoDelayedWork().
+  TimeTicks run_time =
+      delay_ms > 0 ? CalculateDelayedRunTime(delay_ms) : TimeTicks::Now();
+  PendingTask pending_task(task, true);
+  pending_task.delayed_run_time = base::TimerWheelBase::CoalesceRunTime(
+      run_time, TimeDelta::FromMilliseconds(slack_ms));
+  DelayedTaskId id = AddToDelayedWorkQueue(pending_task);
+  // If we changed the topmost task, then it is time to re-schedule.
+  if (delayed_work_queue_.top().task == task)
+    pump_->ScheduleDelayedWork(pending_task.delayed_run_time);
+  return id;
+}
+
+bool MessageLoop::CancelDelayedTask(DelayedTaskId id) {
+  DCHECK_EQ(this, current());
+  PendingTask pending_task(NULL, true);
+  if (!delayed_work_queue_.Cancel(id, &pending_task))
+    return false;
+  // The wake-up scheduled for the task, if any, is left alone: when it comes
+  // DoDelayedWork() finds nothing due, and schedules the next one.
+  delete pending_task.task;
+  return true;
+}
+
 void MessageLoop::Run() {
   AutoRunState save_state(this);
   RunHandler();
@@ -299,9 +385,9 @@ void MessageLoop::RemoveTaskObserver(TaskObserver* task_observer) {
 }
 
 void MessageLoop::AssertIdle() const {
-  // We only check |incoming_queue_|, since we don't want to lock |work_queue_|.
-  base::AutoLock lock(incoming_queue_lock_);
-  DCHECK(incoming_queue_.empty());
+  // We only check |incoming_queue_|, since |work_queue_| belongs to the loop's
+  // thread.
+  DCHECK(!base::subtle::NoBarrier_Load(&incoming_queue_));
 }
 
 //------------------------------------------------------------------------------
@@ -371,11 +457,14 @@ void MessageLoop::RunTask(Task* task) {
   nestable_tasks_allowed_ = false;
 
   HistogramEvent(kTaskRunEvent);
-  FOR_EACH_OBSERVER(TaskObserver, task_observers_,
-                    WillProcessTask(task));
-  task->Run();
-  FOR_EACH_OBSERVER(TaskObserver, task_observers_, DidProcessTask(task));
-  delete task;
+  {
+    TRACE_RECORD_SCOPED("task", "MessageLoop::RunTask");
+    FOR_EACH_OBSERVER(TaskObserver, task_observers_,
+                      WillProcessTask(task));
+    task->Run();
+    FOR_EACH_OBSERVER(TaskObserver, task_observers_, DidProcessTask(task));
+    delete task;
+  }
 
   nestable_tasks_allowed_ = true;
 }
@@ -394,32 +483,102 @@ bool MessageLoop::DeferOrRunPendingTask(const PendingTask& pending_task) {
   return false;
 }
 
-void MessageLoop::AddToDelayedWorkQueue(const PendingTask& pending_task) {
-  // Move to the delayed work queue.  Initialize the sequence number
-  // before inserting into the delayed_work_queue_.  The sequence number
-  // is used to faciliate FIFO sorting when two tasks have the same
-  // delayed_run_time value.
-  PendingTask new_pending_task(pending_task);
-  new_pending_task.sequence_num = next_sequence_num_++;
-  delayed_work_queue_.push(new_pending_task);
+MessageLoop::DelayedTaskId MessageLoop::AddToDelayedWorkQueue(
+    const PendingTask& pending_task) {
+  // Move to the delayed work queue, which keeps tasks with the same
+  // delayed_run_time value in FIFO order.
+  return delayed_work_queue_.Add(pending_task.delayed_run_time, pending_task);
 }
 
 void MessageLoop::ReloadWorkQueue() {
   // We can improve performance of our loading tasks from incoming_queue_ to
   // work_queue_ by waiting until the last minute (work_queue_ is empty) to
-  // load.  That reduces the number of locks-per-task significantly when our
-  // queues get large.
+  // load.  That reduces the number of atomic operations per task
+  // significantly when our queues get large.
   if (!work_queue_.empty())
-    return;  // Wait till we *really* need to lock and load.
+    return;  // Wait till we *really* need to load.
+
+  // Acquire all we can from the inter-thread queue with one compare-and-swap.
+  base::subtle::AtomicWord head =
+      base::subtle::NoBarrier_Load(&incoming_queue_);
+  while (head) {
+    base::subtle::AtomicWord previous =
+        base::subtle::Acquire_CompareAndSwap(&incoming_queue_, head, 0);
+    if (previous == head)
+      break;
+    head = previous;
+  }
+  if (!head)
+    return;
 
-  // Acquire all we can from the inter-thread queue with one lock acquisition.
-  {
-    base::AutoLock lock(incoming_queue_lock_);
-    if (incoming_queue_.empty())
+  // The list is most recently posted first: reverse it to run the tasks in
+  // the order they were posted.
+  IncomingTask* last = reinterpret_cast<IncomingTask*>(head);
+  IncomingTask* first = NULL;
+  for (IncomingTask* node = last; node;) {
+    IncomingTask* next = node->next;
+    node->next = first;
+    first = node;
+    node = next;
+  }
+  size_t count = 0;
+  for (IncomingTask* node = first; node; node = node->next) {
+    work_queue_.push(node->pending_task);
+    ++count;
+  }
+  FreeIncomingTasks(first, last, count);
+}
+
+MessageLoop::IncomingTask* MessageLoop::AllocateIncomingTask() {
+  IncomingTaskCache* cache = incoming_task_cache_.Pointer();
+  IncomingTask* node = cache->Get();
+  if (!node) {
+    // Take all the nodes this loop has freed.  Popping a single node could
+    // see it popped, reused and pushed again by another thread in between
+    // (the ABA problem), but taking the whole list can't.
+    base::subtle::AtomicWord head =
+        base::subtle::NoBarrier_Load(&free_incoming_tasks_);
+    while (head) {
+      base::subtle::AtomicWord previous =
+          base::subtle::Acquire_CompareAndSwap(&free_incoming_tasks_, head, 0);
+      if (previous == head)
+        break;
+      head = previous;
+    }
+    node = reinterpret_cast<IncomingTask*>(head);
+    if (!node)
+      return new IncomingTask;
+  }
+  cache->Set(node->next);
+  node->next = NULL;
+  return node;
+}
+
+void MessageLoop::FreeIncomingTasks(IncomingTask* first, IncomingTask* last,
+                                    size_t count) {
+  // Only this thread pushes onto free_incoming_tasks_, so if it isn't empty,
+  // it still holds all the free_incoming_task_count_ nodes pushed since it
+  // was last taken, and the compare-and-swap only fails if a posting thread
+  // takes them.
+  base::subtle::AtomicWord head =
+      base::subtle::NoBarrier_Load(&free_incoming_tasks_);
+  for (;;) {
+    if (!head)
+      free_incoming_task_count_ = 0;
+    if (free_incoming_task_count_ + count > kMaxFreeIncomingTasks) {
+      // Don't keep the nodes of a burst of tasks for the life of the loop.
+      IncomingTaskCache::Delete(first);
       return;
-    incoming_queue_.Swap(&work_queue_);  // Constant time
-    DCHECK(incoming_queue_.empty());
+    }
+    last->next = reinterpret_cast<IncomingTask*>(head);
+    base::subtle::AtomicWord previous = base::subtle::Release_CompareAndSwap(
+        &free_incoming_tasks_, head,
+        reinterpret_cast<base::subtle::AtomicWord>(first));
+    if (previous == head)
+      break;
+    head = previous;
   }
+  free_incoming_task_count_ += count;
 }
 
 bool MessageLoop::DeletePendingTasks() {
@@ -462,22 +621,17 @@ bool MessageLoop::DeletePendingTasks() {
   did_work |= !delayed_work_queue_.empty();
   while (!delayed_work_queue_.empty()) {
     Task* task = delayed_work_queue_.top().task;
-    delayed_work_queue_.pop();
+    delayed_work_queue_.Pop();
     delete task;
   }
   return did_work;
 }
 
 // Possibly called on a background thread!
-void MessageLoop::PostTask_Helper(
-    const tracked_objects::Location& from_here, Task* task, int64 delay_ms,
-    bool nestable) {
-  task->SetBirthPlace(from_here);
-
-  PendingTask pending_task(task, nestable);
-
+TimeTicks MessageLoop::CalculateDelayedRunTime(int64 delay_ms) {
+  TimeTicks delayed_run_time;
   if (delay_ms > 0) {
-    pending_task.delayed_run_time =
+    delayed_run_time =
         TimeTicks::Now() + TimeDelta::FromMilliseconds(delay_ms);
 
 #if defined(OS_WIN)
@@ -509,25 +663,43 @@ void MessageLoop::PostTask_Helper(
   }
 #endif
 
+  return delayed_run_time;
+}
+
+// Possibly called on a background thread!
+void MessageLoop::PostTask_Helper(
+    const tracked_objects::Location& from_here, Task* task, int64 delay_ms,
+    bool nestable) {
+  task->SetBirthPlace(from_here);
+
+  PendingTask pending_task(task, nestable);
+  pending_task.delayed_run_time = CalculateDelayedRunTime(delay_ms);
+
   // Warning: Don't try to short-circuit, and handle this thread's tasks more
   // directly, as it could starve handling of foreign threads.  Put every task
   // into this queue.
 
-  scoped_refptr<base::MessagePump> pump;
-  {
-    base::AutoLock locked(incoming_queue_lock_);
-
-    bool was_empty = incoming_queue_.empty();
-    incoming_queue_.push(pending_task);
-    if (!was_empty)
-      return;  // Someone else should have started the sub-pump.
-
-    pump = pump_;
-  }
   // Since the incoming_queue_ may contain a task that destroys this message
-  // loop, we cannot exit incoming_queue_lock_ until we are done with |this|.
-  // We use a stack-based reference to the message pump so that we can call
-  // ScheduleWork outside of incoming_queue_lock_.
+  // loop, we cannot touch |this| once the task is pushed.  We use a
+  // stack-based reference to the message pump so that we can call
+  // ScheduleWork after the push.
+  scoped_refptr<base::MessagePump> pump = pump_;
+
+  IncomingTask* node = AllocateIncomingTask();
+  node->pending_task = pending_task;
+  base::subtle::AtomicWord head =
+      base::subtle::NoBarrier_Load(&incoming_queue_);
+  for (;;) {
+    node->next = reinterpret_cast<IncomingTask*>(head);
+    base::subtle::AtomicWord previous = base::subtle::Release_CompareAndSwap(
+        &incoming_queue_, head,
+        reinterpret_cast<base::subtle::AtomicWord>(node));
+    if (previous == head)
+      break;
+    head = previous;
+  }
+  if (head)
+    return;  // Someone else should have started the sub-pump.
 
   pump->ScheduleWork();
 }
@@ -598,7 +770,7 @@ bool MessageLoop::DoDelayedWork(base::TimeTicks* next_delayed_work_time) {
   // fall behind (and have a lot of ready-to-run delayed tasks), the more
   // efficient we'll be at handling the tasks.
 
-  TimeTicks next_run_time = delayed_work_queue_.top().delayed_run_time;
+  TimeTicks next_run_time = delayed_work_queue_.top_run_time();
   if (next_run_time > recent_time_) {
     recent_time_ = TimeTicks::Now();  // Get a better view of Now();
     if (next_run_time > recent_time_) {
@@ -608,10 +780,10 @@ bool MessageLoop::DoDelayedWork(base::TimeTicks* next_delayed_work_time) {
   }
 
   PendingTask pending_task = delayed_work_queue_.top();
-  delayed_work_queue_.pop();
+  delayed_work_queue_.Pop();
 
   if (!delayed_work_queue_.empty())
-    *next_delayed_work_time = delayed_work_queue_.top().delayed_run_time;
+    *next_delayed_work_time = delayed_work_queue_.top_run_time();
 
   return DeferOrRunPendingTask(pending_task);
 }
@@ -650,25 +822,6 @@ MessageLoop::AutoRunState::~AutoRunState() {
   loop_->state_ = previous_state_;
 }
 
-//------------------------------------------------------------------------------
-// MessageLoop::PendingTask
-
-bool MessageLoop::PendingTask::operator<(const PendingTask& other) const {
-  // Since the top of a priority queue is defined as the "greatest" element, we
-  // need to invert the comparison here.  We want the smaller time to be at the
-  // top of the heap.
-
-  if (delayed_run_time < other.delayed_run_time)
-    return false;
-
-  if (delayed_run_time > other.delayed_run_time)
-    return true;
-
-  // If the times happen to match, then we use the sequence number to decide.
-  // Compare the difference to support integer roll-over.
-  return (sequence_num - other.sequence_num) > 0;
-}
-
 //------------------------------------------------------------------------------
 // MessageLoopForUI
 
@@ -720,7 +873,7 @@ bool MessageLoopForIO::WatchFileDescriptor(int fd,
                                            Mode mode,
                                            FileDescriptorWatcher *controller,
                                            Watcher *delegate) {
-  return pump_libevent()->WatchFileDescriptor(
+  return pump_io()->WatchFileDescriptor(
       fd,
       persistent,
       static_cast<base::MessagePumpLibevent::Mode>(mode),
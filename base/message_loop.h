@@ -9,13 +9,16 @@
 #include <queue>
 #include <string>
 
+#include "base/atomicops.h"
 #include "base/base_api.h"
 #include "base/basictypes.h"
+#include "base/lazy_instance.h"
 #include "base/memory/ref_counted.h"
 #include "base/message_pump.h"
 #include "base/observer_list.h"
 #include "base/synchronization/lock.h"
 #include "base/task.h"
+#include "base/timer_wheel.h"
 
 #if defined(OS_WIN)
 // We need this to declare base::MessagePumpWin::Dispatcher, which we should
@@ -23,6 +26,9 @@
 #include "base/message_pump_win.h"
 #elif defined(OS_POSIX)
 #include "base/message_pump_libevent.h"
+#if defined(USE_EPOLL_MESSAGE_PUMP)
+#include "base/message_pump_epoll.h"
+#endif
 #if !defined(OS_MACOSX)
 #include "base/message_pump_glib.h"
 typedef struct _XDisplay Display;
@@ -34,6 +40,15 @@ typedef struct _XDisplay Display;
 
 namespace base {
 class Histogram;
+
+#if defined(OS_POSIX)
+// The pump of TYPE_IO message loops.
+#if defined(USE_EPOLL_MESSAGE_PUMP)
+typedef MessagePumpEpoll MessagePumpForIO;
+#else
+typedef MessagePumpLibevent MessagePumpForIO;
+#endif
+#endif
 }
 
 // A MessageLoop is used to process events for a particular thread.  There is
@@ -163,6 +178,24 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   void PostNonNestableDelayedTask(
       const tracked_objects::Location& from_here, Task* task, int64 delay_ms);
 
+  // Identifies a task posted with PostCancelableDelayedTask().
+  typedef base::TimerWheelBase::Id DelayedTaskId;
+
+  // Like PostDelayedTask, but the task can be cancelled until it runs, and
+  // it may run up to |slack_ms| late so that delayed tasks due at about the
+  // same time run together, and wake the thread once.  See
+  // base::TimerWheelBase::CoalesceRunTime().
+  //
+  // NOTE: Unlike the methods above, this method and CancelDelayedTask() must
+  // be called on the thread that executes MessageLoop::Run().
+  DelayedTaskId PostCancelableDelayedTask(
+      const tracked_objects::Location& from_here, Task* task, int64 delay_ms,
+      int64 slack_ms);
+
+  // Deletes a task posted with PostCancelableDelayedTask() without running
+  // it.  Returns false if the task has already run or been cancelled.
+  bool CancelDelayedTask(DelayedTaskId id);
+
   // A variant on PostTask that deletes the given object.  This is useful
   // if the object needs to live until the next run of the MessageLoop (for
   // example, deleting a RenderProcessHost from within an IPC callback is not
@@ -357,15 +390,11 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   // This structure is copied around by value.
   struct PendingTask {
     PendingTask(Task* task, bool nestable)
-        : task(task), sequence_num(0), nestable(nestable) {
+        : task(task), nestable(nestable) {
     }
 
-    // Used to support sorting.
-    bool operator<(const PendingTask& other) const;
-
     Task* task;                        // The task to run.
     base::TimeTicks delayed_run_time;  // The time when the task should be run.
-    int sequence_num;                  // Secondary sort key for run time.
     bool nestable;                     // OK to dispatch from a nested loop.
   };
 
@@ -376,16 +405,25 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
     }
   };
 
-  typedef std::priority_queue<PendingTask> DelayedTaskQueue;
+  // Delayed tasks due at the same time run in the order they were added.
+  typedef base::TimerWheel<PendingTask> DelayedTaskQueue;
+
+  // A node of incoming_queue_.
+  struct IncomingTask {
+    IncomingTask() : pending_task(NULL, true), next(NULL) {}
+
+    PendingTask pending_task;
+    IncomingTask* next;
+  };
+
+  // The IncomingTask nodes that the current thread allocates from.  Defined
+  // in message_loop.cc.
+  class IncomingTaskCache;
 
 #if defined(OS_WIN)
   base::MessagePumpWin* pump_win() {
     return static_cast<base::MessagePumpWin*>(pump_.get());
   }
-#elif defined(OS_POSIX)
-  base::MessagePumpLibevent* pump_libevent() {
-    return static_cast<base::MessagePumpLibevent*>(pump_.get());
-  }
 #endif
 
   // A function to encapsulate all the exception handling capability in the
@@ -413,19 +451,31 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   // cannot be run right now.  Returns true if the task was run.
   bool DeferOrRunPendingTask(const PendingTask& pending_task);
 
-  // Adds the pending task to delayed_work_queue_.
-  void AddToDelayedWorkQueue(const PendingTask& pending_task);
+  // Adds the pending task to delayed_work_queue_, and returns its id there.
+  DelayedTaskId AddToDelayedWorkQueue(const PendingTask& pending_task);
 
   // Load tasks from the incoming_queue_ into work_queue_ if the latter is
-  // empty.  The former requires a lock to access, while the latter is directly
-  // accessible on this thread.
+  // empty.  The former is shared with posting threads, while the latter is
+  // directly accessible on this thread.
   void ReloadWorkQueue();
 
+  // Returns a node for a task posted to this loop, from the current thread's
+  // cache if it has one, or else from the nodes this loop has freed.
+  IncomingTask* AllocateIncomingTask();
+
+  // Gives the |count| nodes from |first| to |last| that ReloadWorkQueue() has
+  // emptied back to free_incoming_tasks_.  Only called on this loop's thread.
+  void FreeIncomingTasks(IncomingTask* first, IncomingTask* last,
+                         size_t count);
+
   // Delete tasks that haven't run yet without running them.  Used in the
   // destructor to make sure all the task's destructors get called.  Returns
   // true if some work was done.
   bool DeletePendingTasks();
 
+  // Returns the time a task posted with |delay_ms| should run at.
+  base::TimeTicks CalculateDelayedRunTime(int64 delay_ms);
+
   // Post a task to our incomming queue.
   void PostTask_Helper(const tracked_objects::Location& from_here, Task* task,
                        int64 delay_ms, bool nestable);
@@ -475,13 +525,25 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   // A profiling histogram showing the counts of various messages and events.
   base::Histogram* message_histogram_;
 
-  // A null terminated list which creates an incoming_queue of tasks that are
-  // acquired under a mutex for processing on this instance's thread. These
-  // tasks have not yet been sorted out into items for our work_queue_ vs
-  // items that will be handled by the TimerManager.
-  TaskQueue incoming_queue_;
-  // Protect access to incoming_queue_.
-  mutable base::Lock incoming_queue_lock_;
+  // A null terminated list of IncomingTask, most recently posted first, of
+  // tasks that have not yet been sorted out into items for our work_queue_ vs
+  // items that will be handled by the TimerManager.  Posting threads push
+  // onto it with a compare-and-swap, and this thread takes the whole list at
+  // once, so no lock is needed.
+  base::subtle::AtomicWord incoming_queue_;
+
+  // A null terminated list of the IncomingTask nodes that this loop has
+  // emptied, for threads that post to it to reuse.  Only this thread pushes
+  // onto it, and a posting thread takes the whole list at once, so no lock
+  // is needed and a node can't be popped twice.  free_incoming_task_count_ is
+  // the length of the list when it is not empty, and is only used on this
+  // thread.
+  base::subtle::AtomicWord free_incoming_tasks_;
+  size_t free_incoming_task_count_;
+
+  static base::LazyInstance<IncomingTaskCache,
+                            base::LeakyLazyInstanceTraits<IncomingTaskCache> >
+      incoming_task_cache_;
 
   RunState* state_;
 
@@ -492,9 +554,6 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   bool os_modal_loop_;
 #endif
 
-  // The next sequence number to use for delayed tasks.
-  int next_sequence_num_;
-
   ObserverList<TaskObserver> task_observers_;
 
  private:
@@ -576,10 +635,9 @@ class BASE_API MessageLoopForIO : public MessageLoop {
   typedef base::MessagePumpForIO::IOContext IOContext;
   typedef base::MessagePumpForIO::IOObserver IOObserver;
 #elif defined(OS_POSIX)
-  typedef base::MessagePumpLibevent::Watcher Watcher;
-  typedef base::MessagePumpLibevent::FileDescriptorWatcher
-      FileDescriptorWatcher;
-  typedef base::MessagePumpLibevent::IOObserver IOObserver;
+  typedef base::MessagePumpForIO::Watcher Watcher;
+  typedef base::MessagePumpForIO::FileDescriptorWatcher FileDescriptorWatcher;
+  typedef base::MessagePumpForIO::IOObserver IOObserver;
 
   enum Mode {
     WATCH_READ = base::MessagePumpLibevent::WATCH_READ,
@@ -624,7 +682,8 @@ class BASE_API MessageLoopForIO : public MessageLoop {
   }
 
 #elif defined(OS_POSIX)
-  // Please see MessagePumpLibevent for definition.
+  // Please see MessagePumpLibevent for definition.  The pump is
+  // MessagePumpEpoll instead when USE_EPOLL_MESSAGE_PUMP is defined.
   bool WatchFileDescriptor(int fd,
                            bool persistent,
                            Mode mode,
@@ -632,8 +691,8 @@ class BASE_API MessageLoopForIO : public MessageLoop {
                            Watcher *delegate);
 
  private:
-  base::MessagePumpLibevent* pump_io() {
-    return static_cast<base::MessagePumpLibevent*>(pump_.get());
+  base::MessagePumpForIO* pump_io() {
+    return static_cast<base::MessagePumpForIO*>(pump_.get());
   }
 #endif  // defined(OS_POSIX)
 };
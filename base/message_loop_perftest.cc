@@ -0,0 +1,107 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stl_util-inl.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kPostsPerProducer = 100000;
+
+// Counts the tasks run on the consumer thread, and signals |done| after the
+// last one.
+class CountTask : public Task {
+ public:
+  CountTask(int* count, int total, WaitableEvent* done)
+      : count_(count),
+        total_(total),
+        done_(done) {
+  }
+
+  virtual void Run() {
+    if (++*count_ == total_)
+      done_->Signal();
+  }
+
+ private:
+  int* count_;
+  int total_;
+  WaitableEvent* done_;
+};
+
+class PostDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  PostDelegate(MessageLoop* loop, int* count, int total, WaitableEvent* done)
+      : loop_(loop),
+        count_(count),
+        total_(total),
+        done_(done) {
+  }
+
+  virtual void Run() {
+    for (int i = 0; i < kPostsPerProducer; ++i)
+      loop_->PostTask(FROM_HERE, new CountTask(count_, total_, done_));
+  }
+
+ private:
+  MessageLoop* loop_;
+  int* count_;
+  int total_;
+  WaitableEvent* done_;
+};
+
+}  // namespace
+
+// Measures posting tasks to an IO loop from 1 to 8 threads at once.
+TEST(MessageLoopPerfTest, PostTaskProducers) {
+  const int kProducerCounts[] = { 1, 2, 4, 8 };
+  for (size_t i = 0; i < arraysize(kProducerCounts); ++i) {
+    int producers = kProducerCounts[i];
+    Thread consumer("consumer");
+    ASSERT_TRUE(consumer.StartWithOptions(
+        Thread::Options(MessageLoop::TYPE_IO, 0)));
+
+    int count = 0;
+    int total = producers * kPostsPerProducer;
+    WaitableEvent done(false, false);
+    std::vector<PostDelegate*> delegates;
+    std::vector<DelegateSimpleThread*> threads;
+    PerfTimer timer;
+    for (int j = 0; j < producers; ++j) {
+      delegates.push_back(new PostDelegate(consumer.message_loop(), &count,
+                                           total, &done));
+      threads.push_back(new DelegateSimpleThread(delegates.back(), "post"));
+      threads.back()->Start();
+    }
+    for (int j = 0; j < producers; ++j)
+      threads[j]->Join();
+    double post_seconds = timer.Elapsed().InSecondsF();
+    done.Wait();
+    double run_seconds = timer.Elapsed().InSecondsF();
+    STLDeleteElements(&threads);
+    STLDeleteElements(&delegates);
+    consumer.Stop();
+    EXPECT_EQ(total, count);
+
+    LogPerfResult(
+        StringPrintf("MessageLoop_PostTask_%d_producers", producers).c_str(),
+        total / post_seconds / 1000, "kposts/s");
+    LogPerfResult(
+        StringPrintf("MessageLoop_RunTask_%d_producers", producers).c_str(),
+        total / run_seconds / 1000, "ktasks/s");
+  }
+}
+
+}  // namespace base
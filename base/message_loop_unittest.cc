@@ -8,6 +8,7 @@
 #include "base/logging.h"
 #include "base/memory/ref_counted.h"
 #include "base/message_loop.h"
+#include "base/stl_util-inl.h"
 #include "base/task.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread.h"
@@ -156,6 +157,69 @@ void RunTest_PostTask_SEH(MessageLoop::Type message_loop_type) {
   EXPECT_EQ(foo->result(), "abacad");
 }
 
+// This class records the order in which the tasks of each posting thread run,
+// and quits the loop after the last task.
+class SequenceTask : public Task {
+ public:
+  SequenceTask(std::vector<std::vector<int> >* sequences, int thread,
+               int sequence, int* quit_counter)
+      : sequences_(sequences), thread_(thread), sequence_(sequence),
+        quit_counter_(quit_counter) {
+  }
+  virtual void Run() {
+    (*sequences_)[thread_].push_back(sequence_);
+    if (--(*quit_counter_) == 0)
+      MessageLoop::current()->Quit();
+  }
+ private:
+  std::vector<std::vector<int> >* sequences_;
+  int thread_;
+  int sequence_;
+  int* quit_counter_;
+};
+
+void PostSequenceTasks(MessageLoop* loop,
+                       std::vector<std::vector<int> >* sequences,
+                       int thread,
+                       int count,
+                       int* quit_counter) {
+  for (int i = 0; i < count; ++i) {
+    loop->PostTask(FROM_HERE,
+                   new SequenceTask(sequences, thread, i, quit_counter));
+  }
+}
+
+void RunTest_PostTask_ManyThreads(MessageLoop::Type message_loop_type) {
+  MessageLoop loop(message_loop_type);
+
+  // Several threads post at once, many more tasks than the node pool keeps.
+  const int kThreads = 4;
+  const int kTasks = 20000;
+  std::vector<std::vector<int> > sequences(kThreads);
+  int quit_counter = kThreads * kTasks;
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(new Thread("Posting thread"));
+    ASSERT_TRUE(threads.back()->Start());
+  }
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i]->message_loop()->PostTask(FROM_HERE, NewRunnableFunction(
+        &PostSequenceTasks, &loop, &sequences, i, kTasks, &quit_counter));
+  }
+
+  MessageLoop::current()->Run();
+  STLDeleteElements(&threads);
+
+  // No task was lost, and each thread's tasks ran in the order it posted
+  // them.
+  EXPECT_EQ(0, quit_counter);
+  for (int i = 0; i < kThreads; ++i) {
+    ASSERT_EQ(static_cast<size_t>(kTasks), sequences[i].size());
+    for (int j = 0; j < kTasks; ++j)
+      ASSERT_EQ(j, sequences[i][j]);
+  }
+}
+
 // This class runs slowly to simulate a large amount of work being done.
 class SlowTask : public Task {
  public:
@@ -457,6 +521,30 @@ void RunTest_EnsureTaskDeletion_Chain(MessageLoop::Type message_loop_type) {
   EXPECT_TRUE(c_was_deleted);
 }
 
+void RunTest_PostCancelableDelayedTask(MessageLoop::Type message_loop_type) {
+  MessageLoop loop(message_loop_type);
+
+  // Test that a cancelled task is deleted right away without running, and
+  // that the other tasks still run.
+
+  int num_tasks = 1;
+  Time run_time;
+  bool was_deleted = false;
+
+  MessageLoop::DelayedTaskId cancelled = loop.PostCancelableDelayedTask(
+      FROM_HERE, new RecordDeletionTask(NULL, &was_deleted), 10, 0);
+  loop.PostCancelableDelayedTask(
+      FROM_HERE, new RecordRunTimeTask(&run_time, &num_tasks), 20, 0);
+
+  EXPECT_TRUE(loop.CancelDelayedTask(cancelled));
+  EXPECT_TRUE(was_deleted);
+  EXPECT_FALSE(loop.CancelDelayedTask(cancelled));
+
+  loop.Run();
+  EXPECT_EQ(0, num_tasks);
+  EXPECT_FALSE(run_time.is_null());
+}
+
 class NestingTest : public Task {
  public:
   explicit NestingTest(int* depth) : depth_(depth) {
@@ -1388,6 +1476,12 @@ TEST(MessageLoopTest, PostTask_SEH) {
   RunTest_PostTask_SEH(MessageLoop::TYPE_IO);
 }
 
+TEST(MessageLoopTest, PostTask_ManyThreads) {
+  RunTest_PostTask_ManyThreads(MessageLoop::TYPE_DEFAULT);
+  RunTest_PostTask_ManyThreads(MessageLoop::TYPE_UI);
+  RunTest_PostTask_ManyThreads(MessageLoop::TYPE_IO);
+}
+
 TEST(MessageLoopTest, PostDelayedTask_Basic) {
   RunTest_PostDelayedTask_Basic(MessageLoop::TYPE_DEFAULT);
   RunTest_PostDelayedTask_Basic(MessageLoop::TYPE_UI);
@@ -1418,6 +1512,12 @@ TEST(MessageLoopTest, PostDelayedTask_InPostOrder_3) {
   RunTest_PostDelayedTask_InPostOrder_3(MessageLoop::TYPE_IO);
 }
 
+TEST(MessageLoopTest, PostCancelableDelayedTask) {
+  RunTest_PostCancelableDelayedTask(MessageLoop::TYPE_DEFAULT);
+  RunTest_PostCancelableDelayedTask(MessageLoop::TYPE_UI);
+  RunTest_PostCancelableDelayedTask(MessageLoop::TYPE_IO);
+}
+
 TEST(MessageLoopTest, PostDelayedTask_SharedTimer) {
   RunTest_PostDelayedTask_SharedTimer(MessageLoop::TYPE_DEFAULT);
   RunTest_PostDelayedTask_SharedTimer(MessageLoop::TYPE_UI);
@@ -1660,7 +1760,7 @@ TEST(MessageLoopTest, FileDescriptorWatcherOutlivesMessageLoop) {
   int fd = pipefds[1];
   {
     // Arrange for controller to live longer than message loop.
-    base::MessagePumpLibevent::FileDescriptorWatcher controller;
+    MessageLoopForIO::FileDescriptorWatcher controller;
     {
       MessageLoopForIO message_loop;
 
@@ -1687,7 +1787,7 @@ TEST(MessageLoopTest, FileDescriptorWatcherDoubleStop) {
     // Arrange for message loop to live longer than controller.
     MessageLoopForIO message_loop;
     {
-      base::MessagePumpLibevent::FileDescriptorWatcher controller;
+      MessageLoopForIO::FileDescriptorWatcher controller;
 
       QuitDelegate delegate;
       message_loop.WatchFileDescriptor(fd,
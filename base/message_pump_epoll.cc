@@ -0,0 +1,443 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_pump_epoll.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "base/auto_reset.h"
+#include "base/eintr_wrapper.h"
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// The events that make a watcher for each direction ready.  Errors and hang-ups
+// are always reported, and wake both directions up, as with libevent.
+const uint32 kReadEvents = EPOLLIN | EPOLLERR | EPOLLHUP;
+const uint32 kWriteEvents = EPOLLOUT | EPOLLERR | EPOLLHUP;
+
+// The key of a registration: the file descriptor and its generation.
+uint64 MakeKey(int fd, uint32 generation) {
+  return (static_cast<uint64>(generation) << 32) | static_cast<uint32>(fd);
+}
+
+int FdOfKey(uint64 key) {
+  return static_cast<int>(key & 0xffffffff);
+}
+
+uint32 GenerationOfKey(uint64 key) {
+  return static_cast<uint32>(key >> 32);
+}
+
+// Return 0 on success
+int SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags == -1)
+    flags = 0;
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+}  // namespace
+
+MessagePumpEpoll::FileDescriptorWatcher::FileDescriptorWatcher()
+    : fd_(-1),
+      mode_(0),
+      is_persistent_(false),
+      pump_(NULL),
+      watcher_(NULL),
+      next_(NULL) {
+}
+
+MessagePumpEpoll::FileDescriptorWatcher::~FileDescriptorWatcher() {
+  StopWatchingFileDescriptor();
+}
+
+bool MessagePumpEpoll::FileDescriptorWatcher::StopWatchingFileDescriptor() {
+  if (!pump_)
+    return true;
+  return pump_->StopWatching(this);
+}
+
+MessagePumpEpoll::FdState::FdState()
+    : reader(NULL),
+      writer(NULL),
+      controllers(NULL),
+      registered(0),
+      generation(0) {
+}
+
+MessagePumpEpoll::MessagePumpEpoll()
+    : keep_running_(true),
+      in_run_(false),
+      epoll_fd_(-1),
+      wakeup_pipe_in_(-1),
+      wakeup_pipe_out_(-1) {
+  if (!Init())
+     NOTREACHED();
+}
+
+MessagePumpEpoll::~MessagePumpEpoll() {
+  // Controllers may outlive the pump; make them forget it.
+  for (size_t fd = 0; fd < fds_.size(); ++fd) {
+    FileDescriptorWatcher* controller = fds_[fd].controllers;
+    while (controller) {
+      FileDescriptorWatcher* next = controller->next_;
+      controller->fd_ = -1;
+      controller->mode_ = 0;
+      controller->pump_ = NULL;
+      controller->watcher_ = NULL;
+      controller->next_ = NULL;
+      controller = next;
+    }
+  }
+  if (wakeup_pipe_in_ >= 0) {
+    if (HANDLE_EINTR(close(wakeup_pipe_in_)) < 0)
+      PLOG(ERROR) << "close";
+  }
+  if (wakeup_pipe_out_ >= 0) {
+    if (HANDLE_EINTR(close(wakeup_pipe_out_)) < 0)
+      PLOG(ERROR) << "close";
+  }
+  if (epoll_fd_ >= 0) {
+    if (HANDLE_EINTR(close(epoll_fd_)) < 0)
+      PLOG(ERROR) << "close";
+  }
+}
+
+bool MessagePumpEpoll::WatchFileDescriptor(int fd,
+                                           bool persistent,
+                                           Mode mode,
+                                           FileDescriptorWatcher *controller,
+                                           Watcher *delegate) {
+  DCHECK_GE(fd, 0);
+  DCHECK(controller);
+  DCHECK(delegate);
+  DCHECK(mode == WATCH_READ || mode == WATCH_WRITE || mode == WATCH_READ_WRITE);
+
+  bool attached = controller->pump_ != NULL;
+  if (attached && (controller->pump_ != this || controller->fd_ != fd)) {
+    // It's illegal to use this function to listen on 2 separate fds with the
+    // same |controller|.
+    NOTREACHED() << "FDs don't match" << controller->fd_ << "!=" << fd;
+    return false;
+  }
+
+  FdState* state = GetFdState(fd);
+  if (((mode & WATCH_READ) && state->reader && state->reader != controller) ||
+      ((mode & WATCH_WRITE) && state->writer && state->writer != controller)) {
+    NOTREACHED() << "FD " << fd << " is already watched by another controller";
+    return false;
+  }
+
+  if (!attached) {
+    controller->fd_ = fd;
+    controller->mode_ = 0;
+    controller->is_persistent_ = false;
+    controller->pump_ = this;
+    controller->next_ = state->controllers;
+    state->controllers = controller;
+  }
+  // Like libevent, a persistent watch stays persistent when more is watched.
+  controller->is_persistent_ |= persistent;
+  controller->mode_ |= mode;
+  controller->watcher_ = delegate;
+  if (controller->mode_ & WATCH_READ)
+    state->reader = controller;
+  if (controller->mode_ & WATCH_WRITE)
+    state->writer = controller;
+
+  if (!Register(fd)) {
+    StopWatching(controller);
+    return false;
+  }
+  return true;
+}
+
+void MessagePumpEpoll::AddIOObserver(IOObserver *obs) {
+  io_observers_.AddObserver(obs);
+}
+
+void MessagePumpEpoll::RemoveIOObserver(IOObserver *obs) {
+  io_observers_.RemoveObserver(obs);
+}
+
+// Reentrant!
+void MessagePumpEpoll::Run(Delegate* delegate) {
+  DCHECK(keep_running_) << "Quit must have been called outside of Run!";
+  AutoReset<bool> auto_reset_in_run(&in_run_, true);
+
+  // On the stack, since a callback may run a nested loop.
+  epoll_event events[kMaxEvents];
+
+  for (;;) {
+    bool did_work = delegate->DoWork();
+    if (!keep_running_)
+      break;
+
+    did_work |= delegate->DoDelayedWork(&delayed_work_time_);
+    if (!keep_running_)
+      break;
+
+    if (did_work)
+      continue;
+
+    did_work = delegate->DoIdleWork();
+    if (!keep_running_)
+      break;
+
+    if (did_work)
+      continue;
+
+    int timeout_ms = -1;
+    if (!delayed_work_time_.is_null()) {
+      TimeDelta delay = delayed_work_time_ - TimeTicks::Now();
+      if (delay <= TimeDelta()) {
+        // It looks like delayed_work_time_ indicates a time in the past, so we
+        // need to call DoDelayedWork now.
+        delayed_work_time_ = TimeTicks();
+        continue;
+      }
+      // Round up, so that the delayed work is due when epoll_wait() returns.
+      timeout_ms = static_cast<int>(std::min<int64>(
+          (delay.InMicroseconds() + Time::kMicrosecondsPerMillisecond - 1) /
+              Time::kMicrosecondsPerMillisecond,
+          kint32max));
+    }
+
+    int count = epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+    if (count < 0) {
+      DPLOG_IF(ERROR, errno != EINTR) << "epoll_wait";
+      continue;
+    }
+    // Events left when quitting are level triggered, so they are reported
+    // again by the next epoll_wait().
+    for (int i = 0; i < count && keep_running_; ++i)
+      OnEpollEvent(events[i]);
+  }
+
+  keep_running_ = true;
+}
+
+void MessagePumpEpoll::Quit() {
+  DCHECK(in_run_);
+  // Tell both epoll_wait() and Run that they should break out of their loops.
+  keep_running_ = false;
+  ScheduleWork();
+}
+
+void MessagePumpEpoll::ScheduleWork() {
+  // Wake epoll_wait() up, in a threadsafe way.
+  char buf = 0;
+  int nwrite = HANDLE_EINTR(write(wakeup_pipe_in_, &buf, 1));
+  DCHECK(nwrite == 1 || errno == EAGAIN)
+      << "[nwrite:" << nwrite << "] [errno:" << errno << "]";
+}
+
+void MessagePumpEpoll::ScheduleDelayedWork(
+    const TimeTicks& delayed_work_time) {
+  // We know that we can't be blocked on Wait right now since this method can
+  // only be called on the same thread as Run, so we only need to update our
+  // record of how long to sleep when we do sleep.
+  delayed_work_time_ = delayed_work_time;
+}
+
+bool MessagePumpEpoll::Init() {
+  epoll_fd_ = epoll_create(kMaxEvents);
+  if (epoll_fd_ < 0) {
+    DLOG(ERROR) << "epoll_create() failed, errno: " << errno;
+    return false;
+  }
+  if (fcntl(epoll_fd_, F_SETFD, FD_CLOEXEC)) {
+    DLOG(ERROR) << "FD_CLOEXEC for epoll fd failed, errno: " << errno;
+    return false;
+  }
+
+  int fds[2];
+  if (pipe(fds)) {
+    DLOG(ERROR) << "pipe() failed, errno: " << errno;
+    return false;
+  }
+  if (SetNonBlocking(fds[0])) {
+    DLOG(ERROR) << "SetNonBlocking for pipe fd[0] failed, errno: " << errno;
+    return false;
+  }
+  if (SetNonBlocking(fds[1])) {
+    DLOG(ERROR) << "SetNonBlocking for pipe fd[1] failed, errno: " << errno;
+    return false;
+  }
+  wakeup_pipe_out_ = fds[0];
+  wakeup_pipe_in_ = fds[1];
+
+  epoll_event event;
+  event.events = EPOLLIN;
+  event.data.u64 = MakeKey(wakeup_pipe_out_, 0);
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_pipe_out_, &event)) {
+    DLOG(ERROR) << "epoll_ctl() for the wakeup pipe failed, errno: " << errno;
+    return false;
+  }
+  return true;
+}
+
+MessagePumpEpoll::FdState* MessagePumpEpoll::GetFdState(int fd) {
+  if (static_cast<size_t>(fd) >= fds_.size())
+    fds_.resize(fd + 1);
+  return &fds_[fd];
+}
+
+bool MessagePumpEpoll::Register(int fd) {
+  FdState* state = GetFdState(fd);
+  uint32 wanted = (state->reader ? EPOLLIN : 0) |
+                  (state->writer ? EPOLLOUT : 0);
+  if (!(wanted & ~state->registered))
+    return true;
+
+  epoll_event event;
+  event.events = state->registered | wanted;
+  event.data.u64 = MakeKey(fd, state->generation);
+  int rv = epoll_ctl(epoll_fd_, state->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                     fd, &event);
+  if (rv && errno == ENOENT) {
+    // The file was closed and the kernel dropped its registration; this is a
+    // new file with the same number.
+    event.data.u64 = MakeKey(fd, ++state->generation);
+    rv = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+  } else if (rv && errno == EEXIST) {
+    rv = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+  }
+  if (rv) {
+    DPLOG(ERROR) << "epoll_ctl";
+    return false;
+  }
+  state->registered = event.events;
+  return true;
+}
+
+void MessagePumpEpoll::Unregister(int fd) {
+  FdState* state = GetFdState(fd);
+  epoll_event event;
+  event.events = (state->reader ? EPOLLIN : 0) |
+                 (state->writer ? EPOLLOUT : 0);
+  event.data.u64 = MakeKey(fd, state->generation);
+  if (event.events &&
+      epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0) {
+    state->registered = event.events;
+    return;
+  }
+  // This fails if the file was already closed, which removed it anyway.
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &event);
+  state->registered = 0;
+  ++state->generation;
+}
+
+bool MessagePumpEpoll::StopWatching(FileDescriptorWatcher* controller) {
+  DCHECK_EQ(this, controller->pump_);
+  int fd = controller->fd_;
+  FdState* state = GetFdState(fd);
+  if (state->reader == controller)
+    state->reader = NULL;
+  if (state->writer == controller)
+    state->writer = NULL;
+  FileDescriptorWatcher** link = &state->controllers;
+  while (*link != controller)
+    link = &(*link)->next_;
+  *link = controller->next_;
+
+  controller->fd_ = -1;
+  controller->mode_ = 0;
+  controller->pump_ = NULL;
+  controller->watcher_ = NULL;
+  controller->next_ = NULL;
+
+  // The FD is likely about to be closed: remove it now, so that a new file
+  // with the same number starts afresh.
+  if (!state->controllers && state->registered)
+    Unregister(fd);
+  return true;
+}
+
+void MessagePumpEpoll::OnEpollEvent(const epoll_event& event) {
+  int fd = FdOfKey(event.data.u64);
+  uint32 generation = GenerationOfKey(event.data.u64);
+  if (fd == wakeup_pipe_out_) {
+    OnWakeup();
+    return;
+  }
+
+  FdState* state = GetFdState(fd);
+  if (state->generation != generation || !state->registered)
+    return;
+
+  FileDescriptorWatcher* writer =
+      (event.events & kWriteEvents) ? state->writer : NULL;
+  FileDescriptorWatcher* reader =
+      (event.events & kReadEvents) ? state->reader : NULL;
+  if (writer && writer == reader) {
+    Notify(writer, WATCH_READ_WRITE);
+  } else {
+    if (writer) {
+      Notify(writer, WATCH_WRITE);
+      // The callback may have stopped the reader, or closed the FD.
+      state = GetFdState(fd);
+      if (state->generation != generation)
+        return;
+      reader = (event.events & kReadEvents) ? state->reader : NULL;
+    }
+    if (reader)
+      Notify(reader, WATCH_READ);
+  }
+
+  // Level triggered events nobody watches any more would wake the pump up
+  // again and again, so stop asking for them.
+  state = GetFdState(fd);
+  if (state->generation != generation || !state->registered)
+    return;
+  uint32 wanted = (state->reader ? EPOLLIN : 0) |
+                  (state->writer ? EPOLLOUT : 0);
+  if ((event.events & (EPOLLIN | EPOLLOUT) & ~wanted) ||
+      (!wanted && (event.events & (EPOLLERR | EPOLLHUP)))) {
+    Unregister(fd);
+  }
+}
+
+void MessagePumpEpoll::Notify(FileDescriptorWatcher* controller, int mode) {
+  int fd = controller->fd_;
+  Watcher* watcher = controller->watcher_;
+  if (!controller->is_persistent_) {
+    // Only disarmed: the registration stays, in case the watch is re-armed.
+    FdState* state = GetFdState(fd);
+    if (state->reader == controller)
+      state->reader = NULL;
+    if (state->writer == controller)
+      state->writer = NULL;
+    controller->mode_ = 0;
+  }
+
+  if (mode & WATCH_WRITE) {
+    FOR_EACH_OBSERVER(IOObserver, io_observers_, WillProcessIOEvent());
+    watcher->OnFileCanWriteWithoutBlocking(fd);
+    FOR_EACH_OBSERVER(IOObserver, io_observers_, DidProcessIOEvent());
+  }
+  if (mode & WATCH_READ) {
+    FOR_EACH_OBSERVER(IOObserver, io_observers_, WillProcessIOEvent());
+    watcher->OnFileCanReadWithoutBlocking(fd);
+    FOR_EACH_OBSERVER(IOObserver, io_observers_, DidProcessIOEvent());
+  }
+}
+
+void MessagePumpEpoll::OnWakeup() {
+  // Remove and discard all the wakeup bytes; the loop runs its work next.
+  char buf[64];
+  while (HANDLE_EINTR(read(wakeup_pipe_out_, buf, sizeof(buf))) ==
+         static_cast<ssize_t>(sizeof(buf))) {
+  }
+}
+
+}  // namespace base
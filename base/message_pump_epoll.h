@@ -0,0 +1,169 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MESSAGE_PUMP_EPOLL_H_
+#define BASE_MESSAGE_PUMP_EPOLL_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/message_pump.h"
+#include "base/message_pump_libevent.h"
+#include "base/observer_list.h"
+#include "base/time.h"
+
+struct epoll_event;
+
+namespace base {
+
+// A drop-in replacement for MessagePumpLibevent that uses epoll directly.
+//
+// The kernel registration of a file descriptor is kept as long as a controller
+// is attached to it, and only ever widened while watches come and go: a
+// one-shot watch that fired is disarmed in the pump, and re-arming it, which
+// most socket code does after every read or write, costs no system call.  The
+// registration is narrowed lazily, when the kernel reports an event nobody
+// watches any more.  All the events returned by one epoll_wait() are dispatched
+// before the pump sleeps again.
+//
+// Registrations are level triggered, like libevent's, since some persistent
+// watchers only consume part of what is ready on each callback.
+//
+// A file descriptor can be watched for reading and for writing by different
+// controllers, but not for the same direction by two controllers.
+class MessagePumpEpoll : public MessagePump {
+ public:
+  // The watcher interfaces are shared with MessagePumpLibevent, so that code
+  // using either pump through MessageLoopForIO is the same.
+  typedef MessagePumpLibevent::IOObserver IOObserver;
+  typedef MessagePumpLibevent::Watcher Watcher;
+  typedef MessagePumpLibevent::Mode Mode;
+  static const Mode WATCH_READ = MessagePumpLibevent::WATCH_READ;
+  static const Mode WATCH_WRITE = MessagePumpLibevent::WATCH_WRITE;
+  static const Mode WATCH_READ_WRITE = MessagePumpLibevent::WATCH_READ_WRITE;
+
+  // Object returned by WatchFileDescriptor to manage further watching.
+  class FileDescriptorWatcher {
+   public:
+    FileDescriptorWatcher();
+    ~FileDescriptorWatcher();  // Implicitly calls StopWatchingFileDescriptor.
+
+    // Stop watching the FD, always safe to call.  No-op if there's nothing
+    // to do.
+    bool StopWatchingFileDescriptor();
+
+   private:
+    friend class MessagePumpEpoll;
+
+    // The FD this controller is attached to, or -1.  A one-shot watch that
+    // fired leaves the controller attached with an empty |mode_|, until it
+    // is stopped or re-armed.
+    int fd_;
+    int mode_;  // The Mode bits currently armed.
+    bool is_persistent_;
+    MessagePumpEpoll* pump_;
+    Watcher* watcher_;
+    // The next controller attached to the same FD.
+    FileDescriptorWatcher* next_;
+
+    DISALLOW_COPY_AND_ASSIGN(FileDescriptorWatcher);
+  };
+
+  MessagePumpEpoll();
+  virtual ~MessagePumpEpoll();
+
+  // Same as MessagePumpLibevent::WatchFileDescriptor.  If |controller| is
+  // already attached to |fd|, the effect is cumulative.  Returns true on
+  // success.
+  bool WatchFileDescriptor(int fd,
+                           bool persistent,
+                           Mode mode,
+                           FileDescriptorWatcher *controller,
+                           Watcher *delegate);
+
+  void AddIOObserver(IOObserver* obs);
+  void RemoveIOObserver(IOObserver* obs);
+
+  // MessagePump methods:
+  virtual void Run(Delegate* delegate);
+  virtual void Quit();
+  virtual void ScheduleWork();
+  virtual void ScheduleDelayedWork(const TimeTicks& delayed_work_time);
+
+ private:
+  // What the pump knows about a file descriptor.
+  struct FdState {
+    FdState();
+
+    // The controllers armed for each direction.
+    FileDescriptorWatcher* reader;
+    FileDescriptorWatcher* writer;
+    // All the controllers attached to the FD, linked through their |next_|.
+    FileDescriptorWatcher* controllers;
+    // The epoll events the kernel has been asked to report, 0 if the FD isn't
+    // registered.
+    uint32 registered;
+    // Incremented each time the FD is unregistered, and stored with its events
+    // so that an event queued for a previous file with the same number is
+    // ignored.
+    uint32 generation;
+  };
+
+  // The most events dispatched per epoll_wait().
+  static const int kMaxEvents = 256;
+
+  // Risky part of constructor.  Returns true on success.
+  bool Init();
+
+  FdState* GetFdState(int fd);
+
+  // Widens the registration of |fd| to cover what its controllers watch.
+  bool Register(int fd);
+
+  // Narrows the registration of |fd| to what its controllers watch, or
+  // removes it if they watch nothing.
+  void Unregister(int fd);
+
+  // Detaches |controller| from its FD.
+  bool StopWatching(FileDescriptorWatcher* controller);
+
+  // Dispatches one event returned by epoll_wait().
+  void OnEpollEvent(const epoll_event& event);
+
+  // Calls |controller|'s watcher for the directions in |mode|, disarming it
+  // first if it is one-shot.
+  void Notify(FileDescriptorWatcher* controller, int mode);
+
+  // Removes the wakeup bytes written by ScheduleWork().
+  void OnWakeup();
+
+  // This flag is set to false when Run should return.
+  bool keep_running_;
+
+  // This flag is set when inside Run.
+  bool in_run_;
+
+  // The time at which we should call DoDelayedWork.
+  TimeTicks delayed_work_time_;
+
+  int epoll_fd_;
+
+  // Unix pipe used to implement ScheduleWork()
+  // ... write end; ScheduleWork() writes a single byte to it
+  int wakeup_pipe_in_;
+  // ... read end; OnWakeup drains it
+  int wakeup_pipe_out_;
+
+  // Indexed by file descriptor.
+  std::vector<FdState> fds_;
+
+  ObserverList<IOObserver> io_observers_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessagePumpEpoll);
+};
+
+}  // namespace base
+
+#endif  // BASE_MESSAGE_PUMP_EPOLL_H_
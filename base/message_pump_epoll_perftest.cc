@@ -0,0 +1,133 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "base/eintr_wrapper.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_pump_epoll.h"
+#include "base/message_pump_libevent.h"
+#include "base/perftimer.h"
+#include "base/stl_util-inl.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Each socket pair passes a byte on to another one when it receives one.
+const int kEvents = 200000;
+
+class NoWorkDelegate : public MessagePump::Delegate {
+ public:
+  virtual bool DoWork() { return false; }
+  virtual bool DoDelayedWork(TimeTicks* next_delayed_work_time) {
+    return false;
+  }
+  virtual bool DoIdleWork() { return false; }
+};
+
+// Reads the byte sent to one socket pair, sends one to the next pair, and
+// re-arms its one-shot watch, like socket code waiting for each read.
+template <typename Pump>
+class PassWatcher : public MessagePumpLibevent::Watcher {
+ public:
+  PassWatcher(Pump* pump, int* events)
+      : pump_(pump),
+        events_(events),
+        next_fd_(-1) {
+  }
+
+  void Watch(int fd) {
+    EXPECT_TRUE(pump_->WatchFileDescriptor(fd, false, Pump::WATCH_READ,
+                                           &controller_, this));
+  }
+
+  virtual void OnFileCanReadWithoutBlocking(int fd) {
+    char buf;
+    EXPECT_EQ(1, HANDLE_EINTR(read(fd, &buf, 1)));
+    EXPECT_EQ(1, HANDLE_EINTR(write(next_fd_, &buf, 1)));
+    Watch(fd);
+    if (++*events_ == kEvents)
+      pump_->Quit();
+  }
+  virtual void OnFileCanWriteWithoutBlocking(int fd) {}
+
+  void set_next_fd(int fd) { next_fd_ = fd; }
+  void Stop() { controller_.StopWatchingFileDescriptor(); }
+
+ private:
+  Pump* pump_;
+  int* events_;
+  int next_fd_;
+  typename Pump::FileDescriptorWatcher controller_;
+};
+
+// Passes bytes around |pairs| socket pairs, with a quarter of them ready at any
+// time, and returns the events dispatched per second.
+template <typename Pump>
+double PassBytes(int pairs) {
+  std::vector<int> fds(pairs * 2);
+  for (int i = 0; i < pairs; ++i)
+    EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, &fds[i * 2]));
+
+  scoped_refptr<Pump> pump(new Pump);
+  int events = 0;
+  std::vector<PassWatcher<Pump>*> watchers;
+  for (int i = 0; i < pairs; ++i) {
+    watchers.push_back(new PassWatcher<Pump>(pump.get(), &events));
+    // Pass to a pair far away, so that ready pairs are spread out.
+    watchers.back()->set_next_fd(fds[((i + pairs / 3 + 1) % pairs) * 2 + 1]);
+    watchers.back()->Watch(fds[i * 2]);
+  }
+  for (int i = 0; i < pairs; i += 4)
+    EXPECT_EQ(1, HANDLE_EINTR(write(fds[i * 2 + 1], "x", 1)));
+
+  NoWorkDelegate delegate;
+  PerfTimer timer;
+  pump->Run(&delegate);
+  double seconds = timer.Elapsed().InSecondsF();
+  // MessagePumpLibevent finishes the batch of events it is dispatching when it
+  // quits.
+  EXPECT_LE(kEvents, events);
+
+  for (size_t i = 0; i < watchers.size(); ++i)
+    watchers[i]->Stop();
+  STLDeleteElements(&watchers);
+  for (size_t i = 0; i < fds.size(); ++i)
+    HANDLE_EINTR(close(fds[i]));
+  return events / seconds;
+}
+
+}  // namespace
+
+// Compares MessagePumpLibevent and MessagePumpEpoll with thousands of sockets.
+TEST(MessagePumpEpollPerfTest, PassBytes) {
+  // Two file descriptors per pair.
+  const int kPairCounts[] = { 100, 1000, 4000 };
+  struct rlimit limit;
+  ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &limit));
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+
+  for (size_t i = 0; i < arraysize(kPairCounts); ++i) {
+    int pairs = kPairCounts[i];
+    if (limit.rlim_cur != RLIM_INFINITY &&
+        limit.rlim_cur < static_cast<rlim_t>(pairs * 2 + 64)) {
+      LOG(WARNING) << "Not enough file descriptors for " << pairs << " pairs";
+      continue;
+    }
+    LogPerfResult(StringPrintf("MessagePumpLibevent_%d_pairs", pairs).c_str(),
+                  PassBytes<MessagePumpLibevent>(pairs) / 1000, "kevents/s");
+    LogPerfResult(StringPrintf("MessagePumpEpoll_%d_pairs", pairs).c_str(),
+                  PassBytes<MessagePumpEpoll>(pairs) / 1000, "kevents/s");
+  }
+}
+
+}  // namespace base
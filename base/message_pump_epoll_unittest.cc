@@ -0,0 +1,173 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_pump_epoll.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base/eintr_wrapper.h"
+#include "base/memory/ref_counted.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Has no work, and quits the pump once it has waited for events |waits|
+// times.
+class IdleDelegate : public MessagePump::Delegate {
+ public:
+  IdleDelegate(MessagePump* pump, int waits)
+      : pump_(pump),
+        idle_count_(0),
+        waits_(waits) {
+  }
+
+  virtual bool DoWork() { return false; }
+  virtual bool DoDelayedWork(TimeTicks* next_delayed_work_time) {
+    return false;
+  }
+  virtual bool DoIdleWork() {
+    if (idle_count_++ == waits_)
+      pump_->Quit();
+    return false;
+  }
+
+ private:
+  MessagePump* pump_;
+  int idle_count_;
+  int waits_;
+};
+
+// Reads one byte per callback, and re-arms its one-shot watch if asked to.
+class ReadWatcher : public MessagePumpEpoll::Watcher {
+ public:
+  ReadWatcher(MessagePumpEpoll* pump, bool rearm)
+      : pump_(pump),
+        rearm_(rearm),
+        reads_(0),
+        stop_(NULL) {
+  }
+
+  virtual void OnFileCanReadWithoutBlocking(int fd) {
+    char buf;
+    if (HANDLE_EINTR(read(fd, &buf, 1)) == 1)
+      ++reads_;
+    if (rearm_) {
+      EXPECT_TRUE(pump_->WatchFileDescriptor(fd, false,
+                                             MessagePumpEpoll::WATCH_READ,
+                                             &controller_, this));
+    }
+    if (stop_)
+      stop_->StopWatchingFileDescriptor();
+  }
+  virtual void OnFileCanWriteWithoutBlocking(int fd) {
+    ADD_FAILURE();
+  }
+
+  MessagePumpEpoll::FileDescriptorWatcher* controller() {
+    return &controller_;
+  }
+  int reads() const { return reads_; }
+  void set_stop(MessagePumpEpoll::FileDescriptorWatcher* stop) {
+    stop_ = stop;
+  }
+
+ private:
+  MessagePumpEpoll* pump_;
+  bool rearm_;
+  int reads_;
+  MessagePumpEpoll::FileDescriptorWatcher* stop_;
+  MessagePumpEpoll::FileDescriptorWatcher controller_;
+};
+
+class MessagePumpEpollTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    for (int i = 0; i < 2; ++i)
+      ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets_[i]));
+    pump_ = new MessagePumpEpoll;
+  }
+
+  virtual void TearDown() {
+    pump_ = NULL;
+    for (int i = 0; i < 2; ++i) {
+      HANDLE_EINTR(close(sockets_[i][0]));
+      HANDLE_EINTR(close(sockets_[i][1]));
+    }
+  }
+
+  // Writes |count| bytes to the other end of |sockets_[index]|.
+  void Send(int index, int count) {
+    for (int i = 0; i < count; ++i)
+      ASSERT_EQ(1, HANDLE_EINTR(write(sockets_[index][1], "x", 1)));
+  }
+
+  int sockets_[2][2];
+  scoped_refptr<MessagePumpEpoll> pump_;
+};
+
+}  // namespace
+
+// A one-shot watch fires once per arming.
+TEST_F(MessagePumpEpollTest, OneShot) {
+  ReadWatcher rearming(pump_.get(), true);
+  ReadWatcher once(pump_.get(), false);
+  ASSERT_TRUE(pump_->WatchFileDescriptor(sockets_[0][0], false,
+                                         MessagePumpEpoll::WATCH_READ,
+                                         rearming.controller(), &rearming));
+  ASSERT_TRUE(pump_->WatchFileDescriptor(sockets_[1][0], false,
+                                         MessagePumpEpoll::WATCH_READ,
+                                         once.controller(), &once));
+  Send(0, 3);
+  Send(1, 3);
+  IdleDelegate delegate(pump_.get(), 3);
+  pump_->Run(&delegate);
+  EXPECT_EQ(3, rearming.reads());
+  EXPECT_EQ(1, once.reads());
+}
+
+// A persistent watcher that doesn't read everything is called again.
+TEST_F(MessagePumpEpollTest, PersistentPartialReads) {
+  ReadWatcher watcher(pump_.get(), false);
+  ASSERT_TRUE(pump_->WatchFileDescriptor(sockets_[0][0], true,
+                                         MessagePumpEpoll::WATCH_READ,
+                                         watcher.controller(), &watcher));
+  Send(0, 3);
+  IdleDelegate delegate(pump_.get(), 3);
+  pump_->Run(&delegate);
+  EXPECT_EQ(3, watcher.reads());
+}
+
+// A watch stopped by a callback earlier in the same batch of events is not
+// called.
+TEST_F(MessagePumpEpollTest, StopDuringBatch) {
+  ReadWatcher first(pump_.get(), false);
+  ReadWatcher second(pump_.get(), false);
+  first.set_stop(second.controller());
+  second.set_stop(first.controller());
+  ASSERT_TRUE(pump_->WatchFileDescriptor(sockets_[0][0], true,
+                                         MessagePumpEpoll::WATCH_READ,
+                                         first.controller(), &first));
+  ASSERT_TRUE(pump_->WatchFileDescriptor(sockets_[1][0], true,
+                                         MessagePumpEpoll::WATCH_READ,
+                                         second.controller(), &second));
+  Send(0, 1);
+  Send(1, 1);
+  IdleDelegate delegate(pump_.get(), 1);
+  pump_->Run(&delegate);
+  EXPECT_EQ(1, first.reads() + second.reads());
+}
+
+TEST_F(MessagePumpEpollTest, ControllerOutlivesPump) {
+  ReadWatcher watcher(pump_.get(), false);
+  ASSERT_TRUE(pump_->WatchFileDescriptor(sockets_[0][0], true,
+                                         MessagePumpEpoll::WATCH_READ,
+                                         watcher.controller(), &watcher));
+  pump_ = NULL;
+  EXPECT_TRUE(watcher.controller()->StopWatchingFileDescriptor());
+}
+
+}  // namespace base
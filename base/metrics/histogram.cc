@@ -12,12 +12,16 @@
 #include <math.h>
 
 #include <algorithm>
+#include <set>
 #include <string>
 
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/pickle.h"
+#include "base/stl_util-inl.h"
 #include "base/stringprintf.h"
 #include "base/synchronization/lock.h"
+#include "base/threading/thread_local_storage.h"
 
 namespace base {
 
@@ -73,6 +77,151 @@ typedef Histogram::Count Count;
 // static
 const size_t Histogram::kBucketCount_MAX = 16384u;
 
+//------------------------------------------------------------------------------
+// Per-thread sample storage.
+//------------------------------------------------------------------------------
+
+// Every histogram gets an index when it is constructed, and each thread keeps
+// a vector of SampleSets indexed by it, created the first time the thread
+// records a sample in that histogram.  Recording a sample only touches the
+// calling thread's SampleSet, under a lock of the thread's own that is only
+// contended while a snapshot reads that thread's samples.  The global lock is
+// taken when a thread records its first sample, to take a snapshot, and when
+// a histogram is deleted or a thread exits; it is always taken before a
+// thread's lock.
+//
+// A thread that records samples costs a pointer for every histogram created
+// before the last one it recorded in, plus a SampleSet (a count per bucket)
+// for each histogram it recorded in.  All of it is freed when the thread
+// exits, so only long-lived threads hold it.
+class Histogram::ThreadSamples {
+ public:
+  // Adds |count| samples of |value| in bucket |index| to the calling thread's
+  // samples for |histogram|.
+  static void Accumulate(Histogram* histogram, Sample value, Count count,
+                         size_t index) {
+    ThreadSamples* samples =
+        static_cast<ThreadSamples*>(state_.Get().slot.Get());
+    if (!samples)
+      samples = Create();
+
+    AutoLock auto_lock(samples->lock_);
+    size_t histogram_index = histogram->thread_samples_index_;
+    if (histogram_index >= samples->sample_sets_.size())
+      samples->sample_sets_.resize(histogram_index + 1, NULL);
+    SampleSet*& sample_set = samples->sample_sets_[histogram_index];
+    if (!sample_set) {
+      sample_set = new SampleSet;
+      sample_set->Resize(*histogram);
+    }
+    sample_set->Accumulate(value, count, index);
+  }
+
+  static void Register(Histogram* histogram) {
+    State& state = state_.Get();
+    AutoLock auto_lock(state.lock);
+    histogram->thread_samples_index_ = state.histograms.size();
+    state.histograms.push_back(histogram);
+  }
+
+  // Forgets |histogram|, and the samples any thread has for it.
+  static void Unregister(Histogram* histogram) {
+    State& state = state_.Get();
+    AutoLock auto_lock(state.lock);
+    size_t index = histogram->thread_samples_index_;
+    DCHECK_EQ(histogram, state.histograms[index]);
+    state.histograms[index] = NULL;
+    for (std::set<ThreadSamples*>::iterator it = state.threads.begin();
+         it != state.threads.end(); ++it) {
+      AutoLock thread_lock((*it)->lock_);
+      std::vector<SampleSet*>& sample_sets = (*it)->sample_sets_;
+      if (index < sample_sets.size()) {
+        delete sample_sets[index];
+        sample_sets[index] = NULL;
+      }
+    }
+  }
+
+  // Copies the samples of |histogram| from all threads into |sample|.  Each
+  // thread's samples are read under its lock, so none is read half written.
+  static void Snapshot(const Histogram& histogram, SampleSet* sample) {
+    State& state = state_.Get();
+    AutoLock auto_lock(state.lock);
+    *sample = histogram.sample_;
+    size_t index = histogram.thread_samples_index_;
+    for (std::set<ThreadSamples*>::const_iterator it = state.threads.begin();
+         it != state.threads.end(); ++it) {
+      AutoLock thread_lock((*it)->lock_);
+      const std::vector<SampleSet*>& sample_sets = (*it)->sample_sets_;
+      if (index < sample_sets.size() && sample_sets[index])
+        sample->Add(*sample_sets[index]);
+    }
+  }
+
+  static void AddToHistogram(Histogram* histogram, const SampleSet& sample) {
+    State& state = state_.Get();
+    AutoLock auto_lock(state.lock);
+    histogram->sample_.Add(sample);
+  }
+
+ private:
+  struct State {
+    State() : slot(&OnThreadExit) {}
+
+    Lock lock;
+    ThreadLocalStorage::Slot slot;
+
+    // All histograms by index.  Deleted histograms leave a NULL.
+    std::vector<Histogram*> histograms;
+
+    // The samples of every thread that has recorded any and not exited.
+    std::set<ThreadSamples*> threads;
+  };
+
+  ThreadSamples() {}
+  ~ThreadSamples() { STLDeleteElements(&sample_sets_); }
+
+  // Creates the calling thread's samples.
+  static ThreadSamples* Create() {
+    State& state = state_.Get();
+    ThreadSamples* samples = new ThreadSamples;
+    AutoLock auto_lock(state.lock);
+    state.threads.insert(samples);
+    state.slot.Set(samples);
+    return samples;
+  }
+
+  // Folds the samples of an exiting thread into their histograms.
+  static void OnThreadExit(void* value) {
+    ThreadSamples* samples = static_cast<ThreadSamples*>(value);
+    State& state = state_.Get();
+    AutoLock auto_lock(state.lock);
+    for (size_t i = 0; i < samples->sample_sets_.size(); ++i) {
+      if (samples->sample_sets_[i] && state.histograms[i])
+        state.histograms[i]->sample_.Add(*samples->sample_sets_[i]);
+    }
+    state.threads.erase(samples);
+    delete samples;
+  }
+
+  // Leaked, since threads may exit and record samples during shutdown.
+  static LazyInstance<State, LeakyLazyInstanceTraits<State> > state_;
+
+  // Held by the owning thread while it records a sample, and by other threads
+  // while they read or delete its samples.
+  Lock lock_;
+
+  // This thread's samples for each histogram, or NULL if it has recorded none.
+  std::vector<SampleSet*> sample_sets_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadSamples);
+};
+
+// static
+LazyInstance<Histogram::ThreadSamples::State,
+             LeakyLazyInstanceTraits<Histogram::ThreadSamples::State> >
+    Histogram::ThreadSamples::state_(LINKER_INITIALIZED);
+
 Histogram* Histogram::FactoryGet(const std::string& name,
                                  Sample minimum,
                                  Sample maximum,
@@ -129,7 +278,7 @@ void Histogram::AddBoolean(bool value) {
 }
 
 void Histogram::AddSampleSet(const SampleSet& sample) {
-  sample_.Add(sample);
+  ThreadSamples::AddToHistogram(this, sample);
 }
 
 void Histogram::SetRangeDescriptions(const DescriptionPair descriptions[]) {
@@ -361,11 +510,10 @@ size_t Histogram::bucket_count() const {
   return bucket_count_;
 }
 
-// Do a safe atomic snapshot of sample data.
-// This implementation assumes we are on a safe single thread.
+// Do a safe snapshot of sample data: the samples of all threads, each read
+// under the lock its thread takes to record one.
 void Histogram::SnapshotSample(SampleSet* sample) const {
-  // Note locking not done in this version!!!
-  *sample = sample_;
+  ThreadSamples::Snapshot(*this, sample);
 }
 
 bool Histogram::HasConstructorArguments(Sample minimum,
@@ -396,7 +544,8 @@ Histogram::Histogram(const std::string& name, Sample minimum,
     flags_(kNoFlags),
     ranges_(bucket_count + 1, 0),
     range_checksum_(0),
-    sample_() {
+    sample_(),
+    thread_samples_index_(0) {
   Initialize();
 }
 
@@ -409,7 +558,8 @@ Histogram::Histogram(const std::string& name, TimeDelta minimum,
     flags_(kNoFlags),
     ranges_(bucket_count + 1, 0),
     range_checksum_(0),
-    sample_() {
+    sample_(),
+    thread_samples_index_(0) {
   Initialize();
 }
 
@@ -422,6 +572,7 @@ Histogram::~Histogram() {
 
   // Just to make sure most derived class did this properly...
   DCHECK(ValidateBucketRanges());
+  ThreadSamples::Unregister(this);
 }
 
 // Calculate what range of values are held in each bucket.
@@ -515,10 +666,11 @@ const std::string Histogram::GetAsciiBucketRange(size_t i) const {
   return result;
 }
 
-// Update histogram data with new sample.
+// Update histogram data with new sample.  Only the calling thread writes to
+// its SampleSet, so the lock it takes is uncontended unless a snapshot is
+// being taken.
 void Histogram::Accumulate(Sample value, Count count, size_t index) {
-  // Note locking not done in this version!!!
-  sample_.Accumulate(value, count, index);
+  ThreadSamples::Accumulate(this, value, count, index);
 }
 
 void Histogram::SetBucketRange(size_t i, Sample value) {
@@ -546,6 +698,7 @@ uint32 Histogram::CalculateRangeChecksum() const {
 
 void Histogram::Initialize() {
   sample_.Resize(*this);
+  ThreadSamples::Register(this);
   if (declared_min_ < 1)
     declared_min_ = 1;
   if (declared_max_ > kSampleType_MAX - 1)
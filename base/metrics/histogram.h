@@ -263,6 +263,11 @@ class CustomHistogram;
 class Histogram;
 class LinearHistogram;
 
+// Each thread accumulates its samples in a SampleSet of its own, so that
+// threads recording the same histogram neither contend for a lock nor write
+// to the same memory.  SnapshotSample() adds up the samples of all threads,
+// and the samples of a thread are folded into the histogram when the thread
+// exits.
 class BASE_API Histogram {
  public:
   typedef int Sample;  // Used for samples (and ranges of samples).
@@ -512,6 +517,9 @@ class BASE_API Histogram {
 
   friend class StatisticsRecorder;  // To allow it to delete duplicates.
 
+  // Holds the samples each thread has recorded.  Defined in histogram.cc.
+  class ThreadSamples;
+
   // Post constructor initialization.
   void Initialize();
 
@@ -571,9 +579,13 @@ class BASE_API Histogram {
   uint32 range_checksum_;
 
   // Finally, provide the state that changes with the addition of each new
-  // sample.
+  // sample.  Samples are recorded per thread, so this only holds the samples
+  // passed to AddSampleSet() and those of threads that have exited.
   SampleSet sample_;
 
+  // Identifies this histogram in each thread's ThreadSamples.
+  size_t thread_samples_index_;
+
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
 
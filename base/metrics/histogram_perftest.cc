@@ -0,0 +1,114 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/metrics/histogram.h"
+#include "base/perftimer.h"
+#include "base/stl_util-inl.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kAddsPerThread = 2000000;
+
+// Adds kAddsPerThread samples to a histogram, spread over its buckets.
+class AddDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  explicit AddDelegate(Histogram* histogram) : histogram_(histogram) {}
+
+  virtual void Run() {
+    for (int i = 0; i < kAddsPerThread; ++i)
+      histogram_->Add(i & 1023);
+  }
+
+ private:
+  Histogram* histogram_;
+};
+
+// Does what Histogram used to: accumulates the samples of every thread in one
+// shared SampleSet, without a lock. Threads racing on it lose samples.
+class SharedSampleHistogram : public Histogram {
+ public:
+  SharedSampleHistogram(const std::string& name, Sample minimum,
+                        Sample maximum, size_t bucket_count)
+      : Histogram(name, minimum, maximum, bucket_count) {
+    InitializeBucketRange();
+    shared_sample_.Resize(*this);
+  }
+
+  virtual ~SharedSampleHistogram() {}
+
+  const SampleSet& shared_sample() const { return shared_sample_; }
+
+ protected:
+  virtual void Accumulate(Sample value, Count count, size_t index) {
+    shared_sample_.Accumulate(value, count, index);
+  }
+
+ private:
+  SampleSet shared_sample_;
+};
+
+// Runs |delegates| on a thread each, and returns the millions of samples
+// added per second.
+double RunThreads(
+    const std::vector<DelegateSimpleThread::Delegate*>& delegates) {
+  std::vector<DelegateSimpleThread*> threads;
+  PerfTimer timer;
+  for (size_t i = 0; i < delegates.size(); ++i) {
+    threads.push_back(new DelegateSimpleThread(delegates[i], "histogram"));
+    threads.back()->Start();
+  }
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i]->Join();
+  double seconds = timer.Elapsed().InSecondsF();
+  STLDeleteElements(&threads);
+  return delegates.size() * kAddsPerThread / seconds / 1000000;
+}
+
+}  // namespace
+
+// Measures Add() on one histogram from 1, 4 and 8 threads, against the old
+// shared SampleSet.
+TEST(HistogramPerfTest, AddContention) {
+  const int kThreadCounts[] = { 1, 4, 8 };
+  for (size_t i = 0; i < arraysize(kThreadCounts); ++i) {
+    int thread_count = kThreadCounts[i];
+    Histogram* histogram = Histogram::FactoryGet(
+        StringPrintf("Contention%d", thread_count), 1, 1000, 50,
+        Histogram::kNoFlags);
+
+    std::vector<DelegateSimpleThread::Delegate*> delegates;
+    for (int j = 0; j < thread_count; ++j)
+      delegates.push_back(new AddDelegate(histogram));
+    LogPerfResult(
+        StringPrintf("Histogram_Add_%d_threads", thread_count).c_str(),
+        RunThreads(delegates), "M/s");
+    STLDeleteElements(&delegates);
+
+    Histogram::SampleSet sample;
+    histogram->SnapshotSample(&sample);
+    EXPECT_EQ(thread_count * kAddsPerThread, sample.TotalCount());
+
+    SharedSampleHistogram shared_histogram("Shared", 1, 1000, 50);
+    for (int j = 0; j < thread_count; ++j)
+      delegates.push_back(new AddDelegate(&shared_histogram));
+    LogPerfResult(
+        StringPrintf("SharedSampleSet_Add_%d_threads", thread_count).c_str(),
+        RunThreads(delegates), "M/s");
+    STLDeleteElements(&delegates);
+    LogPerfResult(
+        StringPrintf("SharedSampleSet_lost_%d_threads", thread_count).c_str(),
+        thread_count * kAddsPerThread -
+            shared_histogram.shared_sample().TotalCount(),
+        "samples");
+  }
+}
+
+}  // namespace base
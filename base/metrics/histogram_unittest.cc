@@ -6,6 +6,8 @@
 
 #include "base/metrics/histogram.h"
 #include "base/scoped_ptr.h"
+#include "base/stl_util-inl.h"
+#include "base/threading/simple_thread.h"
 #include "base/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -322,6 +324,97 @@ TEST(HistogramTest, BucketPlacementTest) {
     EXPECT_EQ(i + 1, sample.counts(i));
 }
 
+// Adds |count| samples of |value| to a histogram.
+class AddSamplesDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  AddSamplesDelegate(Histogram* histogram, int value, int count)
+      : histogram_(histogram), value_(value), count_(count) {
+  }
+
+  virtual void Run() {
+    for (int i = 0; i < count_; ++i)
+      histogram_->Add(value_);
+  }
+
+ private:
+  Histogram* histogram_;
+  int value_;
+  int count_;
+};
+
+// Samples from threads that have exited are counted along with those of the
+// calling thread.
+TEST(HistogramTest, MultipleThreads) {
+  const int kThreads = 4;
+  const int kSamples = 10000;
+  Histogram* histogram(Histogram::FactoryGet(
+      "Threaded", 1, 64, 8, Histogram::kNoFlags));
+  histogram->Add(1);
+
+  std::vector<AddSamplesDelegate*> delegates;
+  std::vector<DelegateSimpleThread*> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    delegates.push_back(new AddSamplesDelegate(histogram, 1 << i, kSamples));
+    threads.push_back(new DelegateSimpleThread(delegates[i], "histogram"));
+    threads[i]->Start();
+  }
+  for (int i = 0; i < kThreads; ++i)
+    threads[i]->Join();
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(1 + kThreads * kSamples, sample.TotalCount());
+  EXPECT_EQ(sample.TotalCount(), sample.redundant_count());
+  EXPECT_EQ(1 + kSamples, sample.counts(1));
+  for (int i = 1; i < kThreads; ++i)
+    EXPECT_EQ(kSamples, sample.counts(i + 1));
+  EXPECT_EQ(Histogram::NO_INCONSISTENCIES,
+            histogram->FindCorruption(sample));
+
+  // Another snapshot gives the same result.
+  Histogram::SampleSet sample2;
+  histogram->SnapshotSample(&sample2);
+  EXPECT_EQ(sample.TotalCount(), sample2.TotalCount());
+  EXPECT_EQ(sample.sum(), sample2.sum());
+
+  STLDeleteElements(&threads);
+  STLDeleteElements(&delegates);
+}
+
+// Snapshots taken while other threads add samples are consistent.
+TEST(HistogramTest, SnapshotWhileAdding) {
+  const int kThreads = 4;
+  const int kSamples = 100000;
+  Histogram* histogram(Histogram::FactoryGet(
+      "ThreadedSnapshot", 1, 64, 8, Histogram::kNoFlags));
+
+  std::vector<AddSamplesDelegate*> delegates;
+  std::vector<DelegateSimpleThread*> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    delegates.push_back(new AddSamplesDelegate(histogram, 1 << i, kSamples));
+    threads.push_back(new DelegateSimpleThread(delegates[i], "histogram"));
+    threads[i]->Start();
+  }
+  int64 previous_sum = 0;
+  for (int i = 0; i < 100; ++i) {
+    Histogram::SampleSet sample;
+    histogram->SnapshotSample(&sample);
+    EXPECT_EQ(sample.TotalCount(), sample.redundant_count());
+    EXPECT_LE(previous_sum, sample.sum());
+    previous_sum = sample.sum();
+  }
+  for (int i = 0; i < kThreads; ++i)
+    threads[i]->Join();
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(kThreads * kSamples, sample.TotalCount());
+  EXPECT_EQ(sample.TotalCount(), sample.redundant_count());
+
+  STLDeleteElements(&threads);
+  STLDeleteElements(&delegates);
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -335,7 +428,8 @@ TEST(HistogramTest, CorruptSampleCounts) {
   EXPECT_EQ(0, histogram->sample_.redundant_count());
   histogram->Add(20);  // Add some samples.
   histogram->Add(40);
-  EXPECT_EQ(2, histogram->sample_.redundant_count());
+  // They are held by this thread until a snapshot adds them up.
+  EXPECT_EQ(0, histogram->sample_.redundant_count());
 
   Histogram::SampleSet snapshot;
   histogram->SnapshotSample(&snapshot);
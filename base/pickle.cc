@@ -400,6 +400,14 @@ void Pickle::EndWrite(char* dest, int length) {
     memset(dest + length, 0, sizeof(uint32) - (length % sizeof(uint32)));
 }
 
+bool Pickle::Reserve(size_t length) {
+  size_t needed_size = header_size_ +
+      AlignInt(header_->payload_size, sizeof(uint32)) + length;
+  if (needed_size <= capacity_)
+    return true;
+  return Resize(needed_size);
+}
+
 bool Pickle::Resize(size_t new_capacity) {
   new_capacity = AlignInt(new_capacity, kPayloadUnit);
 
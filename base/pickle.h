@@ -138,6 +138,21 @@ class BASE_API Pickle {
   // not been changed.
   void TrimWriteData(int length);
 
+  // Makes room for |length| more bytes of payload, so that writes adding up
+  // to no more than that do not reallocate. Use the sizes below to add up
+  // what a series of writes takes. Returns false if allocation fails.
+  bool Reserve(size_t length);
+
+  // Returns the payload bytes used by WriteBytes() of |length| bytes, and by
+  // WriteString() or WriteData() of a |length| byte value. Fixed size values
+  // such as ints take GetBytesSize(sizeof(value)).
+  static size_t GetBytesSize(size_t length) {
+    return AlignInt(length, sizeof(uint32));
+  }
+  static size_t GetDataSize(size_t length) {
+    return sizeof(int) + GetBytesSize(length);
+  }
+
   // Payload follows after allocation of Header (header size is customizable).
   struct Header {
     uint32 payload_size;  // Specifies the size of the payload.
@@ -239,6 +254,7 @@ class BASE_API Pickle {
   size_t variable_buffer_offset_;  // IF non-zero, then offset to a buffer.
 
   FRIEND_TEST_ALL_PREFIXES(PickleTest, Resize);
+  FRIEND_TEST_ALL_PREFIXES(PickleTest, Reserve);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, FindNext);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, FindNextWithIncompleteHeader);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, IteratorHasRoom);
@@ -235,6 +235,29 @@ TEST(PickleTest, Resize) {
   EXPECT_EQ(cur_payload, pickle.payload_size());
 }
 
+TEST(PickleTest, Reserve) {
+  const std::string kString(1000, 'x');
+  Pickle pickle;
+  pickle.WriteInt(1);
+  size_t length = Pickle::GetDataSize(kString.size()) +
+                  Pickle::GetBytesSize(sizeof(uint16)) +
+                  Pickle::GetDataSize(3);
+  EXPECT_TRUE(pickle.Reserve(length));
+  size_t capacity = pickle.capacity();
+  const void* data = pickle.data();
+
+  pickle.WriteString(kString);
+  pickle.WriteUInt16(2);
+  pickle.WriteData("abc", 3);
+  EXPECT_EQ(capacity, pickle.capacity());
+  EXPECT_EQ(data, pickle.data());
+  EXPECT_GE(sizeof(int) + length, pickle.payload_size());
+
+  // Reserving what is already there does nothing.
+  EXPECT_TRUE(pickle.Reserve(0));
+  EXPECT_EQ(capacity, pickle.capacity());
+}
+
 namespace {
 
 struct CustomHeader : Pickle::Header {
@@ -0,0 +1,315 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/pickled_value_serializer.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+#include "base/string_util.h"
+
+// The data starts with kMagic and the format version. Each value is then
+// written as its Value::ValueType followed by:
+//   TYPE_NULL:       nothing.
+//   TYPE_BOOLEAN:    an int, 0 or 1.
+//   TYPE_INTEGER:    an int.
+//   TYPE_DOUBLE:     the 8 bytes of the double, in host order.
+//   TYPE_STRING:     a string.
+//   TYPE_BINARY:     a length and the bytes.
+//   TYPE_LIST:       the number of values, then each value.
+//   TYPE_DICTIONARY: the number of entries, then each key as a string
+//                    followed by its value.
+// Bump kVersion whenever this changes.
+
+namespace {
+
+const uint32 kMagic = 0x4c415650;  // "PVAL"
+
+const char kBadHeader[] = "Not a pickled value.";
+const char kUnsupportedVersion[] = "Unsupported pickled value version.";
+const char kCorruptData[] = "Pickled value is corrupt.";
+const char kTooMuchNesting[] = "Pickled value is nested too deeply.";
+
+class ValueWriter {
+ public:
+  explicit ValueWriter(Pickle* pickle) : pickle_(pickle) {}
+
+  bool Write(const Value& value, int depth) {
+    if (depth > PickledValueSerializer::kMaxDepth)
+      return false;
+    Value::ValueType type = value.GetType();
+    pickle_->WriteInt(type);
+    switch (type) {
+      case Value::TYPE_NULL:
+        return true;
+      case Value::TYPE_BOOLEAN: {
+        bool boolean = false;
+        value.GetAsBoolean(&boolean);
+        return pickle_->WriteBool(boolean);
+      }
+      case Value::TYPE_INTEGER: {
+        int integer = 0;
+        value.GetAsInteger(&integer);
+        return pickle_->WriteInt(integer);
+      }
+      case Value::TYPE_DOUBLE: {
+        double real = 0;
+        value.GetAsDouble(&real);
+        return pickle_->WriteBytes(&real, sizeof(real));
+      }
+      case Value::TYPE_STRING:
+        value.GetAsString(&string_);
+        return pickle_->WriteString(string_);
+      case Value::TYPE_BINARY: {
+        const BinaryValue& binary = static_cast<const BinaryValue&>(value);
+        return pickle_->WriteData(binary.GetBuffer(),
+                                  static_cast<int>(binary.GetSize()));
+      }
+      case Value::TYPE_LIST: {
+        const ListValue& list = static_cast<const ListValue&>(value);
+        pickle_->WriteInt(static_cast<int>(list.GetSize()));
+        for (ListValue::const_iterator it = list.begin(); it != list.end();
+             ++it) {
+          if (!Write(**it, depth + 1))
+            return false;
+        }
+        return true;
+      }
+      case Value::TYPE_DICTIONARY: {
+        const DictionaryValue& dictionary =
+            static_cast<const DictionaryValue&>(value);
+        pickle_->WriteInt(static_cast<int>(dictionary.size()));
+        for (DictionaryValue::key_iterator it = dictionary.begin_keys();
+             it != dictionary.end_keys(); ++it) {
+          Value* child = NULL;
+          dictionary.GetWithoutPathExpansion(*it, &child);
+          pickle_->WriteString(*it);
+          if (!Write(*child, depth + 1))
+            return false;
+        }
+        return true;
+      }
+      default:
+        NOTREACHED();
+        return false;
+    }
+  }
+
+ private:
+  Pickle* pickle_;
+
+  // Reused for every string value.
+  std::string string_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueWriter);
+};
+
+class ValueReader {
+ public:
+  ValueReader(const Pickle& pickle, void** iter)
+      : pickle_(pickle),
+        iter_(iter),
+        error_(PickledValueSerializer::PICKLE_NO_ERROR) {
+  }
+
+  // Returns NULL and sets error() if the data is corrupt.
+  Value* Read(int depth) {
+    if (depth > PickledValueSerializer::kMaxDepth) {
+      error_ = PickledValueSerializer::PICKLE_TOO_MUCH_NESTING;
+      return NULL;
+    }
+    int type;
+    if (!pickle_.ReadInt(iter_, &type))
+      return Fail();
+    switch (type) {
+      case Value::TYPE_NULL:
+        return Value::CreateNullValue();
+      case Value::TYPE_BOOLEAN: {
+        // Not ReadBool(), which DCHECKs rather than failing on other values.
+        int boolean;
+        if (!pickle_.ReadInt(iter_, &boolean) ||
+            (boolean != 0 && boolean != 1)) {
+          return Fail();
+        }
+        return Value::CreateBooleanValue(boolean != 0);
+      }
+      case Value::TYPE_INTEGER: {
+        int integer;
+        if (!pickle_.ReadInt(iter_, &integer))
+          return Fail();
+        return Value::CreateIntegerValue(integer);
+      }
+      case Value::TYPE_DOUBLE: {
+        const char* bytes;
+        if (!pickle_.ReadBytes(iter_, &bytes, sizeof(double)))
+          return Fail();
+        double real;
+        memcpy(&real, bytes, sizeof(real));
+        return Value::CreateDoubleValue(real);
+      }
+      case Value::TYPE_STRING:
+        // StringValue DCHECKs that its value is UTF-8.
+        if (!pickle_.ReadString(iter_, &string_) || !IsStringUTF8(string_))
+          return Fail();
+        return Value::CreateStringValue(string_);
+      case Value::TYPE_BINARY: {
+        const char* data;
+        int length;
+        if (!pickle_.ReadData(iter_, &data, &length))
+          return Fail();
+        return BinaryValue::CreateWithCopiedBuffer(data, length);
+      }
+      case Value::TYPE_LIST: {
+        // The count is not trusted to reserve memory: each value takes at
+        // least four bytes, so a bad count runs out of data quickly.
+        int count;
+        if (!pickle_.ReadLength(iter_, &count))
+          return Fail();
+        scoped_ptr<ListValue> list(new ListValue);
+        for (int i = 0; i < count; ++i) {
+          Value* child = Read(depth + 1);
+          if (!child)
+            return NULL;
+          list->Append(child);
+        }
+        return list.release();
+      }
+      case Value::TYPE_DICTIONARY: {
+        int count;
+        if (!pickle_.ReadLength(iter_, &count))
+          return Fail();
+        scoped_ptr<DictionaryValue> dictionary(new DictionaryValue);
+        std::string key;
+        for (int i = 0; i < count; ++i) {
+          // Keys must be UTF-8 too, or DictionaryValue's methods DCHECK.
+          if (!pickle_.ReadString(iter_, &key) || !IsStringUTF8(key))
+            return Fail();
+          Value* child = Read(depth + 1);
+          if (!child)
+            return NULL;
+          dictionary->SetWithoutPathExpansion(key, child);
+        }
+        return dictionary.release();
+      }
+      default:
+        return Fail();
+    }
+  }
+
+  PickledValueSerializer::ErrorCode error() const { return error_; }
+
+ private:
+  Value* Fail() {
+    error_ = PickledValueSerializer::PICKLE_CORRUPT_DATA;
+    return NULL;
+  }
+
+  const Pickle& pickle_;
+  void** iter_;
+  PickledValueSerializer::ErrorCode error_;
+
+  // Reused for every string value.
+  std::string string_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueReader);
+};
+
+}  // namespace
+
+const uint32 PickledValueSerializer::kVersion = 1;
+const int PickledValueSerializer::kMaxDepth = 100;
+
+PickledValueSerializer::PickledValueSerializer(std::string* data)
+    : data_(data),
+      input_(data) {
+}
+
+PickledValueSerializer::PickledValueSerializer(const std::string& data)
+    : data_(NULL),
+      input_(&data) {
+}
+
+PickledValueSerializer::~PickledValueSerializer() {
+}
+
+bool PickledValueSerializer::Serialize(const Value& root) {
+  if (!data_)
+    return false;
+
+  Pickle pickle;
+  pickle.WriteUInt32(kMagic);
+  pickle.WriteUInt32(kVersion);
+  if (!WriteValue(root, &pickle))
+    return false;
+  data_->assign(static_cast<const char*>(pickle.data()), pickle.size());
+  return true;
+}
+
+Value* PickledValueSerializer::Deserialize(int* error_code,
+                                           std::string* error_str) {
+  ErrorCode error = PICKLE_NO_ERROR;
+  scoped_ptr<Value> root;
+
+  // The Pickle refers to |input_| without copying it. Pickle reads ints in
+  // place, which is fine since std::string data is at least 32-bit aligned.
+  Pickle pickle(input_->data(), static_cast<int>(input_->size()));
+  void* iter = NULL;
+  uint32 magic;
+  uint32 version;
+  if (!pickle.ReadUInt32(&iter, &magic) || magic != kMagic ||
+      !pickle.ReadUInt32(&iter, &version)) {
+    error = PICKLE_BAD_HEADER;
+  } else if (version != kVersion) {
+    error = PICKLE_UNSUPPORTED_VERSION;
+  } else {
+    ValueReader reader(pickle, &iter);
+    root.reset(reader.Read(0));
+    if (!root.get())
+      error = reader.error();
+    else if (pickle.IteratorHasRoomFor(iter, 1))
+      error = PICKLE_CORRUPT_DATA;
+  }
+
+  if (error != PICKLE_NO_ERROR) {
+    if (error_code)
+      *error_code = error;
+    if (error_str)
+      *error_str = GetErrorMessage(error);
+    return NULL;
+  }
+  return root.release();
+}
+
+// static
+bool PickledValueSerializer::WriteValue(const Value& value, Pickle* pickle) {
+  ValueWriter writer(pickle);
+  return writer.Write(value, 0);
+}
+
+// static
+Value* PickledValueSerializer::ReadValue(const Pickle& pickle, void** iter) {
+  ValueReader reader(pickle, iter);
+  return reader.Read(0);
+}
+
+// static
+const char* PickledValueSerializer::GetErrorMessage(int error_code) {
+  switch (error_code) {
+    case PICKLE_NO_ERROR:
+      return "";
+    case PICKLE_BAD_HEADER:
+      return kBadHeader;
+    case PICKLE_UNSUPPORTED_VERSION:
+      return kUnsupportedVersion;
+    case PICKLE_CORRUPT_DATA:
+      return kCorruptData;
+    case PICKLE_TOO_MUCH_NESTING:
+      return kTooMuchNesting;
+    default:
+      NOTREACHED();
+      return "";
+  }
+}
@@ -0,0 +1,236 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+#include "base/pickled_value_serializer.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Returns a value with every type, nesting and a dictionary too large to be
+// stored flat.
+Value* CreateTestValue() {
+  DictionaryValue* root = new DictionaryValue;
+  root->SetWithoutPathExpansion("null", Value::CreateNullValue());
+  root->SetBoolean("true", true);
+  root->SetBoolean("false", false);
+  root->SetInteger("int", -42);
+  root->SetDouble("double", 3.25);
+  const char kString[] = "\xe7\xbd\x91\xe9\xa1\xb5 with a \0 byte";
+  root->SetString("string", std::string(kString, sizeof(kString) - 1));
+  root->SetString("empty", "");
+  const char kBinary[] = "\x01\x02\x03\x00\x05";
+  root->Set("binary",
+            BinaryValue::CreateWithCopiedBuffer(kBinary, sizeof(kBinary)));
+  root->Set("empty binary", BinaryValue::CreateWithCopiedBuffer(kBinary, 0));
+
+  ListValue* list = new ListValue;
+  list->Append(Value::CreateIntegerValue(1));
+  list->Append(new ListValue);
+  list->Append(new DictionaryValue);
+  root->Set("list", list);
+
+  DictionaryValue* large = new DictionaryValue;
+  for (int i = 0; i < 40; ++i)
+    large->SetInteger(base::StringPrintf("key%d", i), i);
+  root->Set("nested.large", large);
+  root->SetWithoutPathExpansion("dotted.key", Value::CreateIntegerValue(7));
+  return root;
+}
+
+std::string Serialize(const Value& value) {
+  std::string data;
+  PickledValueSerializer serializer(&data);
+  EXPECT_TRUE(serializer.Serialize(value));
+  return data;
+}
+
+Value* Deserialize(const std::string& data, int* error_code) {
+  PickledValueSerializer serializer(data);
+  return serializer.Deserialize(error_code, NULL);
+}
+
+// Returns |depth| lists nested in each other.
+Value* CreateNestedLists(int depth) {
+  Value* value = new ListValue;
+  for (int i = 1; i < depth; ++i) {
+    ListValue* list = new ListValue;
+    list->Append(value);
+    value = list;
+  }
+  return value;
+}
+
+}  // namespace
+
+TEST(PickledValueSerializerTest, RoundTrip) {
+  scoped_ptr<Value> value(CreateTestValue());
+  std::string data = Serialize(*value);
+
+  int error_code = -1;
+  scoped_ptr<Value> copy(Deserialize(data, &error_code));
+  ASSERT_TRUE(copy.get());
+  EXPECT_EQ(-1, error_code);
+  EXPECT_TRUE(value->Equals(copy.get()));
+
+  // Scalars work as the root too.
+  scoped_ptr<Value> scalar(Value::CreateDoubleValue(-0.5));
+  copy.reset(Deserialize(Serialize(*scalar), NULL));
+  ASSERT_TRUE(copy.get());
+  EXPECT_TRUE(scalar->Equals(copy.get()));
+}
+
+TEST(PickledValueSerializerTest, ReadOnly) {
+  std::string data;
+  PickledValueSerializer serializer(static_cast<const std::string&>(data));
+  EXPECT_FALSE(serializer.Serialize(ListValue()));
+  EXPECT_TRUE(data.empty());
+}
+
+TEST(PickledValueSerializerTest, EmbeddedInPickle) {
+  scoped_ptr<Value> value(CreateTestValue());
+  Pickle pickle;
+  pickle.WriteInt(1234);
+  EXPECT_TRUE(PickledValueSerializer::WriteValue(*value, &pickle));
+  pickle.WriteString("after");
+
+  void* iter = NULL;
+  int before;
+  EXPECT_TRUE(pickle.ReadInt(&iter, &before));
+  EXPECT_EQ(1234, before);
+  scoped_ptr<Value> copy(PickledValueSerializer::ReadValue(pickle, &iter));
+  ASSERT_TRUE(copy.get());
+  EXPECT_TRUE(value->Equals(copy.get()));
+  std::string after;
+  EXPECT_TRUE(pickle.ReadString(&iter, &after));
+  EXPECT_EQ("after", after);
+}
+
+TEST(PickledValueSerializerTest, BadHeader) {
+  int error_code = 0;
+  std::string error_message;
+  PickledValueSerializer serializer("{\"json\": true}");
+  EXPECT_FALSE(serializer.Deserialize(&error_code, &error_message));
+  EXPECT_EQ(PickledValueSerializer::PICKLE_BAD_HEADER, error_code);
+  EXPECT_EQ("Not a pickled value.", error_message);
+
+  EXPECT_FALSE(Deserialize(std::string(), &error_code));
+  EXPECT_EQ(PickledValueSerializer::PICKLE_BAD_HEADER, error_code);
+}
+
+TEST(PickledValueSerializerTest, OtherVersion) {
+  std::string data = Serialize(ListValue());
+  Pickle original(data.data(), static_cast<int>(data.size()));
+  void* iter = NULL;
+  uint32 magic;
+  ASSERT_TRUE(original.ReadUInt32(&iter, &magic));
+
+  Pickle pickle;
+  pickle.WriteUInt32(magic);
+  pickle.WriteUInt32(PickledValueSerializer::kVersion + 1);
+  PickledValueSerializer::WriteValue(ListValue(), &pickle);
+  int error_code = 0;
+  EXPECT_FALSE(Deserialize(
+      std::string(static_cast<const char*>(pickle.data()), pickle.size()),
+      &error_code));
+  EXPECT_EQ(PickledValueSerializer::PICKLE_UNSUPPORTED_VERSION, error_code);
+}
+
+TEST(PickledValueSerializerTest, Nesting) {
+  int depth = PickledValueSerializer::kMaxDepth + 1;
+  scoped_ptr<Value> value(CreateNestedLists(depth));
+  scoped_ptr<Value> copy(Deserialize(Serialize(*value), NULL));
+  ASSERT_TRUE(copy.get());
+  EXPECT_TRUE(value->Equals(copy.get()));
+
+  std::string data;
+  PickledValueSerializer serializer(&data);
+  value.reset(CreateNestedLists(depth + 1));
+  EXPECT_FALSE(serializer.Serialize(*value));
+
+  // Data written by hand is still checked when reading.
+  Pickle pickle;
+  for (int i = 0; i < 1000; ++i) {
+    pickle.WriteInt(Value::TYPE_LIST);
+    pickle.WriteInt(1);
+  }
+  pickle.WriteInt(Value::TYPE_NULL);
+  void* iter = NULL;
+  EXPECT_FALSE(PickledValueSerializer::ReadValue(pickle, &iter));
+}
+
+TEST(PickledValueSerializerTest, CorruptCounts) {
+  const int kCounts[] = { -1, 5, 0x7fffffff };
+  for (size_t i = 0; i < arraysize(kCounts); ++i) {
+    for (int type = Value::TYPE_STRING; type <= Value::TYPE_LIST;
+         ++type) {
+      Pickle pickle;
+      pickle.WriteInt(type);
+      pickle.WriteInt(kCounts[i]);
+      pickle.WriteInt(Value::TYPE_NULL);
+      void* iter = NULL;
+      scoped_ptr<Value> value(PickledValueSerializer::ReadValue(pickle, &iter));
+      EXPECT_FALSE(value.get()) << "type " << type << " count " << kCounts[i];
+    }
+  }
+
+  Pickle pickle;
+  pickle.WriteInt(Value::TYPE_BOOLEAN);
+  pickle.WriteInt(2);
+  void* iter = NULL;
+  EXPECT_FALSE(PickledValueSerializer::ReadValue(pickle, &iter));
+
+  pickle.WriteInt(Value::TYPE_LIST + 1);
+  iter = NULL;
+  EXPECT_FALSE(PickledValueSerializer::ReadValue(pickle, &iter));
+}
+
+TEST(PickledValueSerializerTest, Truncated) {
+  scoped_ptr<Value> value(CreateTestValue());
+  std::string data = Serialize(*value);
+  // Every prefix of the data is rejected.
+  for (size_t length = 0; length < data.size(); ++length) {
+    int error_code = 0;
+    scoped_ptr<Value> copy(Deserialize(data.substr(0, length), &error_code));
+    EXPECT_FALSE(copy.get()) << length;
+    EXPECT_NE(PickledValueSerializer::PICKLE_NO_ERROR, error_code);
+  }
+
+  // So is data with something after the value.
+  EXPECT_FALSE(Deserialize(data + std::string(4, '\0'), NULL));
+}
+
+TEST(PickledValueSerializerTest, Fuzz) {
+  scoped_ptr<Value> value(CreateTestValue());
+  const std::string original = Serialize(*value);
+
+  // Corrupts a few bytes at a time with a fixed pseudo-random sequence. The
+  // reader must never crash, and anything it accepts must be a valid value.
+  uint32 seed = 1;
+  int accepted = 0;
+  for (int i = 0; i < 20000; ++i) {
+    std::string data = original;
+    int changes = 1 + i % 4;
+    for (int j = 0; j < changes; ++j) {
+      seed = seed * 1103515245 + 12345;
+      size_t offset = (seed >> 8) % data.size();
+      seed = seed * 1103515245 + 12345;
+      data[offset] = static_cast<char>(seed >> 16);
+    }
+    scoped_ptr<Value> copy(Deserialize(data, NULL));
+    if (copy.get()) {
+      ++accepted;
+      scoped_ptr<Value> again(Deserialize(Serialize(*copy), NULL));
+      ASSERT_TRUE(again.get());
+      EXPECT_TRUE(copy->Equals(again.get()));
+    }
+  }
+  // Changes to integers and string contents still give valid values.
+  EXPECT_GT(accepted, 0);
+}
@@ -6,7 +6,10 @@
 
 #include <string.h>
 
+#include <algorithm>
+
 #include "base/basictypes.h"
+#include "base/sha_simd.h"
 
 namespace base {
 
@@ -33,7 +36,7 @@ namespace base {
 
 class SecureHashAlgorithm {
  public:
-  SecureHashAlgorithm() { Init(); }
+  SecureHashAlgorithm() : kernels_(internal::GetSHAKernels()) { Init(); }
 
   static const int kDigestSizeBytes;
 
@@ -61,6 +64,9 @@ class SecureHashAlgorithm {
 
   uint32 cursor;
   uint32 l;
+
+  // The SHA instructions of the CPU, if it has them.
+  const internal::SHAKernels* kernels_;
 };
 
 static inline uint32 f(uint32 t, uint32 B, uint32 C, uint32 D) {
@@ -125,12 +131,36 @@ void SecureHashAlgorithm::Final() {
 
 void SecureHashAlgorithm::Update(const void* data, size_t nbytes) {
   const uint8* d = reinterpret_cast<const uint8*>(data);
-  while (nbytes--) {
-    M[cursor++] = *d++;
-    if (cursor >= 64)
-      Process();
-    l += 8;
+  l += static_cast<uint32>(nbytes) * 8;
+
+  // Fill up the partial block.
+  if (cursor) {
+    size_t todo = std::min(nbytes, static_cast<size_t>(64 - cursor));
+    memcpy(M + cursor, d, todo);
+    cursor += static_cast<uint32>(todo);
+    d += todo;
+    nbytes -= todo;
+    if (cursor < 64)
+      return;
+    Process();
   }
+
+  // Hash whole blocks in place when the CPU can.
+  if (kernels_ && nbytes >= 64) {
+    kernels_->sha1_blocks(H, d, nbytes / 64);
+    d += nbytes & ~static_cast<size_t>(63);
+    nbytes &= 63;
+  }
+
+  while (nbytes >= 64) {
+    memcpy(M, d, 64);
+    Process();
+    d += 64;
+    nbytes -= 64;
+  }
+
+  memcpy(M, d, nbytes);
+  cursor = static_cast<uint32>(nbytes);
 }
 
 void SecureHashAlgorithm::Pad() {
@@ -154,6 +184,12 @@ void SecureHashAlgorithm::Pad() {
 }
 
 void SecureHashAlgorithm::Process() {
+  if (kernels_) {
+    kernels_->sha1_blocks(H, M, 1);
+    cursor = 0;
+    return;
+  }
+
   uint32 t;
 
   // Each a...e corresponds to a section in the FIPS 180-3 algorithm.
@@ -106,3 +106,26 @@ TEST(SHA1Test, Test3Bytes) {
   for (size_t i = 0; i < base::SHA1_LENGTH; i++)
     EXPECT_EQ(expected[i], output[i]);
 }
+
+TEST(SHA1Test, AllLengths) {
+  // Hashes messages of every length up to a few blocks, which end at every
+  // position in a block, then hashes their digests together. The expected
+  // digest was computed by another implementation.
+  std::string digests;
+  for (size_t length = 0; length < 300; ++length) {
+    std::string input;
+    for (size_t i = 0; i < length; ++i)
+      input.push_back(static_cast<char>(i * 7 + length));
+    digests += base::SHA1HashString(input);
+  }
+
+  unsigned char expected[] = { 0xdf, 0xc9, 0x42, 0xb5,
+                               0xdd, 0xc5, 0xfe, 0x64,
+                               0x21, 0xcc, 0xad, 0xa9,
+                               0xbe, 0x50, 0xfa, 0x42,
+                               0xe8, 0x73, 0x92, 0x6c };
+
+  std::string output = base::SHA1HashString(digests);
+  for (size_t i = 0; i < base::SHA1_LENGTH; i++)
+    EXPECT_EQ(expected[i], output[i] & 0xFF);
+}
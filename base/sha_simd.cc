@@ -0,0 +1,216 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/sha_simd.h"
+
+#include <algorithm>
+
+#include "base/cpu.h"
+#include "base/lazy_instance.h"
+#include "build/build_config.h"
+
+// The SHA instructions are only compiled into the functions that use them, so
+// that the rest of the file runs on any CPU. This needs GCC 4.9 or clang 3.8.
+#if defined(ARCH_CPU_X86_FAMILY) && \
+    ((defined(__clang__) && \
+      (__clang_major__ > 3 || \
+       (__clang_major__ == 3 && __clang_minor__ >= 8))) || \
+     (!defined(__clang__) && defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SHA_NI_KERNELS 1
+#define SHA_NI_TARGET __attribute__((target("sha,ssse3,sse4.1")))
+#include <immintrin.h>
+#endif
+
+namespace base {
+namespace internal {
+
+namespace {
+
+#if defined(SHA_NI_KERNELS)
+
+const size_t kBlockSize = 64;
+
+// Runs rounds 4 * |group| to 4 * |group| + 3 of SHA-1 on the message schedule
+// words in |msg[0]|, and extends the schedule in the other three, which hold
+// those of the following groups. Then moves the next group's words to
+// |msg[0]|, which costs nothing once the loops are unrolled. The round function
+// is a template parameter because sha1rnds4 takes it as an immediate.
+template<int kFunction>
+SHA_NI_TARGET inline void SHA1FourRounds(int group,
+                                         __m128i* abcd,
+                                         __m128i* e,
+                                         __m128i* next_e,
+                                         __m128i msg[4]) {
+  if (group == 0)
+    *e = _mm_add_epi32(*e, msg[0]);
+  else
+    *e = _mm_sha1nexte_epu32(*e, msg[0]);
+  *next_e = *abcd;
+  if (group >= 3 && group <= 18)
+    msg[1] = _mm_sha1msg2_epu32(msg[1], msg[0]);
+  *abcd = _mm_sha1rnds4_epu32(*abcd, *e, kFunction);
+  if (group >= 1 && group <= 16)
+    msg[3] = _mm_sha1msg1_epu32(msg[3], msg[0]);
+  if (group >= 2 && group <= 17)
+    msg[2] = _mm_xor_si128(msg[2], msg[0]);
+
+  __m128i current = msg[0];
+  msg[0] = msg[1];
+  msg[1] = msg[2];
+  msg[2] = msg[3];
+  msg[3] = current;
+  std::swap(*e, *next_e);
+}
+
+SHA_NI_TARGET void SHA1BlocksSHANI(uint32 state[5],
+                                   const uint8* data,
+                                   size_t blocks) {
+  // Loads the big-endian message words in the order the instructions take.
+  const __m128i kShuffle = _mm_set_epi64x(0x0001020304050607LL,
+                                          0x08090a0b0c0d0e0fLL);
+  __m128i abcd = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+  __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+  for (; blocks; --blocks, data += kBlockSize) {
+    __m128i abcd_save = abcd;
+    __m128i e_save = e0;
+    __m128i msg[4];
+    for (int i = 0; i < 4; ++i) {
+      msg[i] = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)),
+          kShuffle);
+    }
+    __m128i e1;
+    for (int group = 0; group < 5; ++group)
+      SHA1FourRounds<0>(group, &abcd, &e0, &e1, msg);
+    for (int group = 5; group < 10; ++group)
+      SHA1FourRounds<1>(group, &abcd, &e0, &e1, msg);
+    for (int group = 10; group < 15; ++group)
+      SHA1FourRounds<2>(group, &abcd, &e0, &e1, msg);
+    for (int group = 15; group < 20; ++group)
+      SHA1FourRounds<3>(group, &abcd, &e0, &e1, msg);
+    e0 = _mm_sha1nexte_epu32(e0, e_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_shuffle_epi32(abcd, 0x1B));
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+const uint32 kSHA256RoundConstants[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+SHA_NI_TARGET void SHA256BlocksSHANI(uint32 state[8],
+                                     const uint8* data,
+                                     size_t blocks) {
+  // Loads the big-endian message words in host order.
+  const __m128i kShuffle = _mm_set_epi64x(0x0c0d0e0f08090a0bLL,
+                                          0x0405060700010203LL);
+  // sha256rnds2 takes the state as ABEF and CDGH.
+  __m128i cdab = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+  __m128i efgh = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+  __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+  __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+  for (; blocks; --blocks, data += kBlockSize) {
+    __m128i abef_save = abef;
+    __m128i cdgh_save = cdgh;
+    __m128i msg[4];
+    for (int i = 0; i < 4; ++i) {
+      msg[i] = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)),
+          kShuffle);
+    }
+    // Each group runs four rounds, two per sha256rnds2, on the message
+    // schedule words in msg[0], and extends the schedule in the other three,
+    // which hold those of the following groups. Then it moves the next
+    // group's words to msg[0].
+    for (int group = 0; group < 16; ++group) {
+      __m128i words = _mm_add_epi32(msg[0], _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(
+              kSHA256RoundConstants + group * 4)));
+      cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+      if (group >= 3 && group <= 14) {
+        msg[1] = _mm_add_epi32(msg[1], _mm_alignr_epi8(msg[0], msg[3], 4));
+        msg[1] = _mm_sha256msg2_epu32(msg[1], msg[0]);
+      }
+      abef = _mm_sha256rnds2_epu32(abef, cdgh,
+                                   _mm_shuffle_epi32(words, 0x0E));
+      if (group >= 1 && group <= 12)
+        msg[3] = _mm_sha256msg1_epu32(msg[3], msg[0]);
+
+      __m128i current = msg[0];
+      msg[0] = msg[1];
+      msg[1] = msg[2];
+      msg[2] = msg[3];
+      msg[3] = current;
+    }
+    abef = _mm_add_epi32(abef, abef_save);
+    cdgh = _mm_add_epi32(cdgh, cdgh_save);
+  }
+
+  __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+  __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_blend_epi16(feba, dchg, 0xF0));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4),
+                   _mm_alignr_epi8(dchg, feba, 8));
+}
+
+const SHAKernels kSHANIKernels = {
+  &SHA1BlocksSHANI,
+  &SHA256BlocksSHANI,
+};
+
+#endif  // defined(SHA_NI_KERNELS)
+
+// Picks the kernels for the CPU we run on, once.
+class KernelsForCPU {
+ public:
+  KernelsForCPU() : kernels_(NULL) {
+#if defined(SHA_NI_KERNELS)
+    base::CPU cpu;
+    if (cpu.has_sha() && cpu.has_ssse3() && cpu.has_sse41())
+      kernels_ = &kSHANIKernels;
+#endif
+  }
+
+  const SHAKernels* kernels() const { return kernels_; }
+
+ private:
+  const SHAKernels* kernels_;
+};
+
+base::LazyInstance<KernelsForCPU, base::LeakyLazyInstanceTraits<KernelsForCPU> >
+    g_kernels_for_cpu(base::LINKER_INITIALIZED);
+
+}  // namespace
+
+const SHAKernels* GetSHAKernels() {
+  return g_kernels_for_cpu.Get().kernels();
+}
+
+}  // namespace internal
+}  // namespace base
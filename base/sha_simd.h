@@ -0,0 +1,35 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Versions of the SHA-1 and SHA-256 block functions that use the SHA
+// instructions of x86 CPUs. They give exactly the result of the portable code
+// in sha1_portable.cc and crypto/third_party/nss/sha512.cc, which use them
+// when the CPU has them. Call base::SHA1HashBytes() and
+// crypto::SHA256HashString() instead.
+
+#ifndef BASE_SHA_SIMD_H_
+#define BASE_SHA_SIMD_H_
+#pragma once
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+
+namespace base {
+namespace internal {
+
+struct SHAKernels {
+  // Process the |blocks| 64-byte blocks at |data|, which need not be aligned,
+  // into the hash |state|, whose words are in host order.
+  void (*sha1_blocks)(uint32 state[5], const uint8* data, size_t blocks);
+  void (*sha256_blocks)(uint32 state[8], const uint8* data, size_t blocks);
+};
+
+// Returns the kernels that this build has and the CPU can run, or NULL if
+// there are none. Picks them the first time it is called.
+BASE_API const SHAKernels* GetSHAKernels();
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_SHA_SIMD_H_
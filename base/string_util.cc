@@ -23,6 +23,7 @@
 #include "base/basictypes.h"
 #include "base/logging.h"
 #include "base/memory/singleton.h"
+#include "base/string_util_simd.h"
 #include "base/third_party/dmg_fp/dmg_fp.h"
 #include "base/utf_string_conversion_utils.h"
 #include "base/utf_string_conversions.h"
@@ -63,6 +64,17 @@ static bool CompareParameter(const ReplacementOffset& elem1,
   return elem1.parameter < elem2.parameter;
 }
 
+// Shorter strings are not worth handing to the vectorized kernels.
+const size_t kMinKernelLength = 16;
+
+// Returns the kernels for a string of |length| chars, or NULL to use the plain
+// loops.
+const base::internal::StringKernels* GetStringKernels(size_t length) {
+  if (length < kMinKernelLength)
+    return NULL;
+  return base::internal::GetStringKernels();
+}
+
 }  // namespace
 
 namespace base {
@@ -306,10 +318,43 @@ TrimPositions TrimWhitespace(const string16& input,
 }
 #endif
 
+// The chars of kWhitespaceASCII.
+static inline bool IsWhitespaceASCII(char c) {
+  return c == ' ' || (c >= 0x09 && c <= 0x0D);
+}
+
 TrimPositions TrimWhitespaceASCII(const std::string& input,
                                   TrimPositions positions,
                                   std::string* output) {
-  return TrimStringT(input, kWhitespaceASCII, positions, output);
+  // Behaves as TrimStringT() with kWhitespaceASCII, without searching the set
+  // for each char or copying when |output| is |input|.
+  size_t begin = 0;
+  size_t end = input.length();
+  if (positions & TRIM_LEADING) {
+    while (begin < end && IsWhitespaceASCII(input[begin]))
+      ++begin;
+  }
+  if (positions & TRIM_TRAILING) {
+    while (end > begin && IsWhitespaceASCII(input[end - 1]))
+      --end;
+  }
+
+  if (begin == end) {
+    bool input_was_empty = input.empty();  // in case output == &input
+    output->clear();
+    return input_was_empty ? TRIM_NONE : positions;
+  }
+
+  TrimPositions trimmed = static_cast<TrimPositions>(
+      ((begin == 0) ? TRIM_NONE : TRIM_LEADING) |
+      ((end == input.length()) ? TRIM_NONE : TRIM_TRAILING));
+  if (output == &input) {
+    output->erase(end);
+    output->erase(0, begin);
+  } else {
+    output->assign(input, begin, end - begin);
+  }
+  return trimmed;
 }
 
 // This function is only for backward-compatibility.
@@ -461,14 +506,32 @@ bool IsStringASCII(const std::wstring& str) {
 
 #if !defined(WCHAR_T_IS_UTF16)
 bool IsStringASCII(const string16& str) {
+  const base::internal::StringKernels* kernels =
+      GetStringKernels(str.length());
+  if (kernels)
+    return kernels->is_ascii16(str.data(), str.length());
   return DoIsStringASCII(str);
 }
 #endif
 
 bool IsStringASCII(const base::StringPiece& str) {
+  const base::internal::StringKernels* kernels =
+      GetStringKernels(str.length());
+  if (kernels)
+    return kernels->is_ascii(str.data(), str.length());
   return DoIsStringASCII(str);
 }
 
+void StringToLowerASCII(std::string* s) {
+  const base::internal::StringKernels* kernels = GetStringKernels(s->length());
+  if (kernels) {
+    kernels->to_lower_ascii(&(*s)[0], s->length());
+    return;
+  }
+  for (std::string::iterator i = s->begin(); i != s->end(); ++i)
+    *i = base::ToLowerASCII(*i);
+}
+
 bool IsStringUTF8(const std::string& str) {
   const char *src = str.data();
   int32 src_len = static_cast<int32>(str.length());
@@ -494,9 +557,21 @@ static inline bool DoLowerCaseEqualsASCII(Iter a_begin,
   return *b == 0;
 }
 
+// Compares with the vectorized kernels when |a| is long enough, after
+// checking the length of |b|.
+static bool DoLowerCaseEqualsASCII(const char* a,
+                                   size_t a_length,
+                                   const char* b) {
+  const base::internal::StringKernels* kernels = GetStringKernels(a_length);
+  if (!kernels)
+    return DoLowerCaseEqualsASCII(a, a + a_length, b);
+  return strlen(b) == a_length &&
+         kernels->lower_case_equals_ascii(a, b, a_length);
+}
+
 // Front-ends for LowerCaseEqualsASCII.
 bool LowerCaseEqualsASCII(const std::string& a, const char* b) {
-  return DoLowerCaseEqualsASCII(a.begin(), a.end(), b);
+  return DoLowerCaseEqualsASCII(a.data(), a.length(), b);
 }
 
 bool LowerCaseEqualsASCII(const std::wstring& a, const char* b) {
@@ -512,7 +587,9 @@ bool LowerCaseEqualsASCII(const string16& a, const char* b) {
 bool LowerCaseEqualsASCII(std::string::const_iterator a_begin,
                           std::string::const_iterator a_end,
                           const char* b) {
-  return DoLowerCaseEqualsASCII(a_begin, a_end, b);
+  if (a_begin == a_end)
+    return *b == 0;
+  return DoLowerCaseEqualsASCII(&*a_begin, a_end - a_begin, b);
 }
 
 bool LowerCaseEqualsASCII(std::wstring::const_iterator a_begin,
@@ -533,7 +610,7 @@ bool LowerCaseEqualsASCII(string16::const_iterator a_begin,
 bool LowerCaseEqualsASCII(const char* a_begin,
                           const char* a_end,
                           const char* b) {
-  return DoLowerCaseEqualsASCII(a_begin, a_end, b);
+  return DoLowerCaseEqualsASCII(a_begin, a_end - a_begin, b);
 }
 #endif // !ANDROID
 
@@ -715,14 +792,33 @@ void DoReplaceSubstringsAfterOffset(StringType* str,
     return;
 
   DCHECK(!find_this.empty());
-  for (typename StringType::size_type offs(str->find(find_this, start_offset));
-      offs != StringType::npos; offs = str->find(find_this, offs)) {
-    str->replace(offs, find_this.length(), replace_with);
-    offs += replace_with.length();
+  typename StringType::size_type offs = str->find(find_this, start_offset);
+  if (offs == StringType::npos)
+    return;
+  if (!replace_all || find_this.length() == replace_with.length()) {
+    // A single replacement, or ones that move nothing: replace in place.
+    while (offs != StringType::npos) {
+      str->replace(offs, find_this.length(), replace_with);
+      if (!replace_all)
+        break;
+      offs = str->find(find_this, offs + replace_with.length());
+    }
+    return;
+  }
 
-    if (!replace_all)
-      break;
+  // Build the result in one pass, rather than moving the rest of the string
+  // at each replacement.
+  StringType result;
+  result.reserve(str->length());
+  typename StringType::size_type copied = 0;
+  while (offs != StringType::npos) {
+    result.append(*str, copied, offs - copied);
+    result.append(replace_with);
+    copied = offs + find_this.length();
+    offs = str->find(find_this, copied);
   }
+  result.append(*str, copied, StringType::npos);
+  str->swap(result);
 }
 
 void ReplaceFirstSubstringAfterOffset(string16* str,
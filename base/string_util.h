@@ -294,6 +294,8 @@ BASE_API bool IsStringASCII(const string16& str);
 
 // Converts the elements of the given string.  This version uses a pointer to
 // clearly differentiate it from the non-pointer variant.
+BASE_API void StringToLowerASCII(std::string* s);
+
 template <class str> inline void StringToLowerASCII(str* s) {
   for (typename str::iterator i = s->begin(); i != s->end(); ++i)
     *i = base::ToLowerASCII(*i);
@@ -0,0 +1,142 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/perftimer.h"
+#include "base/string_number_conversions.h"
+#include "base/string_util.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Each measurement goes through this many bytes.
+const size_t kBytes = 64 * 1024 * 1024;
+
+// String lengths from short header values up to whole documents.
+const size_t kLengths[] = { 8, 32, 128, 1024, 16384 };
+
+// Returns a mixed-case ASCII string of |length| chars, like a header line.
+std::string HeaderLikeString(size_t length) {
+  const char kChars[] = "Content-Type: Text/HTML; Charset=UTF-8 ";
+  std::string result;
+  for (size_t i = 0; i < length; ++i)
+    result.push_back(kChars[i % (arraysize(kChars) - 1)]);
+  return result;
+}
+
+bool PlainIsStringASCII(const std::string& str) {
+  for (size_t i = 0; i < str.length(); ++i) {
+    if (static_cast<unsigned char>(str[i]) > 0x7F)
+      return false;
+  }
+  return true;
+}
+
+void PlainToLowerASCII(std::string* str) {
+  for (std::string::iterator i = str->begin(); i != str->end(); ++i)
+    *i = ToLowerASCII(*i);
+}
+
+bool PlainLowerCaseEqualsASCII(const std::string& a, const char* b) {
+  for (std::string::const_iterator it = a.begin(); it != a.end(); ++it, ++b) {
+    if (!*b || ToLowerASCII(*it) != *b)
+      return false;
+  }
+  return *b == 0;
+}
+
+// Logs the MB/s of the plain loop and of the string_util helper for |name|.
+// |plain| and |helper| go through the string once, and return the same value.
+template <typename Plain, typename Helper>
+void Measure(const char* name, Plain plain, Helper helper) {
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    size_t length = kLengths[i];
+    std::string str = HeaderLikeString(length);
+    std::string lower = StringToLowerASCII(str);
+    size_t runs = kBytes / length;
+
+    int matches = 0;
+    PerfTimer plain_timer;
+    for (size_t run = 0; run < runs; ++run)
+      matches += plain(&str, lower);
+    double plain_seconds = plain_timer.Elapsed().InSecondsF();
+
+    PerfTimer helper_timer;
+    for (size_t run = 0; run < runs; ++run)
+      matches -= helper(&str, lower);
+    double helper_seconds = helper_timer.Elapsed().InSecondsF();
+    EXPECT_EQ(0, matches);
+
+    double megabytes = static_cast<double>(kBytes) / (1024 * 1024);
+    LogPerfResult(StringPrintf("%s_plain_%d", name,
+                               static_cast<int>(length)).c_str(),
+                  megabytes / plain_seconds, "MB/s");
+    LogPerfResult(StringPrintf("%s_%d", name,
+                               static_cast<int>(length)).c_str(),
+                  megabytes / helper_seconds, "MB/s");
+  }
+}
+
+int RunPlainIsStringASCII(std::string* str, const std::string& lower) {
+  return PlainIsStringASCII(*str);
+}
+int RunIsStringASCII(std::string* str, const std::string& lower) {
+  return IsStringASCII(*str);
+}
+
+// Lowercases a copy the size of the caller's string, as callers mostly do.
+int RunPlainToLowerASCII(std::string* str, const std::string& lower) {
+  std::string copy(*str);
+  PlainToLowerASCII(&copy);
+  return copy[0];
+}
+int RunStringToLowerASCII(std::string* str, const std::string& lower) {
+  std::string copy(*str);
+  StringToLowerASCII(&copy);
+  return copy[0];
+}
+
+int RunPlainLowerCaseEqualsASCII(std::string* str, const std::string& lower) {
+  return PlainLowerCaseEqualsASCII(*str, lower.c_str());
+}
+int RunLowerCaseEqualsASCII(std::string* str, const std::string& lower) {
+  return LowerCaseEqualsASCII(*str, lower.c_str());
+}
+
+}  // namespace
+
+TEST(StringUtilPerfTest, IsStringASCII) {
+  Measure("IsStringASCII", &RunPlainIsStringASCII, &RunIsStringASCII);
+}
+
+TEST(StringUtilPerfTest, StringToLowerASCII) {
+  Measure("StringToLowerASCII", &RunPlainToLowerASCII,
+          &RunStringToLowerASCII);
+}
+
+TEST(StringUtilPerfTest, LowerCaseEqualsASCII) {
+  Measure("LowerCaseEqualsASCII", &RunPlainLowerCaseEqualsASCII,
+          &RunLowerCaseEqualsASCII);
+}
+
+TEST(StringUtilPerfTest, ReplaceSubstringsAfterOffset) {
+  // Every header line of a large block gets a longer line ending.
+  std::string headers;
+  for (int i = 0; i < 2000; ++i)
+    headers += "Header-" + IntToString(i) + ": value\n";
+  PerfTimer timer;
+  for (int run = 0; run < 20; ++run) {
+    std::string copy(headers);
+    ReplaceSubstringsAfterOffset(&copy, 0, "\n", "\r\n");
+    EXPECT_EQ(headers.length() + 2000, copy.length());
+  }
+  LogPerfResult("ReplaceSubstringsAfterOffset_2000_lines",
+                20 / timer.Elapsed().InSecondsF(), "runs/s");
+}
+
+}  // namespace base
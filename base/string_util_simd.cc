@@ -0,0 +1,290 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/string_util_simd.h"
+
+#include "base/cpu.h"
+#include "base/lazy_instance.h"
+#include "build/build_config.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace base {
+namespace internal {
+
+namespace {
+
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+
+// The kernels work on blocks of kBlockSize chars, and finish the remaining
+// ones with these loops.
+const size_t kBlockSize = 16;
+
+bool IsASCIITail(const char* str, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    if (static_cast<unsigned char>(str[i]) > 0x7F)
+      return false;
+  }
+  return true;
+}
+
+bool IsASCIITail16(const char16* str, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    if (static_cast<uint16>(str[i]) > 0x7F)
+      return false;
+  }
+  return true;
+}
+
+void ToLowerASCIITail(char* str, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    if (str[i] >= 'A' && str[i] <= 'Z')
+      str[i] += 'a' - 'A';
+  }
+}
+
+bool LowerCaseEqualsASCIITail(const char* a, const char* b, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    char c = a[i];
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    if (c != b[i])
+      return false;
+  }
+  return true;
+}
+
+#if defined(__SSE2__)
+
+inline __m128i Load(const void* p) {
+  return _mm_loadu_si128(static_cast<const __m128i*>(p));
+}
+
+// Adds 0x20 to the bytes in ['A', 'Z']. Bytes above 0x7F compare as negative,
+// so they are left alone.
+inline __m128i ToLower(__m128i chars) {
+  const __m128i before_a = _mm_set1_epi8('A' - 1);
+  const __m128i after_z = _mm_set1_epi8('Z' + 1);
+  __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chars, before_a),
+                                _mm_cmplt_epi8(chars, after_z));
+  return _mm_add_epi8(chars, _mm_and_si128(upper, _mm_set1_epi8('a' - 'A')));
+}
+
+bool IsASCIISSE2(const char* str, size_t length) {
+  // ASCII is the common case, so check the high bits once at the end.
+  __m128i bits = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize)
+    bits = _mm_or_si128(bits, Load(str + i));
+  return !_mm_movemask_epi8(bits) && IsASCIITail(str + i, length - i);
+}
+
+bool IsASCII16SSE2(const char16* str, size_t length) {
+  const size_t kChars = kBlockSize / sizeof(char16);
+  __m128i bits = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + kChars <= length; i += kChars)
+    bits = _mm_or_si128(bits, Load(str + i));
+  __m128i non_ascii = _mm_and_si128(bits, _mm_set1_epi16(~0x7F));
+  return _mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii,
+                                           _mm_setzero_si128())) == 0xFFFF &&
+         IsASCIITail16(str + i, length - i);
+}
+
+void ToLowerASCIISSE2(char* str, size_t length) {
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(str + i),
+                     ToLower(Load(str + i)));
+  }
+  ToLowerASCIITail(str + i, length - i);
+}
+
+bool LowerCaseEqualsASCIISSE2(const char* a, const char* b, size_t length) {
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    __m128i equal = _mm_cmpeq_epi8(ToLower(Load(a + i)), Load(b + i));
+    if (_mm_movemask_epi8(equal) != 0xFFFF)
+      return false;
+  }
+  return LowerCaseEqualsASCIITail(a + i, b + i, length - i);
+}
+
+size_t WidenASCIISSE2(const char* src, size_t length, char16* dest) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    __m128i chars = Load(src + i);
+    if (_mm_movemask_epi8(chars))
+      break;
+    __m128i* out = reinterpret_cast<__m128i*>(dest + i);
+    _mm_storeu_si128(out, _mm_unpacklo_epi8(chars, zero));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(chars, zero));
+  }
+  return i;
+}
+
+size_t NarrowASCIISSE2(const char16* src, size_t length, char* dest) {
+  const __m128i non_ascii = _mm_set1_epi16(~0x7F);
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    __m128i low = Load(src + i);
+    __m128i high = Load(src + i + kBlockSize / 2);
+    __m128i bits = _mm_and_si128(_mm_or_si128(low, high), non_ascii);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(bits, _mm_setzero_si128())) !=
+        0xFFFF) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_packus_epi16(low, high));
+  }
+  return i;
+}
+
+const StringKernels kSSE2Kernels = {
+  &IsASCIISSE2,
+  &IsASCII16SSE2,
+  &ToLowerASCIISSE2,
+  &LowerCaseEqualsASCIISSE2,
+  &WidenASCIISSE2,
+  &NarrowASCIISSE2,
+};
+
+#elif defined(__ARM_NEON__)
+
+// Returns true if all the bits of |v| are set.
+inline bool AllSet(uint8x16_t v) {
+  uint8x8_t both = vand_u8(vget_low_u8(v), vget_high_u8(v));
+  return vget_lane_u64(vreinterpret_u64_u8(both), 0) == ~0ULL;
+}
+
+// Returns true if none of the bits in |mask| is set in |v|.
+inline bool NoneSet(uint8x16_t v, uint64 mask) {
+  uint8x8_t either = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+  return (vget_lane_u64(vreinterpret_u64_u8(either), 0) & mask) == 0;
+}
+
+// Adds 0x20 to the bytes in ['A', 'Z'], that is, those that are below 26 once
+// 'A' is subtracted.
+inline uint8x16_t ToLower(uint8x16_t chars) {
+  uint8x16_t upper = vcltq_u8(vsubq_u8(chars, vdupq_n_u8('A')),
+                              vdupq_n_u8(26));
+  return vaddq_u8(chars, vandq_u8(upper, vdupq_n_u8('a' - 'A')));
+}
+
+inline uint8x16_t Load(const void* p) {
+  return vld1q_u8(static_cast<const uint8*>(p));
+}
+
+bool IsASCIINEON(const char* str, size_t length) {
+  uint8x16_t bits = vdupq_n_u8(0);
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize)
+    bits = vorrq_u8(bits, Load(str + i));
+  return NoneSet(bits, 0x8080808080808080ULL) &&
+         IsASCIITail(str + i, length - i);
+}
+
+bool IsASCII16NEON(const char16* str, size_t length) {
+  const size_t kChars = kBlockSize / sizeof(char16);
+  uint8x16_t bits = vdupq_n_u8(0);
+  size_t i = 0;
+  for (; i + kChars <= length; i += kChars)
+    bits = vorrq_u8(bits, Load(str + i));
+  // Little-endian: the high byte of each char16 follows the low one.
+  return NoneSet(bits, 0xFF80FF80FF80FF80ULL) &&
+         IsASCIITail16(str + i, length - i);
+}
+
+void ToLowerASCIINEON(char* str, size_t length) {
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize)
+    vst1q_u8(reinterpret_cast<uint8*>(str + i), ToLower(Load(str + i)));
+  ToLowerASCIITail(str + i, length - i);
+}
+
+bool LowerCaseEqualsASCIINEON(const char* a, const char* b, size_t length) {
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    if (!AllSet(vceqq_u8(ToLower(Load(a + i)), Load(b + i))))
+      return false;
+  }
+  return LowerCaseEqualsASCIITail(a + i, b + i, length - i);
+}
+
+size_t WidenASCIINEON(const char* src, size_t length, char16* dest) {
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    uint8x16_t chars = Load(src + i);
+    if (!NoneSet(chars, 0x8080808080808080ULL))
+      break;
+    uint16* out = reinterpret_cast<uint16*>(dest + i);
+    vst1q_u16(out, vmovl_u8(vget_low_u8(chars)));
+    vst1q_u16(out + kBlockSize / 2, vmovl_u8(vget_high_u8(chars)));
+  }
+  return i;
+}
+
+size_t NarrowASCIINEON(const char16* src, size_t length, char* dest) {
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    const uint16* in = reinterpret_cast<const uint16*>(src + i);
+    uint16x8_t low = vld1q_u16(in);
+    uint16x8_t high = vld1q_u16(in + kBlockSize / 2);
+    if (!NoneSet(vreinterpretq_u8_u16(vorrq_u16(low, high)),
+                 0xFF80FF80FF80FF80ULL)) {
+      break;
+    }
+    vst1q_u8(reinterpret_cast<uint8*>(dest + i),
+             vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+  }
+  return i;
+}
+
+const StringKernels kNEONKernels = {
+  &IsASCIINEON,
+  &IsASCII16NEON,
+  &ToLowerASCIINEON,
+  &LowerCaseEqualsASCIINEON,
+  &WidenASCIINEON,
+  &NarrowASCIINEON,
+};
+
+#endif
+#endif  // defined(__SSE2__) || defined(__ARM_NEON__)
+
+// Picks the kernels once.
+class KernelsForCPU {
+ public:
+  KernelsForCPU() : kernels_(NULL) {
+#if defined(__SSE2__)
+    if (base::CPU().has_sse2())
+      kernels_ = &kSSE2Kernels;
+#elif defined(__ARM_NEON__)
+    // Built for CPUs with NEON.
+    kernels_ = &kNEONKernels;
+#endif
+  }
+
+  const StringKernels* kernels() const { return kernels_; }
+
+ private:
+  const StringKernels* kernels_;
+};
+
+base::LazyInstance<KernelsForCPU, base::LeakyLazyInstanceTraits<KernelsForCPU> >
+    g_kernels_for_cpu(base::LINKER_INITIALIZED);
+
+}  // namespace
+
+const StringKernels* GetStringKernels() {
+  return g_kernels_for_cpu.Get().kernels();
+}
+
+}  // namespace internal
+}  // namespace base
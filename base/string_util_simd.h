@@ -0,0 +1,45 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// SSE2 and NEON versions of some of the loops in string_util.cc and
+// utf_string_conversions.cc. Each kernel gives exactly the result of the loop
+// it replaces. Call the functions of those files instead.
+
+#ifndef BASE_STRING_UTIL_SIMD_H_
+#define BASE_STRING_UTIL_SIMD_H_
+#pragma once
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+#include "base/string16.h"
+
+namespace base {
+namespace internal {
+
+struct StringKernels {
+  // Returns true if none of the |length| chars of |str| is above 0x7F.
+  bool (*is_ascii)(const char* str, size_t length);
+  bool (*is_ascii16)(const char16* str, size_t length);
+
+  // Lowercases the ASCII letters among the |length| chars of |str|.
+  void (*to_lower_ascii)(char* str, size_t length);
+
+  // Returns true if the |length| chars of |a|, lowercased, are those of |b|.
+  bool (*lower_case_equals_ascii)(const char* a, const char* b, size_t length);
+
+  // Copy the ASCII chars at the start of the |length| chars of |src| to
+  // |dest|, whole blocks at a time, and return how many they copied. The
+  // caller goes on from there.
+  size_t (*widen_ascii)(const char* src, size_t length, char16* dest);
+  size_t (*narrow_ascii)(const char16* src, size_t length, char* dest);
+};
+
+// Returns the kernels that this build has and the CPU can run, or NULL if
+// there are none. Picks them the first time it is called.
+BASE_API const StringKernels* GetStringKernels();
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_STRING_UTIL_SIMD_H_
@@ -1085,4 +1085,164 @@ TEST(StringUtilTest, ContainsOnlyChars) {
   EXPECT_FALSE(ContainsOnlyChars("123a", "4321"));
 }
 
+// The helpers below use vectorized kernels on long enough strings. These tests
+// compare them with plain loops on strings of every length up to a few
+// blocks, starting at every alignment.
+namespace {
+
+// Chars around the edges of the ranges the kernels test for.
+const unsigned char kParityChars[] = {
+  '@', 'A', 'M', 'Z', '[', '`', 'a', 'm', 'z', '{', '0', ' ', '\t', '\v',
+  '\r', 0x1F, 0x7F, 0x80, 0xC1, 0xDA, 0xFF,
+};
+
+// Returns |length| chars from kParityChars, picked by a simple generator
+// seeded with |seed|.
+std::string ParityString(size_t length, unsigned seed) {
+  std::string result;
+  for (size_t i = 0; i < length; ++i) {
+    seed = seed * 1103515245 + 12345;
+    result.push_back(kParityChars[(seed >> 16) % arraysize(kParityChars)]);
+  }
+  return result;
+}
+
+bool PlainIsStringASCII(const std::string& str) {
+  for (size_t i = 0; i < str.length(); ++i) {
+    if (static_cast<unsigned char>(str[i]) > 0x7F)
+      return false;
+  }
+  return true;
+}
+
+std::string PlainToLowerASCII(const std::string& str) {
+  std::string result(str);
+  for (size_t i = 0; i < result.length(); ++i) {
+    if (result[i] >= 'A' && result[i] <= 'Z')
+      result[i] += 'a' - 'A';
+  }
+  return result;
+}
+
+TrimPositions PlainTrimWhitespaceASCII(const std::string& input,
+                                       TrimPositions positions,
+                                       std::string* output) {
+  size_t first = (positions & TRIM_LEADING) ?
+      input.find_first_not_of(kWhitespaceASCII) : 0;
+  size_t last = (positions & TRIM_TRAILING) ?
+      input.find_last_not_of(kWhitespaceASCII) : input.length() - 1;
+  if (input.empty() || first == std::string::npos ||
+      last == std::string::npos) {
+    output->clear();
+    return input.empty() ? TRIM_NONE : positions;
+  }
+  *output = input.substr(first, last - first + 1);
+  return static_cast<TrimPositions>(
+      (first == 0 ? TRIM_NONE : TRIM_LEADING) |
+      (last == input.length() - 1 ? TRIM_NONE : TRIM_TRAILING));
+}
+
+}  // namespace
+
+TEST(StringUtilTest, IsStringASCIIParity) {
+  for (size_t length = 0; length < 70; ++length) {
+    for (size_t offset = 0; offset < 4; ++offset) {
+      std::string str = ParityString(length + offset, length).substr(offset);
+      EXPECT_EQ(PlainIsStringASCII(str), IsStringASCII(str)) << length;
+
+      // One non-ASCII char, anywhere in an otherwise ASCII string.
+      std::string ascii = PlainToLowerASCII(std::string(length, 'A'));
+      EXPECT_TRUE(IsStringASCII(base::StringPiece(ascii)));
+      string16 ascii16(ascii.begin(), ascii.end());
+      EXPECT_TRUE(IsStringASCII(ascii16));
+      for (size_t i = 0; i < length; ++i) {
+        std::string non_ascii(ascii);
+        non_ascii[i] = '\x80';
+        EXPECT_FALSE(IsStringASCII(non_ascii)) << length << " " << i;
+        const char16 kNonASCII16[] = { 0x80, 0xFF, 0x100, 0x7F00, 0xFFFF };
+        for (size_t j = 0; j < arraysize(kNonASCII16); ++j) {
+          string16 non_ascii16(ascii16);
+          non_ascii16[i] = kNonASCII16[j];
+          EXPECT_FALSE(IsStringASCII(non_ascii16)) << length << " " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(StringUtilTest, StringToLowerASCIIParity) {
+  for (size_t length = 0; length < 70; ++length) {
+    for (size_t offset = 0; offset < 4; ++offset) {
+      std::string str = ParityString(length + offset, length).substr(offset);
+      std::string lower(str);
+      StringToLowerASCII(&lower);
+      EXPECT_EQ(PlainToLowerASCII(str), lower);
+      EXPECT_EQ(PlainToLowerASCII(str), StringToLowerASCII(str));
+    }
+  }
+}
+
+TEST(StringUtilTest, LowerCaseEqualsASCIIParity) {
+  for (size_t length = 0; length < 70; ++length) {
+    std::string str = ParityString(length, length);
+    std::string lower = PlainToLowerASCII(str);
+    EXPECT_TRUE(LowerCaseEqualsASCII(str, lower.c_str()));
+    EXPECT_TRUE(LowerCaseEqualsASCII(str.begin(), str.end(), lower.c_str()));
+    EXPECT_FALSE(LowerCaseEqualsASCII(str, (lower + "x").c_str()));
+    if (length == 0)
+      continue;
+    EXPECT_FALSE(LowerCaseEqualsASCII(str, lower.substr(1).c_str()));
+    for (size_t i = 0; i < length; ++i) {
+      std::string different(lower);
+      // Uppercase in |b| never matches, as |a| is lowercased.
+      different[i] = (different[i] >= 'a' && different[i] <= 'z') ?
+          different[i] - ('a' - 'A') : different[i] ^ 1;
+      EXPECT_FALSE(LowerCaseEqualsASCII(str, different.c_str())) << i;
+    }
+  }
+}
+
+TEST(StringUtilTest, TrimWhitespaceASCIIParity) {
+  const TrimPositions kPositions[] = {
+    TRIM_NONE, TRIM_LEADING, TRIM_TRAILING, TRIM_ALL
+  };
+  const char* const kInputs[] = {
+    "", " ", " \t\n\v\f\r ", "a", " a", "a ", " a b ", "\va\f", "\x85 \xA0",
+  };
+  for (size_t i = 0; i < arraysize(kInputs); ++i) {
+    for (size_t j = 0; j < arraysize(kPositions); ++j) {
+      std::string expected;
+      TrimPositions expected_result =
+          PlainTrimWhitespaceASCII(kInputs[i], kPositions[j], &expected);
+      std::string output;
+      EXPECT_EQ(expected_result,
+                TrimWhitespaceASCII(kInputs[i], kPositions[j], &output));
+      EXPECT_EQ(expected, output);
+
+      std::string in_place(kInputs[i]);
+      EXPECT_EQ(expected_result,
+                TrimWhitespaceASCII(in_place, kPositions[j], &in_place));
+      EXPECT_EQ(expected, in_place);
+    }
+  }
+}
+
+TEST(StringUtilTest, ReplaceSubstringsAfterOffsetParity) {
+  const char* const kReplacements[] = { "", "b", "bc", "bcd", "aa" };
+  for (size_t i = 0; i < arraysize(kReplacements); ++i) {
+    for (size_t offset = 0; offset < 12; ++offset) {
+      std::string str("aaXaXaaXXaXa");
+      std::string expected(str);
+      // Replaces one match at a time, the way the helper used to.
+      for (std::string::size_type pos = expected.find("aX", offset);
+           offset < expected.length() && pos != std::string::npos;
+           pos = expected.find("aX", pos + strlen(kReplacements[i]))) {
+        expected.replace(pos, 2, kReplacements[i]);
+      }
+      ReplaceSubstringsAfterOffset(&str, offset, "aX", kReplacements[i]);
+      EXPECT_EQ(expected, str) << kReplacements[i] << " " << offset;
+    }
+  }
+}
+
 }  // namespace base
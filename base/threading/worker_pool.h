@@ -23,12 +23,28 @@ namespace base {
 // exist.
 class BASE_API WorkerPool {
  public:
+  // Where a task posted with PostTask() runs.
+  enum TaskAffinity {
+    // Computation, or short local I/O that doesn't wait long.  These tasks
+    // share a fixed set of threads, one per processor.
+    AFFINITY_CPU,
+    // Tasks that may block for a long or unbounded time, such as DNS lookups
+    // or network fetches.  They get as many threads as they need, since a
+    // blocked thread doesn't compete for the CPU.
+    AFFINITY_BLOCKING,
+  };
+
   // This function posts |task| to run on a worker thread.  |task_is_slow|
   // should be used for tasks that will take a long time to execute.  Returns
   // false if |task| could not be posted to a worker thread.  Regardless of
   // return value, ownership of |task| is transferred to the worker pool.
+  // Slow tasks run with AFFINITY_BLOCKING, others with AFFINITY_CPU.
   static bool PostTask(const tracked_objects::Location& from_here,
                        Task* task, bool task_is_slow);
+
+  // Same as above, but |affinity| picks the threads that run |task|.
+  static bool PostTask(const tracked_objects::Location& from_here,
+                       Task* task, TaskAffinity affinity);
 };
 
 }  // namespace base
@@ -4,10 +4,14 @@
 
 #include "base/threading/worker_pool_posix.h"
 
+#include "base/atomicops.h"
 #include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/ref_counted.h"
+#include "base/stl_util-inl.h"
 #include "base/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/sys_info.h"
 #include "base/task.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/worker_pool.h"
@@ -27,25 +31,54 @@ class WorkerPoolImpl {
   ~WorkerPoolImpl();
 
   void PostTask(const tracked_objects::Location& from_here, Task* task,
-                bool task_is_slow);
+                WorkerPool::TaskAffinity affinity);
 
  private:
+  // Returns |cpu_pool_|, creating it and starting its threads the first time.
+  base::PosixWorkStealingThreadPool* GetCPUPool();
+
+  // Runs AFFINITY_BLOCKING tasks.
   scoped_refptr<base::PosixDynamicThreadPool> pool_;
+
+  // Runs AFFINITY_CPU tasks.  Most processes never post one, so the pool and
+  // its thread per processor are only created for the first.
+  base::Lock cpu_pool_lock_;
+  base::subtle::Atomic32 cpu_pool_created_;
+  scoped_refptr<base::PosixWorkStealingThreadPool> cpu_pool_;
 };
 
 WorkerPoolImpl::WorkerPoolImpl()
     : pool_(new base::PosixDynamicThreadPool("WorkerPool",
-                                             kIdleSecondsBeforeExit)) {
+                                             kIdleSecondsBeforeExit)),
+      cpu_pool_created_(0) {
 }
 
 WorkerPoolImpl::~WorkerPoolImpl() {
   pool_->Terminate();
+  if (base::subtle::Acquire_Load(&cpu_pool_created_))
+    cpu_pool_->Terminate();
 }
 
 void WorkerPoolImpl::PostTask(const tracked_objects::Location& from_here,
-                              Task* task, bool task_is_slow) {
+                              Task* task, WorkerPool::TaskAffinity affinity) {
   task->SetBirthPlace(from_here);
-  pool_->PostTask(task);
+  if (affinity == WorkerPool::AFFINITY_CPU)
+    GetCPUPool()->PostTask(task);
+  else
+    pool_->PostTask(task);
+}
+
+base::PosixWorkStealingThreadPool* WorkerPoolImpl::GetCPUPool() {
+  if (!base::subtle::Acquire_Load(&cpu_pool_created_)) {
+    base::AutoLock locked(cpu_pool_lock_);
+    if (!base::subtle::NoBarrier_Load(&cpu_pool_created_)) {
+      cpu_pool_ = new base::PosixWorkStealingThreadPool(
+          "WorkerPoolCPU", SysInfo::NumberOfProcessors());
+      cpu_pool_->Start();
+      base::subtle::Release_Store(&cpu_pool_created_, 1);
+    }
+  }
+  return cpu_pool_.get();
 }
 
 base::LazyInstance<WorkerPoolImpl> g_lazy_worker_pool(base::LINKER_INITIALIZED);
@@ -85,11 +118,52 @@ void WorkerThread::ThreadMain() {
   delete this;
 }
 
+class WorkStealingWorkerThread : public PlatformThread::Delegate {
+ public:
+  WorkStealingWorkerThread(const std::string& name_prefix, int index,
+                           base::PosixWorkStealingThreadPool* pool)
+      : name_prefix_(name_prefix),
+        index_(index),
+        pool_(pool) {}
+
+  virtual void ThreadMain();
+
+ private:
+  const std::string name_prefix_;
+  const int index_;
+  scoped_refptr<base::PosixWorkStealingThreadPool> pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingWorkerThread);
+};
+
+void WorkStealingWorkerThread::ThreadMain() {
+  const std::string name = base::StringPrintf(
+      "%s/%d", name_prefix_.c_str(), PlatformThread::CurrentId());
+  PlatformThread::SetName(name.c_str());
+
+  for (;;) {
+    Task* task = pool_->WaitForTask(index_);
+    if (!task)
+      break;
+    task->Run();
+    delete task;
+  }
+
+  // The WorkStealingWorkerThread is non-joinable, so it deletes itself.
+  delete this;
+}
+
 }  // namespace
 
 bool WorkerPool::PostTask(const tracked_objects::Location& from_here,
                           Task* task, bool task_is_slow) {
-  g_lazy_worker_pool.Pointer()->PostTask(from_here, task, task_is_slow);
+  return PostTask(from_here, task,
+                  task_is_slow ? AFFINITY_BLOCKING : AFFINITY_CPU);
+}
+
+bool WorkerPool::PostTask(const tracked_objects::Location& from_here,
+                          Task* task, TaskAffinity affinity) {
+  g_lazy_worker_pool.Pointer()->PostTask(from_here, task, affinity);
   return true;
 }
 
@@ -166,4 +240,104 @@ Task* PosixDynamicThreadPool::WaitForTask() {
   return task;
 }
 
+PosixWorkStealingThreadPool::PosixWorkStealingThreadPool(
+    const std::string& name_prefix,
+    int num_threads)
+    : name_prefix_(name_prefix),
+      next_queue_(0),
+      num_sleeping_threads_(0),
+      terminated_(0),
+      tasks_available_cv_(&sleep_lock_) {
+  DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i)
+    queues_.push_back(new TaskQueue);
+}
+
+PosixWorkStealingThreadPool::~PosixWorkStealingThreadPool() {
+  for (size_t i = 0; i < queues_.size(); ++i)
+    STLDeleteElements(&queues_[i]->tasks);
+  STLDeleteElements(&queues_);
+}
+
+void PosixWorkStealingThreadPool::Start() {
+  for (int i = 0; i < num_threads(); ++i) {
+    // The new PlatformThread will take ownership of the
+    // WorkStealingWorkerThread object, which will delete itself on exit.
+    WorkStealingWorkerThread* worker =
+        new WorkStealingWorkerThread(name_prefix_, i, this);
+    PlatformThread::CreateNonJoinable(kWorkerThreadStackSize, worker);
+  }
+}
+
+void PosixWorkStealingThreadPool::Terminate() {
+  {
+    AutoLock locked(sleep_lock_);
+    DCHECK(!base::subtle::NoBarrier_Load(&terminated_)) <<
+        "Thread pool is already terminated.";
+    base::subtle::Release_Store(&terminated_, 1);
+  }
+  tasks_available_cv_.Broadcast();
+}
+
+void PosixWorkStealingThreadPool::PostTask(Task* task) {
+  DCHECK(!base::subtle::NoBarrier_Load(&terminated_)) <<
+      "This thread pool is already terminated.  Do not post new tasks.";
+
+  TaskQueue* queue = current_queue_.Get();
+  if (!queue) {
+    uint32 next = static_cast<uint32>(
+        base::subtle::NoBarrier_AtomicIncrement(&next_queue_, 1));
+    queue = queues_[next % queues_.size()];
+  }
+  {
+    AutoLock locked(queue->lock);
+    queue->tasks.push_back(task);
+  }
+
+  // Pairs with the increment in WaitForTask(): either the sleeping thread
+  // finds |task| when it looks again, or it is counted here and woken up.
+  base::subtle::MemoryBarrier();
+  if (base::subtle::NoBarrier_Load(&num_sleeping_threads_) > 0) {
+    AutoLock locked(sleep_lock_);
+    tasks_available_cv_.Signal();
+  }
+}
+
+Task* PosixWorkStealingThreadPool::WaitForTask(int index) {
+  if (!current_queue_.Get())
+    current_queue_.Set(queues_[index]);
+
+  for (;;) {
+    if (base::subtle::Acquire_Load(&terminated_))
+      return NULL;
+    Task* task = FindTask(index);
+    if (task)
+      return task;
+
+    AutoLock locked(sleep_lock_);
+    base::subtle::Barrier_AtomicIncrement(&num_sleeping_threads_, 1);
+    // Look again, now that a thread posting a task will wake this one up.
+    task = FindTask(index);
+    if (!task && !base::subtle::NoBarrier_Load(&terminated_))
+      tasks_available_cv_.Wait();
+    base::subtle::NoBarrier_AtomicIncrement(&num_sleeping_threads_, -1);
+    if (task)
+      return task;
+  }
+}
+
+Task* PosixWorkStealingThreadPool::FindTask(int index) {
+  // Start with the thread's own queue.
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    TaskQueue* queue = queues_[(index + i) % queues_.size()];
+    AutoLock locked(queue->lock);
+    if (!queue->tasks.empty()) {
+      Task* task = queue->tasks.front();
+      queue->tasks.pop_front();
+      return task;
+    }
+  }
+  return NULL;
+}
+
 }  // namespace base
@@ -17,6 +17,14 @@
 // worker threads exit.  The owner of PosixDynamicThreadPool should likewise
 // maintain a scoped_refptr to the PosixDynamicThreadPool instance.
 //
+// PosixWorkStealingThreadPool runs tasks on a fixed number of threads, usually
+// one per processor.  Each thread has its own queue of tasks: a task posted
+// from a worker thread goes to that thread's queue, and other tasks are spread
+// over the queues in turn.  A thread runs the tasks of its own queue in order,
+// and when its queue is empty it steals the oldest task of another queue, so
+// that threads rarely contend for the same lock.  Its threads are
+// non-joinable too, and hold a reference to the pool in the same way.
+//
 // NOTE: The classes defined in this file are only meant for use by the POSIX
 // implementation of WorkerPool.  No one else should be using these classes.
 // These symbols are exported in a header purely for testing purposes.
@@ -25,15 +33,19 @@
 #define BASE_THREADING_WORKER_POOL_POSIX_H_
 #pragma once
 
+#include <deque>
 #include <queue>
 #include <string>
+#include <vector>
 
+#include "base/atomicops.h"
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/platform_thread.h"
+#include "base/threading/thread_local.h"
 
 class Task;
 
@@ -84,6 +96,69 @@ class PosixDynamicThreadPool
   DISALLOW_COPY_AND_ASSIGN(PosixDynamicThreadPool);
 };
 
+class PosixWorkStealingThreadPool
+    : public RefCountedThreadSafe<PosixWorkStealingThreadPool> {
+ public:
+  // All worker threads will share the same |name_prefix|.  The pool runs
+  // |num_threads| threads once started.
+  PosixWorkStealingThreadPool(const std::string& name_prefix,
+                              int num_threads);
+  ~PosixWorkStealingThreadPool();
+
+  // Starts the worker threads.
+  void Start();
+
+  // Indicates that the thread pool is going away.  Worker threads exit once
+  // they finish their current task, and the tasks left are deleted with the
+  // pool.
+  void Terminate();
+
+  // Adds |task| to the thread pool.  PosixWorkStealingThreadPool assumes
+  // ownership of |task|.
+  void PostTask(Task* task);
+
+  // Worker thread method to wait for the next task of the thread whose queue
+  // is |index|.  Returns NULL once the pool is terminated.
+  Task* WaitForTask(int index);
+
+  int num_threads() const { return static_cast<int>(queues_.size()); }
+
+ private:
+  // The queue of one worker thread.
+  struct TaskQueue {
+    Lock lock;  // Protects |tasks|.
+    std::deque<Task*> tasks;
+  };
+
+  // Pops the oldest task of the queue |index|, or steals the oldest task of
+  // another queue.  Returns NULL if all the queues are empty.
+  Task* FindTask(int index);
+
+  const std::string name_prefix_;
+
+  // One queue per worker thread.  The vector doesn't change after
+  // construction.
+  std::vector<TaskQueue*> queues_;
+
+  // The queue of the calling thread, if it is one of the worker threads.
+  ThreadLocalPointer<TaskQueue> current_queue_;
+
+  // The queue that the next task posted from outside the pool goes to, modulo
+  // the number of queues.
+  base::subtle::Atomic32 next_queue_;
+
+  // The number of threads waiting on |tasks_available_cv_|, read without
+  // |sleep_lock_| so that PostTask() only takes it to wake a thread.
+  base::subtle::Atomic32 num_sleeping_threads_;
+
+  base::subtle::Atomic32 terminated_;
+
+  Lock sleep_lock_;
+  ConditionVariable tasks_available_cv_;
+
+  DISALLOW_COPY_AND_ASSIGN(PosixWorkStealingThreadPool);
+};
+
 }  // namespace base
 
 #endif  // BASE_THREADING_WORKER_POOL_POSIX_H_
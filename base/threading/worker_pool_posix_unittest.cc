@@ -118,6 +118,85 @@ class BlockingIncrementingTask : public Task {
   DISALLOW_COPY_AND_ASSIGN(BlockingIncrementingTask);
 };
 
+// Counts the tasks run on a PosixWorkStealingThreadPool, and signals |done|
+// after the last one.
+class CountingTask : public Task {
+ public:
+  CountingTask(Lock* lock, int* count, int total,
+               std::set<PlatformThreadId>* unique_threads, WaitableEvent* done)
+      : lock_(lock),
+        count_(count),
+        total_(total),
+        unique_threads_(unique_threads),
+        done_(done) {}
+
+  virtual void Run() {
+    base::AutoLock locked(*lock_);
+    unique_threads_->insert(PlatformThread::CurrentId());
+    if (++*count_ == total_)
+      done_->Signal();
+  }
+
+ private:
+  Lock* lock_;
+  int* count_;
+  int total_;
+  std::set<PlatformThreadId>* unique_threads_;
+  WaitableEvent* done_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingTask);
+};
+
+class SignalTask : public Task {
+ public:
+  explicit SignalTask(WaitableEvent* event) : event_(event) {}
+
+  virtual void Run() {
+    event_->Signal();
+  }
+
+ private:
+  WaitableEvent* event_;
+
+  DISALLOW_COPY_AND_ASSIGN(SignalTask);
+};
+
+// Posts a task from a worker thread, which puts it on the thread's own queue,
+// and waits for it to run.  Only another thread stealing it can run it.
+class PostAndWaitTask : public Task {
+ public:
+  PostAndWaitTask(PosixWorkStealingThreadPool* pool, WaitableEvent* done)
+      : pool_(pool),
+        done_(done) {}
+
+  virtual void Run() {
+    WaitableEvent stolen(false, false);
+    pool_->PostTask(new SignalTask(&stolen));
+    stolen.Wait();
+    done_->Signal();
+  }
+
+ private:
+  PosixWorkStealingThreadPool* pool_;
+  WaitableEvent* done_;
+
+  DISALLOW_COPY_AND_ASSIGN(PostAndWaitTask);
+};
+
+// Sets |*deleted| when it is deleted.
+class DeletionTask : public Task {
+ public:
+  explicit DeletionTask(bool* deleted) : deleted_(deleted) {}
+  virtual ~DeletionTask() { *deleted_ = true; }
+
+  virtual void Run() {}
+
+ private:
+  bool* deleted_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeletionTask);
+};
+
 class PosixDynamicThreadPoolTest : public testing::Test {
  protected:
   PosixDynamicThreadPoolTest()
@@ -265,4 +344,50 @@ TEST_F(PosixDynamicThreadPoolTest, Complex) {
   EXPECT_EQ(4, counter_);
 }
 
+TEST(PosixWorkStealingThreadPoolTest, RunsAllTasks) {
+  const int kTasks = 1000;
+  scoped_refptr<PosixWorkStealingThreadPool> pool(
+      new PosixWorkStealingThreadPool("stealing_pool", 4));
+  EXPECT_EQ(4, pool->num_threads());
+  pool->Start();
+
+  Lock lock;
+  int count = 0;
+  std::set<PlatformThreadId> unique_threads;
+  WaitableEvent done(false, false);
+  for (int i = 0; i < kTasks; ++i) {
+    pool->PostTask(
+        new CountingTask(&lock, &count, kTasks, &unique_threads, &done));
+  }
+  done.Wait();
+  pool->Terminate();
+
+  base::AutoLock locked(lock);
+  EXPECT_EQ(kTasks, count);
+  EXPECT_GE(4U, unique_threads.size()) << "The pool has a fixed size.";
+}
+
+TEST(PosixWorkStealingThreadPoolTest, Steal) {
+  scoped_refptr<PosixWorkStealingThreadPool> pool(
+      new PosixWorkStealingThreadPool("stealing_pool", 2));
+  pool->Start();
+
+  WaitableEvent done(false, false);
+  pool->PostTask(new PostAndWaitTask(pool.get(), &done));
+  done.Wait();
+  pool->Terminate();
+}
+
+TEST(PosixWorkStealingThreadPoolTest, DeletesPendingTasks) {
+  bool deleted = false;
+  scoped_refptr<PosixWorkStealingThreadPool> pool(
+      new PosixWorkStealingThreadPool("stealing_pool", 2));
+  // Without threads, the task stays queued until the pool goes away.
+  pool->PostTask(new DeletionTask(&deleted));
+  pool->Terminate();
+  EXPECT_FALSE(deleted);
+  pool = NULL;
+  EXPECT_TRUE(deleted);
+}
+
 }  // namespace base
@@ -43,4 +43,19 @@ TEST_F(WorkerPoolTest, PostTask) {
   EXPECT_TRUE(signaled);
 }
 
+TEST_F(WorkerPoolTest, PostTaskWithAffinity) {
+  WaitableEvent cpu_test_event(false, false);
+  WaitableEvent blocking_test_event(false, false);
+
+  EXPECT_TRUE(WorkerPool::PostTask(FROM_HERE,
+                                   new PostTaskTestTask(&cpu_test_event),
+                                   WorkerPool::AFFINITY_CPU));
+  EXPECT_TRUE(WorkerPool::PostTask(FROM_HERE,
+                                   new PostTaskTestTask(&blocking_test_event),
+                                   WorkerPool::AFFINITY_BLOCKING));
+
+  EXPECT_TRUE(cpu_test_event.Wait());
+  EXPECT_TRUE(blocking_test_event.Wait());
+}
+
 }  // namespace base
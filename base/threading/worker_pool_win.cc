@@ -22,10 +22,18 @@ DWORD CALLBACK WorkItemCallback(void* param) {
 
 bool WorkerPool::PostTask(const tracked_objects::Location& from_here,
                           Task* task, bool task_is_slow) {
+  return PostTask(from_here, task,
+                  task_is_slow ? AFFINITY_BLOCKING : AFFINITY_CPU);
+}
+
+bool WorkerPool::PostTask(const tracked_objects::Location& from_here,
+                          Task* task, TaskAffinity affinity) {
   task->SetBirthPlace(from_here);
 
+  // The system pool adds threads for long functions rather than queuing
+  // them behind the others.
   ULONG flags = 0;
-  if (task_is_slow)
+  if (affinity == AFFINITY_BLOCKING)
     flags |= WT_EXECUTELONGFUNCTION;
 
   if (!QueueUserWorkItem(WorkItemCallback, task, flags)) {
@@ -1,4 +1,4 @@
-// Copyright (c) 2006-2008 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
@@ -12,6 +12,10 @@ void BaseTimer_Helper::OrphanDelayedTask() {
   if (delayed_task_) {
     delayed_task_->timer_ = NULL;
     delayed_task_ = NULL;
+    // Delete the task now rather than leave it in the loop until it is due.
+    // This does nothing if the task is the one running.
+    if (MessageLoop::current() == message_loop_)
+      message_loop_->CancelDelayedTask(delayed_task_id_);
   }
 }
 
@@ -20,9 +24,10 @@ void BaseTimer_Helper::InitiateDelayedTask(TimerTask* timer_task) {
 
   delayed_task_ = timer_task;
   delayed_task_->timer_ = this;
-  MessageLoop::current()->PostDelayedTask(
-      FROM_HERE, timer_task,
-      static_cast<int>(timer_task->delay_.InMillisecondsRoundedUp()));
+  message_loop_ = MessageLoop::current();
+  delayed_task_id_ = message_loop_->PostCancelableDelayedTask(
+      FROM_HERE, timer_task, timer_task->delay_.InMillisecondsRoundedUp(),
+      slack_.InMilliseconds());
 }
 
 }  // namespace base
@@ -51,6 +51,7 @@
 #include "base/logging.h"
 #include "base/task.h"
 #include "base/time.h"
+#include "base/timer_wheel.h"
 
 class MessageLoop;
 
@@ -81,8 +82,18 @@ class BASE_API BaseTimer_Helper {
     return delayed_task_->delay_;
   }
 
+  // Lets the timer fire up to |slack| late, so that it fires together with
+  // other timers and wakes the thread less often.  Takes effect the next time
+  // the timer is started or reset.
+  void set_slack(TimeDelta slack) {
+    slack_ = slack;
+  }
+
  protected:
-  BaseTimer_Helper() : delayed_task_(NULL) {}
+  BaseTimer_Helper()
+      : delayed_task_(NULL),
+        message_loop_(NULL),
+        delayed_task_id_(0) {}
 
   // We have access to the timer_ member so we can orphan this task.
   class TimerTask : public Task {
@@ -94,7 +105,8 @@ class BASE_API BaseTimer_Helper {
     TimeDelta delay_;
   };
 
-  // Used to orphan delayed_task_ so that when it runs it does nothing.
+  // Used to orphan delayed_task_ so that when it runs it does nothing.  It is
+  // deleted right away when called on the thread the task was posted to.
   void OrphanDelayedTask();
 
   // Used to initiated a new delayed task.  This has the side-effect of
@@ -103,6 +115,12 @@ class BASE_API BaseTimer_Helper {
 
   TimerTask* delayed_task_;
 
+  // The loop delayed_task_ was posted to, and its id there.
+  MessageLoop* message_loop_;
+  TimerWheelBase::Id delayed_task_id_;
+
+  TimeDelta slack_;
+
   DISALLOW_COPY_AND_ASSIGN(BaseTimer_Helper);
 };
 
@@ -0,0 +1,60 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/timer_wheel.h"
+
+namespace base {
+
+// static
+TimeTicks TimerWheelBase::CoalesceRunTime(TimeTicks run_time,
+                                          TimeDelta slack) {
+  int64 slack_ms = slack.InMilliseconds();
+  if (slack_ms <= 0)
+    return run_time;
+
+  int64 granularity = 1;
+  while (granularity * 2 <= slack_ms)
+    granularity *= 2;
+  granularity *= Time::kMicrosecondsPerMillisecond;
+
+  int64 value = run_time.ToInternalValue();
+  int64 remainder = value % granularity;
+  if (remainder <= 0)
+    return run_time;
+  return run_time + TimeDelta::FromMicroseconds(granularity - remainder);
+}
+
+// static
+int TimerWheelBase::LowestBit(uint64 bits) {
+  DCHECK(bits);
+  int index = 0;
+  if (!(bits & GG_UINT64_C(0xffffffff))) {
+    bits >>= 32;
+    index += 32;
+  }
+  if (!(bits & 0xffff)) {
+    bits >>= 16;
+    index += 16;
+  }
+  if (!(bits & 0xff)) {
+    bits >>= 8;
+    index += 8;
+  }
+  while (!(bits & 1)) {
+    bits >>= 1;
+    ++index;
+  }
+  return index;
+}
+
+// static
+int TimerWheelBase::LevelOf(int64 tick, int64 current_tick) {
+  uint64 difference = static_cast<uint64>(tick ^ current_tick);
+  int level = 0;
+  while (level < kLevels && (difference >> ((level + 1) * kSlotBits)))
+    ++level;
+  return level;
+}
+
+}  // namespace base
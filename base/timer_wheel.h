@@ -0,0 +1,329 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// TimerWheel keeps values ordered by the time they are due, like a
+// std::priority_queue, but a value can also be cancelled, and adding or
+// cancelling one takes constant time.  It is a hierarchical timing wheel:
+// values due within the next 64 milliseconds are kept in one slot per
+// millisecond, and values due later in coarser slots, which are split into
+// finer ones as their time comes closer.  Values due at the same time come out
+// in the order they were added.
+//
+// TimerWheel is not thread safe.
+//
+// Usage:
+//   TimerWheel<Task*> wheel;
+//   TimerWheel<Task*>::Id id = wheel.Add(run_time, task);
+//   ...
+//   Task* cancelled;
+//   if (wheel.Cancel(id, &cancelled))
+//     delete cancelled;
+//   ...
+//   while (!wheel.empty() && wheel.top_run_time() <= TimeTicks::Now()) {
+//     Task* task = wheel.top();
+//     wheel.Pop();
+//     ...
+//   }
+
+#ifndef BASE_TIMER_WHEEL_H_
+#define BASE_TIMER_WHEEL_H_
+#pragma once
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+#include "base/hash_tables.h"
+#include "base/logging.h"
+#include "base/time.h"
+
+namespace base {
+
+// The parts of TimerWheel that don't depend on the type of its values.
+class BASE_API TimerWheelBase {
+ public:
+  // Identifies a value added to a wheel.
+  typedef int64 Id;
+
+  // Returns a time within |slack| after |run_time|.  Times within the same
+  // power of two milliseconds not above |slack| are all rounded up to the same
+  // time, so that several timers with some slack fire together, and a thread
+  // that waits for them wakes up once rather than once per timer.
+  static TimeTicks CoalesceRunTime(TimeTicks run_time, TimeDelta slack);
+
+ protected:
+  // Each level has 2^kSlotBits slots.
+  static const int kSlotBits = 6;
+  static const int kSlots = 1 << kSlotBits;
+  static const int64 kSlotMask = kSlots - 1;
+  // Six levels cover 2^36 milliseconds, about two years.  Values due later
+  // than that are kept in a list of their own.
+  static const int kLevels = 6;
+
+  // Returns the index of the lowest bit set in |bits|, which can't be 0.
+  static int LowestBit(uint64 bits);
+
+  // Returns the level where a value due at |tick| goes, when the wheel is at
+  // |current_tick|: the level of the highest digit where they differ, or
+  // kLevels if they differ above the last level.
+  static int LevelOf(int64 tick, int64 current_tick);
+
+  static int64 TickOf(TimeTicks time) {
+    return time.ToInternalValue() / Time::kMicrosecondsPerMillisecond;
+  }
+
+  static int DigitOf(int64 tick, int level) {
+    return static_cast<int>((tick >> (level * kSlotBits)) & kSlotMask);
+  }
+};
+
+template <typename T>
+class TimerWheel : public TimerWheelBase {
+ public:
+  TimerWheel()
+      : current_tick_(0),
+        next_id_(0),
+        next_(NULL),
+        overflow_(NULL) {
+    memset(slots_, 0, sizeof(slots_));
+    memset(occupied_, 0, sizeof(occupied_));
+  }
+
+  ~TimerWheel() {
+    for (typename NodeMap::iterator it = nodes_.begin(); it != nodes_.end();
+         ++it) {
+      delete it->second;
+    }
+  }
+
+  bool empty() const { return nodes_.empty(); }
+  size_t size() const { return nodes_.size(); }
+
+  // Adds |value|, due at |run_time|, and returns the id to cancel it with.
+  Id Add(TimeTicks run_time, const T& value) {
+    Node* node = new Node(run_time, next_id_++, value);
+    // An empty wheel can start anywhere, so start at the new value rather
+    // than cascading down to it later.
+    if (nodes_.empty())
+      current_tick_ = node->tick;
+    nodes_[node->id] = node;
+    Place(node);
+    if (next_ && node->IsEarlierThan(*next_))
+      next_ = node;
+    return node->id;
+  }
+
+  // Removes the value added as |id| and copies it to |value|.  Returns false if
+  // it was already popped or cancelled.
+  bool Cancel(Id id, T* value) {
+    typename NodeMap::iterator it = nodes_.find(id);
+    if (it == nodes_.end())
+      return false;
+    Node* node = it->second;
+    nodes_.erase(it);
+    Unlink(node);
+    if (next_ == node)
+      next_ = NULL;
+    *value = node->value;
+    delete node;
+    return true;
+  }
+
+  // The value due first.  The wheel must not be empty.
+  const T& top() {
+    return FindNext()->value;
+  }
+
+  // The time top() is due.  The wheel must not be empty.
+  TimeTicks top_run_time() {
+    return FindNext()->run_time;
+  }
+
+  // Removes top().
+  void Pop() {
+    Node* node = FindNext();
+    nodes_.erase(node->id);
+    Unlink(node);
+    next_ = NULL;
+    delete node;
+  }
+
+ private:
+  struct Node {
+    Node(TimeTicks run_time, Id id, const T& value)
+        : run_time(run_time),
+          tick(TickOf(run_time)),
+          id(id),
+          value(value),
+          level(0),
+          slot(0),
+          previous(NULL),
+          next(NULL) {
+    }
+
+    bool IsEarlierThan(const Node& other) const {
+      if (run_time != other.run_time)
+        return run_time < other.run_time;
+      return id < other.id;
+    }
+
+    const TimeTicks run_time;
+    const int64 tick;
+    const Id id;
+    T value;
+
+    // Where the node is: slots_[level][slot], or |overflow_| if |level| is
+    // kLevels.
+    int level;
+    int slot;
+    Node* previous;
+    Node* next;
+  };
+
+  struct Slot {
+    Node* head;
+    Node* tail;
+  };
+
+  typedef base::hash_map<Id, Node*> NodeMap;
+
+  // Returns the slot of |node|, or NULL if it is in |overflow_|.
+  Slot* SlotOf(Node* node) {
+    return node->level < kLevels ? &slots_[node->level][node->slot] : NULL;
+  }
+
+  // Puts |node| in the slot for its tick, relative to |current_tick_|.  A node
+  // due before |current_tick_| goes in the current slot of the first level.
+  void Place(Node* node) {
+    if (node->tick <= current_tick_) {
+      node->level = 0;
+      node->slot = DigitOf(current_tick_, 0);
+    } else {
+      node->level = LevelOf(node->tick, current_tick_);
+      node->slot = DigitOf(node->tick, node->level);
+    }
+
+    if (node->level == kLevels) {
+      node->previous = NULL;
+      node->next = overflow_;
+      if (overflow_)
+        overflow_->previous = node;
+      overflow_ = node;
+      return;
+    }
+
+    Slot* slot = SlotOf(node);
+    occupied_[node->level] |= GG_UINT64_C(1) << node->slot;
+    // The slots of the first level are sorted, so that the head of the first
+    // slot in use is the next node.  Nodes are usually added in order, so look
+    // from the tail.
+    Node* previous = slot->tail;
+    if (node->level == 0) {
+      while (previous && node->IsEarlierThan(*previous))
+        previous = previous->previous;
+    }
+    node->previous = previous;
+    node->next = previous ? previous->next : slot->head;
+    if (node->next)
+      node->next->previous = node;
+    else
+      slot->tail = node;
+    if (previous)
+      previous->next = node;
+    else
+      slot->head = node;
+  }
+
+  void Unlink(Node* node) {
+    Slot* slot = SlotOf(node);
+    if (node->previous)
+      node->previous->next = node->next;
+    else if (slot)
+      slot->head = node->next;
+    else
+      overflow_ = node->next;
+    if (node->next)
+      node->next->previous = node->previous;
+    else if (slot)
+      slot->tail = node->previous;
+    if (slot && !slot->head)
+      occupied_[node->level] &= ~(GG_UINT64_C(1) << node->slot);
+  }
+
+  // Returns the first slot in use of |level| from |first_slot|, or -1.
+  int FindSlot(int level, int first_slot) const {
+    if (first_slot >= kSlots)
+      return -1;
+    uint64 bits = occupied_[level] >> first_slot;
+    return bits ? first_slot + LowestBit(bits) : -1;
+  }
+
+  // Returns the node due first, splitting coarser slots as needed.
+  Node* FindNext() {
+    DCHECK(!empty());
+    while (!next_) {
+      int slot = FindSlot(0, DigitOf(current_tick_, 0));
+      if (slot >= 0) {
+        next_ = slots_[0][slot].head;
+        break;
+      }
+      // The lower levels are empty: move to the first slot in use of the
+      // lowest level that has one, and spread its nodes over the levels below.
+      int level = 1;
+      for (; level < kLevels; ++level) {
+        slot = FindSlot(level, DigitOf(current_tick_, level) + 1);
+        if (slot >= 0)
+          break;
+      }
+      Node* nodes;
+      if (level < kLevels) {
+        int shift = (level + 1) * kSlotBits;
+        current_tick_ = ((current_tick_ >> shift) << shift) |
+            (static_cast<int64>(slot) << (level * kSlotBits));
+        nodes = slots_[level][slot].head;
+        slots_[level][slot].head = slots_[level][slot].tail = NULL;
+        occupied_[level] &= ~(GG_UINT64_C(1) << slot);
+      } else {
+        nodes = overflow_;
+        overflow_ = NULL;
+        current_tick_ = nodes->tick;
+        for (Node* node = nodes; node; node = node->next)
+          current_tick_ = std::min(current_tick_, node->tick);
+      }
+      while (nodes) {
+        Node* node = nodes;
+        nodes = node->next;
+        Place(node);
+      }
+    }
+    return next_;
+  }
+
+  // The tick the wheel is at.  No node is due in an earlier slot.
+  int64 current_tick_;
+
+  Id next_id_;
+
+  // The node due first, or NULL if it must be looked for.
+  Node* next_;
+
+  Slot slots_[kLevels][kSlots];
+
+  // A bit for each slot in use, per level.
+  uint64 occupied_[kLevels];
+
+  // The nodes due too far after |current_tick_| for the last level.
+  Node* overflow_;
+
+  // All the nodes, for Cancel().
+  NodeMap nodes_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+}  // namespace base
+
+#endif  // BASE_TIMER_WHEEL_H_
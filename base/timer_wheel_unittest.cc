@@ -0,0 +1,147 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/timer_wheel.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// An arbitrary time, so that the tests don't depend on the clock.
+TimeTicks Start() {
+  return TimeTicks() + TimeDelta::FromSeconds(1000);
+}
+
+TimeTicks At(int64 ms) {
+  return Start() + TimeDelta::FromMilliseconds(ms);
+}
+
+}  // namespace
+
+TEST(TimerWheelTest, Order) {
+  TimerWheel<int> wheel;
+  EXPECT_TRUE(wheel.empty());
+
+  // Values in every level, and one past the last level.
+  const int64 kDelays[] = {
+    5, 0, 70, 5, 4000, 1, 300000, 20000000, GG_INT64_C(100000000000), 4000,
+  };
+  for (size_t i = 0; i < arraysize(kDelays); ++i)
+    wheel.Add(At(kDelays[i]), static_cast<int>(i));
+  EXPECT_EQ(arraysize(kDelays), wheel.size());
+
+  // Sorted by time, and in the order they were added for the same time.
+  const int kOrder[] = { 1, 5, 0, 3, 2, 4, 9, 6, 7, 8 };
+  for (size_t i = 0; i < arraysize(kOrder); ++i) {
+    ASSERT_FALSE(wheel.empty());
+    EXPECT_EQ(At(kDelays[kOrder[i]]), wheel.top_run_time());
+    EXPECT_EQ(kOrder[i], wheel.top());
+    wheel.Pop();
+  }
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, Cancel) {
+  TimerWheel<int> wheel;
+  TimerWheel<int>::Id first = wheel.Add(At(10), 1);
+  TimerWheel<int>::Id second = wheel.Add(At(20), 2);
+  TimerWheel<int>::Id third = wheel.Add(At(100000), 3);
+
+  int value = 0;
+  EXPECT_TRUE(wheel.Cancel(second, &value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(wheel.Cancel(second, &value));
+  EXPECT_EQ(2u, wheel.size());
+
+  // Cancelling the top value makes the next one the top.
+  EXPECT_EQ(1, wheel.top());
+  EXPECT_TRUE(wheel.Cancel(first, &value));
+  EXPECT_EQ(3, wheel.top());
+  wheel.Pop();
+  EXPECT_FALSE(wheel.Cancel(third, &value));
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, AddBeforeCurrentTime) {
+  TimerWheel<int> wheel;
+  wheel.Add(At(0), 0);
+  wheel.Add(At(100000), 1);
+  wheel.Pop();
+  // Looking for the top value moves the wheel ahead to it.
+  EXPECT_EQ(1, wheel.top());
+
+  // Values due before that, even in the past, still come out first.
+  wheel.Add(At(50), 2);
+  wheel.Add(At(-50), 3);
+  EXPECT_EQ(3, wheel.top());
+  wheel.Pop();
+  EXPECT_EQ(2, wheel.top());
+  wheel.Pop();
+  EXPECT_EQ(1, wheel.top());
+}
+
+// Checks random adds, cancels and pops against a std::map.
+TEST(TimerWheelTest, Random) {
+  typedef std::map<std::pair<TimeTicks, int>, TimerWheel<int>::Id> Expected;
+  TimerWheel<int> wheel;
+  Expected expected;
+  int64 now = 0;
+  for (int i = 0; i < 20000; ++i) {
+    int action = RandInt(0, 9);
+    if (action < 5 || expected.empty()) {
+      // Mostly short delays, sometimes very long ones.
+      int64 delay = RandInt(0, 2) ? RandInt(0, 200) : RandInt(0, 100000000);
+      TimeTicks run_time = At(now + delay);
+      expected[std::make_pair(run_time, i)] = wheel.Add(run_time, i);
+    } else if (action < 7) {
+      Expected::iterator it = expected.begin();
+      std::advance(it, RandInt(0, static_cast<int>(expected.size()) - 1));
+      int value = -1;
+      ASSERT_TRUE(wheel.Cancel(it->second, &value));
+      EXPECT_EQ(it->first.second, value);
+      expected.erase(it);
+    } else {
+      ASSERT_EQ(expected.begin()->first.first, wheel.top_run_time());
+      ASSERT_EQ(expected.begin()->first.second, wheel.top());
+      now = (expected.begin()->first.first - Start()).InMilliseconds();
+      wheel.Pop();
+      expected.erase(expected.begin());
+    }
+    ASSERT_EQ(expected.size(), wheel.size());
+  }
+  while (!expected.empty()) {
+    ASSERT_EQ(expected.begin()->first.second, wheel.top());
+    wheel.Pop();
+    expected.erase(expected.begin());
+  }
+}
+
+TEST(TimerWheelTest, CoalesceRunTime) {
+  TimeTicks run_time = At(1234) + TimeDelta::FromMicroseconds(567);
+  EXPECT_EQ(run_time, TimerWheelBase::CoalesceRunTime(run_time, TimeDelta()));
+
+  TimeDelta slack = TimeDelta::FromMilliseconds(100);
+  TimeTicks coalesced = TimerWheelBase::CoalesceRunTime(run_time, slack);
+  EXPECT_LE(run_time, coalesced);
+  EXPECT_GE(run_time + slack, coalesced);
+  // Rounded to 64 milliseconds, the largest power of two within the slack.
+  EXPECT_EQ(0, coalesced.ToInternalValue() % 64000);
+
+  // Close times get the same time, even with different slack.
+  EXPECT_EQ(coalesced, TimerWheelBase::CoalesceRunTime(
+      run_time + TimeDelta::FromMilliseconds(5), slack));
+  EXPECT_EQ(coalesced, TimerWheelBase::CoalesceRunTime(
+      run_time + TimeDelta::FromMilliseconds(5),
+      TimeDelta::FromMilliseconds(70)));
+  EXPECT_EQ(coalesced, TimerWheelBase::CoalesceRunTime(coalesced, slack));
+}
+
+}  // namespace base
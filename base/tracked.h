@@ -114,7 +114,8 @@ class BASE_API Tracked {
 #if defined(TRACK_ALL_TASK_OBJECTS)
 
   // Pointer to instance were counts of objects with the same birth location
-  // (on the same thread) are stored.
+  // (on the same thread) are stored.  NULL if this object was not sampled
+  // (see ThreadData::SetSamplingInterval()).
   Births* tracked_births_;
   // The time this object was constructed.  If its life consisted of a long
   // waiting period, and then it became active, then this value is generally
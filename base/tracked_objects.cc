@@ -7,10 +7,13 @@
 #include <math.h>
 
 #include "base/format_macros.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/message_loop.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "base/threading/thread_restrictions.h"
+#include "base/values.h"
 
 using base::TimeDelta;
 
@@ -90,7 +93,16 @@ base::Lock ThreadData::list_lock_;
 // static
 ThreadData::Status ThreadData::status_ = ThreadData::UNINITIALIZED;
 
-ThreadData::ThreadData() : next_(NULL) {
+// static
+base::subtle::Atomic32 ThreadData::sampling_interval_ = 1;
+
+// static
+base::subtle::Atomic32 ThreadData::reset_generation_ = 0;
+
+ThreadData::ThreadData()
+    : next_(NULL),
+      generation_(base::subtle::Acquire_Load(&reset_generation_)),
+      sample_countdown_(1) {
   // This shouldn't use the MessageLoop::current() LazyInstance since this might
   // be used on a non-joinable thread.
   // http://crbug.com/62728
@@ -225,6 +237,34 @@ void ThreadData::WriteHTML(const std::string& query, std::string* output) {
   output->append("</body></html>");
 }
 
+// static
+void ThreadData::WriteJSON(std::string* output) {
+  if (!ThreadData::IsActive())
+    return;  // Not yet initialized.
+
+  DCHECK(ThreadData::current());
+
+  DataCollector collected_data;
+  collected_data.AddListOfLivingObjects();
+  DataCollector::Collection* collection = collected_data.collection();
+
+  ListValue* tasks = new ListValue;
+  for (DataCollector::Collection::const_iterator it = collection->begin();
+       it != collection->end(); ++it) {
+    tasks->Append(it->ToValue());
+  }
+  DictionaryValue root;
+  root.SetInteger("sampling_interval", sampling_interval());
+  root.Set("tasks", tasks);
+  base::JSONWriter::Write(&root, false, output);
+}
+
+// static
+void ThreadData::SetSamplingInterval(int interval) {
+  DCHECK_GT(interval, 0);
+  base::subtle::NoBarrier_Store(&sampling_interval_, interval);
+}
+
 // static
 void ThreadData::WriteHTMLTotalAndSubtotals(
     const DataCollector::Collection& match_array,
@@ -275,6 +315,7 @@ Births* ThreadData::TallyABirth(const Location& location) {
     if (!message_loop_)  // In case message loop wasn't yet around...
       message_loop_ = MessageLoop::current();  // Find it now.
   }
+  ResetIfStale();
 
   BirthMap::iterator it = birth_map_.find(location);
   if (it != birth_map_.end()) {
@@ -298,6 +339,7 @@ void ThreadData::TallyADeath(const Births& lifetimes,
     if (!message_loop_)  // In case message loop wasn't yet around...
       message_loop_ = MessageLoop::current();  // Find it now.
   }
+  ResetIfStale();
 
   DeathMap::iterator it = death_map_.find(&lifetimes);
   if (it != death_map_.end()) {
@@ -339,12 +381,25 @@ void ThreadData::SnapshotDeathMap(DeathMap *output) const {
 
 // static
 void ThreadData::ResetAllThreadData() {
-  ThreadData* my_list = ThreadData::current()->first();
+  // Writing the tallies of other threads would race with their updates, so
+  // each thread is left to clear its own.
+  base::subtle::Barrier_AtomicIncrement(&reset_generation_, 1);
+}
 
-  for (ThreadData* thread_data = my_list;
-       thread_data;
-       thread_data = thread_data->next())
-    thread_data->Reset();
+bool ThreadData::IsUpToDate() const {
+  return base::subtle::Acquire_Load(&generation_) ==
+      base::subtle::Acquire_Load(&reset_generation_);
+}
+
+void ThreadData::ResetIfStale() {
+  // No barrier on this fast path: a reset seen a little late is harmless.
+  base::subtle::Atomic32 generation =
+      base::subtle::NoBarrier_Load(&reset_generation_);
+  if (generation == generation_)
+    return;
+  Reset();
+  // Snapshots ignore our data until they see the new generation.
+  base::subtle::Release_Store(&generation_, generation);
 }
 
 void ThreadData::Reset() {
@@ -566,6 +621,23 @@ void Snapshot::Write(std::string* output) const {
   birth_->location().Write(true, true, output);
 }
 
+DictionaryValue* Snapshot::ToValue() const {
+  DictionaryValue* value = new DictionaryValue;
+  value->SetString("birth_thread", birth_->birth_thread()->ThreadName());
+  value->SetString("death_thread", DeathThreadName());
+  value->SetString("file", location().file_name());
+  value->SetString("function", location().function_name());
+  value->SetInteger("line", location().line_number());
+  value->SetInteger("count", count());
+  // Totals are doubles since they can overflow an int.
+  value->SetDouble("life_ms",
+                   static_cast<double>(life_duration().InMilliseconds()));
+  value->SetDouble("square_life_ms", static_cast<double>(square_duration()));
+  if (count())
+    value->SetInteger("average_life_ms", AverageMsDuration());
+  return value;
+}
+
 void Snapshot::Add(const Snapshot& other) {
   death_data_.AddDeathData(other.death_data_);
 }
@@ -607,6 +679,13 @@ DataCollector::~DataCollector() {
 }
 
 void DataCollector::Append(const ThreadData& thread_data) {
+  if (!thread_data.IsUpToDate()) {
+    // The data was reset, but the thread has not cleared it yet.
+    base::AutoLock lock(accumulation_lock_);
+    --count_of_contributing_threads_;
+    return;
+  }
+
   // Get copy of data (which is done under ThreadData's lock).
   ThreadData::BirthMap birth_map;
   thread_data.SnapshotBirthMap(&birth_map);
@@ -621,7 +700,7 @@ void DataCollector::Append(const ThreadData& thread_data) {
   for (ThreadData::DeathMap::const_iterator it = death_map.begin();
        it != death_map.end(); ++it) {
     collection_.push_back(Snapshot(*it->first, thread_data, it->second));
-    global_birth_count_[it->first] -= it->first->birth_count();
+    global_birth_count_[it->first] -= it->second.count();
   }
 
   for (ThreadData::BirthMap::const_iterator it = birth_map.begin();
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/base_api.h"
 #include "base/synchronization/lock.h"
 #include "base/tracked.h"
@@ -139,15 +140,28 @@
 // that set? etc.).  Aggregation instances collect running sums of any set of
 // snapshot instances, and are used to print sub-totals in an about:tasks page.
 //
+// To keep the overhead low enough to leave tracking on in production, only one
+// in every ThreadData::sampling_interval() tracked objects born on a thread has
+// its birth and death recorded.  The others cost a single decrement of a
+// per-thread counter.  The counts displayed are then those of the sampled
+// objects, and should be scaled up by the interval.
+//
+// The counts and durations of each thread are only ever written by that
+// thread, so they need neither locks nor atomic operations.  Even a reset
+// (see ResetAllThreadData()) only bumps a global generation number, and each
+// thread clears its own data the next time it records a birth or death.
+// Threads that have not caught up with a reset are treated as having no data
+// when a snapshot is taken.
+//
 // TODO(jar): I need to store DataCollections, and provide facilities for taking
 // the difference between two gathered DataCollections.  For now, I'm just
-// adding a hack that Reset()'s to zero all counts and stats.  This is also
-// done in a slighly thread-unsafe fashion, as the reseting is done
-// asynchronously relative to ongoing updates, and worse yet, some data fields
-// are 64bit quantities, and are not atomicly accessed (reset or incremented
-// etc.).  For basic profiling, this will work "most of the time," and should be
-// sufficient... but storing away DataCollections is the "right way" to do this.
+// adding a hack that Reset()'s to zero all counts and stats.  Some data fields
+// are 64bit quantities, and are not atomicly read by the snapshot while they
+// are being incremented.  For basic profiling, this will work "most of the
+// time," and should be sufficient... but storing away DataCollections is the
+// "right way" to do this.
 //
+class DictionaryValue;
 class MessageLoop;
 
 
@@ -273,6 +287,10 @@ class BASE_API Snapshot {
 
   void Write(std::string* output) const;
 
+  // Returns the birth and death places and statistics as a dictionary, for
+  // ThreadData::WriteJSON().  The caller owns the result.
+  DictionaryValue* ToValue() const;
+
   void Add(const Snapshot& other);
 
  private:
@@ -489,6 +507,28 @@ class BASE_API ThreadData {
       const DataCollector::Collection& match_array,
       const Comparator& comparator, std::string* output);
 
+  // Write all births and deaths as JSON, for collection by tools rather than
+  // display.  The output is an object holding the "sampling_interval" and a
+  // list of "tasks", one per birth place, birth thread and death thread.
+  static void WriteJSON(std::string* output);
+
+  // Record only one in |interval| tracked objects born on each thread.  The
+  // default, 1, records all of them.  May be called at any time.
+  static void SetSamplingInterval(int interval);
+  static int sampling_interval() {
+    return base::subtle::NoBarrier_Load(&sampling_interval_);
+  }
+
+  // Called when a tracked object is born on this thread.  Returns true if its
+  // birth and death should be recorded, which is once per sampling_interval()
+  // calls.
+  bool ShouldSample() {
+    if (--sample_countdown_ > 0)
+      return false;
+    sample_countdown_ = sampling_interval();
+    return true;
+  }
+
   // In this thread's data, record a new birth.
   Births* TallyABirth(const Location& location);
 
@@ -509,15 +549,20 @@ class BASE_API ThreadData {
   void SnapshotBirthMap(BirthMap *output) const;
   void SnapshotDeathMap(DeathMap *output) const;
 
-  // Hack: asynchronously clear all birth counts and death tallies data values
-  // in all ThreadData instances.  The numerical (zeroing) part is done without
-  // use of a locks or atomics exchanges, and may (for int64 values) produce
-  // bogus counts VERY rarely.
+  // Hack: clear all birth counts and death tallies data values in all
+  // ThreadData instances.  Each thread clears its own data the next time it
+  // records a birth or death, and until then it is left out of snapshots.
   static void ResetAllThreadData();
 
   // Using our lock to protect the iteration, Clear all birth and death data.
+  // Must be called on the thread that owns this instance.
   void Reset();
 
+  // Returns false if ResetAllThreadData() has been called since this thread
+  // last cleared its data, in which case its data should be ignored.  May be
+  // called on any thread.
+  bool IsUpToDate() const;
+
   // Using the "known list of threads" gathered during births and deaths, the
   // following attempts to run the given function once all all such threads.
   // Note that the function can only be run on threads which have a message
@@ -571,6 +616,9 @@ class BASE_API ThreadData {
   // notification into the memory cache of all possible threads.
   static void ShutdownDisablingFurtherTracking();
 
+  // Calls Reset() if ResetAllThreadData() was called since the last time.
+  void ResetIfStale();
+
   // We use thread local store to identify which ThreadData to interact with.
   static base::ThreadLocalStorage::Slot tls_index_;
 
@@ -585,11 +633,24 @@ class BASE_API ThreadData {
   // and avoid additional calls into the  service.
   static Status status_;
 
+  // See SetSamplingInterval().  Read by every thread as its objects are born.
+  static base::subtle::Atomic32 sampling_interval_;
+
+  // Incremented by ResetAllThreadData().
+  static base::subtle::Atomic32 reset_generation_;
+
   // Link to next instance (null terminated list). Used to globally track all
   // registered instances (corresponds to all registered threads where we keep
   // data).
   ThreadData* next_;
 
+  // The value of reset_generation_ when this thread last cleared its data.
+  // Only written by this thread, but read by snapshots on other threads.
+  base::subtle::Atomic32 generation_;
+
+  // The number of births until the next one to be sampled.
+  int sample_countdown_;
+
   // The message loop where tasks needing to access this instance's private data
   // should be directed.  Since some threads have no message loop, some
   // instances have data that can't be (safely) modified externally.
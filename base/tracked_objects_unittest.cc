@@ -6,7 +6,10 @@
 
 #include "base/tracked_objects.h"
 
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/message_loop.h"
+#include "base/values.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace tracked_objects {
@@ -93,4 +96,107 @@ TEST_F(TrackedObjectsTest, TinyStartupShutdown) {
   ThreadData::ShutdownSingleThreadedCleanup();
 }
 
+TEST_F(TrackedObjectsTest, Sampling) {
+  if (!ThreadData::StartTracking(true))
+    return;
+
+  // Only the 1st, 4th and 7th objects are recorded.
+  ThreadData::SetSamplingInterval(3);
+  for (int i = 0; i < 7; ++i)
+    delete new NoopTracked;
+
+  const ThreadData* data = ThreadData::current();
+  ThreadData::BirthMap birth_map;
+  data->SnapshotBirthMap(&birth_map);
+  ASSERT_EQ(1u, birth_map.size());
+  EXPECT_EQ(3, birth_map.begin()->second->birth_count());
+  ThreadData::DeathMap death_map;
+  data->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(3, death_map.begin()->second.count());
+
+  // Objects that were not sampled have no birth place to be missing.
+  {
+    NoopTracked not_sampled;
+    NoopTracked also_not_sampled;
+    NoopTracked sampled;
+    EXPECT_FALSE(not_sampled.MissingBirthplace());
+    EXPECT_TRUE(sampled.MissingBirthplace());
+  }
+  ThreadData::SetSamplingInterval(1);
+
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
+TEST_F(TrackedObjectsTest, ResetAllThreadData) {
+  if (!ThreadData::StartTracking(true))
+    return;
+
+  delete new NoopTracked;
+  ThreadData* data = ThreadData::current();
+  EXPECT_TRUE(data->IsUpToDate());
+
+  // The data is left out of snapshots until this thread clears it.
+  ThreadData::ResetAllThreadData();
+  EXPECT_FALSE(data->IsUpToDate());
+  {
+    DataCollector collected_data;
+    collected_data.AddListOfLivingObjects();
+    EXPECT_EQ(0u, collected_data.collection()->size());
+  }
+
+  delete new NoopTracked;
+  EXPECT_TRUE(data->IsUpToDate());
+  ThreadData::BirthMap birth_map;
+  data->SnapshotBirthMap(&birth_map);
+  ASSERT_EQ(1u, birth_map.size());
+  EXPECT_EQ(1, birth_map.begin()->second->birth_count());
+  ThreadData::DeathMap death_map;
+  data->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(1, death_map.begin()->second.count());
+
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
+TEST_F(TrackedObjectsTest, WriteJSON) {
+  if (!ThreadData::StartTracking(true))
+    return;
+
+  delete new NoopTracked;
+  NoopTracked alive;
+
+  std::string json;
+  ThreadData::WriteJSON(&json);
+  scoped_ptr<Value> value(base::JSONReader::Read(json, false));
+  ASSERT_TRUE(value.get());
+  ASSERT_TRUE(value->IsType(Value::TYPE_DICTIONARY));
+  DictionaryValue* root = static_cast<DictionaryValue*>(value.get());
+  int sampling_interval = 0;
+  EXPECT_TRUE(root->GetInteger("sampling_interval", &sampling_interval));
+  EXPECT_EQ(1, sampling_interval);
+
+  // One task has died, and one is still alive.
+  ListValue* tasks = NULL;
+  ASSERT_TRUE(root->GetList("tasks", &tasks));
+  ASSERT_EQ(2u, tasks->GetSize());
+  DictionaryValue* task = NULL;
+  ASSERT_TRUE(tasks->GetDictionary(0, &task));
+  int count = 0;
+  EXPECT_TRUE(task->GetInteger("count", &count));
+  EXPECT_EQ(1, count);
+  int line = 0;
+  EXPECT_TRUE(task->GetInteger("line", &line));
+  EXPECT_EQ(-1, line);
+  std::string file;
+  EXPECT_TRUE(task->GetString("file", &file));
+  EXPECT_EQ("NeedToSetBirthPlace", file);
+  ASSERT_TRUE(tasks->GetDictionary(1, &task));
+  std::string death_thread;
+  EXPECT_TRUE(task->GetString("death_thread", &death_thread));
+  EXPECT_EQ("Still_Alive", death_thread);
+
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
 }  // namespace tracked_objects
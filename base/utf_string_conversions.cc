@@ -6,10 +6,9 @@
 
 #include "base/string_piece.h"
 #include "base/string_util.h"
+#include "base/string_util_simd.h"
 #include "base/utf_string_conversion_utils.h"
 
-using base::PrepareForUTF8Output;
-using base::PrepareForUTF16Or32Output;
 using base::ReadUnicodeCharacter;
 using base::WriteUnicodeCharacter;
 
@@ -17,10 +16,44 @@ namespace {
 
 // Generalized Unicode converter -----------------------------------------------
 
+// Shorter ASCII runs are not worth handing to the vectorized kernels.
+const size_t kMinKernelLength = 16;
+
+// Sign extension makes the chars above 0x7F of a signed char type large too.
+template<typename CHAR>
+inline bool IsASCIIChar(CHAR c) {
+  return static_cast<uint32>(c) < 0x80;
+}
+
+// Copies the ASCII chars at the start of |src| to |dest|, and returns how many
+// there were.
+template<typename SRC_CHAR, typename DEST_CHAR>
+size_t CopyASCIIPrefix(const SRC_CHAR* src, size_t src_len, DEST_CHAR* dest) {
+  size_t i = 0;
+  for (; i < src_len && IsASCIIChar(src[i]); ++i)
+    dest[i] = static_cast<DEST_CHAR>(src[i]);
+  return i;
+}
+
+size_t CopyASCIIPrefix(const char* src, size_t src_len, char16* dest) {
+  const base::internal::StringKernels* kernels =
+      src_len < kMinKernelLength ? NULL : base::internal::GetStringKernels();
+  size_t copied = kernels ? kernels->widen_ascii(src, src_len, dest) : 0;
+  return copied + CopyASCIIPrefix<char, char16>(src + copied, src_len - copied,
+                                                dest + copied);
+}
+
+size_t CopyASCIIPrefix(const char16* src, size_t src_len, char* dest) {
+  const base::internal::StringKernels* kernels =
+      src_len < kMinKernelLength ? NULL : base::internal::GetStringKernels();
+  size_t copied = kernels ? kernels->narrow_ascii(src, src_len, dest) : 0;
+  return copied + CopyASCIIPrefix<char16, char>(src + copied, src_len - copied,
+                                                dest + copied);
+}
+
 // Converts the given source Unicode character type to the given destination
 // Unicode character type as a STL string. The given input buffer and size
-// determine the source, and the given output STL string will be replaced by
-// the result.
+// determine the source, and the given output STL string will be appended to.
 template<typename SRC_CHAR, typename DEST_STRING>
 bool ConvertUnicode(const SRC_CHAR* src,
                     size_t src_len,
@@ -29,6 +62,10 @@ bool ConvertUnicode(const SRC_CHAR* src,
   bool success = true;
   int32 src_len32 = static_cast<int32>(src_len);
   for (int32 i = 0; i < src_len32; i++) {
+    if (IsASCIIChar(src[i])) {
+      output->push_back(static_cast<typename DEST_STRING::value_type>(src[i]));
+      continue;
+    }
     uint32 code_point;
     if (ReadUnicodeCharacter(src, src_len32, &i, &code_point)) {
       WriteUnicodeCharacter(code_point, output);
@@ -41,13 +78,37 @@ bool ConvertUnicode(const SRC_CHAR* src,
   return success;
 }
 
+// Replaces |output| with the conversion of |src|. Copies the ASCII run at the
+// start of |src| directly, which is all of it most of the time, and converts
+// the rest code point by code point. |max_dest_per_src| is the most chars one
+// source char converts to. It bounds the output, so that the output is
+// allocated once when |src| is ASCII, and at most twice otherwise.
+template<typename SRC_CHAR, typename DEST_STRING>
+bool ConvertUnicodeAfterASCII(const SRC_CHAR* src,
+                              size_t src_len,
+                              size_t max_dest_per_src,
+                              DEST_STRING* output) {
+  output->clear();
+  if (src_len == 0)
+    return true;
+
+  output->resize(src_len);
+  size_t ascii_len = CopyASCIIPrefix(src, src_len, &(*output)[0]);
+  output->resize(ascii_len);
+  if (ascii_len == src_len)
+    return true;
+
+  output->reserve(ascii_len + (src_len - ascii_len) * max_dest_per_src);
+  return ConvertUnicode(src + ascii_len, src_len - ascii_len, output);
+}
+
 }  // namespace
 
 // UTF-8 <-> Wide --------------------------------------------------------------
 
 bool WideToUTF8(const wchar_t* src, size_t src_len, std::string* output) {
-  PrepareForUTF8Output(src, src_len, output);
-  return ConvertUnicode(src, src_len, output);
+  return ConvertUnicodeAfterASCII(src, src_len, sizeof(wchar_t) == 2 ? 3 : 4,
+                                  output);
 }
 
 std::string WideToUTF8(const std::wstring& wide) {
@@ -59,8 +120,7 @@ std::string WideToUTF8(const std::wstring& wide) {
 }
 
 bool UTF8ToWide(const char* src, size_t src_len, std::wstring* output) {
-  PrepareForUTF16Or32Output(src, src_len, output);
-  return ConvertUnicode(src, src_len, output);
+  return ConvertUnicodeAfterASCII(src, src_len, 1, output);
 }
 
 std::wstring UTF8ToWide(const base::StringPiece& utf8) {
@@ -129,8 +189,8 @@ std::wstring UTF16ToWide(const string16& utf16) {
 #if defined(WCHAR_T_IS_UTF32)
 
 bool UTF8ToUTF16(const char* src, size_t src_len, string16* output) {
-  PrepareForUTF16Or32Output(src, src_len, output);
-  return ConvertUnicode(src, src_len, output);
+  // A UTF-8 byte never makes more than one UTF-16 char.
+  return ConvertUnicodeAfterASCII(src, src_len, 1, output);
 }
 
 string16 UTF8ToUTF16(const base::StringPiece& utf8) {
@@ -142,8 +202,8 @@ string16 UTF8ToUTF16(const base::StringPiece& utf8) {
 }
 
 bool UTF16ToUTF8(const char16* src, size_t src_len, std::string* output) {
-  PrepareForUTF8Output(src, src_len, output);
-  return ConvertUnicode(src, src_len, output);
+  // A UTF-16 char makes at most three UTF-8 bytes, and a surrogate pair four.
+  return ConvertUnicodeAfterASCII(src, src_len, 3, output);
 }
 
 std::string UTF16ToUTF8(const string16& utf16) {
@@ -0,0 +1,104 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/perftimer.h"
+#include "base/string16.h"
+#include "base/stringprintf.h"
+#include "base/utf_string_conversion_utils.h"
+#include "base/utf_string_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Each measurement converts this many source bytes.
+const size_t kBytes = 64 * 1024 * 1024;
+
+// Converts code point by code point, the way the conversions used to.
+template<typename SRC_CHAR, typename DEST_STRING>
+void ConvertByCodePoint(const SRC_CHAR* src, size_t src_len,
+                        DEST_STRING* output) {
+  int32 src_len32 = static_cast<int32>(src_len);
+  for (int32 i = 0; i < src_len32; i++) {
+    uint32 code_point;
+    if (!ReadUnicodeCharacter(src, src_len32, &i, &code_point))
+      code_point = 0xFFFD;
+    WriteUnicodeCharacter(code_point, output);
+  }
+}
+
+void OldUTF8ToUTF16(const std::string& utf8, string16* output) {
+  PrepareForUTF16Or32Output(utf8.data(), utf8.length(), output);
+  ConvertByCodePoint(utf8.data(), utf8.length(), output);
+}
+
+void OldUTF16ToUTF8(const string16& utf16, std::string* output) {
+  PrepareForUTF8Output(utf16.data(), utf16.length(), output);
+  ConvertByCodePoint(utf16.data(), utf16.length(), output);
+}
+
+void NewUTF8ToUTF16(const std::string& utf8, string16* output) {
+  UTF8ToUTF16(utf8.data(), utf8.length(), output);
+}
+
+void NewUTF16ToUTF8(const string16& utf16, std::string* output) {
+  UTF16ToUTF8(utf16.data(), utf16.length(), output);
+}
+
+// Logs the MB of |src| that |convert| converts per second.
+template<typename SRC_STRING, typename DEST_STRING>
+void Measure(const std::string& name,
+             const SRC_STRING& src,
+             void (*convert)(const SRC_STRING&, DEST_STRING*)) {
+  size_t bytes = src.length() * sizeof(typename SRC_STRING::value_type);
+  size_t runs = kBytes / bytes;
+  DEST_STRING output;
+  PerfTimer timer;
+  for (size_t run = 0; run < runs; ++run)
+    convert(src, &output);
+  LogPerfResult(name.c_str(),
+                runs * bytes / (1024 * 1024) / timer.Elapsed().InSecondsF(),
+                "MB/s");
+}
+
+// Returns |length| chars of text: ASCII, ASCII with one accented letter at
+// the start, or Chinese.
+enum Text { TEXT_ASCII, TEXT_MOSTLY_ASCII, TEXT_CJK };
+const char* const kTextNames[] = { "ascii", "mostly_ascii", "cjk" };
+
+string16 MakeText(Text text, size_t length) {
+  string16 result;
+  for (size_t i = 0; i < length; ++i) {
+    if (text == TEXT_CJK)
+      result.push_back(static_cast<char16>(0x4E00 + i % 1000));
+    else
+      result.push_back(static_cast<char16>('a' + i % 26));
+  }
+  if (text == TEXT_MOSTLY_ASCII && length)
+    result[0] = 0xE9;
+  return result;
+}
+
+}  // namespace
+
+TEST(UTFStringConversionsPerfTest, UTF8AndUTF16) {
+  const size_t kLengths[] = { 16, 256, 16384 };
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    for (int text = TEXT_ASCII; text <= TEXT_CJK; ++text) {
+      string16 utf16 = MakeText(static_cast<Text>(text), kLengths[i]);
+      std::string utf8 = UTF16ToUTF8(utf16);
+      std::string suffix = StringPrintf("_%s_%d", kTextNames[text],
+                                        static_cast<int>(kLengths[i]));
+      Measure("UTF8ToUTF16_old" + suffix, utf8, &OldUTF8ToUTF16);
+      Measure("UTF8ToUTF16" + suffix, utf8, &NewUTF8ToUTF16);
+      Measure("UTF16ToUTF8_old" + suffix, utf16, &OldUTF16ToUTF8);
+      Measure("UTF16ToUTF8" + suffix, utf16, &NewUTF16ToUTF8);
+    }
+  }
+}
+
+}  // namespace base
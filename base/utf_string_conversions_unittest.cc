@@ -208,4 +208,46 @@ TEST(UTFStringConversionsTest, ConvertMultiString) {
   EXPECT_EQ(expected, converted);
 }
 
+// ASCII is copied in blocks up to the first non-ASCII char, which can be
+// anywhere in a block or after it.
+TEST(UTFStringConversionsTest, ConvertASCIIRuns) {
+  for (size_t length = 0; length < 50; ++length) {
+    std::string ascii;
+    for (size_t i = 0; i < length; ++i)
+      ascii.push_back(static_cast<char>('!' + (i * 7) % 94));
+    string16 ascii16(ascii.begin(), ascii.end());
+    EXPECT_EQ(ascii16, UTF8ToUTF16(ascii));
+    EXPECT_EQ(ascii, UTF16ToUTF8(ascii16));
+
+    for (size_t pos = 0; pos <= length; ++pos) {
+      // "\xC3\xA9" is U+00E9, and "\xE4\xBD\xA0" U+4F60.
+      std::string utf8 = ascii.substr(0, pos) + "\xC3\xA9" +
+          ascii.substr(pos) + "\xE4\xBD\xA0";
+      string16 utf16 = ascii16.substr(0, pos) + static_cast<char16>(0xE9) +
+          ascii16.substr(pos) + static_cast<char16>(0x4F60);
+      string16 converted16;
+      EXPECT_TRUE(UTF8ToUTF16(utf8.data(), utf8.length(), &converted16));
+      EXPECT_EQ(utf16, converted16) << length << " " << pos;
+      std::string converted8;
+      EXPECT_TRUE(UTF16ToUTF8(utf16.data(), utf16.length(), &converted8));
+      EXPECT_EQ(utf8, converted8) << length << " " << pos;
+
+      // Invalid input still converts the ASCII around it.
+      std::string invalid8 = ascii.substr(0, pos) + "\xFF" + ascii.substr(pos);
+      string16 replaced16 = ascii16.substr(0, pos) +
+          static_cast<char16>(0xFFFD) + ascii16.substr(pos);
+      EXPECT_FALSE(UTF8ToUTF16(invalid8.data(), invalid8.length(),
+                               &converted16));
+      EXPECT_EQ(replaced16, converted16);
+      string16 invalid16 = ascii16.substr(0, pos) +
+          static_cast<char16>(0xD800) + ascii16.substr(pos);
+      std::string replaced8 = ascii.substr(0, pos) + "\xEF\xBF\xBD" +
+          ascii.substr(pos);
+      EXPECT_FALSE(UTF16ToUTF8(invalid16.data(), invalid16.length(),
+                               &converted8));
+      EXPECT_EQ(replaced8, converted8);
+    }
+  }
+}
+
 }  // base
@@ -4,12 +4,34 @@
 
 #include "base/values.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/string_util.h"
 #include "base/utf_string_conversions.h"
 
 namespace {
 
+// The most entries a DictionaryValue keeps in its sorted vector. Lookups in it
+// are binary searches, and an insertion moves at most this many entries.
+const size_t kMaxFlatDictionarySize = 16;
+
+// Returns the index of the first entry in |entries| whose key is not less
+// than |key|.
+size_t FindFlatEntry(const FlatValueMap& entries,
+                     const base::StringPiece& key) {
+  size_t begin = 0;
+  size_t end = entries.size();
+  while (begin < end) {
+    size_t middle = begin + (end - begin) / 2;
+    if (base::StringPiece(entries[middle].first) < key)
+      begin = middle + 1;
+    else
+      end = middle;
+  }
+  return begin;
+}
+
 // Make a deep copy of |node|, but don't include empty lists or dictionaries
 // in the copy. It's possible for this function to return NULL and it
 // expects |node| to always be non-NULL.
@@ -320,12 +342,16 @@ DictionaryValue::~DictionaryValue() {
 
 bool DictionaryValue::HasKey(const std::string& key) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator current_entry = dictionary_.find(key);
-  DCHECK((current_entry == dictionary_.end()) || current_entry->second);
-  return current_entry != dictionary_.end();
+  return FindValue(key) != NULL;
 }
 
 void DictionaryValue::Clear() {
+  for (FlatValueMap::iterator it = flat_dictionary_.begin();
+       it != flat_dictionary_.end(); ++it) {
+    delete it->second;
+  }
+  flat_dictionary_.clear();
+
   ValueMap::iterator dict_iterator = dictionary_.begin();
   while (dict_iterator != dictionary_.end()) {
     delete dict_iterator->second;
@@ -339,24 +365,31 @@ void DictionaryValue::Set(const std::string& path, Value* in_value) {
   DCHECK(IsStringUTF8(path));
   DCHECK(in_value);
 
-  std::string current_path(path);
+  // Walk the path in place rather than copying each key out of it.
   DictionaryValue* current_dictionary = this;
-  for (size_t delimiter_position = current_path.find('.');
+  size_t key_begin = 0;
+  for (size_t delimiter_position = path.find('.');
        delimiter_position != std::string::npos;
-       delimiter_position = current_path.find('.')) {
+       delimiter_position = path.find('.', key_begin)) {
     // Assume that we're indexing into a dictionary.
-    std::string key(current_path, 0, delimiter_position);
-    DictionaryValue* child_dictionary = NULL;
-    if (!current_dictionary->GetDictionary(key, &child_dictionary)) {
+    base::StringPiece key(path.data() + key_begin,
+                          delimiter_position - key_begin);
+    Value* child = current_dictionary->FindValue(key);
+    DictionaryValue* child_dictionary;
+    if (child && child->IsType(TYPE_DICTIONARY)) {
+      child_dictionary = static_cast<DictionaryValue*>(child);
+    } else {
       child_dictionary = new DictionaryValue;
-      current_dictionary->SetWithoutPathExpansion(key, child_dictionary);
+      current_dictionary->SetValue(key, child_dictionary);
     }
 
     current_dictionary = child_dictionary;
-    current_path.erase(0, delimiter_position + 1);
+    key_begin = delimiter_position + 1;
   }
 
-  current_dictionary->SetWithoutPathExpansion(current_path, in_value);
+  current_dictionary->SetValue(
+      base::StringPiece(path.data() + key_begin, path.size() - key_begin),
+      in_value);
 }
 
 void DictionaryValue::SetBoolean(const std::string& path, bool in_value) {
@@ -383,33 +416,33 @@ void DictionaryValue::SetString(const std::string& path,
 
 void DictionaryValue::SetWithoutPathExpansion(const std::string& key,
                                               Value* in_value) {
-  // If there's an existing value here, we need to delete it, because
-  // we own all our children.
-  if (HasKey(key)) {
-    DCHECK(dictionary_[key] != in_value);  // This would be bogus
-    delete dictionary_[key];
-  }
-
-  dictionary_[key] = in_value;
+  SetValue(key, in_value);
 }
 
 bool DictionaryValue::Get(const std::string& path, Value** out_value) const {
   DCHECK(IsStringUTF8(path));
-  std::string current_path(path);
   const DictionaryValue* current_dictionary = this;
-  for (size_t delimiter_position = current_path.find('.');
+  size_t key_begin = 0;
+  for (size_t delimiter_position = path.find('.');
        delimiter_position != std::string::npos;
-       delimiter_position = current_path.find('.')) {
-    DictionaryValue* child_dictionary = NULL;
-    if (!current_dictionary->GetDictionary(
-            current_path.substr(0, delimiter_position), &child_dictionary))
+       delimiter_position = path.find('.', key_begin)) {
+    Value* child = current_dictionary->FindValue(base::StringPiece(
+        path.data() + key_begin, delimiter_position - key_begin));
+    if (!child || !child->IsType(TYPE_DICTIONARY))
       return false;
 
-    current_dictionary = child_dictionary;
-    current_path.erase(0, delimiter_position + 1);
+    current_dictionary = static_cast<DictionaryValue*>(child);
+    key_begin = delimiter_position + 1;
   }
 
-  return current_dictionary->GetWithoutPathExpansion(current_path, out_value);
+  Value* entry = current_dictionary->FindValue(
+      base::StringPiece(path.data() + key_begin, path.size() - key_begin));
+  if (!entry)
+    return false;
+
+  if (out_value)
+    *out_value = entry;
+  return true;
 }
 
 bool DictionaryValue::GetBoolean(const std::string& path,
@@ -514,11 +547,10 @@ bool DictionaryValue::GetList(const std::string& path,
 bool DictionaryValue::GetWithoutPathExpansion(const std::string& key,
                                               Value** out_value) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator entry_iterator = dictionary_.find(key);
-  if (entry_iterator == dictionary_.end())
+  Value* entry = FindValue(key);
+  if (!entry)
     return false;
 
-  Value* entry = entry_iterator->second;
   if (out_value)
     *out_value = entry;
   return true;
@@ -608,16 +640,33 @@ bool DictionaryValue::Remove(const std::string& path, Value** out_value) {
 bool DictionaryValue::RemoveWithoutPathExpansion(const std::string& key,
                                                  Value** out_value) {
   DCHECK(IsStringUTF8(key));
-  ValueMap::iterator entry_iterator = dictionary_.find(key);
-  if (entry_iterator == dictionary_.end())
-    return false;
+  Value* entry;
+  if (is_flat()) {
+    size_t index = FindFlatEntry(flat_dictionary_, key);
+    if (index == flat_dictionary_.size() ||
+        flat_dictionary_[index].first != key)
+      return false;
+
+    // Move the later entries up by swapping rather than copying their keys.
+    entry = flat_dictionary_[index].second;
+    for (size_t i = index + 1; i < flat_dictionary_.size(); ++i) {
+      flat_dictionary_[i - 1].first.swap(flat_dictionary_[i].first);
+      flat_dictionary_[i - 1].second = flat_dictionary_[i].second;
+    }
+    flat_dictionary_.pop_back();
+  } else {
+    ValueMap::iterator entry_iterator = dictionary_.find(key);
+    if (entry_iterator == dictionary_.end())
+      return false;
+
+    entry = entry_iterator->second;
+    dictionary_.erase(entry_iterator);
+  }
 
-  Value* entry = entry_iterator->second;
   if (out_value)
     *out_value = entry;
   else
     delete entry;
-  dictionary_.erase(entry_iterator);
   return true;
 }
 
@@ -649,6 +698,14 @@ void DictionaryValue::MergeDictionary(const DictionaryValue* dictionary) {
 DictionaryValue* DictionaryValue::DeepCopy() const {
   DictionaryValue* result = new DictionaryValue;
 
+  // The entries are already sorted, so a flat copy can simply be appended to.
+  result->flat_dictionary_.reserve(flat_dictionary_.size());
+  for (FlatValueMap::const_iterator current_entry(flat_dictionary_.begin());
+       current_entry != flat_dictionary_.end(); ++current_entry) {
+    result->flat_dictionary_.push_back(std::make_pair(
+        current_entry->first, current_entry->second->DeepCopy()));
+  }
+
   for (ValueMap::const_iterator current_entry(dictionary_.begin());
        current_entry != dictionary_.end(); ++current_entry) {
     result->SetWithoutPathExpansion(current_entry->first,
@@ -684,6 +741,62 @@ bool DictionaryValue::Equals(const Value* other) const {
   return true;
 }
 
+Value* DictionaryValue::FindValue(const base::StringPiece& key) const {
+  if (is_flat()) {
+    size_t index = FindFlatEntry(flat_dictionary_, key);
+    if (index == flat_dictionary_.size() ||
+        base::StringPiece(flat_dictionary_[index].first) != key)
+      return NULL;
+    return flat_dictionary_[index].second;
+  }
+
+  ValueMap::const_iterator entry_iterator = dictionary_.find(key.as_string());
+  if (entry_iterator == dictionary_.end())
+    return NULL;
+  return entry_iterator->second;
+}
+
+void DictionaryValue::SetValue(const base::StringPiece& key,
+                               Value* in_value) {
+  DCHECK(in_value);
+  if (is_flat()) {
+    size_t index = FindFlatEntry(flat_dictionary_, key);
+    if (index < flat_dictionary_.size() &&
+        base::StringPiece(flat_dictionary_[index].first) == key) {
+      // If there's an existing value here, we need to delete it, because
+      // we own all our children.
+      // This would be bogus.
+      DCHECK(flat_dictionary_[index].second != in_value);
+      delete flat_dictionary_[index].second;
+      flat_dictionary_[index].second = in_value;
+      return;
+    }
+
+    if (flat_dictionary_.size() < kMaxFlatDictionarySize) {
+      // Append the entry and swap it down into place, which is cheaper than
+      // copying the keys it passes.
+      flat_dictionary_.push_back(std::make_pair(key.as_string(), in_value));
+      for (size_t i = flat_dictionary_.size() - 1; i > index; --i) {
+        flat_dictionary_[i].first.swap(flat_dictionary_[i - 1].first);
+        std::swap(flat_dictionary_[i].second, flat_dictionary_[i - 1].second);
+      }
+      return;
+    }
+
+    // The dictionary has outgrown the vector.
+    dictionary_.insert(flat_dictionary_.begin(), flat_dictionary_.end());
+    FlatValueMap().swap(flat_dictionary_);
+  }
+
+  std::pair<ValueMap::iterator, bool> result =
+      dictionary_.insert(std::make_pair(key.as_string(), in_value));
+  if (!result.second) {
+    DCHECK(result.first->second != in_value);  // This would be bogus
+    delete result.first->second;
+    result.first->second = in_value;
+  }
+}
+
 ///////////////////// ListValue ////////////////////
 
 ListValue::ListValue() : Value(TYPE_LIST) {
@@ -25,11 +25,13 @@
 #include <iterator>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/base_api.h"
 #include "base/basictypes.h"
 #include "base/string16.h"
+#include "base/string_piece.h"
 #include "build/build_config.h"
 
 class BinaryValue;
@@ -41,6 +43,7 @@ class Value;
 
 typedef std::vector<Value*> ValueVector;
 typedef std::map<std::string, Value*> ValueMap;
+typedef std::vector<std::pair<std::string, Value*> > FlatValueMap;
 
 // The Value class is the base class for Values.  A Value can be
 // instantiated via the Create*Value() factory methods, or by directly
@@ -206,6 +209,17 @@ class BASE_API BinaryValue: public Value {
 // DictionaryValue provides a key-value dictionary with (optional) "path"
 // parsing for recursive access; see the comment at the top of the file. Keys
 // are |std::string|s and should be UTF-8 encoded.
+//
+// Most dictionaries are small, so they keep their entries in a vector sorted
+// by key, which costs one allocation rather than one per entry and is quicker
+// to search. A dictionary that outgrows it moves its entries into a map.
+// Either way the values themselves are allocated separately, so pointers
+// returned by Get() stay valid while other keys are added or removed.
+//
+// Unlike with a map, adding or removing a key invalidates every key_iterator
+// and every key reference obtained from the dictionary, since entries move
+// within the vector. Replacing the value of an existing key does not. Collect
+// the keys to add or remove while iterating, and change the dictionary after.
 class BASE_API DictionaryValue : public Value {
  public:
   DictionaryValue();
@@ -215,10 +229,10 @@ class BASE_API DictionaryValue : public Value {
   bool HasKey(const std::string& key) const;
 
   // Returns the number of Values in this dictionary.
-  size_t size() const { return dictionary_.size(); }
+  size_t size() const { return flat_dictionary_.size() + dictionary_.size(); }
 
   // Returns whether the dictionary is empty.
-  bool empty() const { return dictionary_.empty(); }
+  bool empty() const { return flat_dictionary_.empty() && dictionary_.empty(); }
 
   // Clears any current contents of this dictionary.
   void Clear();
@@ -317,27 +331,56 @@ class BASE_API DictionaryValue : public Value {
   class BASE_API key_iterator
       : private std::iterator<std::input_iterator_tag, const std::string> {
    public:
-    explicit key_iterator(ValueMap::const_iterator itr) { itr_ = itr; }
+    explicit key_iterator(FlatValueMap::const_iterator itr)
+        : flat_itr_(itr), is_flat_(true) {}
+    explicit key_iterator(ValueMap::const_iterator itr)
+        : itr_(itr), is_flat_(false) {}
     key_iterator operator++() {
-      ++itr_;
+      if (is_flat_)
+        ++flat_itr_;
+      else
+        ++itr_;
       return *this;
     }
-    const std::string& operator*() { return itr_->first; }
-    bool operator!=(const key_iterator& other) { return itr_ != other.itr_; }
-    bool operator==(const key_iterator& other) { return itr_ == other.itr_; }
+    const std::string& operator*() {
+      return is_flat_ ? flat_itr_->first : itr_->first;
+    }
+    bool operator!=(const key_iterator& other) { return !(*this == other); }
+    bool operator==(const key_iterator& other) {
+      return is_flat_ ? flat_itr_ == other.flat_itr_ : itr_ == other.itr_;
+    }
 
    private:
+    FlatValueMap::const_iterator flat_itr_;
     ValueMap::const_iterator itr_;
+    bool is_flat_;
   };
 
-  key_iterator begin_keys() const { return key_iterator(dictionary_.begin()); }
-  key_iterator end_keys() const { return key_iterator(dictionary_.end()); }
+  key_iterator begin_keys() const {
+    return is_flat() ? key_iterator(flat_dictionary_.begin()) :
+                       key_iterator(dictionary_.begin());
+  }
+  key_iterator end_keys() const {
+    return is_flat() ? key_iterator(flat_dictionary_.end()) :
+                       key_iterator(dictionary_.end());
+  }
 
   // Overridden from Value:
   virtual DictionaryValue* DeepCopy() const;
   virtual bool Equals(const Value* other) const;
 
  private:
+  // The entries are in |flat_dictionary_| until there are too many of them,
+  // and then in |dictionary_| until it is emptied.
+  bool is_flat() const { return dictionary_.empty(); }
+
+  // Returns the value for |key|, or NULL.
+  Value* FindValue(const base::StringPiece& key) const;
+
+  // Like SetWithoutPathExpansion(), but only copies |key| if it is new.
+  void SetValue(const base::StringPiece& key, Value* in_value);
+
+  FlatValueMap flat_dictionary_;
   ValueMap dictionary_;
 
   DISALLOW_COPY_AND_ASSIGN(DictionaryValue);
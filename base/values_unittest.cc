@@ -6,6 +6,7 @@
 
 #include "base/memory/scoped_ptr.h"
 #include "base/string16.h"
+#include "base/stringprintf.h"
 #include "base/utf_string_conversions.h"
 #include "base/values.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -319,6 +320,61 @@ TEST_F(ValuesTest, DictionaryWithoutPathExpansion) {
   EXPECT_EQ(Value::TYPE_NULL, value4->GetType());
 }
 
+TEST_F(ValuesTest, DictionaryGrowth) {
+  // Small dictionaries are stored differently from large ones; check that
+  // growing past the switch and shrinking back keeps the same behavior.
+  DictionaryValue dict;
+  Value* first = Value::CreateIntegerValue(0);
+  dict.SetWithoutPathExpansion("key99", first);
+  for (int i = 0; i < 99; ++i) {
+    // Visits the keys below 99 out of order.
+    int key = i * 37 % 99;
+    dict.SetInteger(base::StringPrintf("key%02d", key), key);
+  }
+  EXPECT_EQ(100U, dict.size());
+
+  // Values stay where they are, and replacing a value keeps its key.
+  Value* value = NULL;
+  ASSERT_TRUE(dict.Get("key99", &value));
+  EXPECT_EQ(first, value);
+  dict.SetInteger("key99", 99);
+
+  int expected = 0;
+  for (DictionaryValue::key_iterator it = dict.begin_keys();
+       it != dict.end_keys(); ++it, ++expected) {
+    EXPECT_EQ(base::StringPrintf("key%02d", expected), *it);
+    int int_value = -1;
+    EXPECT_TRUE(dict.GetIntegerWithoutPathExpansion(*it, &int_value));
+    EXPECT_EQ(expected, int_value);
+  }
+  EXPECT_EQ(100, expected);
+
+  scoped_ptr<DictionaryValue> copy(dict.DeepCopy());
+  EXPECT_TRUE(dict.Equals(copy.get()));
+
+  for (int i = 0; i < 100; ++i) {
+    if (i != 50) {
+      EXPECT_TRUE(dict.Remove(base::StringPrintf("key%02d", i), NULL));
+    }
+  }
+  EXPECT_EQ(1U, dict.size());
+  EXPECT_FALSE(dict.HasKey("key49"));
+  EXPECT_TRUE(dict.HasKey("key50"));
+  EXPECT_TRUE(dict.Remove("key50", NULL));
+  EXPECT_TRUE(dict.empty());
+
+  dict.SetString("b.c", "c");
+  dict.SetString("a", "a");
+  dict.Set("b.d", Value::CreateNullValue());
+  std::string string_value;
+  EXPECT_TRUE(dict.GetString("b.c", &string_value));
+  EXPECT_EQ("c", string_value);
+  EXPECT_TRUE(dict.HasKey("a"));
+  EXPECT_FALSE(dict.Get("b.c.d", &value));
+  EXPECT_FALSE(dict.Get("b.", &value));
+  EXPECT_EQ(2U, dict.size());
+}
+
 TEST_F(ValuesTest, DeepCopy) {
   DictionaryValue original_dict;
   Value* original_null = Value::CreateNullValue();
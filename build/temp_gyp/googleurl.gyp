@@ -21,6 +21,8 @@
       'sources': [
         '../../googleurl/src/gurl.cc',
         '../../googleurl/src/gurl.h',
+        '../../googleurl/src/gurl_view.cc',
+        '../../googleurl/src/gurl_view.h',
         '../../googleurl/src/url_canon.h',
         '../../googleurl/src/url_canon_etc.cc',
         '../../googleurl/src/url_canon_fileurl.cc',
@@ -106,6 +108,31 @@
         }],
       ],
     },
+    {
+      'target_name': 'googleurl_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'googleurl',
+        '../../base/base.gyp:base_i18n',
+        '../../base/base.gyp:test_support_perf',
+        '../../testing/gtest.gyp:gtest',
+        '../../third_party/icu/icu.gyp:icuuc',
+      ],
+      'sources': [
+        '../../googleurl/src/gurl_perftest.cc',
+      ],
+      'conditions': [
+        ['OS=="linux" or OS=="freebsd"', {
+          'conditions': [
+            ['linux_use_tcmalloc==1', {
+              'dependencies': [
+                '../../base/allocator/allocator.gyp:allocator',
+              ],
+            }],
+          ],
+        }],
+      ],
+    },
   ],
 }
 
@@ -101,6 +101,8 @@
 #include "net/base/cookie_monster.h"
 #include "net/base/net_module.h"
 #include "net/base/network_change_notifier.h"
+#include "net/base/sdch_dictionary_disk_store.h"
+#include "net/base/sdch_manager.h"
 #include "net/http/http_network_layer.h"
 #include "net/http/http_stream_factory.h"
 #include "net/socket/client_socket_pool_base.h"
@@ -176,7 +178,6 @@
 #include "chrome/installer/util/install_util.h"
 #include "chrome/installer/util/shell_util.h"
 #include "net/base/net_util.h"
-#include "net/base/sdch_manager.h"
 #include "printing/printed_document.h"
 #include "sandbox/src/sandbox.h"
 #include "ui/base/l10n/l10n_util_win.h"
@@ -1083,6 +1084,10 @@ OSStatus KeychainCallback(SecKeychainEvent keychain_event,
 DISABLE_RUNNABLE_METHOD_REFCOUNT(StubLogin);
 #endif
 
+// The SDCH manager lives on the stack of BrowserMain(), which stops the IO
+// thread before it returns.
+DISABLE_RUNNABLE_METHOD_REFCOUNT(net::SdchManager);
+
 #if defined(OS_WIN)
 #define DLLEXPORT __declspec(dllexport)
 
@@ -1684,6 +1689,17 @@ int BrowserMain(const MainFunctionParams& parameters) {
 
   net::SdchManager sdch_manager;  // Singleton database.
   sdch_manager.set_sdch_fetcher(new SdchDictionaryFetcher);
+  // Keep dictionaries across restarts.  The store reads and writes them on the
+  // file thread, and hands those it read to the manager on the IO thread,
+  // which uses them.
+  net::SdchDictionaryStore* sdch_store = new net::SdchDictionaryDiskStore(
+      profile->GetPath().Append(chrome::kSdchDictionaryDirname),
+      BrowserThread::GetMessageLoopProxyForThread(BrowserThread::FILE));
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      NewRunnableMethod(&sdch_manager,
+                        &net::SdchManager::SetSdchDictionaryStore,
+                        sdch_store));
   sdch_manager.EnableSdchSupport(sdch_supported_domain);
 
   MetricsService* metrics = InitializeMetrics(parsed_command_line, local_state);
@@ -32,6 +32,7 @@
 #include "content/common/notification_source.h"
 #include "net/base/cookie_monster.h"
 #include "net/base/net_errors.h"
+#include "net/base/sdch_manager.h"
 #include "net/base/transport_security_state.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/http/http_cache.h"
@@ -371,6 +372,11 @@ void BrowsingDataRemover::ClearCacheOnIOThread() {
   DCHECK(main_context_getter_);
   DCHECK(media_context_getter_);
 
+  // SDCH dictionaries are cached responses too.  They don't record when they
+  // were fetched, so all of them go, whatever the time period.
+  if (net::SdchManager::Global())
+    net::SdchManager::Global()->ClearData();
+
   next_cache_state_ = STATE_CREATE_MAIN;
   DoClearCache(net::OK);
 }
@@ -5,6 +5,7 @@
 #include "chrome/browser/net/sqlite_persistent_cookie_store.h"
 
 #include <list>
+#include <map>
 
 #include "app/sql/meta_table.h"
 #include "app/sql/statement.h"
@@ -50,6 +51,8 @@ using base::Time;
 
 // This class is designed to be shared between any calling threads and the
 // database thread.  It batches operations and commits them on a timer.
+// Operations on the same cookie within one batch are coalesced, so e.g. a
+// stream of access time updates costs a single UPDATE per commit.
 class SQLitePersistentCookieStore::Backend
     : public base::RefCountedThreadSafe<SQLitePersistentCookieStore::Backend> {
  public:
@@ -96,7 +99,7 @@ class SQLitePersistentCookieStore::Backend
   // You should call Close() before destructing this object.
   ~Backend() {
     DCHECK(!db_.get()) << "Close should have already been called.";
-    DCHECK(num_pending_ == 0 && pending_.empty());
+    DCHECK(num_pending_ == 0 && pending_.empty() && pending_cookies_.empty());
   }
 
   // Database upgrade statements.
@@ -117,6 +120,12 @@ class SQLitePersistentCookieStore::Backend
     OperationType op() const { return op_; }
     const net::CookieMonster::CanonicalCookie& cc() const { return cc_; }
 
+    // Folds a later access time update for the same cookie into this
+    // operation.
+    void SetLastAccessDate(const base::Time& last_access) {
+      cc_.SetLastAccessDate(last_access);
+    }
+
    private:
     OperationType op_;
     net::CookieMonster::CanonicalCookie cc_;
@@ -126,6 +135,11 @@ class SQLitePersistentCookieStore::Backend
   // Batch a cookie operation (add or delete)
   void BatchOperation(PendingOperation::OperationType op,
                       const net::CookieMonster::CanonicalCookie& cc);
+  // Tries to merge |op| on |cc| with the pending operation for the same
+  // cookie, if any.  Returns true if nothing more needs to be queued.
+  // Must be called with |lock_| held.
+  bool CoalesceOperation(PendingOperation::OperationType op,
+                         const net::CookieMonster::CanonicalCookie& cc);
   // Commit our pending operations to the database.
 #if defined(ANDROID)
   void Commit(Task* completion_task);
@@ -142,9 +156,14 @@ class SQLitePersistentCookieStore::Backend
   typedef std::list<PendingOperation*> PendingOperationsList;
   PendingOperationsList pending_;
   PendingOperationsList::size_type num_pending_;
+  // Maps the creation time of a cookie (the primary key of the cookies table)
+  // to the latest operation on it in |pending_|.
+  typedef std::map<int64, PendingOperationsList::iterator> PendingCookieMap;
+  PendingCookieMap pending_cookies_;
   // True if the persistent store should be deleted upon destruction.
   bool clear_local_state_on_exit_;
-  // Guard |pending_|, |num_pending_| and |clear_local_state_on_exit_|.
+  // Guard |pending_|, |num_pending_|, |pending_cookies_| and
+  // |clear_local_state_on_exit_|.
   base::Lock lock_;
 
 #if defined(ANDROID)
@@ -382,13 +401,15 @@ void SQLitePersistentCookieStore::Backend::BatchOperation(
   DCHECK(!BrowserThread::CurrentlyOn(BrowserThread::DB));
 #endif
 
-  // We do a full copy of the cookie here, and hopefully just here.
-  scoped_ptr<PendingOperation> po(new PendingOperation(op, cc));
-
   PendingOperationsList::size_type num_pending;
   {
     base::AutoLock locked(lock_);
-    pending_.push_back(po.release());
+    if (CoalesceOperation(op, cc))
+      return;
+
+    // We do a full copy of the cookie here, and hopefully just here.
+    pending_.push_back(new PendingOperation(op, cc));
+    pending_cookies_[cc.CreationDate().ToInternalValue()] = --pending_.end();
     num_pending = ++num_pending_;
   }
 
@@ -419,6 +440,46 @@ void SQLitePersistentCookieStore::Backend::BatchOperation(
   }
 }
 
+bool SQLitePersistentCookieStore::Backend::CoalesceOperation(
+    PendingOperation::OperationType op,
+    const net::CookieMonster::CanonicalCookie& cc) {
+  lock_.AssertAcquired();
+
+  PendingCookieMap::iterator found =
+      pending_cookies_.find(cc.CreationDate().ToInternalValue());
+  if (found == pending_cookies_.end())
+    return false;
+
+  PendingOperationsList::iterator last_it = found->second;
+  PendingOperation* last = *last_it;
+  switch (op) {
+    case PendingOperation::COOKIE_UPDATEACCESS:
+      // A pending add or access update will write the newer access time.
+      if (last->op() == PendingOperation::COOKIE_DELETE)
+        return false;
+      last->SetLastAccessDate(cc.LastAccessDate());
+      return true;
+
+    case PendingOperation::COOKIE_DELETE: {
+      if (last->op() == PendingOperation::COOKIE_DELETE)
+        return false;
+      // An add or access update that is about to be deleted never needs to
+      // reach the database, and deleting a cookie that was only added in this
+      // batch is a no-op.  Any operation queued before it for the same cookie
+      // (e.g. an earlier delete) is left untouched.
+      const bool was_add = last->op() == PendingOperation::COOKIE_ADD;
+      pending_.erase(last_it);
+      pending_cookies_.erase(found);
+      --num_pending_;
+      delete last;
+      return was_add;
+    }
+
+    default:
+      return false;
+  }
+}
+
 #if defined(ANDROID)
 void SQLitePersistentCookieStore::Backend::Commit(Task* completion_task) {
 #else
@@ -437,6 +498,7 @@ void SQLitePersistentCookieStore::Backend::Commit() {
   {
     base::AutoLock locked(lock_);
     pending_.swap(ops);
+    pending_cookies_.clear();
     num_pending_ = 0;
   }
 
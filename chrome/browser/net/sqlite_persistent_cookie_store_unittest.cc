@@ -177,3 +177,44 @@ TEST_F(SQLitePersistentCookieStoreTest, TestFlushCompletionCallback) {
 
   ASSERT_EQ(1, counter->callback_count());
 }
+
+// Test that operations on the same cookie within one batch are coalesced
+// without changing what ends up in the database.
+TEST_F(SQLitePersistentCookieStoreTest, TestCoalescedOperations) {
+  base::Time t = base::Time::Now() + base::TimeDelta::FromMicroseconds(10);
+  base::Time later_access = t + base::TimeDelta::FromMinutes(10);
+
+  // A cookie added and then deleted in the same batch never hits the DB.
+  net::CookieMonster::CanonicalCookie transient(GURL(), "C", "D",
+                                                "http://foo.bar", "/", t, t, t,
+                                                false, false, true);
+  store_->AddCookie(transient);
+  store_->UpdateCookieAccessTime(transient);
+  store_->DeleteCookie(transient);
+
+  // Access time updates are folded into the pending add.
+  t += base::TimeDelta::FromMicroseconds(10);
+  net::CookieMonster::CanonicalCookie kept(GURL(), "E", "F", "http://foo.bar",
+                                           "/", t, t, t, false, false, true);
+  store_->AddCookie(kept);
+  kept.SetLastAccessDate(later_access);
+  store_->UpdateCookieAccessTime(kept);
+
+  store_ = NULL;
+  scoped_refptr<ThreadTestHelper> helper(
+      new ThreadTestHelper(BrowserThread::DB));
+  // Make sure we wait until the destructor has run.
+  ASSERT_TRUE(helper->Run());
+  store_ = new SQLitePersistentCookieStore(
+      temp_dir_.path().Append(chrome::kCookieFilename));
+
+  std::vector<net::CookieMonster::CanonicalCookie*> cookies;
+  ASSERT_TRUE(store_->Load(&cookies));
+  ASSERT_EQ(2U, cookies.size());
+  for (size_t i = 0; i < cookies.size(); ++i) {
+    ASSERT_NE("C", cookies[i]->Name());
+    if (cookies[i]->Name() == "E")
+      EXPECT_EQ(later_access, cookies[i]->LastAccessDate());
+  }
+  STLDeleteContainerPointers(cookies.begin(), cookies.end());
+}
@@ -53,6 +53,7 @@ extern const FilePath::CharType kLocalStateFilename[];
 extern const FilePath::CharType kPreferencesFilename[];
 extern const FilePath::CharType kSafeBrowsingBaseFilename[];
 extern const FilePath::CharType kSafeBrowsingPhishingModelFilename[];
+extern const FilePath::CharType kSdchDictionaryDirname[];
 extern const FilePath::CharType kSingletonCookieFilename[];
 extern const FilePath::CharType kSingletonSocketFilename[];
 extern const FilePath::CharType kSingletonLockFilename[];
@@ -5,13 +5,17 @@
 #include "chrome/common/important_file_writer.h"
 
 #include <stdio.h>
+#include <string.h>
 
+#include <algorithm>
 #include <string>
 
 #include "base/file_path.h"
 #include "base/file_util.h"
 #include "base/logging.h"
+#include "base/md5.h"
 #include "base/message_loop_proxy.h"
+#include "base/platform_file.h"
 #include "base/string_number_conversions.h"
 #include "base/task.h"
 #include "base/threading/thread.h"
@@ -23,11 +27,79 @@ namespace {
 
 const int kDefaultCommitIntervalMs = 10000;
 
-class WriteToDiskTask : public Task {
+// The journal is not compacted before it reaches this size, however small the
+// file is.
+const int64 kMinJournalSizeToCompact = 16 * 1024;
+
+// Each journal record is a header followed by the record. The header is the
+// length of the record, the start of its MD5 digest and the generation of the
+// file it was appended after, in host byte order.
+const size_t kJournalHeaderSize = 3 * sizeof(uint32);
+
+// Larger lengths are taken to be garbage.
+const uint32 kMaxJournalRecordSize = 64 * 1024 * 1024;
+
+uint32 JournalChecksum(const char* data, size_t length) {
+  MD5Digest digest;
+  MD5Sum(data, length, &digest);
+  uint32 checksum;
+  memcpy(&checksum, digest.a, sizeof(checksum));
+  return checksum;
+}
+
+// Returns the generation of the file at |path|: the checksum of its contents,
+// or of no contents if it can't be read.
+uint32 FileGeneration(const FilePath& path) {
+  std::string data;
+  file_util::ReadFileToString(path, &data);
+  return JournalChecksum(data.data(), data.length());
+}
+
+}  // namespace
+
+// The generation of the file that the journal records appended next apply
+// to. Only used on the file thread, where it is read from the file the first
+// time it is needed and updated by every successful write of the whole file.
+class ImportantFileWriter::JournalGeneration
+    : public base::RefCountedThreadSafe<JournalGeneration> {
  public:
-  WriteToDiskTask(const FilePath& path, const std::string& data)
+  explicit JournalGeneration(const FilePath& path)
       : path_(path),
-        data_(data) {
+        known_(false),
+        generation_(0) {
+  }
+
+  uint32 Get() {
+    if (!known_)
+      Set(FileGeneration(path_));
+    return generation_;
+  }
+
+  void Set(uint32 generation) {
+    known_ = true;
+    generation_ = generation;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<JournalGeneration>;
+
+  ~JournalGeneration() {}
+
+  const FilePath path_;
+  bool known_;
+  uint32 generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(JournalGeneration);
+};
+
+class ImportantFileWriter::WriteToDiskTask : public Task {
+ public:
+  WriteToDiskTask(const FilePath& path,
+                  const std::string& data,
+                  JournalGeneration* generation)
+      : path_(path),
+        data_(data),
+        generation_(generation) {
   }
 
   virtual void Run() {
@@ -61,6 +133,14 @@ class WriteToDiskTask : public Task {
       file_util::Delete(tmp_file_path, false);
       return;
     }
+
+    // The journal records are all in the new file. Should a crash or an error
+    // keep the journal from being deleted, its records are now stamped with
+    // an older generation than the file, and won't be read again.
+    generation_->Set(JournalChecksum(data_.data(), data_.length()));
+    FilePath journal_path = ImportantFileWriter::GetJournalPath(path_);
+    if (!file_util::Delete(journal_path, false))
+      LogFailure("could not delete " + journal_path.value());
   }
 
  private:
@@ -71,11 +151,62 @@ class WriteToDiskTask : public Task {
 
   const FilePath path_;
   const std::string data_;
+  scoped_refptr<JournalGeneration> generation_;
 
   DISALLOW_COPY_AND_ASSIGN(WriteToDiskTask);
 };
 
-}  // namespace
+class ImportantFileWriter::AppendToJournalTask : public Task {
+ public:
+  AppendToJournalTask(const FilePath& path,
+                      const std::string& record,
+                      JournalGeneration* generation)
+      : path_(path),
+        record_(record),
+        generation_(generation) {
+  }
+
+  virtual void Run() {
+    // Write the header and the record at once, to leave a torn record
+    // behind only if the write itself fails half way.
+    uint32 header[3] = {
+      static_cast<uint32>(record_.length()),
+      JournalChecksum(record_.data(), record_.length()),
+      generation_->Get()
+    };
+    std::string data;
+    data.reserve(kJournalHeaderSize + record_.length());
+    data.assign(reinterpret_cast<const char*>(header), kJournalHeaderSize);
+    data.append(record_);
+
+    FilePath journal_path = ImportantFileWriter::GetJournalPath(path_);
+    base::PlatformFile file = base::CreatePlatformFile(
+        journal_path,
+        base::PLATFORM_FILE_OPEN_ALWAYS | base::PLATFORM_FILE_WRITE,
+        NULL, NULL);
+    if (file == base::kInvalidPlatformFileValue) {
+      PLOG(WARNING) << "failed to open " << journal_path.value();
+      return;
+    }
+    // The record is committed once it is on the disk, as a rename is for a
+    // write of the whole file, so wait for it to get there.
+    base::PlatformFileInfo info;
+    bool appended = base::GetPlatformFileInfo(file, &info) &&
+        base::WritePlatformFile(file, info.size, data.data(),
+                                data.length()) ==
+            static_cast<int>(data.length()) &&
+        base::FlushPlatformFile(file);
+    if (!base::ClosePlatformFile(file) || !appended)
+      PLOG(WARNING) << "failed to append to " << journal_path.value();
+  }
+
+ private:
+  const FilePath path_;
+  const std::string record_;
+  scoped_refptr<JournalGeneration> generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(AppendToJournalTask);
+};
 
 ImportantFileWriter::ImportantFileWriter(
     const FilePath& path, base::MessageLoopProxy* file_message_loop_proxy)
@@ -83,7 +214,10 @@ ImportantFileWriter::ImportantFileWriter(
           file_message_loop_proxy_(file_message_loop_proxy),
           serializer_(NULL),
           commit_interval_(TimeDelta::FromMilliseconds(
-              kDefaultCommitIntervalMs)) {
+              kDefaultCommitIntervalMs)),
+          generation_(new JournalGeneration(path)),
+          write_size_(0),
+          journal_size_(0) {
   DCHECK(CalledOnValidThread());
   DCHECK(file_message_loop_proxy_.get());
 }
@@ -105,15 +239,17 @@ void ImportantFileWriter::WriteNow(const std::string& data) {
 
   if (HasPendingWrite())
     timer_.Stop();
+  write_size_ = data.length();
+  journal_size_ = 0;
 
   if (!file_message_loop_proxy_->PostTask(
-      FROM_HERE, new WriteToDiskTask(path_, data))) {
+      FROM_HERE, new WriteToDiskTask(path_, data, generation_))) {
     // Posting the task to background message loop is not expected
     // to fail, but if it does, avoid losing data and just hit the disk
     // on the current thread.
     NOTREACHED();
 
-    WriteToDiskTask write_task(path_, data);
+    WriteToDiskTask write_task(path_, data, generation_);
     write_task.Run();
   }
 }
@@ -147,3 +283,72 @@ void ImportantFileWriter::DoScheduledWrite() {
   }
   serializer_ = NULL;
 }
+
+void ImportantFileWriter::AppendToJournal(const std::string& record,
+                                          DataSerializer* serializer) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_LE(record.length(), kMaxJournalRecordSize);
+
+  if (!file_message_loop_proxy_->PostTask(
+      FROM_HERE, new AppendToJournalTask(path_, record, generation_))) {
+    // See WriteNow().
+    NOTREACHED();
+
+    AppendToJournalTask append_task(path_, record, generation_);
+    append_task.Run();
+  }
+
+  journal_size_ += kJournalHeaderSize + record.length();
+  if (serializer &&
+      journal_size_ > std::max(write_size_, kMinJournalSizeToCompact)) {
+    ScheduleWrite(serializer);
+  }
+}
+
+// static
+FilePath ImportantFileWriter::GetJournalPath(const FilePath& path) {
+  return FilePath(path.value() + FILE_PATH_LITERAL(".journal"));
+}
+
+// static
+bool ImportantFileWriter::ReadJournal(const FilePath& path,
+                                      std::vector<std::string>* records) {
+  FilePath journal_path = GetJournalPath(path);
+  std::string journal;
+  if (!file_util::ReadFileToString(journal_path, &journal))
+    return !file_util::PathExists(journal_path);
+
+  uint32 generation = FileGeneration(path);
+  size_t offset = 0;
+  while (journal.length() - offset >= kJournalHeaderSize) {
+    uint32 header[3];
+    memcpy(header, journal.data() + offset, kJournalHeaderSize);
+    size_t length = header[0];
+    if (length > kMaxJournalRecordSize ||
+        length > journal.length() - offset - kJournalHeaderSize) {
+      break;
+    }
+    const char* record = journal.data() + offset + kJournalHeaderSize;
+    if (JournalChecksum(record, length) != header[1])
+      break;
+    // Records appended before the file was last written are in it already.
+    if (header[2] == generation)
+      records->push_back(std::string(record, length));
+    offset += kJournalHeaderSize + length;
+  }
+
+  if (offset < journal.length()) {
+    LOG(WARNING) << "dropping " << journal.length() - offset
+                 << " bytes from the end of " << journal_path.value();
+    FILE* file = file_util::OpenFile(journal_path, "r+b");
+    bool truncated = file && fseek(file, offset, SEEK_SET) == 0 &&
+                     file_util::TruncateFile(file);
+    if (file)
+      file_util::CloseFile(file);
+    if (!truncated) {
+      PLOG(WARNING) << "failed to truncate " << journal_path.value();
+      return false;
+    }
+  }
+  return true;
+}
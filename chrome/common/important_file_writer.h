@@ -7,6 +7,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/file_path.h"
@@ -36,6 +37,17 @@ class Thread;
 //
 // If you want to know more about this approach and ext3/ext4 fsync issues, see
 // http://valhenson.livejournal.com/37921.html
+//
+// Small changes to a large file can instead be appended to a journal next to
+// it with AppendToJournal(), and only folded into the file by an occasional
+// write of the whole file. Each journal record is framed with its length and
+// a checksum, so that a record torn by a crash is detected, and dropped, by
+// ReadJournal(). Every write of the whole file deletes the journal once the
+// new file is in place. Each record is also stamped with the generation of the
+// file it was appended after, which is the checksum of the file's contents, so
+// that records left behind by a crash or an error between the two are known to
+// be in the file already, and skipped. Each record is flushed to the disk as
+// it is appended.
 class ImportantFileWriter : public base::NonThreadSafe {
  public:
   // Used by ScheduleSave to lazily provide the data to be saved. Allows us
@@ -83,6 +95,27 @@ class ImportantFileWriter : public base::NonThreadSafe {
   // Serialize data pending to be saved and execute write on backend thread.
   void DoScheduledWrite();
 
+  // Appends |record| to the journal. Does not block. Once the journal has
+  // grown larger than the file was when last written, a write of the whole
+  // file with |serializer| is scheduled as by ScheduleWrite(), unless
+  // |serializer| is NULL. Call ReadJournal() before the first append, so that
+  // a record torn by an earlier crash is cut off first.
+  void AppendToJournal(const std::string& record, DataSerializer* serializer);
+
+  // Returns the bytes appended to the journal since the file was last written.
+  int64 journal_size() const { return journal_size_; }
+
+  // Returns the path of the journal kept for |path|.
+  static FilePath GetJournalPath(const FilePath& path);
+
+  // Reads the records of the journal of |path| that apply to the file now at
+  // |path| into |records|, oldest first. A torn or corrupt record, and
+  // everything after it, is dropped and cut from the journal. Returns false if
+  // the journal exists but could not be read. Does blocking I/O, so call it
+  // where reading |path| is done.
+  static bool ReadJournal(const FilePath& path,
+                          std::vector<std::string>* records);
+
   base::TimeDelta commit_interval() const {
     return commit_interval_;
   }
@@ -92,6 +125,10 @@ class ImportantFileWriter : public base::NonThreadSafe {
   }
 
  private:
+  class AppendToJournalTask;
+  class JournalGeneration;
+  class WriteToDiskTask;
+
   // Path being written to.
   const FilePath path_;
 
@@ -107,6 +144,14 @@ class ImportantFileWriter : public base::NonThreadSafe {
   // Time delta after which scheduled data will be written to disk.
   base::TimeDelta commit_interval_;
 
+  // Generation of the file, shared with the tasks run on the file thread.
+  scoped_refptr<JournalGeneration> generation_;
+
+  // Size of the data last written by WriteNow(), and of the records appended
+  // to the journal since.
+  int64 write_size_;
+  int64 journal_size_;
+
   DISALLOW_COPY_AND_ASSIGN(ImportantFileWriter);
 };
 
@@ -113,3 +113,120 @@ TEST_F(ImportantFileWriterTest, BatchingWrites) {
   ASSERT_TRUE(file_util::PathExists(writer.path()));
   EXPECT_EQ("baz", GetFileContent(writer.path()));
 }
+
+TEST_F(ImportantFileWriterTest, Journal) {
+  ImportantFileWriter writer(file_,
+                             base::MessageLoopProxy::CreateForCurrentThread());
+  DataSerializer serializer("foo");
+  writer.AppendToJournal("a", &serializer);
+  writer.AppendToJournal("", &serializer);
+  writer.AppendToJournal("bc", &serializer);
+  EXPECT_FALSE(writer.HasPendingWrite());
+  loop_.RunAllPending();
+
+  std::vector<std::string> records;
+  ASSERT_TRUE(ImportantFileWriter::ReadJournal(file_, &records));
+  ASSERT_EQ(3U, records.size());
+  EXPECT_EQ("a", records[0]);
+  EXPECT_EQ("", records[1]);
+  EXPECT_EQ("bc", records[2]);
+
+  // Writing the whole file deletes the journal, and later records start a new
+  // one.
+  writer.WriteNow("abc");
+  writer.AppendToJournal("d", &serializer);
+  loop_.RunAllPending();
+  EXPECT_EQ("abc", GetFileContent(file_));
+  records.clear();
+  ASSERT_TRUE(ImportantFileWriter::ReadJournal(file_, &records));
+  ASSERT_EQ(1U, records.size());
+  EXPECT_EQ("d", records[0]);
+}
+
+TEST_F(ImportantFileWriterTest, NoJournal) {
+  std::vector<std::string> records;
+  EXPECT_TRUE(ImportantFileWriter::ReadJournal(file_, &records));
+  EXPECT_TRUE(records.empty());
+}
+
+// A record torn by a crash is dropped, and cut from the journal so that later
+// records can be read.
+TEST_F(ImportantFileWriterTest, TornJournal) {
+  ImportantFileWriter writer(file_,
+                             base::MessageLoopProxy::CreateForCurrentThread());
+  DataSerializer serializer("foo");
+  writer.AppendToJournal("first", &serializer);
+  writer.AppendToJournal("second", &serializer);
+  loop_.RunAllPending();
+
+  FilePath journal = ImportantFileWriter::GetJournalPath(file_);
+  std::string content = GetFileContent(journal);
+  content.resize(content.length() - 1);
+  ASSERT_EQ(static_cast<int>(content.length()),
+            file_util::WriteFile(journal, content.data(), content.length()));
+
+  std::vector<std::string> records;
+  ASSERT_TRUE(ImportantFileWriter::ReadJournal(file_, &records));
+  ASSERT_EQ(1U, records.size());
+  EXPECT_EQ("first", records[0]);
+
+  writer.AppendToJournal("third", &serializer);
+  loop_.RunAllPending();
+  records.clear();
+  ASSERT_TRUE(ImportantFileWriter::ReadJournal(file_, &records));
+  ASSERT_EQ(2U, records.size());
+  EXPECT_EQ("first", records[0]);
+  EXPECT_EQ("third", records[1]);
+}
+
+// Records left behind when the journal could not be deleted after a write of
+// the whole file are in the file already, so they are skipped, but later ones
+// are not.
+TEST_F(ImportantFileWriterTest, StaleJournal) {
+  ImportantFileWriter writer(file_,
+                             base::MessageLoopProxy::CreateForCurrentThread());
+  DataSerializer serializer("foo");
+  writer.AppendToJournal("old", &serializer);
+  loop_.RunAllPending();
+  FilePath journal = ImportantFileWriter::GetJournalPath(file_);
+  std::string stale = GetFileContent(journal);
+
+  writer.WriteNow("new");
+  loop_.RunAllPending();
+  ASSERT_EQ(static_cast<int>(stale.length()),
+            file_util::WriteFile(journal, stale.data(), stale.length()));
+  writer.AppendToJournal("later", &serializer);
+  loop_.RunAllPending();
+
+  std::vector<std::string> records;
+  ASSERT_TRUE(ImportantFileWriter::ReadJournal(file_, &records));
+  ASSERT_EQ(1U, records.size());
+  EXPECT_EQ("later", records[0]);
+
+  // None of them apply to a file replaced behind the writer's back.
+  ASSERT_EQ(3, file_util::WriteFile(file_, "bar", 3));
+  records.clear();
+  ASSERT_TRUE(ImportantFileWriter::ReadJournal(file_, &records));
+  EXPECT_TRUE(records.empty());
+}
+
+// The journal is folded into the file once it is larger than the file.
+TEST_F(ImportantFileWriterTest, CompactJournal) {
+  ImportantFileWriter writer(file_,
+                             base::MessageLoopProxy::CreateForCurrentThread());
+  writer.set_commit_interval(base::TimeDelta::FromMilliseconds(25));
+  const std::string record(1024, 'x');
+  DataSerializer serializer("compacted");
+  while (!writer.HasPendingWrite()) {
+    writer.AppendToJournal(record, &serializer);
+    ASSERT_LE(writer.journal_size(), 64 * 1024);
+  }
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+                                          new MessageLoop::QuitTask(), 100);
+  MessageLoop::current()->Run();
+  EXPECT_FALSE(writer.HasPendingWrite());
+  EXPECT_EQ(0, writer.journal_size());
+  EXPECT_EQ("compacted", GetFileContent(file_));
+  EXPECT_FALSE(file_util::PathExists(
+      ImportantFileWriter::GetJournalPath(file_)));
+}
@@ -5,10 +5,13 @@
 #include "chrome/common/json_pref_store.h"
 
 #include <algorithm>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
 #include "base/memory/ref_counted.h"
 #include "base/values.h"
 #include "content/browser/browser_thread.h"
@@ -19,6 +22,11 @@ namespace {
 // Some extensions we'll tack on to copies of the Preferences files.
 const FilePath::CharType* kBadExtension = FILE_PATH_LITERAL("bad");
 
+// Keys of the journal records. A record holds the values set under "set",
+// and the list of the keys removed under "remove".
+const char kJournalSetKey[] = "set";
+const char kJournalRemoveKey[] = "remove";
+
 // Differentiates file loading between UI and FILE threads.
 class FileThreadDeserializer
     : public base::RefCountedThreadSafe<FileThreadDeserializer> {
@@ -47,6 +55,7 @@ class FileThreadDeserializer
     value_.reset(serializer.Deserialize(&error_code, &error_msg));
 
     HandleErrors(value_.get(), path, error_code, error_msg, &error_);
+    journal_replayed_ = ReplayJournal(path, &value_, &error_);
 
     no_dir_ = !file_util::PathExists(path.DirName());
 
@@ -59,7 +68,8 @@ class FileThreadDeserializer
   // Reports deserialization result on the UI thread.
   void ReportOnUIThread() {
     DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
-    delegate_->OnFileRead(value_.release(), error_, no_dir_);
+    delegate_->OnFileRead(value_.release(), error_, no_dir_,
+                          journal_replayed_);
   }
 
   static void HandleErrors(const Value* value,
@@ -68,10 +78,17 @@ class FileThreadDeserializer
                            const std::string& error_msg,
                            PersistentPrefStore::PrefReadError* error);
 
+  // Applies the changes in the journal of |path| to |value|, which is read
+  // from |path| with |error|. Returns true if there were any.
+  static bool ReplayJournal(const FilePath& path,
+                            scoped_ptr<Value>* value,
+                            PersistentPrefStore::PrefReadError* error);
+
  private:
   friend class base::RefCountedThreadSafe<FileThreadDeserializer>;
 
   bool no_dir_;
+  bool journal_replayed_;
   PersistentPrefStore::PrefReadError error_;
   scoped_ptr<Value> value_;
   scoped_refptr<JsonPrefStore> delegate_;
@@ -123,6 +140,56 @@ void FileThreadDeserializer::HandleErrors(
   }
 }
 
+// static
+bool FileThreadDeserializer::ReplayJournal(
+    const FilePath& path,
+    scoped_ptr<Value>* value,
+    PersistentPrefStore::PrefReadError* error) {
+  if (*error != PersistentPrefStore::PREF_READ_ERROR_NONE &&
+      *error != PersistentPrefStore::PREF_READ_ERROR_NO_FILE) {
+    return false;
+  }
+  // Also cuts off a record torn by a crash, before any new one is appended.
+  std::vector<std::string> records;
+  ImportantFileWriter::ReadJournal(path, &records);
+  if (records.empty())
+    return false;
+
+  // The journal outlives the file when it was never written in full.
+  if (*error == PersistentPrefStore::PREF_READ_ERROR_NO_FILE) {
+    value->reset(new DictionaryValue);
+    *error = PersistentPrefStore::PREF_READ_ERROR_NONE;
+  }
+  DictionaryValue* prefs = static_cast<DictionaryValue*>(value->get());
+  for (size_t i = 0; i < records.size(); ++i) {
+    scoped_ptr<Value> record(base::JSONReader::Read(records[i], false));
+    if (!record.get() || !record->IsType(Value::TYPE_DICTIONARY)) {
+      LOG(WARNING) << "Skipping bad record in the journal of "
+                   << path.value();
+      continue;
+    }
+    DictionaryValue* changes = static_cast<DictionaryValue*>(record.get());
+    DictionaryValue* set = NULL;
+    if (changes->GetDictionary(kJournalSetKey, &set)) {
+      for (DictionaryValue::key_iterator it = set->begin_keys();
+           it != set->end_keys(); ++it) {
+        Value* set_value = NULL;
+        if (set->GetWithoutPathExpansion(*it, &set_value))
+          prefs->Set(*it, set_value->DeepCopy());
+      }
+    }
+    ListValue* removed = NULL;
+    if (changes->GetList(kJournalRemoveKey, &removed)) {
+      for (size_t j = 0; j < removed->GetSize(); ++j) {
+        std::string key;
+        if (removed->GetString(j, &key))
+          prefs->Remove(key, NULL);
+      }
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 JsonPrefStore::JsonPrefStore(const FilePath& filename,
@@ -130,7 +197,8 @@ JsonPrefStore::JsonPrefStore(const FilePath& filename,
     : path_(filename),
       prefs_(new DictionaryValue()),
       read_only_(false),
-      writer_(filename, file_message_loop_proxy) {
+      writer_(filename, file_message_loop_proxy),
+      journal_enabled_(false) {
 }
 
 JsonPrefStore::~JsonPrefStore() {
@@ -167,6 +235,7 @@ void JsonPrefStore::SetValue(const std::string& key, Value* value) {
   prefs_->Get(key, &old_value);
   if (!old_value || !value->Equals(old_value)) {
     prefs_->Set(key, new_value.release());
+    KeyChanged(key);
     FOR_EACH_OBSERVER(PrefStore::Observer, observers_, OnPrefValueChanged(key));
   }
 }
@@ -176,12 +245,15 @@ void JsonPrefStore::SetValueSilently(const std::string& key, Value* value) {
   scoped_ptr<Value> new_value(value);
   Value* old_value = NULL;
   prefs_->Get(key, &old_value);
-  if (!old_value || !value->Equals(old_value))
+  if (!old_value || !value->Equals(old_value)) {
     prefs_->Set(key, new_value.release());
+    KeyChanged(key);
+  }
 }
 
 void JsonPrefStore::RemoveValue(const std::string& key) {
   if (prefs_->Remove(key, NULL)) {
+    KeyChanged(key);
     FOR_EACH_OBSERVER(PrefStore::Observer, observers_, OnPrefValueChanged(key));
   }
 }
@@ -192,7 +264,8 @@ bool JsonPrefStore::ReadOnly() const {
 
 void JsonPrefStore::OnFileRead(Value* value_owned,
                                PersistentPrefStore::PrefReadError error,
-                               bool no_dir) {
+                               bool no_dir,
+                               bool journal_replayed) {
   scoped_ptr<Value> value(value_owned);
   switch (error) {
     case PREF_READ_ERROR_ACCESS_DENIED:
@@ -216,6 +289,10 @@ void JsonPrefStore::OnFileRead(Value* value_owned,
       NOTREACHED() << "Unknown error: " << error;
   }
 
+  // Fold the journal into the file.
+  if (journal_replayed && !read_only_)
+    writer_.ScheduleWrite(this);
+
   if (delegate_)
     delegate_->OnPrefsRead(error, no_dir);
 }
@@ -260,8 +337,10 @@ PersistentPrefStore::PrefReadError JsonPrefStore::ReadPrefs() {
                                        error_code,
                                        error_msg,
                                        &error);
+  bool journal_replayed =
+      FileThreadDeserializer::ReplayJournal(path_, &value, &error);
 
-  OnFileRead(value.release(), error, false);
+  OnFileRead(value.release(), error, false, journal_replayed);
 
   return error;
 }
@@ -283,15 +362,26 @@ void JsonPrefStore::ScheduleWritePrefs() {
   if (read_only_)
     return;
 
+  if (journal_enabled_) {
+    if (!changed_keys_.empty())
+      AppendChangesToJournal(true);
+    return;
+  }
   writer_.ScheduleWrite(this);
 }
 
 void JsonPrefStore::CommitPendingWrite() {
-  if (writer_.HasPendingWrite() && !read_only_)
+  if (read_only_)
+    return;
+
+  if (!changed_keys_.empty())
+    AppendChangesToJournal(true);
+  if (writer_.HasPendingWrite())
     writer_.DoScheduledWrite();
 }
 
 void JsonPrefStore::ReportValueChanged(const std::string& key) {
+  KeyChanged(key);
   FOR_EACH_OBSERVER(PrefStore::Observer, observers_, OnPrefValueChanged(key));
 }
 
@@ -301,5 +391,36 @@ bool JsonPrefStore::SerializeData(std::string* output) {
   JSONStringValueSerializer serializer(output);
   serializer.set_pretty_print(true);
   scoped_ptr<DictionaryValue> copy(prefs_->DeepCopyWithoutEmptyChildren());
+  // Journal the changes that aren't yet, so that should the file not be
+  // written, the journal still holds everything that would have been in it.
+  if (!changed_keys_.empty())
+    AppendChangesToJournal(false);
   return serializer.Serialize(*(copy.get()));
 }
+
+void JsonPrefStore::KeyChanged(const std::string& key) {
+  if (journal_enabled_ && !read_only_)
+    changed_keys_.insert(key);
+}
+
+void JsonPrefStore::AppendChangesToJournal(bool compact) {
+  DCHECK(journal_enabled_);
+  DictionaryValue* set = new DictionaryValue;
+  ListValue* removed = new ListValue;
+  for (std::set<std::string>::const_iterator it = changed_keys_.begin();
+       it != changed_keys_.end(); ++it) {
+    Value* value = NULL;
+    if (prefs_->Get(*it, &value))
+      set->SetWithoutPathExpansion(*it, value->DeepCopy());
+    else
+      removed->Append(Value::CreateStringValue(*it));
+  }
+  changed_keys_.clear();
+
+  DictionaryValue changes;
+  changes.Set(kJournalSetKey, set);
+  changes.Set(kJournalRemoveKey, removed);
+  std::string record;
+  base::JSONWriter::Write(&changes, false, &record);
+  writer_.AppendToJournal(record, compact ? this : NULL);
+}
@@ -6,6 +6,7 @@
 #define CHROME_COMMON_JSON_PREF_STORE_H_
 #pragma once
 
+#include <set>
 #include <string>
 
 #include "base/basictypes.h"
@@ -61,14 +62,31 @@ class JsonPrefStore : public PersistentPrefStore,
   virtual void CommitPendingWrite();
   virtual void ReportValueChanged(const std::string& key);
 
+  // Makes ScheduleWritePrefs() append the prefs changed since its last call to
+  // a journal next to the file, instead of rewriting the whole file. The file
+  // is rewritten only once the journal has grown larger than it. Call before
+  // ReadPrefs().
+  void set_journal_enabled(bool enabled) { journal_enabled_ = enabled; }
+
   // This method is called after JSON file has been read. Method takes
-  // ownership of the |value| pointer.
-  void OnFileRead(Value* value_owned, PrefReadError error, bool no_dir);
+  // ownership of the |value| pointer. |journal_replayed| is true when changes
+  // from the journal were applied to it.
+  void OnFileRead(Value* value_owned,
+                  PrefReadError error,
+                  bool no_dir,
+                  bool journal_replayed);
 
  private:
   // ImportantFileWriter::DataSerializer overrides:
   virtual bool SerializeData(std::string* output);
 
+  // Remembers that |key| changed, to journal it.
+  void KeyChanged(const std::string& key);
+
+  // Appends the values of |changed_keys_| to the journal, and schedules a
+  // write of the whole file if |compact| and the journal has grown enough.
+  void AppendChangesToJournal(bool compact);
+
   FilePath path_;
 
   scoped_ptr<DictionaryValue> prefs_;
@@ -78,6 +96,12 @@ class JsonPrefStore : public PersistentPrefStore,
   // Helper for safely writing pref data.
   ImportantFileWriter writer_;
 
+  bool journal_enabled_;
+
+  // The prefs changed since they were last journaled or serialized, when
+  // |journal_enabled_|.
+  std::set<std::string> changed_keys_;
+
   ObserverList<PrefStore::Observer, true> observers_;
 
   Delegate* delegate_;
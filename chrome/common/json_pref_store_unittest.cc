@@ -160,3 +160,84 @@ TEST_F(JsonPrefStoreTest, Basic) {
   EXPECT_TRUE(file_util::TextContentsEqual(golden_output_file, output_file));
   ASSERT_TRUE(file_util::Delete(output_file, false));
 }
+
+// Changes kept in the journal are read back, and folded into the file.
+TEST_F(JsonPrefStoreTest, Journal) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("journal.json");
+  FilePath journal_file = ImportantFileWriter::GetJournalPath(pref_file);
+  {
+    scoped_refptr<JsonPrefStore> pref_store =
+        new JsonPrefStore(pref_file, message_loop_proxy_.get());
+    pref_store->set_journal_enabled(true);
+    EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_NO_FILE,
+              pref_store->ReadPrefs());
+    pref_store->SetValue("a.b", Value::CreateIntegerValue(1));
+    pref_store->SetValue("c", Value::CreateStringValue("removed"));
+    pref_store->ScheduleWritePrefs();
+    pref_store->RemoveValue("c");
+    pref_store->ScheduleWritePrefs();
+    MessageLoop::current()->RunAllPending();
+    EXPECT_FALSE(file_util::PathExists(pref_file));
+    EXPECT_TRUE(file_util::PathExists(journal_file));
+  }
+
+  scoped_refptr<JsonPrefStore> pref_store =
+      new JsonPrefStore(pref_file, message_loop_proxy_.get());
+  EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+  const Value* actual = NULL;
+  ASSERT_EQ(PrefStore::READ_OK, pref_store->GetValue("a.b", &actual));
+  int integer = 0;
+  EXPECT_TRUE(actual->GetAsInteger(&integer));
+  EXPECT_EQ(1, integer);
+  EXPECT_EQ(PrefStore::READ_NO_VALUE, pref_store->GetValue("c", &actual));
+
+  pref_store->CommitPendingWrite();
+  MessageLoop::current()->RunAllPending();
+  EXPECT_TRUE(file_util::PathExists(pref_file));
+  EXPECT_FALSE(file_util::PathExists(journal_file));
+}
+
+// A journal that outlives the write of the whole file it was folded into does
+// not undo the changes made since.
+TEST_F(JsonPrefStoreTest, StaleJournal) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("stale.json");
+  FilePath journal_file = ImportantFileWriter::GetJournalPath(pref_file);
+  std::string stale_journal;
+  {
+    scoped_refptr<JsonPrefStore> pref_store =
+        new JsonPrefStore(pref_file, message_loop_proxy_.get());
+    pref_store->set_journal_enabled(true);
+    EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_NO_FILE,
+              pref_store->ReadPrefs());
+    pref_store->SetValue("a", Value::CreateIntegerValue(1));
+    pref_store->ScheduleWritePrefs();
+    // Not journaled before the file is written.
+    pref_store->SetValue("a", Value::CreateIntegerValue(2));
+    ASSERT_TRUE(pref_store->WritePrefs());
+    MessageLoop::current()->RunAllPending();
+    EXPECT_FALSE(file_util::PathExists(journal_file));
+
+    // As if the journal couldn't be deleted.
+    pref_store->SetValue("a", Value::CreateIntegerValue(1));
+    pref_store->ScheduleWritePrefs();
+    MessageLoop::current()->RunAllPending();
+    ASSERT_TRUE(file_util::ReadFileToString(journal_file, &stale_journal));
+    pref_store->SetValue("a", Value::CreateIntegerValue(3));
+    ASSERT_TRUE(pref_store->WritePrefs());
+    MessageLoop::current()->RunAllPending();
+    ASSERT_EQ(static_cast<int>(stale_journal.length()),
+              file_util::WriteFile(journal_file, stale_journal.data(),
+                                   stale_journal.length()));
+  }
+
+  scoped_refptr<JsonPrefStore> pref_store =
+      new JsonPrefStore(pref_file, message_loop_proxy_.get());
+  EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+  const Value* actual = NULL;
+  ASSERT_EQ(PrefStore::READ_OK, pref_store->GetValue("a", &actual));
+  int integer = 0;
+  EXPECT_TRUE(actual->GetAsInteger(&integer));
+  EXPECT_EQ(3, integer);
+}
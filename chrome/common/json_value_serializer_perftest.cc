@@ -2,11 +2,17 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <vector>
 
 #include "base/file_util.h"
+#include "base/json/json_arena.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_stream_parser.h"
+#include "base/json/json_writer.h"
 #include "base/path_service.h"
 #include "base/perftimer.h"
+#include "base/pickled_value_serializer.h"
 #include "base/string_util.h"
 #include "base/values.h"
 #include "chrome/common/chrome_paths.h"
@@ -40,6 +46,80 @@ class JSONValueSerializerTests : public testing::Test {
   std::vector<std::string> test_cases_;
 };
 
+// A delegate that only looks at what the parser finds, to measure the parser
+// by itself.
+class CountingDelegate : public base::JSONStreamParser::Delegate {
+ public:
+  CountingDelegate() : values_(0) {}
+
+  virtual void OnNull() { ++values_; }
+  virtual void OnBoolean(bool value) { ++values_; }
+  virtual void OnInteger(int value) { ++values_; }
+  virtual void OnDouble(double value) { ++values_; }
+  virtual void OnString(const base::StringPiece& value) { ++values_; }
+  virtual void OnListBegin() { ++values_; }
+  virtual void OnListEnd() {}
+  virtual void OnDictionaryBegin() { ++values_; }
+  virtual void OnDictionaryKey(const base::StringPiece& key) {}
+  virtual void OnDictionaryEnd() {}
+
+  int values() const { return values_; }
+
+ private:
+  int values_;
+};
+
+// Feeds |json| to |parser| in chunks, as it would be read from a file.
+bool ParseInChunks(const std::string& json, base::JSONStreamParser* parser) {
+  const size_t kChunkSize = 4096;
+  for (size_t i = 0; i < json.size(); i += kChunkSize) {
+    if (!parser->Parse(json.data() + i, std::min(kChunkSize, json.size() - i)))
+      return false;
+  }
+  return parser->Finish();
+}
+
+// Returns the number of heap blocks that a Value tree holds: one per Value,
+// one per non-empty list's array, one per non-empty string, key or value, and
+// for dictionaries one array of entries, or one block per entry once there
+// are more than 16 entries.
+int CountHeapBlocks(const Value& value) {
+  int blocks = 1;
+  if (value.IsType(Value::TYPE_STRING)) {
+    std::string string_value;
+    value.GetAsString(&string_value);
+    if (!string_value.empty())
+      ++blocks;
+  } else if (value.IsType(Value::TYPE_LIST)) {
+    const ListValue& list = static_cast<const ListValue&>(value);
+    if (list.GetSize() > 0)
+      ++blocks;
+    for (ListValue::const_iterator it = list.begin(); it != list.end(); ++it)
+      blocks += CountHeapBlocks(**it);
+  } else if (value.IsType(Value::TYPE_DICTIONARY)) {
+    const DictionaryValue& dictionary =
+        static_cast<const DictionaryValue&>(value);
+    if (dictionary.size() > 16)
+      blocks += dictionary.size();
+    else if (!dictionary.empty())
+      ++blocks;
+    for (DictionaryValue::key_iterator it = dictionary.begin_keys();
+         it != dictionary.end_keys(); ++it) {
+      Value* child = NULL;
+      dictionary.GetWithoutPathExpansion(*it, &child);
+      if (!(*it).empty())
+        ++blocks;
+      blocks += CountHeapBlocks(*child);
+    }
+  }
+  return blocks;
+}
+
+void LogThroughput(const char* name, const PerfTimer& timer, size_t bytes) {
+  double seconds = timer.Elapsed().InSecondsF();
+  LogPerfResult(name, seconds > 0 ? bytes / seconds / 1048576 : 0, "MB/s");
+}
+
 }  // namespace
 
 // Test deserialization of a json string into a Value object.  We run the test
@@ -60,6 +140,73 @@ TEST_F(JSONValueSerializerTests, Reading) {
   chrome_timer.Done();
 }
 
+// Compares JSONReader with the streaming parser building the same Values,
+// building an arena, and only reporting what it finds. Allocations are counted
+// per pass over the test cases: for the Value trees, the blocks the result
+// holds; for the arena, the blocks it allocated, before and after its memory
+// is reused.
+TEST_F(JSONValueSerializerTests, ReadingThroughput) {
+  const int kIterations = 20000;
+  size_t bytes = 0;
+  for (size_t i = 0; i < test_cases_.size(); ++i)
+    bytes += test_cases_[i].size() * kIterations;
+
+  int tree_blocks = 0;
+  PerfTimer reader_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < test_cases_.size(); ++j) {
+      scoped_ptr<Value> root(base::JSONReader::Read(test_cases_[j], false));
+      ASSERT_TRUE(root.get());
+      if (i == 0)
+        tree_blocks += CountHeapBlocks(*root);
+    }
+  }
+  LogThroughput("JSONReader_throughput", reader_timer, bytes);
+  LogPerfResult("JSONReader_allocations", tree_blocks, "allocs");
+
+  PerfTimer builder_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < test_cases_.size(); ++j) {
+      base::JSONValueBuilder builder;
+      base::JSONStreamParser parser(&builder, true, false);
+      ASSERT_TRUE(ParseInChunks(test_cases_[j], &parser));
+      scoped_ptr<Value> root(builder.Release());
+    }
+  }
+  LogThroughput("JSONStreamParser_values_throughput", builder_timer, bytes);
+
+  base::JSONArena arena;
+  int first_pass_allocations = 0;
+  PerfTimer arena_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < test_cases_.size(); ++j) {
+      arena.Clear();
+      base::JSONStreamParser parser(&arena, true, false);
+      ASSERT_TRUE(ParseInChunks(test_cases_[j], &parser));
+    }
+    if (i == 0)
+      first_pass_allocations = arena.allocation_count();
+  }
+  LogThroughput("JSONStreamParser_arena_throughput", arena_timer, bytes);
+  LogPerfResult("JSONArena_allocations", first_pass_allocations, "allocs");
+  LogPerfResult("JSONArena_reused_allocations",
+                static_cast<double>(arena.allocation_count() -
+                                    first_pass_allocations) /
+                    (kIterations - 1),
+                "allocs");
+
+  CountingDelegate counter;
+  PerfTimer sax_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < test_cases_.size(); ++j) {
+      base::JSONStreamParser parser(&counter, true, false);
+      ASSERT_TRUE(ParseInChunks(test_cases_[j], &parser));
+    }
+  }
+  LogThroughput("JSONStreamParser_throughput", sax_timer, bytes);
+  EXPECT_GT(counter.values(), 0);
+}
+
 TEST_F(JSONValueSerializerTests, CompactWriting) {
   printf("\n");
   const int kIterations = 100000;
@@ -88,3 +235,73 @@ TEST_F(JSONValueSerializerTests, CompactWriting) {
     test_cases[i] = NULL;
   }
 }
+
+// Compares JSON with the binary format of PickledValueSerializer for the same
+// Values: the time to write and read them all, and their total size.
+TEST_F(JSONValueSerializerTests, PickledRoundTrip) {
+  const int kIterations = 20000;
+  std::vector<Value*> values;
+  std::vector<std::string> pickles;
+  size_t json_size = 0;
+  size_t pickle_size = 0;
+  for (size_t i = 0; i < test_cases_.size(); ++i) {
+    Value* root = base::JSONReader::Read(test_cases_[i], false);
+    ASSERT_TRUE(root);
+    values.push_back(root);
+    std::string json;
+    base::JSONWriter::Write(root, false, &json);
+    json_size += json.size();
+    std::string data;
+    PickledValueSerializer serializer(&data);
+    ASSERT_TRUE(serializer.Serialize(*root));
+    pickle_size += data.size();
+    pickles.push_back(data);
+  }
+  LogPerfResult("JSON_size", json_size, "bytes");
+  LogPerfResult("PickledValue_size", pickle_size, "bytes");
+
+  PerfTimer json_write_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < values.size(); ++j) {
+      std::string json;
+      base::JSONWriter::Write(values[j], false, &json);
+    }
+  }
+  LogPerfResult("JSONWriter_time",
+                json_write_timer.Elapsed().InMillisecondsF(), "ms");
+
+  PerfTimer pickle_write_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < values.size(); ++j) {
+      std::string data;
+      PickledValueSerializer serializer(&data);
+      ASSERT_TRUE(serializer.Serialize(*values[j]));
+    }
+  }
+  LogPerfResult("PickledValue_write_time",
+                pickle_write_timer.Elapsed().InMillisecondsF(), "ms");
+
+  PerfTimer json_read_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < test_cases_.size(); ++j) {
+      scoped_ptr<Value> root(base::JSONReader::Read(test_cases_[j], false));
+      ASSERT_TRUE(root.get());
+    }
+  }
+  LogPerfResult("JSONReader_time",
+                json_read_timer.Elapsed().InMillisecondsF(), "ms");
+
+  PerfTimer pickle_read_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < pickles.size(); ++j) {
+      PickledValueSerializer serializer(pickles[j]);
+      scoped_ptr<Value> root(serializer.Deserialize(NULL, NULL));
+      ASSERT_TRUE(root.get());
+    }
+  }
+  LogPerfResult("PickledValue_read_time",
+                pickle_read_timer.Elapsed().InMillisecondsF(), "ms");
+
+  for (size_t i = 0; i < values.size(); ++i)
+    delete values[i];
+}
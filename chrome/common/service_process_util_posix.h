@@ -77,7 +77,7 @@ struct ServiceProcessState::StateData
   scoped_ptr<MultiProcessLock> running_lock_;
 #endif  // OS_LINUX
   scoped_ptr<ServiceProcessShutdownMonitor> shut_down_monitor_;
-  base::MessagePumpLibevent::FileDescriptorWatcher watcher_;
+  MessageLoopForIO::FileDescriptorWatcher watcher_;
   int sockets_[2];
   struct sigaction old_action_;
   bool set_action_;
@@ -220,5 +220,18 @@
         }],
       ],
     },
+    {
+      'target_name': 'crypto_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'crypto',
+        '../base/base.gyp:base',
+        '../base/base.gyp:test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'sha_perftest.cc',
+      ],
+    },
   ],
 }
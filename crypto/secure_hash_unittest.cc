@@ -32,3 +32,26 @@ TEST(SecureHashTest, TestUpdate) {
   for (size_t i = 0; i < crypto::SHA256_LENGTH; i++)
     EXPECT_EQ(expected3[i], static_cast<int>(output3[i]));
 }
+
+TEST(SecureHashTest, TestUpdateSplit) {
+  // Updating with a message in three pieces of any size gives the hash of the
+  // whole message.
+  std::string input;
+  for (int i = 0; i < 200; ++i)
+    input.push_back(static_cast<char>(i * 7));
+  std::string expected = crypto::SHA256HashString(input);
+
+  for (size_t first = 0; first < input.size(); first += 13) {
+    for (size_t second = first; second < input.size(); second += 29) {
+      scoped_ptr<crypto::SecureHash> ctx(crypto::SecureHash::Create(
+          crypto::SecureHash::SHA256));
+      ctx->Update(input.data(), first);
+      ctx->Update(input.data() + first, second - first);
+      ctx->Update(input.data() + second, input.size() - second);
+      uint8 output[crypto::SHA256_LENGTH];
+      ctx->Finish(output, sizeof(output));
+      EXPECT_EQ(expected, std::string(reinterpret_cast<char*>(output),
+                                      sizeof(output)));
+    }
+  }
+}
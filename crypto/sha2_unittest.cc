@@ -98,3 +98,30 @@ TEST(Sha256Test, Test3) {
   for (size_t i = 0; i < sizeof(output_truncated3); i++)
     EXPECT_EQ(expected3[i], static_cast<int>(output_truncated3[i]));
 }
+
+TEST(Sha256Test, AllLengths) {
+  // Hashes messages of every length up to a few blocks, which end at every
+  // position in a block, then hashes their digests together. The expected
+  // digest was computed by another implementation.
+  std::string digests;
+  for (size_t length = 0; length < 300; ++length) {
+    std::string input;
+    for (size_t i = 0; i < length; ++i)
+      input.push_back(static_cast<char>(i * 7 + length));
+    digests += crypto::SHA256HashString(input);
+  }
+
+  int expected[] = { 0xd5, 0x23, 0x88, 0x71,
+                     0xa4, 0x6a, 0xc4, 0xa1,
+                     0xa7, 0x5a, 0xc3, 0xfb,
+                     0x19, 0xd6, 0x45, 0xb0,
+                     0xb3, 0xb9, 0xe5, 0xf3,
+                     0x5f, 0x5f, 0x72, 0x0e,
+                     0x2b, 0x24, 0x0d, 0x60,
+                     0x5c, 0x6b, 0x69, 0x4e };
+
+  std::string output = crypto::SHA256HashString(digests);
+  ASSERT_EQ(crypto::SHA256_LENGTH, output.size());
+  for (size_t i = 0; i < crypto::SHA256_LENGTH; i++)
+    EXPECT_EQ(expected[i], static_cast<uint8>(output[i]));
+}
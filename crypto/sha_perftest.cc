@@ -0,0 +1,57 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/perftimer.h"
+#include "base/sha1.h"
+#include "base/sha_simd.h"
+#include "base/stringprintf.h"
+#include "crypto/sha2.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Each measurement hashes this many bytes.
+const size_t kBytes = 256 * 1024 * 1024;
+
+void HashSHA1(const std::string& input) {
+  unsigned char hash[base::SHA1_LENGTH];
+  base::SHA1HashBytes(reinterpret_cast<const unsigned char*>(input.data()),
+                      input.length(), hash);
+}
+
+void HashSHA256(const std::string& input) {
+  unsigned char hash[crypto::SHA256_LENGTH];
+  crypto::SHA256HashString(input, hash, sizeof(hash));
+}
+
+// Logs the MB of messages of |length| bytes that |hash| hashes per second.
+void Measure(const char* name, size_t length,
+             void (*hash)(const std::string&)) {
+  std::string input(length, 'a');
+  size_t runs = kBytes / length;
+  PerfTimer timer;
+  for (size_t run = 0; run < runs; ++run)
+    hash(input);
+  // Names the results after the code that ran, which depends on the CPU.
+  const char* code =
+      base::internal::GetSHAKernels() ? "sha_instructions" : "portable";
+  LogPerfResult(base::StringPrintf("%s_%s_%d", name, code,
+                                   static_cast<int>(length)).c_str(),
+                runs * length / (1024 * 1024) / timer.Elapsed().InSecondsF(),
+                "MB/s");
+}
+
+}  // namespace
+
+// Certificate fingerprints hash about 1 KB, SDCH dictionaries and cache
+// entries more.
+TEST(SHAPerfTest, Hash) {
+  const size_t kLengths[] = { 64, 1024, 65536 };
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    Measure("SHA1", kLengths[i], &HashSHA1);
+    Measure("SHA256", kLengths[i], &HashSHA256);
+  }
+}
@@ -49,6 +49,7 @@
 #endif
 #include "crypto/third_party/nss/blapi.h"
 #include "crypto/third_party/nss/sha256.h"    /* for struct SHA256ContextStr */
+#include "base/sha_simd.h"                  /* for the SHA instructions */
 
 #include <stdlib.h>
 #include <string.h>
@@ -181,6 +182,11 @@ SHA256_Begin(SHA256Context *ctx)
 static void
 SHA256_Compress(SHA256Context *ctx)
 {
+  const base::internal::SHAKernels *kernels = base::internal::GetSHAKernels();
+  if (kernels) {
+    kernels->sha256_blocks(H, B, 1);
+    return;
+  }
   {
     register PRUint32 t1, t2;
 
@@ -398,6 +404,7 @@ SHA256_Update(SHA256Context *ctx, const unsigned char *input,
 		    unsigned int inputLen)
 {
     unsigned int inBuf = ctx->sizeLo & 0x3f;
+    const base::internal::SHAKernels *kernels;
     if (!inputLen)
     	return;
 
@@ -418,6 +425,13 @@ SHA256_Update(SHA256Context *ctx, const unsigned char *input,
     }
 
     /* if enough data to fill one or more whole buffers, process them. */
+    kernels = base::internal::GetSHAKernels();
+    if (kernels && inputLen >= SHA256_BLOCK_LENGTH) {
+	unsigned int blocks = inputLen / SHA256_BLOCK_LENGTH;
+	kernels->sha256_blocks(H, input, blocks);
+	input    += blocks * SHA256_BLOCK_LENGTH;
+	inputLen -= blocks * SHA256_BLOCK_LENGTH;
+    }
     while (inputLen >= SHA256_BLOCK_LENGTH) {
     	memcpy(B, input, SHA256_BLOCK_LENGTH);
 	input    += SHA256_BLOCK_LENGTH;
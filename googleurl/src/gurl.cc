@@ -187,7 +187,7 @@ GURL GURL::ResolveWithCharsetConverter(
   url_canon::StdStringCanonOutput output(&result.spec_);
 
   if (!url_util::ResolveRelative(
-          spec_.data(), static_cast<int>(spec_.length()), parsed_,
+          spec_.data(), parsed_,
           relative.data(), static_cast<int>(relative.length()),
           charset_converter, &output, &result.parsed_)) {
     // Error resolving, return an empty URL.
@@ -215,7 +215,7 @@ GURL GURL::ResolveWithCharsetConverter(
   url_canon::StdStringCanonOutput output(&result.spec_);
 
   if (!url_util::ResolveRelative(
-          spec_.data(), static_cast<int>(spec_.length()), parsed_,
+          spec_.data(), parsed_,
           relative.data(), static_cast<int>(relative.length()),
           charset_converter, &output, &result.parsed_)) {
     // Error resolving, return an empty URL.
@@ -227,6 +227,64 @@ GURL GURL::ResolveWithCharsetConverter(
   return result;
 }
 
+// Note: code duplicated below (it's inconvenient to use a template here).
+void GURL::ResolveAll(const std::vector<std::string>& relatives,
+                      std::vector<GURL>* results) const {
+  results->reserve(results->size() + relatives.size());
+
+  // Not allowed for invalid URLs.
+  if (!is_valid_) {
+    results->resize(results->size() + relatives.size());
+    return;
+  }
+
+  url_util::RelativeURLResolver resolver(spec_.data(), parsed_, NULL);
+  url_canon::RawCanonOutput<1024> output;
+  for (size_t i = 0; i < relatives.size(); ++i) {
+    results->push_back(GURL());
+    output.set_length(0);
+    GURL& result = results->back();
+    if (resolver.Resolve(relatives[i].data(),
+                         static_cast<int>(relatives[i].length()),
+                         &output, &result.parsed_)) {
+      result.spec_.assign(output.data(), output.length());
+      result.is_valid_ = true;
+    } else {
+      // Error resolving, leave the URL empty.
+      result.parsed_ = url_parse::Parsed();
+    }
+  }
+}
+
+// Note: code duplicated above (it's inconvenient to use a template here).
+void GURL::ResolveAll(const std::vector<string16>& relatives,
+                      std::vector<GURL>* results) const {
+  results->reserve(results->size() + relatives.size());
+
+  // Not allowed for invalid URLs.
+  if (!is_valid_) {
+    results->resize(results->size() + relatives.size());
+    return;
+  }
+
+  url_util::RelativeURLResolver resolver(spec_.data(), parsed_, NULL);
+  url_canon::RawCanonOutput<1024> output;
+  for (size_t i = 0; i < relatives.size(); ++i) {
+    results->push_back(GURL());
+    output.set_length(0);
+    GURL& result = results->back();
+    if (resolver.Resolve(relatives[i].data(),
+                         static_cast<int>(relatives[i].length()),
+                         &output, &result.parsed_)) {
+      result.spec_.assign(output.data(), output.length());
+      result.is_valid_ = true;
+    } else {
+      // Error resolving, leave the URL empty.
+      result.parsed_ = url_parse::Parsed();
+    }
+  }
+}
+
 // Note: code duplicated below (it's inconvenient to use a template here).
 GURL GURL::ReplaceComponents(
     const url_canon::Replacements<char>& replacements) const {
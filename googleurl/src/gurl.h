@@ -32,6 +32,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 #include "base/string16.h"
 #include "googleurl/src/url_canon.h"
@@ -170,6 +171,16 @@ class GURL {
       const string16& relative,
       url_canon::CharsetConverter* charset_converter) const;
 
+  // Resolves each of |relatives| as Resolve() would and appends the results
+  // to |results|, in the same order. This is faster than calling Resolve() in
+  // a loop: the base is only examined once, and every URL is canonicalized
+  // into the same stack buffer so that its spec is allocated once, at its
+  // final size.
+  GURL_API void ResolveAll(const std::vector<std::string>& relatives,
+                           std::vector<GURL>* results) const;
+  GURL_API void ResolveAll(const std::vector<string16>& relatives,
+                           std::vector<GURL>* results) const;
+
   // Creates a new GURL by replacing the current URL's components with the
   // supplied versions. See the Replacements class in url_canon.h for more.
   //
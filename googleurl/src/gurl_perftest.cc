@@ -0,0 +1,166 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "googleurl/src/gurl.h"
+#include "googleurl/src/url_canon.h"
+#include "googleurl/src/url_parse.h"
+#include "googleurl/src/url_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// A corpus modelled on the URLs a browser sees while loading pages: mostly
+// already canonical, with long paths and queries, plus some that need work.
+const char* const kCanonicalURLs[] = {
+  "http://www.google.com/",
+  "http://www.google.com/search?q=chromium+url+canonicalization&ie=UTF-8"
+      "&oe=UTF-8&hl=en&client=safari&rls=en&aq=f&oq=&aqi=g10",
+  "https://mail.google.com/mail/?shva=1#inbox/12f4c3a9b2e6d7f8",
+  "http://en.wikipedia.org/wiki/Uniform_Resource_Locator",
+  "http://static.ak.fbcdn.net/rsrc.php/v1/yY/r/ZkWyiFmX6_9.js",
+  "http://ad.doubleclick.net/adj/N5295.google/B5132364.2;sz=300x250;"
+      "ord=1302034820?",
+  "http://www.example.com:8080/a/very/long/path/to/some/resource/that/is/"
+      "nested/deeply/in/the/site/index.html?session=0123456789abcdef"
+      "&user=someone&lang=en-US&ref=homepage",
+  "http://images.example.org/thumbs/2011/04/05/photo_000123_small.jpg",
+  "https://www.bank.example.com/login/auth.do?redirect=%2Faccount%2Foverview",
+  "ftp://ftp.example.net/pub/releases/chromium-12.0.742.0.tar.bz2",
+  "file:///home/user/Documents/report.html",
+};
+
+const char* const kNonCanonicalURLs[] = {
+  "HTTP://WWW.Google.COM/",
+  "http://www.example.com/foo/./bar/../baz/index.html",
+  "http://www.example.com/path with spaces/file name.html",
+  "http://www.example.com/search?q=a b\"c<d>e",
+  "  http://www.example.com:80/trimmed  ",
+  "http://www.example.com/%7Euser/home.html#section 2",
+  "http://%77%77%77.example.com/escaped/host",
+  "http://www.example.com\\backslash\\path\\to\\file.txt",
+  "www.example.com/no/scheme",
+};
+
+const int kIterations = 20000;
+
+void RunGURLTest(const char* name, const char* const* urls, size_t url_count) {
+  size_t bytes = 0;
+  for (size_t i = 0; i < url_count; ++i)
+    bytes += strlen(urls[i]);
+
+  size_t total_length = 0;
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < url_count; ++j) {
+      GURL url(urls[j]);
+      total_length += url.possibly_invalid_spec().length();
+    }
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+  EXPECT_GT(total_length, 0u);
+
+  double seconds = elapsed.InSecondsF();
+  double urls_parsed = static_cast<double>(kIterations) * url_count;
+  LogPerfResult(base::StringPrintf("%s_us_per_url", name).c_str(),
+                elapsed.InMicroseconds() / urls_parsed, "us");
+  LogPerfResult(base::StringPrintf("%s_throughput", name).c_str(),
+                seconds > 0 ? (bytes * kIterations) / seconds / 1048576 : 0,
+                "MB/s");
+}
+
+}  // namespace
+
+TEST(GURLPerfTest, ConstructCanonical) {
+  RunGURLTest("GURL_canonical", kCanonicalURLs, arraysize(kCanonicalURLs));
+}
+
+TEST(GURLPerfTest, ConstructNonCanonical) {
+  RunGURLTest("GURL_non_canonical", kNonCanonicalURLs,
+              arraysize(kNonCanonicalURLs));
+}
+
+// Canonicalizes directly into a reused output so the numbers reflect the
+// canonicalizer rather than GURL's string allocations.
+TEST(GURLPerfTest, CanonicalizeReusedOutput) {
+  size_t bytes = 0;
+  for (size_t i = 0; i < arraysize(kCanonicalURLs); ++i)
+    bytes += strlen(kCanonicalURLs[i]);
+
+  url_canon::RawCanonOutputT<char, 1024> output;
+  int total_length = 0;
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < arraysize(kCanonicalURLs); ++j) {
+      const char* spec = kCanonicalURLs[j];
+      url_parse::Parsed out_parsed;
+      output.set_length(0);
+      url_util::Canonicalize(spec, static_cast<int>(strlen(spec)), NULL,
+                             &output, &out_parsed);
+      total_length += output.length();
+    }
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+  EXPECT_GT(total_length, 0);
+
+  double seconds = elapsed.InSecondsF();
+  LogPerfResult("Canonicalize_throughput",
+                seconds > 0 ? (bytes * kIterations) / seconds / 1048576 : 0,
+                "MB/s");
+}
+
+// Resolves the links of a typical page against its URL, one at a time and as
+// a batch.
+TEST(GURLPerfTest, ResolveLinks) {
+  GURL base("http://www.example.com/news/2011/04/index.html?page=2");
+  std::vector<std::string> links;
+  for (int i = 0; i < 200; ++i) {
+    switch (i % 4) {
+      case 0:
+        links.push_back(base::StringPrintf("story_%d.html", i));
+        break;
+      case 1:
+        links.push_back(base::StringPrintf("../../images/thumb_%d.jpg", i));
+        break;
+      case 2:
+        links.push_back(base::StringPrintf("/static/js/module%d.js?v=3", i));
+        break;
+      default:
+        links.push_back(base::StringPrintf(
+            "http://ads.example.net/click?id=%d&src=news", i));
+        break;
+    }
+  }
+
+  const int kResolveIterations = 500;
+  size_t total_length = 0;
+  PerfTimer one_timer;
+  for (int i = 0; i < kResolveIterations; ++i) {
+    for (size_t j = 0; j < links.size(); ++j)
+      total_length += base.Resolve(links[j]).spec().length();
+  }
+  base::TimeDelta one_elapsed = one_timer.Elapsed();
+
+  PerfTimer all_timer;
+  for (int i = 0; i < kResolveIterations; ++i) {
+    std::vector<GURL> resolved;
+    base.ResolveAll(links, &resolved);
+    for (size_t j = 0; j < resolved.size(); ++j)
+      total_length -= resolved[j].spec().length();
+  }
+  base::TimeDelta all_elapsed = all_timer.Elapsed();
+  EXPECT_EQ(0u, total_length);
+
+  double links_resolved = static_cast<double>(kResolveIterations) *
+      links.size();
+  LogPerfResult("Resolve_us_per_link",
+                one_elapsed.InMicroseconds() / links_resolved, "us");
+  LogPerfResult("ResolveAll_us_per_link",
+                all_elapsed.InMicroseconds() / links_resolved, "us");
+}
@@ -0,0 +1,154 @@
+// Copyright 2011, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "googleurl/src/gurl_view.h"
+
+#include "base/logging.h"
+#include "googleurl/src/gurl.h"
+#include "googleurl/src/url_canon.h"
+#include "googleurl/src/url_util.h"
+
+GURLView::GURLView() : spec_(""), spec_len_(0), is_valid_(false) {
+}
+
+GURLView::GURLView(const GURL& url)
+    : spec_(url.possibly_invalid_spec().data()),
+      spec_len_(url.possibly_invalid_spec().length()),
+      is_valid_(url.is_valid()),
+      parsed_(url.parsed_for_possibly_invalid_spec()) {
+}
+
+GURLView::GURLView(const char* canonical_spec, size_t canonical_spec_len,
+                   const url_parse::Parsed& parsed, bool is_valid)
+    : spec_(canonical_spec),
+      spec_len_(canonical_spec_len),
+      is_valid_(is_valid),
+      parsed_(parsed) {
+}
+
+GURL GURLView::ToGURL() const {
+  return GURL(spec_, spec_len_, parsed_, is_valid_);
+}
+
+base::StringPiece GURLView::spec() const {
+  if (is_valid_ || !spec_len_)
+    return possibly_invalid_spec();
+
+  DCHECK(false) << "Trying to get the spec of an invalid URL!";
+  return base::StringPiece();
+}
+
+bool GURLView::IsStandard() const {
+  return url_util::IsStandard(spec_, parsed_.scheme);
+}
+
+bool GURLView::SchemeIs(const char* lower_ascii_scheme) const {
+  if (parsed_.scheme.len <= 0)
+    return lower_ascii_scheme == NULL;
+  return url_util::LowerCaseEqualsASCII(spec_ + parsed_.scheme.begin,
+                                        spec_ + parsed_.scheme.end(),
+                                        lower_ascii_scheme);
+}
+
+int GURLView::IntPort() const {
+  if (parsed_.port.is_nonempty())
+    return url_parse::ParsePort(spec_, parsed_.port);
+  return url_parse::PORT_UNSPECIFIED;
+}
+
+int GURLView::EffectiveIntPort() const {
+  int int_port = IntPort();
+  if (int_port == url_parse::PORT_UNSPECIFIED && IsStandard())
+    return url_canon::DefaultPortForScheme(spec_ + parsed_.scheme.begin,
+                                           parsed_.scheme.len);
+  return int_port;
+}
+
+base::StringPiece GURLView::PathForRequest() const {
+  DCHECK(parsed_.path.len > 0) << "Canonical path for requests should be non-empty";
+  if (parsed_.ref.len >= 0) {
+    // Clip off the reference when it exists. The reference starts after the #
+    // sign, so we have to subtract one to also remove it.
+    return base::StringPiece(spec_ + parsed_.path.begin,
+                             parsed_.ref.begin - parsed_.path.begin - 1);
+  }
+
+  // Use everything form the path to the end.
+  return base::StringPiece(spec_ + parsed_.path.begin,
+                           spec_len_ - parsed_.path.begin);
+}
+
+base::StringPiece GURLView::HostNoBrackets() const {
+  // If host looks like an IPv6 literal, strip the square brackets.
+  url_parse::Component h(parsed_.host);
+  if (h.len >= 2 && spec_[h.begin] == '[' && spec_[h.end() - 1] == ']') {
+    h.begin++;
+    h.len -= 2;
+  }
+  return ComponentString(h);
+}
+
+bool GURLView::DomainIs(const char* lower_ascii_domain,
+                        int domain_len) const {
+  // Return false if this URL is not valid or domain is empty.
+  if (!is_valid_ || !parsed_.host.is_nonempty() || !domain_len)
+    return false;
+
+  // Check whether the host name is end with a dot. If yes, treat it
+  // the same as no-dot unless the input comparison domain is end
+  // with dot.
+  const char* last_pos = spec_ + parsed_.host.end() - 1;
+  int host_len = parsed_.host.len;
+  if ('.' == *last_pos && '.' != lower_ascii_domain[domain_len - 1]) {
+    last_pos--;
+    host_len--;
+  }
+
+  // Return false if host's length is less than domain's length.
+  if (host_len < domain_len)
+    return false;
+
+  // Compare this url whether belong specific domain.
+  const char* start_pos = spec_ + parsed_.host.begin + host_len - domain_len;
+
+  if (!url_util::LowerCaseEqualsASCII(start_pos,
+                                      last_pos + 1,
+                                      lower_ascii_domain,
+                                      lower_ascii_domain + domain_len))
+    return false;
+
+  // Check whether host has right domain start with dot, make sure we got
+  // right domain range. For example www.google.com has domain
+  // "google.com" but www.iamnotgoogle.com does not.
+  if ('.' != lower_ascii_domain[0] && host_len > domain_len &&
+      '.' != *(start_pos - 1))
+    return false;
+
+  return true;
+}
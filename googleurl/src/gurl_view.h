@@ -0,0 +1,181 @@
+// Copyright 2011, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef GOOGLEURL_SRC_GURL_VIEW_H__
+#define GOOGLEURL_SRC_GURL_VIEW_H__
+
+#include <string.h>
+
+#include "base/string_piece.h"
+#include "googleurl/src/url_common.h"
+#include "googleurl/src/url_parse.h"
+
+class GURL;
+
+// A GURLView is a non-owning, read-only reference to a parsed and
+// canonicalized URL. It holds a pointer to the spec and a copy of the parsed
+// components, so creating or copying one never allocates, and the component
+// getters return pieces of the referenced spec instead of new strings.
+//
+// The referenced spec must outlive the view: a view made from a GURL is no
+// longer usable once that GURL is modified or destroyed. Views are therefore
+// meant for parameters of functions that only read a URL. Since GURL converts
+// implicitly, such functions can take a const GURLView& without changing their
+// callers. Anything that stores a URL should store a GURL.
+class GURLView {
+ public:
+  // Creates a view of the empty, invalid URL.
+  GURL_API GURLView();
+
+  // Intentionally not explicit, see above.
+  GURL_API GURLView(const GURL& url);
+
+  // Creates a view of a spec that has already been parsed and canonicalized,
+  // for example by url_util::Canonicalize() into a caller-owned buffer. The
+  // same consistency requirements as the equivalent GURL constructor apply.
+  GURL_API GURLView(const char* canonical_spec, size_t canonical_spec_len,
+                    const url_parse::Parsed& parsed, bool is_valid);
+
+  // Returns an owning copy of the URL. This copies the spec but does not
+  // re-parse it.
+  GURL_API GURL ToGURL() const;
+
+  // See the GURL getters of the same names.
+  bool is_valid() const {
+    return is_valid_;
+  }
+  bool is_empty() const {
+    return spec_len_ == 0;
+  }
+  GURL_API base::StringPiece spec() const;
+  base::StringPiece possibly_invalid_spec() const {
+    return base::StringPiece(spec_, spec_len_);
+  }
+  const url_parse::Parsed& parsed_for_possibly_invalid_spec() const {
+    return parsed_;
+  }
+
+  bool operator==(const GURLView& other) const {
+    return possibly_invalid_spec() == other.possibly_invalid_spec();
+  }
+  bool operator!=(const GURLView& other) const {
+    return !(*this == other);
+  }
+
+  GURL_API bool IsStandard() const;
+  GURL_API bool SchemeIs(const char* lower_ascii_scheme) const;
+  bool SchemeIsFile() const {
+    return SchemeIs("file");
+  }
+  bool SchemeIsSecure() const {
+    return SchemeIs("https");
+  }
+
+  base::StringPiece scheme() const {
+    return ComponentString(parsed_.scheme);
+  }
+  base::StringPiece username() const {
+    return ComponentString(parsed_.username);
+  }
+  base::StringPiece password() const {
+    return ComponentString(parsed_.password);
+  }
+  base::StringPiece host() const {
+    return ComponentString(parsed_.host);
+  }
+  base::StringPiece port() const {
+    return ComponentString(parsed_.port);
+  }
+  base::StringPiece path() const {
+    return ComponentString(parsed_.path);
+  }
+  base::StringPiece query() const {
+    return ComponentString(parsed_.query);
+  }
+  base::StringPiece ref() const {
+    return ComponentString(parsed_.ref);
+  }
+
+  bool has_scheme() const {
+    return parsed_.scheme.len >= 0;
+  }
+  bool has_username() const {
+    return parsed_.username.len >= 0;
+  }
+  bool has_password() const {
+    return parsed_.password.len >= 0;
+  }
+  bool has_host() const {
+    return parsed_.host.len > 0;
+  }
+  bool has_port() const {
+    return parsed_.port.len >= 0;
+  }
+  bool has_path() const {
+    return parsed_.path.len >= 0;
+  }
+  bool has_query() const {
+    return parsed_.query.len >= 0;
+  }
+  bool has_ref() const {
+    return parsed_.ref.len >= 0;
+  }
+
+  GURL_API int IntPort() const;
+  GURL_API int EffectiveIntPort() const;
+
+  // The path and query are adjacent in the spec, so unlike the GURL version
+  // this doesn't need to build a new string.
+  GURL_API base::StringPiece PathForRequest() const;
+
+  GURL_API base::StringPiece HostNoBrackets() const;
+
+  GURL_API bool DomainIs(const char* lower_ascii_domain, int domain_len) const;
+  bool DomainIs(const char* lower_ascii_domain) const {
+    return DomainIs(lower_ascii_domain,
+                    static_cast<int>(strlen(lower_ascii_domain)));
+  }
+
+ private:
+  base::StringPiece ComponentString(const url_parse::Component& comp) const {
+    if (comp.len <= 0)
+      return base::StringPiece();
+    return base::StringPiece(spec_ + comp.begin, comp.len);
+  }
+
+  // The canonical spec, which is not owned and not NULL-terminated.
+  const char* spec_;
+  size_t spec_len_;
+
+  bool is_valid_;
+
+  url_parse::Parsed parsed_;
+};
+
+#endif  // GOOGLEURL_SRC_GURL_VIEW_H__
@@ -136,11 +136,19 @@ class CanonOutputT {
       if (!Grow(cur_len_ + str_len - buffer_len_))
         return;
     }
-    for (int i = 0; i < str_len; i++)
-      buffer_[cur_len_ + i] = str[i];
+    memcpy(&buffer_[cur_len_], str, sizeof(T) * str_len);
     cur_len_ += str_len;
   }
 
+  // Makes sure the buffer can hold |estimated_size| characters, so that the
+  // caller can write up to that many directly into data() and then declare
+  // them with set_length(). Returns false if the buffer couldn't be grown.
+  bool ReserveSizeIfNeeded(int estimated_size) {
+    if (estimated_size <= buffer_len_)
+      return true;
+    return Grow(estimated_size - buffer_len_);
+  }
+
  protected:
   // Grows the given buffer so that it can fit at least |min_additional|
   // characters. Returns true if the buffer could be resized, false on OOM.
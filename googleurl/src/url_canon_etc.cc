@@ -282,8 +282,13 @@ void DoCanonicalizeRef(const CHAR* spec,
       // shouldn't be using control characters in their anchor names.
       AppendEscapedChar(static_cast<unsigned char>(spec[i]), output);
     } else if (static_cast<UCHAR>(spec[i]) < 0x80) {
-      // Normal ASCII characters are just appended.
-      output->push_back(static_cast<char>(spec[i]));
+      // Normal ASCII characters are just appended, along with any that follow.
+      int run_end = i + 1;
+      while (run_end < end && static_cast<UCHAR>(spec[run_end]) >= 0x20 &&
+             static_cast<UCHAR>(spec[run_end]) < 0x80)
+        run_end++;
+      AppendASCIIRun(spec, i, run_end, output);
+      i = run_end - 1;
     } else {
       // Non-ASCII characters are appended unescaped, but only when they are
       // valid. Invalid Unicode characters are replaced with the "invalid
@@ -173,6 +173,17 @@ bool DoSimpleHost(const INCHAR* host,
         // table tells us the canonical representation of that character (lower
         // cased).
         output->push_back(replacement);
+
+        // The characters that follow are usually already canonical, append
+        // them all at once.
+        int run_end = i + 1;
+        while (run_end < host_len &&
+               static_cast<unsigned int>(host[run_end]) < 0x80 &&
+               kHostCharLookup[static_cast<unsigned char>(host[run_end])] ==
+                   host[run_end])
+          run_end++;
+        AppendASCIIRun(host, i + 1, run_end, output);
+        i = run_end - 1;
       }
     } else {
       // It's a non-ascii char. Just push it to the output.
@@ -153,6 +153,26 @@ inline void AppendEscapedChar(UINCHAR ch,
   output->push_back(kHexCharLookup[ch & 0xf]);
 }
 
+// Appends the characters of |spec| from |begin| to |end| (non-inclusive) to
+// the output unchanged; they must all be 7-bit. The canonicalizers use this for
+// runs of input that are already canonical, which is the common case, so that
+// they don't do a capacity check for every character.
+inline void AppendASCIIRun(const char* spec, int begin, int end,
+                           CanonOutput* output) {
+  output->Append(&spec[begin], end - begin);
+}
+template<typename INCHAR, typename OUTCHAR>
+inline void AppendASCIIRun(const INCHAR* spec, int begin, int end,
+                           CanonOutputT<OUTCHAR>* output) {
+  int len = end - begin;
+  if (!output->ReserveSizeIfNeeded(output->length() + len))
+    return;
+  OUTCHAR* dest = &output->data()[output->length()];
+  for (int i = 0; i < len; i++)
+    dest[i] = static_cast<OUTCHAR>(spec[begin + i]);
+  output->set_length(output->length() + len);
+}
+
 // The character we'll substitute for undecodable or invalid characters.
 extern const char16 kUnicodeReplacementCharacter;
 
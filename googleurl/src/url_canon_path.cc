@@ -311,8 +311,17 @@ bool DoPartialPath(const CHAR* spec,
           AppendEscapedChar(out_ch, output);
         }
       } else {
-        // Nothing special about this character, just append it.
-        output->push_back(out_ch);
+        // Nothing special about this character. Most paths are already
+        // canonical, so append it together with all the following characters
+        // that are not special either.
+        int run_end = i + 1;
+        while (run_end < end &&
+               static_cast<UCHAR>(spec[run_end]) < 0x80 &&
+               !(kPathCharLookup[static_cast<UCHAR>(spec[run_end])] &
+                 SPECIAL))
+          run_end++;
+        AppendASCIIRun(spec, i, run_end, output);
+        i = run_end - 1;
       }
     }
   }
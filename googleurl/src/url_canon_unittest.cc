@@ -1991,3 +1991,38 @@ TEST(URLCanonTest, ReplacementOverflow) {
     expected.push_back('a');
   EXPECT_TRUE(expected == repl_str);
 }
+
+// Long runs of already-canonical characters are appended in one go; make sure
+// that works when the runs are interrupted by characters needing work and when
+// the output has to grow in the middle of a run.
+TEST(URLCanonTest, LongCanonicalRuns) {
+  std::string run;
+  for (int i = 0; i < 300; i++)
+    run.push_back(static_cast<char>('a' + i % 26));
+
+  std::string input = "http://" + run + ".Example.com/" + run + "/./" + run +
+      " /" + run + "?" + run + "<" + run + "#" + run + " " + run;
+  std::string expected = "http://" + run + ".example.com/" + run + "/" + run +
+      "%20/" + run + "?" + run + "%3C" + run + "#" + run + " " + run;
+
+  // 8-bit input.
+  url_parse::Parsed parsed;
+  url_parse::ParseStandardURL(input.data(), static_cast<int>(input.length()),
+                              &parsed);
+  url_canon::RawCanonOutput<16> output;
+  url_parse::Parsed out_parsed;
+  EXPECT_TRUE(url_canon::CanonicalizeStandardURL(
+      input.data(), static_cast<int>(input.length()), parsed, NULL, &output,
+      &out_parsed));
+  EXPECT_EQ(expected, std::string(output.data(), output.length()));
+
+  // 16-bit input.
+  string16 input16(input.begin(), input.end());
+  url_parse::ParseStandardURL(input16.data(),
+                              static_cast<int>(input16.length()), &parsed);
+  url_canon::RawCanonOutput<16> output16;
+  EXPECT_TRUE(url_canon::CanonicalizeStandardURL(
+      input16.data(), static_cast<int>(input16.length()), parsed, NULL,
+      &output16, &out_parsed));
+  EXPECT_EQ(expected, std::string(output16.data(), output16.length()));
+}
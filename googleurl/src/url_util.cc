@@ -210,10 +210,25 @@ bool DoCanonicalize(const CHAR* in_spec, int in_spec_len,
   return success;
 }
 
+// See if the given base URL should be treated as "standard".
+bool IsStandardBase(const char* base_spec,
+                    const url_parse::Parsed& base_parsed) {
+  return base_parsed.scheme.is_nonempty() &&
+      DoIsStandard(base_spec, base_parsed.scheme);
+}
+
+bool IsFileBase(const char* base_spec, const url_parse::Parsed& base_parsed) {
+  return base_parsed.scheme.is_nonempty() &&
+      CompareSchemeComponent(base_spec, base_parsed.scheme, kFileScheme);
+}
+
+// The two properties of the base are passed in so that RelativeURLResolver
+// only needs to look them up once.
 template<typename CHAR>
 bool DoResolveRelative(const char* base_spec,
-                       int base_spec_len,
                        const url_parse::Parsed& base_parsed,
+                       bool standard_base_scheme,
+                       bool file_base_scheme,
                        const CHAR* in_relative,
                        int in_relative_length,
                        url_canon::CharsetConverter* charset_converter,
@@ -227,11 +242,6 @@ bool DoResolveRelative(const char* base_spec,
                                              &whitespace_buffer,
                                              &relative_length);
 
-  // See if our base URL should be treated as "standard".
-  bool standard_base_scheme =
-      base_parsed.scheme.is_nonempty() &&
-      DoIsStandard(base_spec, base_parsed.scheme);
-
   bool is_relative;
   url_parse::Component relative_component;
   if (!url_canon::IsRelativeURL(base_spec, base_parsed,
@@ -245,8 +255,6 @@ bool DoResolveRelative(const char* base_spec,
 
   if (is_relative) {
     // Relative, resolve and canonicalize.
-    bool file_base_scheme = base_parsed.scheme.is_nonempty() &&
-        CompareSchemeComponent(base_spec, base_parsed.scheme, kFileScheme);
     return url_canon::ResolveRelativeURL(base_spec, base_parsed,
                                          file_base_scheme, relative,
                                          relative_component, charset_converter,
@@ -429,31 +437,64 @@ bool Canonicalize(const char16* spec,
 }
 
 bool ResolveRelative(const char* base_spec,
-                     int base_spec_len,
                      const url_parse::Parsed& base_parsed,
                      const char* relative,
                      int relative_length,
                      url_canon::CharsetConverter* charset_converter,
                      url_canon::CanonOutput* output,
                      url_parse::Parsed* output_parsed) {
-  return DoResolveRelative(base_spec, base_spec_len, base_parsed,
+  return DoResolveRelative(base_spec, base_parsed,
+                           IsStandardBase(base_spec, base_parsed),
+                           IsFileBase(base_spec, base_parsed),
                            relative, relative_length,
                            charset_converter, output, output_parsed);
 }
 
 bool ResolveRelative(const char* base_spec,
-                     int base_spec_len,
                      const url_parse::Parsed& base_parsed,
                      const char16* relative,
                      int relative_length,
                      url_canon::CharsetConverter* charset_converter,
                      url_canon::CanonOutput* output,
                      url_parse::Parsed* output_parsed) {
-  return DoResolveRelative(base_spec, base_spec_len, base_parsed,
+  return DoResolveRelative(base_spec, base_parsed,
+                           IsStandardBase(base_spec, base_parsed),
+                           IsFileBase(base_spec, base_parsed),
                            relative, relative_length,
                            charset_converter, output, output_parsed);
 }
 
+RelativeURLResolver::RelativeURLResolver(
+    const char* base_spec,
+    const url_parse::Parsed& base_parsed,
+    url_canon::CharsetConverter* charset_converter)
+    : base_spec_(base_spec),
+      base_parsed_(base_parsed),
+      standard_base_scheme_(IsStandardBase(base_spec, base_parsed)),
+      file_base_scheme_(IsFileBase(base_spec, base_parsed)),
+      charset_converter_(charset_converter) {
+}
+
+bool RelativeURLResolver::Resolve(const char* relative,
+                                  int relative_length,
+                                  url_canon::CanonOutput* output,
+                                  url_parse::Parsed* output_parsed) const {
+  return DoResolveRelative(base_spec_, base_parsed_,
+                           standard_base_scheme_, file_base_scheme_,
+                           relative, relative_length,
+                           charset_converter_, output, output_parsed);
+}
+
+bool RelativeURLResolver::Resolve(const char16* relative,
+                                  int relative_length,
+                                  url_canon::CanonOutput* output,
+                                  url_parse::Parsed* output_parsed) const {
+  return DoResolveRelative(base_spec_, base_parsed_,
+                           standard_base_scheme_, file_base_scheme_,
+                           relative, relative_length,
+                           charset_converter_, output, output_parsed);
+}
+
 bool ReplaceComponents(const char* spec,
                        int spec_len,
                        const url_parse::Parsed& parsed,
@@ -782,17 +782,28 @@ std::string CookieMonster::GetCookiesWithOptions(const GURL& url,
   FindCookiesForHostAndDomain(url, options, true, &cookies);
   std::sort(cookies.begin(), cookies.end(), CookieSorter);
 
+  // Size the line up front so that building it doesn't reallocate.
+  size_t cookie_line_length = 0;
+  for (std::vector<CanonicalCookie*>::const_iterator it = cookies.begin();
+       it != cookies.end(); ++it) {
+    cookie_line_length +=
+        (*it)->Name().length() + 1 + (*it)->Value().length() + 2;
+  }
+
   std::string cookie_line;
+  cookie_line.reserve(cookie_line_length);
   for (std::vector<CanonicalCookie*>::const_iterator it = cookies.begin();
        it != cookies.end(); ++it) {
     if (it != cookies.begin())
-      cookie_line += "; ";
+      cookie_line.append("; ", 2);
     // In Mozilla if you set a cookie like AAAA, it will have an empty token
     // and a value of AAAA.  When it sends the cookie back, it will send AAAA,
     // so we need to avoid sending =AAAA for a blank token value.
-    if (!(*it)->Name().empty())
-      cookie_line += (*it)->Name() + "=";
-    cookie_line += (*it)->Value();
+    if (!(*it)->Name().empty()) {
+      cookie_line.append((*it)->Name());
+      cookie_line.push_back('=');
+    }
+    cookie_line.append((*it)->Value());
   }
 
   histogram_time_get_->AddTime(TimeTicks::Now() - start_time);
@@ -1052,32 +1063,25 @@ void CookieMonster::FindCookiesForHostAndDomain(
     FindCookiesForKey(key, url, options, current_time,
                       update_access_time, cookies);
   } else {
-    // Need to probe for all domains that might have relevant
-    // cookies for us.
-
-    // Query for the full host, For example: 'a.c.blah.com'.
-    std::string key(GetKey(url.host()));
-    FindCookiesForKey(key, url, options, current_time, update_access_time,
-                      cookies);
-
-    // See if we can search for domain cookies, i.e. if the host has a TLD + 1.
-    const std::string domain(GetEffectiveDomain(url.scheme(), key));
-    if (domain.empty())
-      return;
-    DCHECK_LE(domain.length(), key.length());
-    DCHECK_EQ(0, key.compare(key.length() - domain.length(), domain.length(),
-                             domain));
-
-    // Walk through the string and query at the dot points (GURL should have
-    // canonicalized the dots, so this should be safe).  Stop once we reach the
-    // domain + registry; we can't write cookies past this point, and with some
-    // registrars other domains can, in which case we don't want to read their
-    // cookies.
-    for (key = "." + key; key.length() > domain.length(); ) {
-      FindCookiesForKey(key, url, options, current_time, update_access_time,
-                        cookies);
-      const size_t next_dot = key.find('.', 1);  // Skip over leading dot.
-      key.erase(0, next_dot);
+    // Need to probe for all domains that might have relevant cookies for
+    // us.  All of them live under the eTLD+1 key of the host.  Rather than
+    // scanning every cookie stored under that key, probe the domain index
+    // for exactly the cookie domains that can domain-match the host (see
+    // CanonicalCookie::IsDomainMatch()): the host itself, the host with a
+    // leading ".", and every "."-prefixed suffix of the host.
+    const std::string key(GetKey(url.host()));
+    const std::string host(url.host());
+    const std::string path(url.path());
+    const bool secure = url.SchemeIsSecure();
+
+    FindCookiesForDomain(key, host, path, secure, options, current_time,
+                         update_access_time, cookies);
+    FindCookiesForDomain(key, "." + host, path, secure, options, current_time,
+                         update_access_time, cookies);
+    for (size_t dot = host.find('.', 1); dot != std::string::npos;
+         dot = host.find('.', dot + 1)) {
+      FindCookiesForDomain(key, host.substr(dot), path, secure, options,
+                           current_time, update_access_time, cookies);
     }
   }
 }
@@ -1093,6 +1097,7 @@ void CookieMonster::FindCookiesForKey(
 
   const std::string scheme(url.scheme());
   const std::string host(url.host());
+  const std::string path(url.path());
   bool secure = url.SchemeIsSecure();
 
   for (CookieMapItPair its = cookies_.equal_range(key);
@@ -1120,7 +1125,58 @@ void CookieMonster::FindCookiesForKey(
         && !cc->IsDomainMatch(scheme, host))
       continue;
 
-    if (!cc->IsOnPath(url.path()))
+    if (!cc->IsOnPath(path))
+      continue;
+
+    // Add this cookie to the set of matching cookies.  Update the access
+    // time if we've been requested to do so.
+    if (update_access_time) {
+      InternalUpdateCookieAccessTime(cc, current);
+    }
+    cookies->push_back(cc);
+  }
+}
+
+void CookieMonster::FindCookiesForDomain(
+    const std::string& key,
+    const std::string& domain,
+    const std::string& path,
+    bool secure,
+    const CookieOptions& options,
+    const Time& current,
+    bool update_access_time,
+    std::vector<CanonicalCookie*>* cookies) {
+  lock_.AssertAcquired();
+
+  typedef std::pair<CookieDomainIndex::iterator, CookieDomainIndex::iterator>
+      DomainIndexItPair;
+  for (DomainIndexItPair its = domain_index_.equal_range(domain);
+       its.first != its.second; ) {
+    // InternalDeleteCookie() removes the index entry, so advance first.
+    CookieMap::iterator curit = its.first->second;
+    CanonicalCookie* cc = curit->second;
+    ++its.first;
+
+    // The same domain may be stored under a different key (e.g. ".com"), in
+    // which case it is not visible to this host.
+    if (curit->first != key)
+      continue;
+
+    // If the cookie is expired, delete it.
+    if (cc->IsExpired(current) && !keep_expired_cookies_) {
+      InternalDeleteCookie(curit, true, DELETE_COOKIE_EXPIRED);
+      continue;
+    }
+
+    // Filter out HttpOnly cookies, per options.
+    if (options.exclude_httponly() && cc->IsHttpOnly())
+      continue;
+
+    // Filter out secure cookies unless we're https.
+    if (!secure && cc->IsSecure())
+      continue;
+
+    if (!cc->IsOnPath(path))
       continue;
 
     // Add this cookie to the set of matching cookies.  Update the access
@@ -1170,7 +1226,8 @@ void CookieMonster::InternalInsertCookie(const std::string& key,
 
   if (cc->IsPersistent() && store_ && sync_to_store)
     store_->AddCookie(*cc);
-  cookies_.insert(CookieMap::value_type(key, cc));
+  CookieMap::iterator it = cookies_.insert(CookieMap::value_type(key, cc));
+  domain_index_.insert(CookieDomainIndex::value_type(cc->Domain(), it));
   if (delegate_.get()) {
     delegate_->OnCookieChanged(
         *cc, false, CookieMonster::Delegate::CHANGE_COOKIE_EXPLICIT);
@@ -1309,6 +1366,15 @@ void CookieMonster::InternalDeleteCookie(CookieMap::iterator it,
     if (mapping.notify)
       delegate_->OnCookieChanged(*cc, true, mapping.cause);
   }
+  for (CookieDomainIndex::iterator index_it =
+           domain_index_.lower_bound(cc->Domain());
+       index_it != domain_index_.end(); ++index_it) {
+    DCHECK_EQ(cc->Domain(), index_it->first);
+    if (index_it->second == it) {
+      domain_index_.erase(index_it);
+      break;
+    }
+  }
   cookies_.erase(it);
   delete cc;
 }
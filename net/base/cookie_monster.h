@@ -98,6 +98,15 @@ class NET_EXPORT CookieMonster : public CookieStore {
   typedef std::multimap<std::string, CanonicalCookie*> CookieMap;
   typedef std::pair<CookieMap::iterator, CookieMap::iterator> CookieMapItPair;
 
+  // Secondary index over |cookies_|, keyed by the domain attribute of each
+  // cookie (e.g. "www.google.com" for a host cookie, ".google.com" for a
+  // domain cookie).  With the eTLD+1 key scheme a single CookieMap key can
+  // hold cookies for many subdomains; the index lets lookups probe only the
+  // domains that can match a given host instead of scanning every cookie
+  // under the key.  Kept in sync with |cookies_| by InternalInsertCookie()
+  // and InternalDeleteCookie(), which are the only places that mutate it.
+  typedef std::multimap<std::string, CookieMap::iterator> CookieDomainIndex;
+
   // The key and expiry scheme to be used by the monster.
   // EKS_KEEP_RECENT_AND_PURGE_ETLDP1 means to use
   // the new key scheme based on effective domain and save recent cookies
@@ -382,6 +391,20 @@ class NET_EXPORT CookieMonster : public CookieStore {
                          bool update_access_time,
                          std::vector<CanonicalCookie*>* cookies);
 
+  // Looks up the cookies stored under CookieMap key |key| whose domain
+  // attribute is exactly |domain|, using |domain_index_|.  The caller must
+  // only pass domains that domain-match |host|; filtering on |path|,
+  // |secure| and |options| and access time updates are as for
+  // FindCookiesForKey().
+  void FindCookiesForDomain(const std::string& key,
+                            const std::string& domain,
+                            const std::string& path,
+                            bool secure,
+                            const CookieOptions& options,
+                            const base::Time& current,
+                            bool update_access_time,
+                            std::vector<CanonicalCookie*>* cookies);
+
   // Delete any cookies that are equivalent to |ecc| (same path, domain, etc).
   // If |skip_httponly| is true, httponly cookies will not be deleted.  The
   // return value with be true if |skip_httponly| skipped an httponly cookie.
@@ -483,6 +506,9 @@ class NET_EXPORT CookieMonster : public CookieStore {
 
   CookieMap cookies_;
 
+  // Index of |cookies_| by cookie domain; see the CookieDomainIndex typedef.
+  CookieDomainIndex domain_index_;
+
   // Indicates whether the cookie store has been initialized. This happens
   // lazily in InitStoreIfNecessary().
   bool initialized_;
@@ -199,6 +199,51 @@ TEST(CookieMonsterTest, TestDomainLine) {
   timer2.Done();
 }
 
+// Models a heavy user's profile: 3000 cookies spread over many eTLD+1s, each
+// with host and domain cookies on several subdomains and paths, queried
+// with the kind of URLs that generate the Cookie header of a request.
+TEST(CookieMonsterTest, TestManyDomainsManyCookies) {
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+  const int kNumDomains = 100;
+  const int kNumSubdomains = 3;
+  const int kCookiesPerHost = 10;
+
+  std::vector<GURL> probe_gurls;
+  for (int domain_num = 0; domain_num < kNumDomains; domain_num++) {
+    const std::string domain(base::StringPrintf("domain%03d.com", domain_num));
+    for (int sub_num = 0; sub_num < kNumSubdomains; sub_num++) {
+      const std::string host(base::StringPrintf("sub%d.", sub_num) + domain);
+      GURL gurl("http://" + host + "/");
+      for (int cookie_num = 0; cookie_num < kCookiesPerHost; cookie_num++) {
+        std::string cookie_line;
+        if (cookie_num % 3 == 0) {
+          cookie_line = base::StringPrintf("host%d=v", cookie_num);
+        } else if (cookie_num % 3 == 1) {
+          cookie_line = base::StringPrintf("dom%d_%d=v; domain=.%s",
+                                           sub_num, cookie_num,
+                                           domain.c_str());
+        } else {
+          cookie_line = base::StringPrintf("path%d=v; path=/p%d",
+                                           cookie_num, cookie_num);
+        }
+        EXPECT_TRUE(cm->SetCookie(gurl, cookie_line));
+      }
+      probe_gurls.push_back(GURL("http://" + host + "/p2/index.html"));
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumDomains * kNumSubdomains *
+                                kCookiesPerHost),
+            cm->GetAllCookies().size());
+
+  PerfTimeLogger timer("Cookie_monster_query_many_domains_many_cookies");
+  for (int i = 0; i < kNumCookies / kNumSubdomains; i++) {
+    for (int sub_num = 0; sub_num < kNumSubdomains; sub_num++)
+      cm->GetCookies(probe_gurls[(i * kNumSubdomains + sub_num) %
+                                 probe_gurls.size()]);
+  }
+  timer.Done();
+}
+
 TEST(CookieMonsterTest, TestImport) {
   scoped_refptr<MockPersistentCookieStore> store(new MockPersistentCookieStore);
   std::vector<CookieMonster::CanonicalCookie*> initial_cookies;
@@ -400,6 +400,34 @@ TEST(CookieMonsterTest, DomainTest) {
   EXPECT_EQ(0u, store->commands().size());
 }
 
+// Cookies for sibling subdomains share one eTLD+1 key; make sure lookups and
+// deletes only see the cookies whose domain matches the requested host.
+TEST(CookieMonsterTest, SiblingSubdomainTest) {
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+  GURL url_a("http://a.google.izzle");
+  GURL url_b("http://b.google.izzle");
+  GURL url_xa("http://x.a.google.izzle");
+
+  EXPECT_TRUE(cm->SetCookie(url_a, "A=1"));
+  EXPECT_TRUE(cm->SetCookie(url_a, "AD=2; domain=.a.google.izzle"));
+  EXPECT_TRUE(cm->SetCookie(url_b, "B=3"));
+  EXPECT_TRUE(cm->SetCookie(url_b, "D=4; domain=.google.izzle"));
+
+  EXPECT_EQ("A=1; AD=2; D=4", cm->GetCookies(url_a));
+  EXPECT_EQ("B=3; D=4", cm->GetCookies(url_b));
+  EXPECT_EQ("AD=2; D=4", cm->GetCookies(url_xa));
+
+  EXPECT_EQ(1, cm->DeleteAllForHost(url_a));
+  EXPECT_EQ("AD=2; D=4", cm->GetCookies(url_a));
+  cm->DeleteCookie(url_xa, "D");
+  EXPECT_EQ("AD=2", cm->GetCookies(url_a));
+  EXPECT_EQ("B=3", cm->GetCookies(url_b));
+
+  EXPECT_EQ(2, cm->DeleteAll(false));
+  EXPECT_EQ("", cm->GetCookies(url_a));
+  EXPECT_EQ("", cm->GetCookies(url_b));
+}
+
 // FireFox recognizes domains containing trailing periods as valid.
 // IE and Safari do not. Assert the expected policy here.
 TEST(CookieMonsterTest, DomainWithTrailingDotTest) {
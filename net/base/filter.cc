@@ -4,8 +4,13 @@
 
 #include "net/base/filter.h"
 
+#include <algorithm>
+#include <utility>
+
 #include "base/file_path.h"
+#include "base/lazy_instance.h"
 #include "base/string_util.h"
+#include "base/synchronization/lock.h"
 #include "net/base/gzip_filter.h"
 #include "net/base/io_buffer.h"
 #include "net/base/mime_util.h"
@@ -37,10 +42,105 @@ const char kTextHtml[]             = "text/html";
 // Buffer size allocated when de-compressing data.
 const int kFilterBufSize = 32 * 1024;
 
+// Buffers of filters built by Filter::Factory() start small and grow while
+// the response keeps filling them.
+const int kInitialFilterBufSize = 8 * 1024;
+const int kMaxFilterBufSize = 64 * 1024;
+
 }  // namespace
 
 namespace net {
 
+namespace {
+
+Filter::FilterType ConvertBuiltinEncodingToType(const std::string& encoding) {
+  if (LowerCaseEqualsASCII(encoding, kDeflate))
+    return Filter::FILTER_TYPE_DEFLATE;
+  if (LowerCaseEqualsASCII(encoding, kGZip) ||
+      LowerCaseEqualsASCII(encoding, kXGZip))
+    return Filter::FILTER_TYPE_GZIP;
+  if (LowerCaseEqualsASCII(encoding, kSdch))
+    return Filter::FILTER_TYPE_SDCH;
+  // Note we also consider "identity" and "uncompressed" UNSUPPORTED as
+  // filter should be disabled in such cases.
+  return Filter::FILTER_TYPE_UNSUPPORTED;
+}
+
+// Holds the decoders added with Filter::RegisterDecoderFactory().  An encoding
+// keeps its slot, and thus its FilterType, after it is unregistered, so a type
+// obtained from ConvertEncodingToType() never refers to a different decoder.
+class DecoderRegistry {
+ public:
+  DecoderRegistry() {}
+
+  Filter::DecoderFactory* Register(const std::string& encoding,
+                                   Filter::DecoderFactory* factory) {
+    const std::string name(StringToLowerASCII(encoding));
+    base::AutoLock locked(lock_);
+    for (size_t i = 0; i < decoders_.size(); ++i) {
+      if (decoders_[i].first == name) {
+        Filter::DecoderFactory* old_factory = decoders_[i].second;
+        decoders_[i].second = factory;
+        return old_factory;
+      }
+    }
+    if (!factory)
+      return NULL;
+    if (decoders_.size() == kMaxDecoders) {
+      NOTREACHED() << "Too many content decoders registered.";
+      return NULL;
+    }
+    decoders_.push_back(std::make_pair(name, factory));
+    return NULL;
+  }
+
+  Filter::FilterType GetType(const std::string& encoding) const {
+    base::AutoLock locked(lock_);
+    for (size_t i = 0; i < decoders_.size(); ++i) {
+      if (decoders_[i].second &&
+          LowerCaseEqualsASCII(encoding, decoders_[i].first.c_str())) {
+        return static_cast<Filter::FilterType>(
+            Filter::FILTER_TYPE_FIRST_REGISTERED + i);
+      }
+    }
+    return Filter::FILTER_TYPE_UNSUPPORTED;
+  }
+
+  Filter::DecoderFactory* GetFactory(Filter::FilterType type_id) const {
+    DCHECK_GE(type_id, Filter::FILTER_TYPE_FIRST_REGISTERED);
+    size_t index = type_id - Filter::FILTER_TYPE_FIRST_REGISTERED;
+    base::AutoLock locked(lock_);
+    return index < decoders_.size() ? decoders_[index].second : NULL;
+  }
+
+  void AppendEncodings(std::string* encodings) const {
+    base::AutoLock locked(lock_);
+    for (size_t i = 0; i < decoders_.size(); ++i) {
+      if (!decoders_[i].second)
+        continue;
+      encodings->push_back(',');
+      encodings->append(decoders_[i].first);
+    }
+  }
+
+ private:
+  typedef std::vector<std::pair<std::string, Filter::DecoderFactory*> >
+      DecoderList;
+
+  static const size_t kMaxDecoders = Filter::FILTER_TYPE_LAST_REGISTERED -
+                                     Filter::FILTER_TYPE_FIRST_REGISTERED + 1;
+
+  mutable base::Lock lock_;
+  DecoderList decoders_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecoderRegistry);
+};
+
+base::LazyInstance<DecoderRegistry> g_decoder_registry(
+    base::LINKER_INITIALIZED);
+
+}  // namespace
+
 FilterContext::~FilterContext() {
 }
 
@@ -49,17 +149,8 @@ Filter::~Filter() {}
 // static
 Filter* Filter::Factory(const std::vector<FilterType>& filter_types,
                         const FilterContext& filter_context) {
-  if (filter_types.empty())
-    return NULL;
-
-  Filter* filter_list = NULL;  // Linked list of filters.
-  for (size_t i = 0; i < filter_types.size(); i++) {
-    filter_list = PrependNewFilter(filter_types[i], filter_context,
-                                   kFilterBufSize, filter_list);
-    if (!filter_list)
-      return NULL;
-  }
-  return filter_list;
+  return CreateChain(filter_types, filter_context, kInitialFilterBufSize,
+                     kMaxFilterBufSize);
 }
 
 // static
@@ -67,17 +158,38 @@ Filter* Filter::GZipFactory() {
   return InitGZipFilter(FILTER_TYPE_GZIP, kFilterBufSize);
 }
 
+// static
+Filter::DecoderFactory* Filter::RegisterDecoderFactory(
+    const std::string& encoding,
+    DecoderFactory* factory) {
+  DCHECK_EQ(FILTER_TYPE_UNSUPPORTED, ConvertBuiltinEncodingToType(encoding));
+  return g_decoder_registry.Get().Register(encoding, factory);
+}
+
+// static
+void Filter::AppendRegisteredEncodings(std::string* encodings) {
+  g_decoder_registry.Get().AppendEncodings(encodings);
+}
+
 // static
 Filter* Filter::FactoryForTests(const std::vector<FilterType>& filter_types,
                                 const FilterContext& filter_context,
                                 int buffer_size) {
+  return CreateChain(filter_types, filter_context, buffer_size, buffer_size);
+}
+
+// static
+Filter* Filter::CreateChain(const std::vector<FilterType>& filter_types,
+                            const FilterContext& filter_context,
+                            int buffer_size,
+                            int max_buffer_size) {
   if (filter_types.empty())
     return NULL;
 
   Filter* filter_list = NULL;  // Linked list of filters.
   for (size_t i = 0; i < filter_types.size(); i++) {
     filter_list = PrependNewFilter(filter_types[i], filter_context,
-                                   buffer_size, filter_list);
+                                   buffer_size, max_buffer_size, filter_list);
     if (!filter_list)
       return NULL;
   }
@@ -85,16 +197,27 @@ Filter* Filter::FactoryForTests(const std::vector<FilterType>& filter_types,
 }
 
 Filter::FilterStatus Filter::ReadData(char* dest_buffer, int* dest_len) {
+  FilterStatus status = ReadChainedData(dest_buffer, dest_len);
+  MaybeGrowBuffer();
+  return status;
+}
+
+Filter::FilterStatus Filter::ReadChainedData(char* dest_buffer, int* dest_len) {
   const int dest_buffer_capacity = *dest_len;
   if (last_status_ == FILTER_ERROR)
     return last_status_;
+  BypassPassThroughFilters();
   if (!next_filter_.get())
     return last_status_ = ReadFilteredData(dest_buffer, dest_len);
   if (last_status_ == FILTER_NEED_MORE_DATA && !stream_data_len())
     return next_filter_->ReadData(dest_buffer, dest_len);
 
   do {
-    if (next_filter_->last_status() == FILTER_NEED_MORE_DATA) {
+    // The next filter's status is only refreshed when it reads, so it may
+    // still say it needs data after we already gave it some.  Don't overwrite
+    // input it hasn't consumed yet.
+    if (next_filter_->last_status() == FILTER_NEED_MORE_DATA &&
+        !next_filter_->stream_data_len()) {
       PushDataIntoNextFilter();
       if (FILTER_ERROR == last_status_)
         return FILTER_ERROR;
@@ -134,25 +257,16 @@ bool Filter::FlushStreamBuffer(int stream_data_len) {
 
   next_stream_data_ = stream_buffer()->data();
   stream_data_len_ = stream_data_len;
+  stream_buffer_filled_ = (stream_data_len == stream_buffer_size_);
   return true;
 }
 
 // static
 Filter::FilterType Filter::ConvertEncodingToType(
     const std::string& filter_type) {
-  FilterType type_id;
-  if (LowerCaseEqualsASCII(filter_type, kDeflate)) {
-    type_id = FILTER_TYPE_DEFLATE;
-  } else if (LowerCaseEqualsASCII(filter_type, kGZip) ||
-             LowerCaseEqualsASCII(filter_type, kXGZip)) {
-    type_id = FILTER_TYPE_GZIP;
-  } else if (LowerCaseEqualsASCII(filter_type, kSdch)) {
-    type_id = FILTER_TYPE_SDCH;
-  } else {
-    // Note we also consider "identity" and "uncompressed" UNSUPPORTED as
-    // filter should be disabled in such cases.
-    type_id = FILTER_TYPE_UNSUPPORTED;
-  }
+  FilterType type_id = ConvertBuiltinEncodingToType(filter_type);
+  if (type_id == FILTER_TYPE_UNSUPPORTED)
+    type_id = g_decoder_registry.Get().GetType(filter_type);
   return type_id;
 }
 
@@ -322,7 +436,14 @@ Filter::Filter()
       next_stream_data_(NULL),
       stream_data_len_(0),
       next_filter_(NULL),
-      last_status_(FILTER_NEED_MORE_DATA) {
+      bypassed_filters_(NULL),
+      last_status_(FILTER_NEED_MORE_DATA),
+      max_stream_buffer_size_(0),
+      stream_buffer_filled_(false) {
+}
+
+bool Filter::IsPassThrough() const {
+  return false;
 }
 
 Filter::FilterStatus Filter::CopyOut(char* dest_buffer, int* dest_len) {
@@ -362,10 +483,24 @@ Filter* Filter::InitSdchFilter(FilterType type_id,
   return sdch_filter->InitDecoding(type_id) ? sdch_filter.release() : NULL;
 }
 
+// static
+Filter* Filter::InitRegisteredFilter(FilterType type_id,
+                                     const FilterContext& filter_context,
+                                     int buffer_size) {
+  DecoderFactory* factory = g_decoder_registry.Get().GetFactory(type_id);
+  if (!factory)
+    return NULL;
+  Filter* filter = factory(filter_context);
+  if (filter)
+    filter->InitBuffer(buffer_size);
+  return filter;
+}
+
 // static
 Filter* Filter::PrependNewFilter(FilterType type_id,
                                  const FilterContext& filter_context,
                                  int buffer_size,
+                                 int max_buffer_size,
                                  Filter* filter_list) {
   scoped_ptr<Filter> first_filter;  // Soon to be start of chain.
   switch (type_id) {
@@ -379,12 +514,21 @@ Filter* Filter::PrependNewFilter(FilterType type_id,
       first_filter.reset(InitSdchFilter(type_id, filter_context, buffer_size));
       break;
     default:
+      if (type_id >= FILTER_TYPE_FIRST_REGISTERED &&
+          type_id <= FILTER_TYPE_LAST_REGISTERED) {
+        first_filter.reset(
+            InitRegisteredFilter(type_id, filter_context, buffer_size));
+      }
       break;
   }
 
-  if (!first_filter.get())
+  if (!first_filter.get()) {
+    delete filter_list;
     return NULL;
+  }
 
+  DCHECK_GE(max_buffer_size, buffer_size);
+  first_filter->max_stream_buffer_size_ = max_buffer_size;
   first_filter->next_filter_.reset(filter_list);
   return first_filter.release();
 }
@@ -394,6 +538,28 @@ void Filter::InitBuffer(int buffer_size) {
   DCHECK_GT(buffer_size, 0);
   stream_buffer_ = new IOBuffer(buffer_size);
   stream_buffer_size_ = buffer_size;
+  max_stream_buffer_size_ = buffer_size;
+}
+
+void Filter::MaybeGrowBuffer() {
+  if (stream_data_len_ || !stream_buffer_filled_ ||
+      stream_buffer_size_ >= max_stream_buffer_size_)
+    return;
+  stream_buffer_size_ = std::min(2 * stream_buffer_size_,
+                                 max_stream_buffer_size_);
+  stream_buffer_ = new IOBuffer(stream_buffer_size_);
+  next_stream_data_ = NULL;
+  stream_buffer_filled_ = false;
+}
+
+void Filter::BypassPassThroughFilters() {
+  while (next_filter_.get() && !next_filter_->stream_data_len() &&
+         next_filter_->IsPassThrough()) {
+    Filter* pass_through = next_filter_.release();
+    next_filter_.reset(pass_through->next_filter_.release());
+    pass_through->next_filter_.reset(bypassed_filters_.release());
+    bypassed_filters_.reset(pass_through);
+  }
 }
 
 void Filter::PushDataIntoNextFilter() {
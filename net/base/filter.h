@@ -126,8 +126,18 @@ class Filter {
     FILTER_TYPE_SDCH,
     FILTER_TYPE_SDCH_POSSIBLE,  // Sdch possible, but pass through allowed.
     FILTER_TYPE_UNSUPPORTED,
+    // Decoders added with RegisterDecoderFactory() are assigned types in this
+    // range, in order of registration.
+    FILTER_TYPE_FIRST_REGISTERED,
+    FILTER_TYPE_LAST_REGISTERED = FILTER_TYPE_FIRST_REGISTERED + 15,
   };
 
+  // A DecoderFactory creates a Filter for a Content-Encoding that is not built
+  // into this class.  The returned filter must not yet have a stream buffer;
+  // the caller allocates it.  Returns NULL if the decoder can't be created,
+  // which causes the whole filter chain to fail.
+  typedef Filter* (DecoderFactory)(const FilterContext& filter_context);
+
   virtual ~Filter();
 
   // Creates a Filter object.
@@ -153,6 +163,17 @@ class Filter {
   // initialized.
   static Filter* GZipFactory();
 
+  // Registers a decoder factory for the given Content-Encoding, which is
+  // matched case insensitively.  The factory parameter may be NULL to remove
+  // an existing registration.  Returns the previously registered factory, if
+  // any.  Registered encodings are advertised in Accept-Encoding (see
+  // AppendRegisteredEncodings) and can't replace the built-in ones.
+  static DecoderFactory* RegisterDecoderFactory(const std::string& encoding,
+                                                DecoderFactory* factory);
+
+  // Appends ",<encoding>" to |encodings| for each registered decoder.
+  static void AppendRegisteredEncodings(std::string* encodings);
+
   // External call to obtain data from this filter chain.  If ther is no
   // next_filter_, then it obtains data from this specific filter.
   FilterStatus ReadData(char* dest_buffer, int* dest_len);
@@ -197,6 +218,7 @@ class Filter {
                                  std::vector<FilterType>* encoding_types);
 
  protected:
+  friend class FilterPerfTest;
   friend class GZipUnitTest;
   friend class SdchFilterChainingTest;
 
@@ -218,6 +240,12 @@ class Filter {
   // Copy pre-filter data directly to destination buffer without decoding.
   FilterStatus CopyOut(char* dest_buffer, int* dest_len);
 
+  // Returns true if this filter has settled on copying its input to its output
+  // unchanged, and holds no output of its own besides stream_buffer_.  Once
+  // such a filter's stream buffer is empty, the filter feeding it writes
+  // straight into the following filter (or the caller's buffer) instead.
+  virtual bool IsPassThrough() const;
+
   FilterStatus last_status() const { return last_status_; }
 
   // Buffer to hold the data to be filtered (the input queue).
@@ -236,6 +264,19 @@ class Filter {
   // Allocates and initializes stream_buffer_ and stream_buffer_size_.
   void InitBuffer(int size);
 
+  // Doubles stream_buffer_, up to max_stream_buffer_size_, if it is empty and
+  // the last FlushStreamBuffer() filled it completely.  Large responses thus
+  // move through the chain in fewer, larger chunks, while small ones never
+  // pay for a large buffer.
+  void MaybeGrowBuffer();
+
+  // Builds a chain for |filter_types| whose buffers start at |buffer_size| and
+  // may grow up to |max_buffer_size|.
+  static Filter* CreateChain(const std::vector<FilterType>& filter_types,
+                             const FilterContext& filter_context,
+                             int buffer_size,
+                             int max_buffer_size);
+
   // A factory helper for creating filters for within a chain of potentially
   // multiple encodings.  If a chain of filters is created, then this may be
   // called multiple times during the filter creation process.  In most simple
@@ -244,6 +285,7 @@ class Filter {
   static Filter* PrependNewFilter(FilterType type_id,
                                   const FilterContext& filter_context,
                                   int buffer_size,
+                                  int max_buffer_size,
                                   Filter* filter_list);
 
   // Helper methods for PrependNewFilter. If initialization is successful,
@@ -252,10 +294,20 @@ class Filter {
   static Filter* InitSdchFilter(FilterType type_id,
                                 const FilterContext& filter_context,
                                 int buffer_size);
+  static Filter* InitRegisteredFilter(FilterType type_id,
+                                      const FilterContext& filter_context,
+                                      int buffer_size);
+
+  // Does the work of ReadData(), before the stream buffer is resized.
+  FilterStatus ReadChainedData(char* dest_buffer, int* dest_len);
 
   // Helper function to empty our output into the next filter's input.
   void PushDataIntoNextFilter();
 
+  // Unlinks drained pass-through filters that follow this one, so that our
+  // output skips the copy they would make.  See IsPassThrough().
+  void BypassPassThroughFilters();
+
   // Constructs a filter with an internal buffer of the given size.
   // Only meant to be called by unit tests that need to control the buffer size.
   static Filter* FactoryForTests(const std::vector<FilterType>& filter_types,
@@ -264,10 +316,21 @@ class Filter {
 
   // An optional filter to process output from this filter.
   scoped_ptr<Filter> next_filter_;
+  // Filters unlinked by BypassPassThroughFilters(), chained through their
+  // next_filter_.  They live as long as the chain so that they report their
+  // statistics at the same time as before.
+  scoped_ptr<Filter> bypassed_filters_;
   // Remember what status or local filter last returned so we can better handle
   // chained filters.
   FilterStatus last_status_;
 
+  // Upper bound for MaybeGrowBuffer().  Equal to stream_buffer_size_ when the
+  // buffer has a fixed size.
+  int max_stream_buffer_size_;
+
+  // True if the last FlushStreamBuffer() used all of stream_buffer_.
+  bool stream_buffer_filled_;
+
   DISALLOW_COPY_AND_ASSIGN(Filter);
 };
 
@@ -0,0 +1,236 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/path_service.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/base/filter.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mock_filter_context.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Total amount of decoded data per benchmark.
+const size_t kDecodedBytesPerRun = 64 * 1024 * 1024;
+
+// The fixed buffer size Filter::Factory() used before buffers became
+// adaptive.
+const int kFixedBufferSize = 32 * 1024;
+
+// Size of the consumer's buffer, as used by URLRequest clients.
+const int kReadBufferSize = 32 * 1024;
+
+const char kPassThroughEncoding[] = "x-perftest-identity";
+
+// Stands in for a registered decoder, so that the cost of the chaining
+// machinery itself shows up in the results.
+class PassThroughFilter : public Filter {
+ public:
+  static Filter* Create(const FilterContext& filter_context) {
+    return new PassThroughFilter;
+  }
+
+ protected:
+  virtual FilterStatus ReadFilteredData(char* dest_buffer, int* dest_len) {
+    return CopyOut(dest_buffer, dest_len);
+  }
+};
+
+// Compresses |input| with zlib, using a gzip wrapper if |gzip| is true and
+// a raw deflate stream otherwise.
+std::string Compress(const std::string& input, bool gzip) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  int window_bits = gzip ? MAX_WBITS + 16 : -MAX_WBITS;
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               window_bits, 8, Z_DEFAULT_STRATEGY));
+  std::string output(deflateBound(&stream, input.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = output.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+  return output;
+}
+
+}  // namespace
+
+class FilterPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    FilePath file_path;
+    PathService::Get(base::DIR_SOURCE_ROOT, &file_path);
+    file_path = file_path.AppendASCII("net")
+                         .AppendASCII("data")
+                         .AppendASCII("filter_unittests")
+                         .AppendASCII("google.txt");
+    ASSERT_TRUE(file_util::ReadFileToString(file_path, &small_page_));
+    // A large page made of the same markup, as compressible as a real one.
+    for (int i = 0; i < 128; ++i)
+      large_page_.append(small_page_);
+    Filter::RegisterDecoderFactory(kPassThroughEncoding,
+                                   &PassThroughFilter::Create);
+  }
+
+  virtual void TearDown() {
+    Filter::RegisterDecoderFactory(kPassThroughEncoding, NULL);
+  }
+
+  // Decodes |encoded| as URLRequestJob does, and returns the number of
+  // decoded bytes.  Adds the size of every stream buffer in the chain, once
+  // the response is done, to |buffer_bytes|.
+  size_t Decode(const std::vector<Filter::FilterType>& types,
+                bool adaptive,
+                const std::string& encoded,
+                char* read_buffer,
+                size_t* buffer_bytes) {
+    scoped_ptr<Filter> filter(adaptive ?
+        Filter::Factory(types, filter_context_) :
+        Filter::FactoryForTests(types, filter_context_, kFixedBufferSize));
+    EXPECT_TRUE(filter.get());
+    if (!filter.get())
+      return 0;
+
+    size_t input_index = 0;
+    size_t decoded = 0;
+    Filter::FilterStatus status = Filter::FILTER_NEED_MORE_DATA;
+    while (status != Filter::FILTER_DONE && status != Filter::FILTER_ERROR) {
+      if (!filter->stream_data_len() && input_index < encoded.size()) {
+        int amount = std::min(filter->stream_buffer_size(),
+                              static_cast<int>(encoded.size() - input_index));
+        memcpy(filter->stream_buffer()->data(), encoded.data() + input_index,
+               amount);
+        filter->FlushStreamBuffer(amount);
+        input_index += amount;
+      }
+      int read_len = kReadBufferSize;
+      status = filter->ReadData(read_buffer, &read_len);
+      decoded += read_len;
+      if (status == Filter::FILTER_NEED_MORE_DATA &&
+          input_index == encoded.size() && !read_len)
+        break;
+    }
+    EXPECT_NE(Filter::FILTER_ERROR, status);
+
+    for (Filter* f = filter.get(); f; f = f->next_filter_.get())
+      *buffer_bytes += f->stream_buffer_size();
+    return decoded;
+  }
+
+  void RunTest(const char* name,
+               const std::string& page,
+               const std::vector<std::string>& encodings) {
+    // Encode in content-coding order, as a server would.
+    std::vector<Filter::FilterType> types;
+    std::string encoded(page);
+    for (size_t i = 0; i < encodings.size(); ++i) {
+      types.push_back(Filter::ConvertEncodingToType(encodings[i]));
+      if (encodings[i] == "gzip")
+        encoded = Compress(encoded, true);
+      else if (encodings[i] == "deflate")
+        encoded = Compress(encoded, false);
+    }
+    RunTest(name, page, types, encoded);
+  }
+
+  // Decodes |encoded| with a chain of |types| and checks that it yields
+  // |page|.
+  void RunTest(const char* name,
+               const std::string& page,
+               const std::vector<Filter::FilterType>& types,
+               const std::string& encoded) {
+    const size_t responses =
+        std::max(static_cast<size_t>(1), kDecodedBytesPerRun / page.size());
+    scoped_array<char> read_buffer(new char[kReadBufferSize]);
+    for (int adaptive = 0; adaptive < 2; ++adaptive) {
+      const std::string test_name = base::StringPrintf("Filter_%s_%s", name,
+          adaptive ? "adaptive" : "fixed");
+      size_t decoded = 0;
+      size_t buffer_bytes = 0;
+      PerfTimer timer;
+      for (size_t i = 0; i < responses; ++i) {
+        decoded += Decode(types, adaptive != 0, encoded, read_buffer.get(),
+                          &buffer_bytes);
+      }
+      base::TimeDelta elapsed = timer.Elapsed();
+      EXPECT_EQ(page.size() * responses, decoded);
+
+      LogPerfResult(test_name.c_str(),
+                    decoded / (1024.0 * 1024.0) / elapsed.InSecondsF(),
+                    "MB/s");
+      LogPerfResult((test_name + "_buffers").c_str(),
+                    static_cast<double>(buffer_bytes) / responses,
+                    "bytes/response");
+    }
+  }
+
+  MockFilterContext filter_context_;
+  std::string small_page_;
+  std::string large_page_;
+};
+
+TEST_F(FilterPerfTest, Gzip) {
+  std::vector<std::string> encodings;
+  encodings.push_back("gzip");
+  RunTest("gzip_small", small_page_, encodings);
+  RunTest("gzip_large", large_page_, encodings);
+}
+
+TEST_F(FilterPerfTest, Deflate) {
+  std::vector<std::string> encodings;
+  encodings.push_back("deflate");
+  RunTest("deflate_small", small_page_, encodings);
+  RunTest("deflate_large", large_page_, encodings);
+}
+
+// A registered decoder chained after gzip, and gzip applied twice, as some
+// proxies do.
+TEST_F(FilterPerfTest, Chained) {
+  std::vector<std::string> encodings;
+  encodings.push_back(kPassThroughEncoding);
+  encodings.push_back("gzip");
+  RunTest("registered_gzip_small", small_page_, encodings);
+  RunTest("registered_gzip_large", large_page_, encodings);
+
+  encodings.clear();
+  encodings.push_back("gzip");
+  encodings.push_back("gzip");
+  RunTest("gzip_gzip_large", large_page_, encodings);
+}
+
+// The chain Filter::FixupEncodingTypes() builds for a gzipped response to a
+// request that advertised an SDCH dictionary.  Both tentative filters fall
+// back to pass through.
+TEST_F(FilterPerfTest, TentativeSdch) {
+  std::vector<Filter::FilterType> types;
+  types.push_back(Filter::FILTER_TYPE_SDCH_POSSIBLE);
+  types.push_back(Filter::FILTER_TYPE_GZIP_HELPING_SDCH);
+  types.push_back(Filter::FILTER_TYPE_GZIP);
+  // Only a 404 lets the tentative SDCH filter pass content through.
+  filter_context_.SetResponseCode(404);
+  RunTest("tentative_sdch_small", small_page_, types,
+          Compress(small_page_, true));
+  RunTest("tentative_sdch_large", large_page_, types,
+          Compress(large_page_, true));
+}
+
+}  // namespace net
@@ -2,12 +2,38 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
 #include "net/base/filter.h"
+#include "net/base/io_buffer.h"
 #include "net/base/mock_filter_context.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace net {
 
+namespace {
+
+// A registered decoder which passes its input through unchanged.
+class PassThroughFilter : public Filter {
+ public:
+  static Filter* Create(const FilterContext& filter_context) {
+    return new PassThroughFilter;
+  }
+
+ protected:
+  virtual FilterStatus ReadFilteredData(char* dest_buffer, int* dest_len) {
+    return CopyOut(dest_buffer, dest_len);
+  }
+};
+
+Filter* FailingFactory(const FilterContext& filter_context) {
+  return NULL;
+}
+
+}  // namespace
+
 class FilterTest : public testing::Test {
 };
 
@@ -347,4 +373,125 @@ TEST(FilterTest, SupportedMimeGzip) {
   EXPECT_TRUE(encoding_types.empty());
 }
 
+TEST(FilterTest, RegisteredDecoder) {
+  EXPECT_EQ(NULL, Filter::RegisterDecoderFactory("x-test",
+                                                 &PassThroughFilter::Create));
+  Filter::FilterType type_id = Filter::ConvertEncodingToType("X-Test");
+  EXPECT_GE(type_id, Filter::FILTER_TYPE_FIRST_REGISTERED);
+  EXPECT_LE(type_id, Filter::FILTER_TYPE_LAST_REGISTERED);
+
+  std::string encodings("gzip,deflate");
+  Filter::AppendRegisteredEncodings(&encodings);
+  EXPECT_EQ("gzip,deflate,x-test", encodings);
+
+  // A registered decoder can be chained after a built-in one.
+  MockFilterContext filter_context;
+  std::vector<Filter::FilterType> encoding_types;
+  encoding_types.push_back(type_id);
+  encoding_types.push_back(Filter::FILTER_TYPE_GZIP_HELPING_SDCH);
+  scoped_ptr<Filter> filter(Filter::Factory(encoding_types, filter_context));
+  ASSERT_TRUE(filter.get());
+
+  const char kData[] = "Plain text that is not gzipped.";
+  const int kDataLen = sizeof(kData) - 1;
+  memcpy(filter->stream_buffer()->data(), kData, kDataLen);
+  EXPECT_TRUE(filter->FlushStreamBuffer(kDataLen));
+  char output[100];
+  int output_len = sizeof(output);
+  EXPECT_NE(Filter::FILTER_ERROR, filter->ReadData(output, &output_len));
+  EXPECT_EQ(std::string(kData, kDataLen), std::string(output, output_len));
+
+  // A factory that fails makes the whole chain fail.
+  EXPECT_EQ(&PassThroughFilter::Create,
+            Filter::RegisterDecoderFactory("x-test", &FailingFactory));
+  EXPECT_EQ(type_id, Filter::ConvertEncodingToType("x-test"));
+  EXPECT_EQ(NULL, Filter::Factory(encoding_types, filter_context));
+
+  // Unregistering keeps the type, but no longer resolves or advertises it.
+  EXPECT_EQ(&FailingFactory, Filter::RegisterDecoderFactory("x-test", NULL));
+  EXPECT_EQ(Filter::FILTER_TYPE_UNSUPPORTED,
+            Filter::ConvertEncodingToType("x-test"));
+  encodings = "gzip";
+  Filter::AppendRegisteredEncodings(&encodings);
+  EXPECT_EQ("gzip", encodings);
+  EXPECT_EQ(NULL, Filter::Factory(encoding_types, filter_context));
+}
+
+// A consumer buffer smaller than the filters' stream buffers leaves data
+// waiting in the middle of a chain, which must not be overwritten.
+TEST(FilterTest, SmallReadsThroughChain) {
+  Filter::RegisterDecoderFactory("x-test", &PassThroughFilter::Create);
+  MockFilterContext filter_context;
+  std::vector<Filter::FilterType> encoding_types(
+      3, Filter::ConvertEncodingToType("x-test"));
+  scoped_ptr<Filter> filter(Filter::Factory(encoding_types, filter_context));
+  ASSERT_TRUE(filter.get());
+
+  std::string input;
+  for (int i = 0; input.size() < 100000; ++i)
+    input.append(1, static_cast<char>('a' + i % 26));
+  std::string output;
+  size_t input_index = 0;
+  char read_buffer[1000];
+  while (true) {
+    if (!filter->stream_data_len() && input_index < input.size()) {
+      int amount = std::min(filter->stream_buffer_size(),
+                            static_cast<int>(input.size() - input_index));
+      memcpy(filter->stream_buffer()->data(), input.data() + input_index,
+             amount);
+      ASSERT_TRUE(filter->FlushStreamBuffer(amount));
+      input_index += amount;
+    }
+    int read_len = sizeof(read_buffer);
+    Filter::FilterStatus status = filter->ReadData(read_buffer, &read_len);
+    ASSERT_NE(Filter::FILTER_ERROR, status);
+    output.append(read_buffer, read_len);
+    if (input_index == input.size() && !read_len &&
+        status == Filter::FILTER_NEED_MORE_DATA)
+      break;
+  }
+  EXPECT_EQ(input, output);
+
+  Filter::RegisterDecoderFactory("x-test", NULL);
+}
+
+// The stream buffer of a filter grows while the caller keeps filling it, but
+// is bounded.
+TEST(FilterTest, StreamBufferGrowsWhenFilled) {
+  Filter::RegisterDecoderFactory("x-test", &PassThroughFilter::Create);
+  MockFilterContext filter_context;
+  std::vector<Filter::FilterType> encoding_types;
+  encoding_types.push_back(Filter::ConvertEncodingToType("x-test"));
+  scoped_ptr<Filter> filter(Filter::Factory(encoding_types, filter_context));
+  ASSERT_TRUE(filter.get());
+
+  const int initial_size = filter->stream_buffer_size();
+  std::string output(1024 * 1024, '\0');
+  int last_size = 0;
+  for (int i = 0; i < 10; ++i) {
+    last_size = filter->stream_buffer_size();
+    memset(filter->stream_buffer()->data(), 'a' + i, last_size);
+    ASSERT_TRUE(filter->FlushStreamBuffer(last_size));
+    int output_len = static_cast<int>(output.size());
+    EXPECT_EQ(Filter::FILTER_NEED_MORE_DATA,
+              filter->ReadData(&output[0], &output_len));
+    ASSERT_EQ(last_size, output_len);
+    EXPECT_EQ(std::string(last_size, 'a' + i), output.substr(0, output_len));
+  }
+  EXPECT_GT(last_size, initial_size);
+  EXPECT_EQ(last_size, filter->stream_buffer_size());
+
+  // Partially filled buffers don't grow.
+  scoped_ptr<Filter> small_filter(
+      Filter::Factory(encoding_types, filter_context));
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(small_filter->FlushStreamBuffer(initial_size - 1));
+    int output_len = static_cast<int>(output.size());
+    small_filter->ReadData(&output[0], &output_len);
+  }
+  EXPECT_EQ(initial_size, small_filter->stream_buffer_size());
+
+  Filter::RegisterDecoderFactory("x-test", NULL);
+}
+
 }  // namespace net
@@ -51,6 +51,10 @@ class GZipFilter : public Filter {
   // but not produce output yet.
   virtual FilterStatus ReadFilteredData(char* dest_buffer, int* dest_len);
 
+  // True once a FILTER_TYPE_GZIP_HELPING_SDCH filter has found that its input
+  // is not gzipped, and copies it through.
+  virtual bool IsPassThrough() const;
+
  private:
   enum DecodingStatus {
     DECODING_UNINITIALIZED,
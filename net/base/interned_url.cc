@@ -0,0 +1,86 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/interned_url.h"
+
+#include "base/lazy_instance.h"
+
+namespace net {
+
+namespace {
+
+// Don't bother trimming pools smaller than this.
+const size_t kMinTrimSize = 64;
+
+base::LazyInstance<InternedURLPool> g_interned_url_pool(
+    base::LINKER_INITIALIZED);
+
+}  // namespace
+
+InternedURL::InternedURL(const GURLView& url) : url_(url.ToGURL()) {
+}
+
+InternedURL::~InternedURL() {
+}
+
+InternedURLPool::InternedURLPool() : size_after_trim_(0) {
+}
+
+InternedURLPool::~InternedURLPool() {
+}
+
+// static
+InternedURLPool* InternedURLPool::GetInstance() {
+  return g_interned_url_pool.Pointer();
+}
+
+scoped_refptr<InternedURL> InternedURLPool::Intern(const GURLView& url) {
+  base::AutoLock lock(lock_);
+
+  URLMap::iterator it = urls_.find(url.possibly_invalid_spec());
+  if (it != urls_.end())
+    return it->second;
+
+  if (urls_.size() >= kMinTrimSize && urls_.size() >= 2 * size_after_trim_)
+    TrimLocked();
+
+  scoped_refptr<InternedURL> interned(new InternedURL(url));
+  const std::string& spec = interned->url().possibly_invalid_spec();
+  urls_.insert(std::make_pair(base::StringPiece(spec), interned));
+  return interned;
+}
+
+scoped_refptr<InternedURL> InternedURLPool::Find(const GURLView& url) const {
+  base::AutoLock lock(lock_);
+  URLMap::const_iterator it = urls_.find(url.possibly_invalid_spec());
+  if (it == urls_.end())
+    return NULL;
+  return it->second;
+}
+
+void InternedURLPool::Trim() {
+  base::AutoLock lock(lock_);
+  TrimLocked();
+}
+
+size_t InternedURLPool::size() const {
+  base::AutoLock lock(lock_);
+  return urls_.size();
+}
+
+void InternedURLPool::TrimLocked() {
+  lock_.AssertAcquired();
+  // A URL can only gain references from someone who already holds one, or
+  // through Intern(), which needs |lock_|. So a URL that only the pool
+  // references can't gain one while we're looking.
+  for (URLMap::iterator it = urls_.begin(); it != urls_.end();) {
+    if (it->second->HasOneRef())
+      urls_.erase(it++);
+    else
+      ++it;
+  }
+  size_after_trim_ = urls_.size();
+}
+
+}  // namespace net
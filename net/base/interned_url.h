@@ -0,0 +1,94 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_INTERNED_URL_H_
+#define NET_BASE_INTERNED_URL_H_
+#pragma once
+
+#include <map>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/string_piece.h"
+#include "base/synchronization/lock.h"
+#include "googleurl/src/gurl.h"
+#include "googleurl/src/gurl_view.h"
+
+namespace base {
+template <typename T>
+struct DefaultLazyInstanceTraits;
+}  // namespace base
+
+namespace net {
+
+// An immutable, ref-counted URL handed out by an InternedURLPool. Everyone who
+// interns the same URL gets the same InternedURL, and so shares a single copy
+// of its spec.
+class InternedURL : public base::RefCountedThreadSafe<InternedURL> {
+ public:
+  const GURL& url() const { return url_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<InternedURL>;
+  friend class InternedURLPool;
+
+  explicit InternedURL(const GURLView& url);
+  ~InternedURL();
+
+  const GURL url_;
+
+  DISALLOW_COPY_AND_ASSIGN(InternedURL);
+};
+
+// Interns URLs, so that places which keep many copies of the same few URLs can
+// share one buffer per URL instead of each owning a copy. Intern() only
+// allocates the first time it sees a URL; looking up a URL that is already in
+// the pool is done with a GURLView and copies nothing. This class is
+// thread-safe.
+//
+// The pool holds a reference to every URL in it. Trim() drops the ones that
+// nobody else references any more, and Intern() calls it whenever the pool has
+// doubled in size since it was last trimmed, so the pool stays proportional to
+// the number of URLs in use.
+class InternedURLPool {
+ public:
+  InternedURLPool();
+  ~InternedURLPool();
+
+  // Returns the process-wide pool.
+  static InternedURLPool* GetInstance();
+
+  // Returns the pooled copy of |url|, adding one if there isn't one yet.
+  scoped_refptr<InternedURL> Intern(const GURLView& url);
+
+  // Returns the pooled copy of |url|, or NULL if there isn't one. Unlike
+  // Intern(), this never allocates.
+  scoped_refptr<InternedURL> Find(const GURLView& url) const;
+
+  // Drops the URLs that are only referenced by the pool.
+  void Trim();
+
+  // Returns the number of URLs in the pool, including ones Trim() would drop.
+  size_t size() const;
+
+ private:
+  friend struct base::DefaultLazyInstanceTraits<InternedURLPool>;
+
+  // The keys point into the spec of the InternedURL they map to.
+  typedef std::map<base::StringPiece, scoped_refptr<InternedURL> > URLMap;
+
+  void TrimLocked();
+
+  mutable base::Lock lock_;
+  URLMap urls_;
+
+  // The size of |urls_| after the last trim.
+  size_t size_after_trim_;
+
+  DISALLOW_COPY_AND_ASSIGN(InternedURLPool);
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_INTERNED_URL_H_
@@ -0,0 +1,186 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdlib.h>
+
+#include <new>
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "googleurl/src/gurl.h"
+#include "googleurl/src/gurl_view.h"
+#include "googleurl/src/url_canon.h"
+#include "googleurl/src/url_util.h"
+#include "net/base/interned_url.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+// Count the heap allocations and the bytes in use, so that the tests below can
+// report what each way of holding URLs costs. Every block is prefixed with its
+// size so that it can be subtracted again when the block is freed.
+
+namespace {
+
+const size_t kHeaderSize = 16;
+
+base::subtle::Atomic32 g_allocation_count = 0;
+base::subtle::Atomic32 g_bytes_in_use = 0;
+
+void* CountedAlloc(size_t size) {
+  char* block = static_cast<char*>(malloc(size + kHeaderSize));
+  if (!block)
+    abort();
+  *reinterpret_cast<size_t*>(block) = size;
+  base::subtle::NoBarrier_AtomicIncrement(&g_allocation_count, 1);
+  base::subtle::NoBarrier_AtomicIncrement(&g_bytes_in_use,
+                                          static_cast<int>(size));
+  return block + kHeaderSize;
+}
+
+void CountedFree(void* ptr) {
+  if (!ptr)
+    return;
+  char* block = static_cast<char*>(ptr) - kHeaderSize;
+  base::subtle::NoBarrier_AtomicIncrement(
+      &g_bytes_in_use, -static_cast<int>(*reinterpret_cast<size_t*>(block)));
+  free(block);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+  return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) throw() {
+  CountedFree(ptr);
+}
+
+void operator delete[](void* ptr) throw() {
+  CountedFree(ptr);
+}
+
+namespace net {
+
+namespace {
+
+// The number of distinct URLs, and how many references to each are held. This
+// roughly models the net stack keeping a URL in the request, the transaction,
+// the cache key and a few more places while a page loads.
+const int kDistinctURLs = 500;
+const int kReferencesPerURL = 20;
+
+class InternedURLPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    for (int i = 0; i < kDistinctURLs; ++i) {
+      specs_.push_back(base::StringPrintf(
+          "http://www.example%d.com/static/images/2011/04/photo_%06d.jpg"
+          "?size=large&session=0123456789abcdef", i % 20, i));
+      urls_.push_back(GURL(specs_.back()));
+    }
+  }
+
+  // Logs the allocations made, the memory retained and the time taken
+  // between its construction and the call to Log().
+  class Counter {
+   public:
+    explicit Counter(const char* name)
+        : name_(name),
+          allocations_(base::subtle::NoBarrier_Load(&g_allocation_count)),
+          bytes_(base::subtle::NoBarrier_Load(&g_bytes_in_use)) {
+    }
+
+    void Log() {
+      base::TimeDelta elapsed = timer_.Elapsed();
+      int allocations =
+          base::subtle::NoBarrier_Load(&g_allocation_count) - allocations_;
+      int bytes = base::subtle::NoBarrier_Load(&g_bytes_in_use) - bytes_;
+      LogPerfResult(base::StringPrintf("%s_allocations", name_).c_str(),
+                    allocations, "allocs");
+      LogPerfResult(base::StringPrintf("%s_retained", name_).c_str(),
+                    bytes / 1024.0, "KB");
+      LogPerfResult(base::StringPrintf("%s_time", name_).c_str(),
+                    elapsed.InMillisecondsF(), "ms");
+    }
+
+   private:
+    const char* name_;
+    int allocations_;
+    int bytes_;
+    PerfTimer timer_;
+  };
+
+  std::vector<std::string> specs_;
+  std::vector<GURL> urls_;
+};
+
+// Every holder keeps its own copy of the GURL.
+TEST_F(InternedURLPerfTest, CopiedGURLs) {
+  std::vector<GURL> held;
+  held.reserve(kDistinctURLs * kReferencesPerURL);
+  Counter counter("URL_copies");
+  for (int i = 0; i < kReferencesPerURL; ++i) {
+    for (int j = 0; j < kDistinctURLs; ++j)
+      held.push_back(urls_[j]);
+  }
+  counter.Log();
+}
+
+// Every holder keeps a reference to the pooled copy.
+TEST_F(InternedURLPerfTest, InternedURLs) {
+  InternedURLPool pool;
+  std::vector<scoped_refptr<InternedURL> > held;
+  held.reserve(kDistinctURLs * kReferencesPerURL);
+  Counter counter("URL_interned");
+  for (int i = 0; i < kReferencesPerURL; ++i) {
+    for (int j = 0; j < kDistinctURLs; ++j)
+      held.push_back(pool.Intern(urls_[j]));
+  }
+  counter.Log();
+}
+
+// URLs arrive as strings. Building a GURL for each allocates its spec even
+// when an equal URL is already held, while canonicalizing onto the stack and
+// interning through a GURLView only allocates for new URLs.
+TEST_F(InternedURLPerfTest, ParsedGURLs) {
+  std::vector<GURL> held;
+  held.reserve(kDistinctURLs * kReferencesPerURL);
+  Counter counter("URL_parsed_copies");
+  for (int i = 0; i < kReferencesPerURL; ++i) {
+    for (int j = 0; j < kDistinctURLs; ++j)
+      held.push_back(GURL(specs_[j]));
+  }
+  counter.Log();
+}
+
+TEST_F(InternedURLPerfTest, ParsedInternedURLs) {
+  InternedURLPool pool;
+  std::vector<scoped_refptr<InternedURL> > held;
+  held.reserve(kDistinctURLs * kReferencesPerURL);
+  Counter counter("URL_parsed_interned");
+  for (int i = 0; i < kReferencesPerURL; ++i) {
+    for (int j = 0; j < kDistinctURLs; ++j) {
+      url_canon::RawCanonOutputT<char, 256> output;
+      url_parse::Parsed parsed;
+      bool is_valid = url_util::Canonicalize(
+          specs_[j].data(), static_cast<int>(specs_[j].length()), NULL,
+          &output, &parsed);
+      held.push_back(pool.Intern(
+          GURLView(output.data(), output.length(), parsed, is_valid)));
+    }
+  }
+  counter.Log();
+  EXPECT_EQ(urls_[0], held[0]->url());
+}
+
+}  // namespace
+
+}  // namespace net
@@ -0,0 +1,97 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/interned_url.h"
+
+#include <vector>
+
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+TEST(InternedURLPoolTest, SharesEqualURLs) {
+  InternedURLPool pool;
+  GURL url1("http://www.google.com/search?q=foo");
+  GURL url2("http://www.google.com/search?q=foo");
+  GURL other("http://www.google.com/search?q=bar");
+
+  scoped_refptr<InternedURL> interned1 = pool.Intern(url1);
+  scoped_refptr<InternedURL> interned2 = pool.Intern(url2);
+  scoped_refptr<InternedURL> interned_other = pool.Intern(other);
+
+  EXPECT_EQ(interned1.get(), interned2.get());
+  EXPECT_NE(interned1.get(), interned_other.get());
+  EXPECT_EQ(url1, interned1->url());
+  EXPECT_EQ(other, interned_other->url());
+  EXPECT_EQ(2u, pool.size());
+
+  // The interned copy doesn't refer to the URL it was made from.
+  EXPECT_NE(url1.spec().data(), interned1->url().spec().data());
+}
+
+TEST(InternedURLPoolTest, Find) {
+  InternedURLPool pool;
+  GURL url("http://www.google.com/");
+  EXPECT_FALSE(pool.Find(url).get());
+  EXPECT_EQ(0u, pool.size());
+
+  scoped_refptr<InternedURL> interned = pool.Intern(url);
+  EXPECT_EQ(interned.get(), pool.Find(GURL("http://www.google.com/")).get());
+  EXPECT_FALSE(pool.Find(GURL("http://www.google.com/a")).get());
+  EXPECT_EQ(1u, pool.size());
+}
+
+TEST(InternedURLPoolTest, InvalidURLs) {
+  InternedURLPool pool;
+  GURL invalid("http://");
+  scoped_refptr<InternedURL> interned = pool.Intern(invalid);
+  EXPECT_FALSE(interned->url().is_valid());
+  EXPECT_EQ(invalid.possibly_invalid_spec(),
+            interned->url().possibly_invalid_spec());
+
+  scoped_refptr<InternedURL> empty = pool.Intern(GURL());
+  EXPECT_TRUE(empty->url().is_empty());
+  EXPECT_EQ(empty.get(), pool.Intern(GURLView()).get());
+}
+
+TEST(InternedURLPoolTest, TrimDropsUnreferencedURLs) {
+  InternedURLPool pool;
+  scoped_refptr<InternedURL> kept = pool.Intern(GURL("http://a.com/"));
+  pool.Intern(GURL("http://b.com/"));
+  EXPECT_EQ(2u, pool.size());
+
+  pool.Trim();
+  EXPECT_EQ(1u, pool.size());
+  EXPECT_EQ(kept.get(), pool.Intern(GURL("http://a.com/")).get());
+
+  // Once released, the URL can be interned again.
+  kept = NULL;
+  pool.Trim();
+  EXPECT_EQ(0u, pool.size());
+  EXPECT_EQ("http://a.com/", pool.Intern(GURL("http://a.com/"))->url().spec());
+}
+
+// The pool should trim itself rather than growing with every URL it has seen.
+TEST(InternedURLPoolTest, TrimsAutomatically) {
+  InternedURLPool pool;
+  std::vector<scoped_refptr<InternedURL> > kept;
+  for (int i = 0; i < 1000; ++i) {
+    GURL url(base::StringPrintf("http://www.example.com/%d", i));
+    scoped_refptr<InternedURL> interned = pool.Intern(url);
+    if (i % 10 == 0)
+      kept.push_back(interned);
+  }
+  EXPECT_LT(pool.size(), 400u);
+
+  // The URLs that are still referenced must have survived.
+  for (size_t i = 0; i < kept.size(); ++i)
+    EXPECT_EQ(kept[i].get(), pool.Intern(kept[i]->url()).get());
+}
+
+}  // namespace
+
+}  // namespace net
@@ -0,0 +1,191 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/sdch_dictionary_disk_store.h"
+
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop_proxy.h"
+#include "base/pickle.h"
+#include "base/task.h"
+
+namespace net {
+
+namespace {
+
+// Bump this when the layout of the pickled file changes; files with any other
+// version are discarded.
+const int kFormatVersion = 1;
+
+void WriteDictionaryFile(const FilePath& directory,
+                         const FilePath& path,
+                         const std::string& data) {
+  if (!file_util::PathExists(directory) &&
+      !file_util::CreateDirectory(directory)) {
+    return;
+  }
+  int size = static_cast<int>(data.size());
+  if (file_util::WriteFile(path, data.data(), size) != size) {
+    LOG(WARNING) << "Failed to save SDCH dictionary " << path.value();
+    file_util::Delete(path, false);
+  }
+}
+
+// Deletes |path|, which is a dictionary file or the whole directory.
+void DeleteDictionaryPath(const FilePath& path, bool recursive) {
+  if (!file_util::Delete(path, recursive))
+    LOG(WARNING) << "Failed to delete SDCH dictionaries at " << path.value();
+}
+
+// Returns false if |data| is not a dictionary we can use.
+bool ParseDictionaryFile(const std::string& data,
+                         SdchDictionaryStore::Entry* entry) {
+  Pickle pickle(data.data(), static_cast<int>(data.size()));
+  void* iter = NULL;
+  int version;
+  std::string url_spec;
+  int64 expiration;
+  if (!pickle.ReadInt(&iter, &version) || version != kFormatVersion ||
+      !pickle.ReadString(&iter, &url_spec) ||
+      !pickle.ReadInt64(&iter, &expiration) ||
+      !pickle.ReadString(&iter, &entry->text)) {
+    return false;
+  }
+  entry->url = GURL(url_spec);
+  entry->expiration = base::Time::FromInternalValue(expiration);
+  return entry->url.is_valid() && base::Time::Now() <= entry->expiration;
+}
+
+// Appends the usable dictionaries in |directory| to |dictionaries|, and
+// deletes the other files.
+void ReadDictionaries(const FilePath& directory,
+                      std::vector<SdchDictionaryStore::Entry>* dictionaries) {
+  file_util::FileEnumerator enumerator(directory, false,
+                                       file_util::FileEnumerator::FILES);
+  for (FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    std::string data;
+    SdchDictionaryStore::Entry entry;
+    if (!file_util::ReadFileToString(path, &data) ||
+        !ParseDictionaryFile(data, &entry)) {
+      file_util::Delete(path, false);
+      continue;
+    }
+    dictionaries->push_back(entry);
+  }
+}
+
+// Runs the callback of Load() with the dictionaries read on the file thread.
+class LoadReplyTask : public Task {
+ public:
+  LoadReplyTask(SdchDictionaryStore::LoadCallback* callback,
+                const std::vector<SdchDictionaryStore::Entry>& dictionaries)
+      : callback_(callback),
+        dictionaries_(dictionaries) {
+  }
+
+  virtual void Run() {
+    callback_->Run(dictionaries_);
+  }
+
+ private:
+  scoped_ptr<SdchDictionaryStore::LoadCallback> callback_;
+  const std::vector<SdchDictionaryStore::Entry> dictionaries_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadReplyTask);
+};
+
+// Reads the dictionaries on the file thread, and posts them back to the
+// thread that called Load().
+class LoadTask : public Task {
+ public:
+  LoadTask(const FilePath& directory,
+           base::MessageLoopProxy* reply_loop,
+           SdchDictionaryStore::LoadCallback* callback)
+      : directory_(directory),
+        reply_loop_(reply_loop),
+        callback_(callback) {
+  }
+
+  virtual void Run() {
+    std::vector<SdchDictionaryStore::Entry> dictionaries;
+    ReadDictionaries(directory_, &dictionaries);
+    reply_loop_->PostTask(FROM_HERE,
+                          new LoadReplyTask(callback_.release(), dictionaries));
+  }
+
+ private:
+  const FilePath directory_;
+  scoped_refptr<base::MessageLoopProxy> reply_loop_;
+  scoped_ptr<SdchDictionaryStore::LoadCallback> callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadTask);
+};
+
+}  // namespace
+
+SdchDictionaryDiskStore::SdchDictionaryDiskStore(
+    const FilePath& directory,
+    base::MessageLoopProxy* file_loop)
+    : directory_(directory),
+      file_loop_(file_loop) {
+}
+
+SdchDictionaryDiskStore::~SdchDictionaryDiskStore() {
+}
+
+void SdchDictionaryDiskStore::Load(LoadCallback* callback) {
+  // Posted to the same loop as the writes, so it reads what they wrote.
+  if (file_loop_) {
+    file_loop_->PostTask(FROM_HERE, new LoadTask(
+        directory_, base::MessageLoopProxy::CreateForCurrentThread(),
+        callback));
+  } else {
+    std::vector<Entry> dictionaries;
+    ReadDictionaries(directory_, &dictionaries);
+    LoadReplyTask(callback, dictionaries).Run();
+  }
+}
+
+void SdchDictionaryDiskStore::Save(const std::string& server_hash,
+                                   const Entry& dictionary) {
+  Pickle pickle;
+  pickle.WriteInt(kFormatVersion);
+  pickle.WriteString(dictionary.url.spec());
+  pickle.WriteInt64(dictionary.expiration.ToInternalValue());
+  pickle.WriteString(dictionary.text);
+  const std::string data(static_cast<const char*>(pickle.data()),
+                         pickle.size());
+
+  // Server hashes are URL safe base64, so they are also safe file names.
+  const FilePath path(directory_.AppendASCII(server_hash));
+  if (file_loop_) {
+    file_loop_->PostTask(FROM_HERE, NewRunnableFunction(
+        &WriteDictionaryFile, directory_, path, data));
+  } else {
+    WriteDictionaryFile(directory_, path, data);
+  }
+}
+
+void SdchDictionaryDiskStore::Remove(const std::string& server_hash) {
+  DeletePath(directory_.AppendASCII(server_hash), false);
+}
+
+void SdchDictionaryDiskStore::Clear() {
+  DeletePath(directory_, true);
+}
+
+void SdchDictionaryDiskStore::DeletePath(const FilePath& path,
+                                         bool recursive) {
+  // Posted to the same loop as the writes, so it can't overtake them.
+  if (file_loop_) {
+    file_loop_->PostTask(FROM_HERE, NewRunnableFunction(
+        &DeleteDictionaryPath, path, recursive));
+  } else {
+    DeleteDictionaryPath(path, recursive);
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,55 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// An SdchDictionaryStore that keeps each SDCH dictionary in its own file, so
+// that dictionaries fetched in one session can be used by the next one.
+
+#ifndef NET_BASE_SDCH_DICTIONARY_DISK_STORE_H_
+#define NET_BASE_SDCH_DICTIONARY_DISK_STORE_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "net/base/sdch_manager.h"
+
+namespace base {
+class MessageLoopProxy;
+}
+
+namespace net {
+
+// Each dictionary is stored in |directory| in a file named after its server
+// hash, as a Pickle of a format version, the dictionary URL, its expiration
+// time and the dictionary text.  Load() reads the directory, and deletes
+// expired or unreadable files.  Load(), Save(), Remove() and Clear() touch the
+// disk on |file_loop| if one was supplied, so that neither the IO thread nor
+// startup waits on it, and synchronously otherwise.
+class SdchDictionaryDiskStore : public SdchDictionaryStore {
+ public:
+  SdchDictionaryDiskStore(const FilePath& directory,
+                          base::MessageLoopProxy* file_loop);
+  virtual ~SdchDictionaryDiskStore();
+
+  // SdchDictionaryStore implementation.
+  virtual void Load(LoadCallback* callback);
+  virtual void Save(const std::string& server_hash, const Entry& dictionary);
+  virtual void Remove(const std::string& server_hash);
+  virtual void Clear();
+
+ private:
+  // Deletes |path| on |file_loop_|, or now if there is none.
+  void DeletePath(const FilePath& path, bool recursive);
+
+  const FilePath directory_;
+  scoped_refptr<base::MessageLoopProxy> file_loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(SdchDictionaryDiskStore);
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_SDCH_DICTIONARY_DISK_STORE_H_
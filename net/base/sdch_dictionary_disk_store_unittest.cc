@@ -0,0 +1,224 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/sdch_dictionary_disk_store.h"
+
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/memory/scoped_temp_dir.h"
+#include "base/message_loop.h"
+#include "base/message_loop_proxy.h"
+#include "base/string_number_conversions.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/sdch_manager.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const char kDictionaryText[] = "Domain: sdch.example.com\n\nSdchDictionary";
+const char kDictionaryUrl[] = "http://sdch.example.com/dictionary";
+const char kTargetUrl[] = "http://sdch.example.com/page.html";
+
+void PostQuitTask(scoped_refptr<base::MessageLoopProxy> loop) {
+  loop->PostTask(FROM_HERE, new MessageLoop::QuitTask);
+}
+
+}  // namespace
+
+class SdchDictionaryDiskStoreTest : public testing::Test {
+ public:
+  // Keeps the dictionaries handed to a Load() callback in |loaded_|.
+  void OnLoaded(const std::vector<SdchDictionaryStore::Entry>& dictionaries) {
+    loaded_ = dictionaries;
+  }
+
+ protected:
+  virtual void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    directory_ = temp_dir_.path().AppendASCII("sdch");
+  }
+
+  // Returns the number of files in |directory_|.
+  int CountFiles() {
+    file_util::FileEnumerator enumerator(directory_, false,
+                                         file_util::FileEnumerator::FILES);
+    int count = 0;
+    while (!enumerator.Next().empty())
+      ++count;
+    return count;
+  }
+
+  ScopedTempDir temp_dir_;
+  FilePath directory_;
+  std::vector<SdchDictionaryStore::Entry> loaded_;
+};
+
+TEST_F(SdchDictionaryDiskStoreTest, RestoredAcrossManagers) {
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(kDictionaryText, &client_hash, &server_hash);
+
+  {
+    SdchManager manager;
+    manager.EnableSdchSupport("");
+    manager.SetSdchDictionaryStore(
+        new SdchDictionaryDiskStore(directory_, NULL));
+    EXPECT_TRUE(manager.AddSdchDictionary(kDictionaryText,
+                                          GURL(kDictionaryUrl)));
+  }
+  EXPECT_TRUE(file_util::PathExists(directory_.AppendASCII(server_hash)));
+
+  SdchManager manager;
+  manager.EnableSdchSupport("");
+  manager.SetSdchDictionaryStore(new SdchDictionaryDiskStore(directory_, NULL));
+  SdchManager::Dictionary* dictionary = NULL;
+  manager.GetVcdiffDictionary(server_hash, GURL(kTargetUrl), &dictionary);
+  ASSERT_TRUE(dictionary != NULL);
+  EXPECT_EQ("SdchDictionary", dictionary->text());
+
+  std::string list;
+  manager.GetAvailDictionaryList(GURL(kTargetUrl), &list);
+  EXPECT_EQ(client_hash, list);
+}
+
+// With a file loop, the dictionaries are read there, and added to the manager
+// on the thread that registered the store.
+TEST_F(SdchDictionaryDiskStoreTest, LoadsOnFileThread) {
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(kDictionaryText, &client_hash, &server_hash);
+  SdchDictionaryStore::Entry entry;
+  entry.text = kDictionaryText;
+  entry.url = GURL(kDictionaryUrl);
+  entry.expiration = base::Time::Now() + base::TimeDelta::FromDays(1);
+  SdchDictionaryDiskStore(directory_, NULL).Save(server_hash, entry);
+
+  MessageLoop loop;
+  base::Thread file_thread("SdchFileThread");
+  ASSERT_TRUE(file_thread.Start());
+  SdchManager manager;
+  manager.EnableSdchSupport("");
+  manager.SetSdchDictionaryStore(new SdchDictionaryDiskStore(
+      directory_, file_thread.message_loop_proxy()));
+  SdchManager::Dictionary* dictionary = NULL;
+  manager.GetVcdiffDictionary(server_hash, GURL(kTargetUrl), &dictionary);
+  EXPECT_TRUE(dictionary == NULL);
+
+  // Quits once the file thread has posted the dictionaries back.
+  file_thread.message_loop()->PostTask(FROM_HERE, NewRunnableFunction(
+      &PostQuitTask, base::MessageLoopProxy::CreateForCurrentThread()));
+  loop.Run();
+  manager.GetVcdiffDictionary(server_hash, GURL(kTargetUrl), &dictionary);
+  ASSERT_TRUE(dictionary != NULL);
+  EXPECT_EQ("SdchDictionary", dictionary->text());
+}
+
+TEST_F(SdchDictionaryDiskStoreTest, LoadDiscardsBadAndExpiredFiles) {
+  SdchDictionaryDiskStore store(directory_, NULL);
+
+  SdchDictionaryStore::Entry expired;
+  expired.text = kDictionaryText;
+  expired.url = GURL(kDictionaryUrl);
+  expired.expiration = base::Time::Now() - base::TimeDelta::FromDays(1);
+  store.Save("expired_", expired);
+
+  SdchDictionaryStore::Entry current(expired);
+  current.expiration = base::Time::Now() + base::TimeDelta::FromDays(1);
+  store.Save("current_", current);
+
+  const FilePath garbage(directory_.AppendASCII("garbage_"));
+  ASSERT_EQ(4, file_util::WriteFile(garbage, "junk", 4));
+
+  store.Load(NewCallback(static_cast<SdchDictionaryDiskStoreTest*>(this),
+                         &SdchDictionaryDiskStoreTest::OnLoaded));
+  ASSERT_EQ(1u, loaded_.size());
+  EXPECT_EQ(kDictionaryText, loaded_[0].text);
+  EXPECT_EQ(GURL(kDictionaryUrl), loaded_[0].url);
+  EXPECT_EQ(current.expiration, loaded_[0].expiration);
+
+  EXPECT_FALSE(file_util::PathExists(directory_.AppendASCII("expired_")));
+  EXPECT_FALSE(file_util::PathExists(garbage));
+  EXPECT_TRUE(file_util::PathExists(directory_.AppendASCII("current_")));
+}
+
+TEST_F(SdchDictionaryDiskStoreTest, RemoveAndClear) {
+  SdchDictionaryDiskStore store(directory_, NULL);
+  SdchDictionaryStore::Entry entry;
+  entry.text = kDictionaryText;
+  entry.url = GURL(kDictionaryUrl);
+  entry.expiration = base::Time::Now() + base::TimeDelta::FromDays(1);
+  store.Save("first_", entry);
+  store.Save("second", entry);
+  store.Save("third_", entry);
+
+  store.Remove("second");
+  store.Remove("missing");
+  EXPECT_FALSE(file_util::PathExists(directory_.AppendASCII("second")));
+  EXPECT_EQ(2, CountFiles());
+
+  store.Clear();
+  EXPECT_FALSE(file_util::PathExists(directory_));
+  loaded_.push_back(entry);
+  store.Load(NewCallback(static_cast<SdchDictionaryDiskStoreTest*>(this),
+                         &SdchDictionaryDiskStoreTest::OnLoaded));
+  EXPECT_TRUE(loaded_.empty());
+}
+
+TEST_F(SdchDictionaryDiskStoreTest, ManagerDeletesUnusedDictionaries) {
+  // A saved dictionary the manager rejects, since its domain doesn't match
+  // the URL it came from.
+  const std::string rejected_text("Domain: other.example.com\n\nOther");
+  std::string client_hash;
+  std::string rejected_hash;
+  SdchManager::GenerateHash(rejected_text, &client_hash, &rejected_hash);
+  SdchDictionaryStore::Entry rejected;
+  rejected.text = rejected_text;
+  rejected.url = GURL(kDictionaryUrl);
+  rejected.expiration = base::Time::Now() + base::TimeDelta::FromDays(1);
+  SdchDictionaryDiskStore(directory_, NULL).Save(rejected_hash, rejected);
+
+  SdchManager manager;
+  manager.EnableSdchSupport("");
+  manager.SetSdchDictionaryStore(new SdchDictionaryDiskStore(directory_, NULL));
+  EXPECT_FALSE(file_util::PathExists(directory_.AppendASCII(rejected_hash)));
+
+  EXPECT_TRUE(manager.AddSdchDictionary(kDictionaryText, GURL(kDictionaryUrl)));
+  EXPECT_EQ(1, CountFiles());
+
+  // Clearing browsing data forgets the dictionary and deletes its file.
+  manager.ClearData();
+  EXPECT_EQ(0, CountFiles());
+  std::string server_hash;
+  SdchManager::GenerateHash(kDictionaryText, &client_hash, &server_hash);
+  SdchManager::Dictionary* dictionary = NULL;
+  manager.GetVcdiffDictionary(server_hash, GURL(kTargetUrl), &dictionary);
+  EXPECT_TRUE(dictionary == NULL);
+}
+
+TEST_F(SdchDictionaryDiskStoreTest, ManagerEvictsExpiredDictionaries) {
+  SdchManager manager;
+  manager.EnableSdchSupport("");
+  manager.SetSdchDictionaryStore(new SdchDictionaryDiskStore(directory_, NULL));
+
+  // Fill the manager with dictionaries that expire right away.
+  for (size_t i = 0; i < SdchManager::kMaxDictionaryCount; ++i) {
+    std::string text("Domain: sdch.example.com\nMax-Age: 0\n\n");
+    text.append(base::Uint64ToString(i));
+    EXPECT_TRUE(manager.AddSdchDictionary(text, GURL(kDictionaryUrl)));
+  }
+  EXPECT_EQ(static_cast<int>(SdchManager::kMaxDictionaryCount), CountFiles());
+  base::PlatformThread::Sleep(10);
+
+  // Adding one more evicts them, and deletes their files.
+  EXPECT_TRUE(manager.AddSdchDictionary(kDictionaryText, GURL(kDictionaryUrl)));
+  EXPECT_EQ(1, CountFiles());
+}
+
+}  // namespace net
@@ -42,6 +42,10 @@ class SdchFilter : public Filter {
   // written into the destination buffer.
   virtual FilterStatus ReadFilteredData(char* dest_buffer, int* dest_len);
 
+  // True once the filter has decided to pass its input through undecoded,
+  // and has output the bytes it buffered while deciding.
+  virtual bool IsPassThrough() const;
+
  private:
   // Internal status.  Once we enter an error state, we stop processing data.
   enum DecodingStatus {
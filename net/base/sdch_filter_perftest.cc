@@ -0,0 +1,142 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/filter.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mock_filter_context.h"
+#include "net/base/sdch_manager.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// The same VCDIFF dictionary and delta as in sdch_filter_unittest.cc.  The
+// delta consists of a 5 byte VCDIFF header followed by one window, which
+// copies from the first 77 bytes of the dictionary and decodes to kTestData.
+const char kTestVcdiffDictionary[] = "DictionaryFor"
+    "SdchCompression1SdchCompression2SdchCompression3SdchCompression\n";
+const char kTestData[] = "0000000000000000000000000000000000000000000000"
+    "0000000000000000000000000000TestData "
+    "SdchCompression1SdchCompression2SdchCompression3SdchCompression"
+    "00000000000000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000\n";
+const char kSdchCompressedTestData[] =
+    "\326\303\304\0\0\001M\0\201S\202\004\0\201E\006\001"
+    "00000000000000000000000000000000000000000000000000000000000000000000000000"
+    "TestData 00000000000000000000000000000000000000000000000000000000000000000"
+    "000000000000000000000000000000000000000000000000\n\001S\023\077\001r\r";
+const size_t kVcdiffHeaderLength = 5;
+
+const char kDomain[] = "sdch.perftest.com";
+const char kUrl[] = "http://sdch.perftest.com/page.html";
+
+const int kNumResponses = 2000;
+const int kWindowsPerResponse = 20;
+const int kOutputBufferSize = 32 * 1024;
+
+// Adds a dictionary of roughly |dictionary_size| bytes to |manager| and
+// returns its server hash.  Only the leading kTestVcdiffDictionary bytes are
+// referenced by the deltas; the rest is padding.
+std::string AddDictionary(SdchManager* manager, size_t dictionary_size) {
+  std::string dictionary(base::StringPrintf("Domain: %s\n\n", kDomain));
+  dictionary.append(kTestVcdiffDictionary);
+  if (dictionary.size() < dictionary_size)
+    dictionary.append(dictionary_size - dictionary.size(), 'p');
+  EXPECT_TRUE(manager->AddSdchDictionary(dictionary, GURL(kUrl)));
+
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(dictionary, &client_hash, &server_hash);
+  return server_hash;
+}
+
+// Builds one SDCH response body: the dictionary id, the VCDIFF header and
+// kWindowsPerResponse copies of the delta window.
+std::string BuildResponse(const std::string& server_hash) {
+  const std::string delta(kSdchCompressedTestData,
+                          sizeof(kSdchCompressedTestData) - 1);
+  std::string response(server_hash);
+  response.append("\0", 1);
+  response.append(delta, 0, kVcdiffHeaderLength);
+  for (int i = 0; i < kWindowsPerResponse; ++i)
+    response.append(delta, kVcdiffHeaderLength, std::string::npos);
+  return response;
+}
+
+// Runs |response| through a freshly built SDCH filter, as URLRequestJob would,
+// and returns the number of decoded bytes.
+size_t DecodeResponse(const std::string& response, char* output_buffer) {
+  MockFilterContext filter_context;
+  filter_context.SetURL(GURL(kUrl));
+  std::vector<Filter::FilterType> filter_types;
+  filter_types.push_back(Filter::FILTER_TYPE_SDCH);
+  scoped_ptr<Filter> filter(Filter::Factory(filter_types, filter_context));
+
+  size_t input_index = 0;
+  size_t output_size = 0;
+  Filter::FilterStatus status = Filter::FILTER_NEED_MORE_DATA;
+  while (status != Filter::FILTER_ERROR && status != Filter::FILTER_DONE) {
+    if (status == Filter::FILTER_NEED_MORE_DATA) {
+      if (input_index == response.size())
+        break;
+      size_t amount = std::min(response.size() - input_index,
+          static_cast<size_t>(filter->stream_buffer_size()));
+      memcpy(filter->stream_buffer()->data(), response.data() + input_index,
+             amount);
+      filter->FlushStreamBuffer(amount);
+      input_index += amount;
+    }
+    int output_length = kOutputBufferSize;
+    status = filter->ReadData(output_buffer, &output_length);
+    output_size += output_length;
+  }
+  EXPECT_NE(Filter::FILTER_ERROR, status);
+  return output_size;
+}
+
+void RunDecodeBenchmark(const char* name, size_t dictionary_size) {
+  SdchManager manager;
+  manager.EnableSdchSupport("");
+  const std::string response(
+      BuildResponse(AddDictionary(&manager, dictionary_size)));
+  scoped_array<char> output_buffer(new char[kOutputBufferSize]);
+
+  size_t decoded_bytes = 0;
+  PerfTimer timer;
+  for (int i = 0; i < kNumResponses; ++i)
+    decoded_bytes += DecodeResponse(response, output_buffer.get());
+  const base::TimeDelta elapsed = timer.Elapsed();
+
+  EXPECT_EQ(static_cast<size_t>(kNumResponses) * kWindowsPerResponse *
+                (sizeof(kTestData) - 1),
+            decoded_bytes);
+  LogPerfResult(base::StringPrintf("Sdch_decode_%s", name).c_str(),
+                elapsed.InMillisecondsF(), "ms");
+  LogPerfResult(base::StringPrintf("Sdch_decode_%s_throughput", name).c_str(),
+                decoded_bytes / (1024.0 * 1024.0) / elapsed.InSecondsF(),
+                "MB/s");
+}
+
+}  // namespace
+
+// Decoding cost per response should depend on the size of the delta, not on
+// the size of the dictionary it refers to.
+TEST(SdchFilterPerfTest, DecodeSmallDictionary) {
+  RunDecodeBenchmark("small_dictionary", 0);
+}
+
+TEST(SdchFilterPerfTest, DecodeLargeDictionary) {
+  RunDecodeBenchmark("large_dictionary", SdchManager::kMaxDictionarySize - 1);
+}
+
+}  // namespace net
@@ -820,6 +820,10 @@ class SdchFilterChainingTest {
                            const FilterContext& context, int size) {
     return Filter::FactoryForTests(types, context, size);
   }
+
+  static Filter* NextFilter(Filter* filter) {
+    return filter->next_filter_.get();
+  }
 };
 
 // Test that filters can be cascaded (chained) so that the output of one filter
@@ -909,6 +913,36 @@ TEST_F(SdchFilterTest, FilterChaining) {
   EXPECT_EQ(output, expanded_);
 }
 
+// Tentative filters that fall back to pass through are unlinked from the chain
+// once drained, so the gzip output lands directly in the caller's buffer.
+TEST_F(SdchFilterTest, PassThroughFiltersBypassed) {
+  std::string gzip_compressed = gzip_compress(expanded_);
+
+  std::vector<Filter::FilterType> filter_types;
+  filter_types.push_back(Filter::FILTER_TYPE_SDCH_POSSIBLE);
+  filter_types.push_back(Filter::FILTER_TYPE_GZIP_HELPING_SDCH);
+  filter_types.push_back(Filter::FILTER_TYPE_GZIP);
+
+  // A 404 response lets the tentative SDCH filter pass through.
+  MockFilterContext filter_context;
+  filter_context.SetURL(GURL("http://sdchtest.com"));
+  filter_context.SetResponseCode(404);
+
+  const size_t kBufferSizes[] = { 1, 20, 1000 };
+  for (size_t i = 0; i < arraysize(kBufferSizes); ++i) {
+    scoped_ptr<Filter> filter(SdchFilterChainingTest::Factory(
+        filter_types, filter_context, kBufferSizes[i]));
+    ASSERT_TRUE(filter.get());
+    EXPECT_TRUE(SdchFilterChainingTest::NextFilter(filter.get()));
+
+    std::string output;
+    EXPECT_TRUE(FilterTestData(gzip_compressed, kBufferSizes[i],
+                               kBufferSizes[i], filter.get(), &output));
+    EXPECT_EQ(expanded_, output);
+    EXPECT_FALSE(SdchFilterChainingTest::NextFilter(filter.get()));
+  }
+}
+
 TEST_F(SdchFilterTest, DefaultGzipIfSdch) {
   // Construct a valid SDCH dictionary from a VCDIFF dictionary.
   const std::string kSampleDomain = "sdchtest.com";
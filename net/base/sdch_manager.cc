@@ -25,6 +25,11 @@ const size_t SdchManager::kMaxDictionaryCount = 20;
 // static
 SdchManager* SdchManager::global_;
 
+//------------------------------------------------------------------------------
+SdchDictionaryStore::Entry::Entry() {}
+
+SdchDictionaryStore::Entry::~Entry() {}
+
 //------------------------------------------------------------------------------
 SdchManager::Dictionary::Dictionary(const std::string& dictionary_text,
                                     size_t offset,
@@ -202,7 +207,9 @@ bool SdchManager::Dictionary::DomainMatch(const GURL& gurl,
 }
 
 //------------------------------------------------------------------------------
-SdchManager::SdchManager() : sdch_enabled_(false) {
+SdchManager::SdchManager()
+    : discard_saved_dictionaries_(false),
+      sdch_enabled_(false) {
   DCHECK(!global_);
   global_ = this;
 }
@@ -361,8 +368,59 @@ bool SdchManager::CanFetchDictionary(const GURL& referring_url,
   return true;
 }
 
+void SdchManager::SetSdchDictionaryStore(SdchDictionaryStore* store) {
+  dictionary_store_.reset(store);
+  discard_saved_dictionaries_ = false;
+  if (store)
+    store->Load(NewCallback(this, &SdchManager::AddSavedDictionaries));
+}
+
+void SdchManager::AddSavedDictionaries(
+    const std::vector<SdchDictionaryStore::Entry>& saved) {
+  if (discard_saved_dictionaries_ || !dictionary_store_.get())
+    return;
+
+  for (size_t i = 0; i < saved.size(); ++i) {
+    if (!saved[i].expiration.is_null() &&
+        base::Time::Now() <= saved[i].expiration &&
+        AddSdchDictionaryInternal(saved[i].text, saved[i].url,
+                                  saved[i].expiration)) {
+      continue;
+    }
+    // Delete the file of a dictionary we won't use, unless it is one we
+    // already had.
+    std::string client_hash;
+    std::string server_hash;
+    GenerateHash(saved[i].text, &client_hash, &server_hash);
+    if (dictionaries_.find(server_hash) == dictionaries_.end())
+      dictionary_store_->Remove(server_hash);
+  }
+  UMA_HISTOGRAM_COUNTS_100("Sdch3.Dictionary_Count_Restored",
+                           dictionaries_.size());
+}
+
+void SdchManager::ClearData() {
+  while (!dictionaries_.empty()) {
+    DictionaryMap::iterator it = dictionaries_.begin();
+    it->second->Release();
+    dictionaries_.erase(it);
+  }
+  if (dictionary_store_.get()) {
+    dictionary_store_->Clear();
+    discard_saved_dictionaries_ = true;
+  }
+}
+
 bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
     const GURL& dictionary_url) {
+  return AddSdchDictionaryInternal(dictionary_text, dictionary_url,
+                                   base::Time());
+}
+
+bool SdchManager::AddSdchDictionaryInternal(
+    const std::string& dictionary_text,
+    const GURL& dictionary_url,
+    const base::Time& saved_expiration) {
   std::string client_hash;
   std::string server_hash;
   GenerateHash(dictionary_text, &client_hash, &server_hash);
@@ -432,6 +490,9 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
     line_start = line_end + 1;
   }
 
+  if (!saved_expiration.is_null())
+    expiration = saved_expiration;
+
   if (!Dictionary::CanSet(domain, path, ports, dictionary_url))
     return false;
 
@@ -443,6 +504,8 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
     SdchErrorRecovery(DICTIONARY_IS_TOO_LARGE);
     return false;
   }
+  if (kMaxDictionaryCount <= dictionaries_.size())
+    EvictExpiredDictionaries();
   if (kMaxDictionaryCount <= dictionaries_.size()) {
     SdchErrorRecovery(DICTIONARY_COUNT_EXCEEDED);
     return false;
@@ -456,9 +519,32 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
                      dictionary_url, domain, path, expiration, ports);
   dictionary->AddRef();
   dictionaries_[server_hash] = dictionary;
+
+  if (dictionary_store_.get() && saved_expiration.is_null()) {
+    SdchDictionaryStore::Entry entry;
+    entry.text = dictionary_text;
+    entry.url = dictionary_url;
+    entry.expiration = expiration;
+    dictionary_store_->Save(server_hash, entry);
+  }
   return true;
 }
 
+void SdchManager::EvictExpiredDictionaries() {
+  base::Time now(base::Time::Now());
+  DictionaryMap::iterator it = dictionaries_.begin();
+  while (it != dictionaries_.end()) {
+    if (now <= it->second->expiration()) {
+      ++it;
+      continue;
+    }
+    if (dictionary_store_.get())
+      dictionary_store_->Remove(it->first);
+    it->second->Release();
+    dictionaries_.erase(it++);
+  }
+}
+
 void SdchManager::GetVcdiffDictionary(const std::string& server_hash,
     const GURL& referring_url, Dictionary** dictionary) {
   *dictionary = NULL;
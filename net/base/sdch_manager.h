@@ -24,7 +24,9 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
+#include "base/callback.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
@@ -52,6 +54,48 @@ class SdchFetcher {
   DISALLOW_COPY_AND_ASSIGN(SdchFetcher);
 };
 
+//------------------------------------------------------------------------------
+// Create a public interface to persist SDCH dictionaries across restarts.
+// The SdchManager class allows registration of a store.  Every dictionary that
+// is successfully added is handed to the store, and the dictionaries the store
+// saved earlier are added back once it has loaded them.
+class SdchDictionaryStore {
+ public:
+  // A dictionary as it was added: the full dictionary text (including the
+  // metadata headers), the URL it was fetched from, and when it expires.
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    std::string text;
+    GURL url;
+    base::Time expiration;
+  };
+
+  typedef Callback1<const std::vector<Entry>&>::Type LoadCallback;
+
+  SdchDictionaryStore() {}
+  virtual ~SdchDictionaryStore() {}
+
+  // Reads every saved, unexpired dictionary, and runs |callback| with them on
+  // the thread that called Load().  The store takes ownership of |callback|,
+  // and may run it before Load() returns.
+  virtual void Load(LoadCallback* callback) = 0;
+
+  // Saves |dictionary|, which the SdchManager knows by |server_hash|.
+  virtual void Save(const std::string& server_hash,
+                    const Entry& dictionary) = 0;
+
+  // Deletes the dictionary saved as |server_hash|, if there is one.
+  virtual void Remove(const std::string& server_hash) = 0;
+
+  // Deletes every saved dictionary.
+  virtual void Clear() = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SdchDictionaryStore);
+};
+
 //------------------------------------------------------------------------------
 
 class SdchManager {
@@ -186,6 +230,7 @@ class SdchManager {
 
     const GURL& url() const { return url_; }
     const std::string& client_hash() const { return client_hash_; }
+    const base::Time& expiration() const { return expiration_; }
 
     // Security method to check if we can advertise this dictionary for use
     // if the |target_url| returns SDCH compressed data.
@@ -245,6 +290,16 @@ class SdchManager {
   // Register a fetcher that this class can use to obtain dictionaries.
   void set_sdch_fetcher(SdchFetcher* fetcher) { fetcher_.reset(fetcher); }
 
+  // Register a store that this class uses to keep dictionaries across
+  // restarts, and start loading the dictionaries it has saved.  They are
+  // added once the store has read them, so call this on the thread that uses
+  // this class.
+  void SetSdchDictionaryStore(SdchDictionaryStore* store);
+
+  // Forgets every dictionary, and deletes those the store has saved.  Used
+  // when the user clears browsing data.
+  void ClearData();
+
   // If called with an empty string, advertise and support sdch on all domains.
   // If called with a specific string, advertise and support only the specified
   // domain.  Function assumes the existence of a global SdchManager instance.
@@ -345,11 +400,36 @@ class SdchManager {
   // A simple implementation of a RFC 3548 "URL safe" base64 encoder.
   static void UrlSafeBase64Encode(const std::string& input,
                                   std::string* output);
+
+  // Does the work of AddSdchDictionary().  A non-null |saved_expiration| means
+  // the dictionary is being restored from |dictionary_store_|: it replaces the
+  // expiration derived from the max-age header, and the dictionary is not
+  // saved to the store again.
+  bool AddSdchDictionaryInternal(const std::string& dictionary_text,
+                                 const GURL& dictionary_url,
+                                 const base::Time& saved_expiration);
+
+  // Adds the dictionaries loaded by |dictionary_store_|, and deletes from it
+  // those that can't be used.
+  void AddSavedDictionaries(
+      const std::vector<SdchDictionaryStore::Entry>& saved);
+
+  // Forgets the dictionaries that have expired, and deletes them from the
+  // store.
+  void EvictExpiredDictionaries();
+
   DictionaryMap dictionaries_;
 
   // An instance that can fetch a dictionary given a URL.
   scoped_ptr<SdchFetcher> fetcher_;
 
+  // An instance that persists dictionaries, if one has been registered.
+  scoped_ptr<SdchDictionaryStore> dictionary_store_;
+
+  // Set by ClearData(), so that dictionaries the store was still loading are
+  // not added back.
+  bool discard_saved_dictionaries_;
+
   // Support SDCH compression, by advertising in headers.
   bool sdch_enabled_;
 
@@ -444,8 +444,11 @@ int BackendImpl::SyncInit() {
   if (!restarted_) {
     buffer_bytes_ = 0;
     trace_object_ = TraceObject::GetTraceObject();
-    // Create a recurrent timer of 30 secs.
+    // Create a recurrent timer of 30 secs, which may fire a few seconds late
+    // so that it fires together with other timers.
     int timer_delay = unit_test_ ? 1000 : 30000;
+    if (!unit_test_)
+      timer_.set_slack(TimeDelta::FromSeconds(5));
     timer_.Start(TimeDelta::FromMilliseconds(timer_delay), this,
                  &BackendImpl::OnStatsTimer);
   }
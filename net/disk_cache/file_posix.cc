@@ -6,6 +6,7 @@
 
 #include <fcntl.h>
 
+#include "base/debug/trace_recorder.h"
 #include "base/logging.h"
 #include "base/threading/worker_pool.h"
 #include "net/base/net_errors.h"
@@ -115,7 +116,8 @@ void FileInFlightIO::PostRead(disk_cache::File *file, void* buf, size_t buf_len,
   file->AddRef();  // Balanced on OnOperationComplete()
 
   base::WorkerPool::PostTask(FROM_HERE,
-      NewRunnableMethod(operation.get(), &FileBackgroundIO::Read), true);
+      NewRunnableMethod(operation.get(), &FileBackgroundIO::Read),
+      base::WorkerPool::AFFINITY_BLOCKING);
   OnOperationPosted(operation);
 }
 
@@ -127,7 +129,8 @@ void FileInFlightIO::PostWrite(disk_cache::File* file, const void* buf,
   file->AddRef();  // Balanced on OnOperationComplete()
 
   base::WorkerPool::PostTask(FROM_HERE,
-      NewRunnableMethod(operation.get(), &FileBackgroundIO::Write), true);
+      NewRunnableMethod(operation.get(), &FileBackgroundIO::Write),
+      base::WorkerPool::AFFINITY_BLOCKING);
   OnOperationPosted(operation);
 }
 
@@ -202,6 +205,7 @@ bool File::IsValid() const {
 
 bool File::Read(void* buffer, size_t buffer_len, size_t offset) {
   DCHECK(init_);
+  TRACE_RECORD_SCOPED("disk_cache", "File::Read");
   if (buffer_len > ULONG_MAX || offset > LONG_MAX)
     return false;
 
@@ -211,6 +215,7 @@ bool File::Read(void* buffer, size_t buffer_len, size_t offset) {
 
 bool File::Write(const void* buffer, size_t buffer_len, size_t offset) {
   DCHECK(init_);
+  TRACE_RECORD_SCOPED("disk_cache", "File::Write");
   if (buffer_len > ULONG_MAX || offset > ULONG_MAX)
     return false;
 
@@ -1954,6 +1954,7 @@ int HttpCache::Transaction::WriteResponseInfoToEntry(bool truncated) {
   }
 
   scoped_refptr<PickledIOBuffer> data(new PickledIOBuffer());
+  data->pickle()->Reserve(response_.EstimatePersistedSize());
   response_.Persist(data->pickle(), skip_transient_headers, truncated);
   data->Done();
 
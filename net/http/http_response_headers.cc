@@ -190,6 +190,8 @@ void HttpResponseHeaders::Persist(Pickle* pickle, PersistOptions options) {
   // so this just copies the first header line.
   blob.assign(raw_headers_.c_str(), strlen(raw_headers_.c_str()) + 1);
 
+  // Reused for every header, to avoid an allocation each.
+  std::string header_name;
   for (size_t i = 0; i < parsed_.size(); ++i) {
     DCHECK(!parsed_[i].is_continuation());
 
@@ -198,7 +200,7 @@ void HttpResponseHeaders::Persist(Pickle* pickle, PersistOptions options) {
     while (++k < parsed_.size() && parsed_[k].is_continuation()) {}
     --k;
 
-    std::string header_name(parsed_[i].name_begin, parsed_[i].name_end);
+    header_name.assign(parsed_[i].name_begin, parsed_[i].name_end);
     StringToLowerASCII(&header_name);
 
     if (filter_headers.find(header_name) == filter_headers.end()) {
@@ -214,6 +216,11 @@ void HttpResponseHeaders::Persist(Pickle* pickle, PersistOptions options) {
   pickle->WriteString(blob);
 }
 
+size_t HttpResponseHeaders::EstimatePersistedSize() const {
+  // The filtered headers are a subset of the raw ones, plus a terminator.
+  return Pickle::GetDataSize(raw_headers_.size() + 1);
+}
+
 void HttpResponseHeaders::Update(const HttpResponseHeaders& new_headers) {
   DCHECK(new_headers.response_code() == 304 ||
          new_headers.response_code() == 206);
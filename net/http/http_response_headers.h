@@ -60,6 +60,10 @@ class NET_EXPORT HttpResponseHeaders
   // The options argument can be a combination of PersistOptions.
   void Persist(Pickle* pickle, PersistOptions options);
 
+  // Returns an upper bound on the number of bytes Persist() appends to a
+  // pickle, whatever the options, for reserving room ahead of time.
+  size_t EstimatePersistedSize() const;
+
   // Performs header merging as described in 13.5.3 of RFC 2616.
   void Update(const HttpResponseHeaders& new_headers);
 
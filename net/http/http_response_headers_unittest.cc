@@ -449,6 +449,8 @@ TEST(HttpResponseHeadersTest, Persist) {
 
     Pickle pickle;
     parsed1->Persist(&pickle, tests[i].options);
+    EXPECT_LE(pickle.size(),
+              sizeof(Pickle::Header) + parsed1->EstimatePersistedSize());
 
     void* iter = NULL;
     scoped_refptr<net::HttpResponseHeaders> parsed2(
@@ -59,6 +59,10 @@ enum {
   // For now, we don't support storing those.
 };
 
+// The size assumed for each DER-encoded certificate by
+// HttpResponseInfo::EstimatePersistedSize(). Most are 1-2KB.
+const size_t kCertificateSizeEstimate = 2048;
+
 HttpResponseInfo::HttpResponseInfo()
     : was_cached(false),
       was_fetched_via_spdy(false),
@@ -238,4 +242,23 @@ void HttpResponseInfo::Persist(Pickle* pickle,
   pickle->WriteUInt16(socket_address.port());
 }
 
+size_t HttpResponseInfo::EstimatePersistedSize() const {
+  // The flags and the request and response times.
+  size_t size = Pickle::GetBytesSize(sizeof(int)) +
+                2 * Pickle::GetBytesSize(sizeof(int64));
+  size += headers->EstimatePersistedSize();
+  if (ssl_info.is_valid()) {
+    size_t certificates =
+        1 + ssl_info.cert->GetIntermediateCertificates().size();
+    size += certificates * Pickle::GetDataSize(kCertificateSizeEstimate) +
+            Pickle::GetBytesSize(sizeof(size_t)) +
+            2 * Pickle::GetBytesSize(sizeof(int));
+  }
+  if (vary_data.is_valid())
+    size += Pickle::GetBytesSize(sizeof(MD5Digest));
+  size += Pickle::GetDataSize(socket_address.host().size()) +
+          Pickle::GetBytesSize(sizeof(uint16));
+  return size;
+}
+
 }  // namespace net
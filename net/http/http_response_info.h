@@ -38,6 +38,12 @@ class NET_EXPORT HttpResponseInfo {
                bool skip_transient_headers,
                bool response_truncated) const;
 
+  // Returns how many bytes Persist() is expected to append to a pickle, so
+  // that the pickle can be allocated once. This is an upper bound unless the
+  // response has unusually large certificates, whose size is only known once
+  // they are encoded.
+  size_t EstimatePersistedSize() const;
+
   // The following is only defined if the request_time member is set.
   // If this response was resurrected from cache, then this bool is set, and
   // request_time may corresponds to a time "far" in the past.  Note that
@@ -12,6 +12,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/string_tokenizer.h"
 #include "googleurl/src/gurl.h"
+#include "googleurl/src/gurl_view.h"
 #include "net/http/http_byte_range.h"
 
 // This is a macro to support extending this string literal at compile time.
@@ -26,12 +27,12 @@ class HttpUtil {
  public:
   // Returns the absolute path of the URL, to be used for the http request.
   // The absolute path starts with a '/' and may contain a query.
-  static std::string PathForRequest(const GURL& url);
+  static std::string PathForRequest(const GURLView& url);
 
   // Returns the absolute URL, to be used for the http request. This url is
   // made up of the protocol, host, [port], path, [query]. Everything else
   // is stripped (username, password, reference).
-  static std::string SpecForRequest(const GURL& url);
+  static std::string SpecForRequest(const GURLView& url);
 
   // Locates the next occurance of delimiter in line, skipping over quoted
   // strings (e.g., commas will not be treated as delimiters if they appear
@@ -8,22 +8,35 @@
 #include "net/http/http_util.h"
 
 #include "base/logging.h"
-#include "net/base/net_util.h"
+#include "base/string_piece.h"
 
 namespace net {
 
 // static
-std::string HttpUtil::PathForRequest(const GURL& url) {
+std::string HttpUtil::PathForRequest(const GURLView& url) {
   DCHECK(url.is_valid() && (url.SchemeIs("http") || url.SchemeIs("https")));
-  if (url.has_query())
-    return url.path() + "?" + url.query();
-  return url.path();
+  return url.PathForRequest().as_string();
 }
 
 // static
-std::string HttpUtil::SpecForRequest(const GURL& url) {
+std::string HttpUtil::SpecForRequest(const GURLView& url) {
   DCHECK(url.is_valid() && (url.SchemeIs("http") || url.SchemeIs("https")));
-  return SimplifyUrlForRequest(url).spec();
+  // This is what SimplifyUrlForRequest() produces, but since the spec is
+  // already canonical the stripped parts can be cut out of it directly instead
+  // of canonicalizing the URL again.
+  const url_parse::Parsed& parsed = url.parsed_for_possibly_invalid_spec();
+  base::StringPiece spec = url.spec();
+  // The end of the "scheme://" prefix, which comes right before the username
+  // if there is one.
+  size_t authority_begin = parsed.scheme.end() + 3;
+  DCHECK(spec.substr(parsed.scheme.end(), 3) == "://");
+  size_t end = parsed.ref.is_valid() ? parsed.ref.begin - 1 : spec.length();
+  std::string result;
+  result.reserve(authority_begin + end - parsed.host.begin);
+  spec.substr(0, authority_begin).AppendToString(&result);
+  spec.substr(parsed.host.begin, end - parsed.host.begin)
+      .AppendToString(&result);
+  return result;
 }
 
 }  // namespace net
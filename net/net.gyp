@@ -103,6 +103,8 @@
         'base/host_resolver_impl.h',
         'base/host_resolver_proc.cc',
         'base/host_resolver_proc.h',
+        'base/interned_url.cc',
+        'base/interned_url.h',
         'base/io_buffer.cc',
         'base/io_buffer.h',
         'base/ip_endpoint.cc',
@@ -172,6 +174,8 @@
         'base/registry_controlled_domain.cc',
         'base/registry_controlled_domain.h',
         'base/scoped_cert_chain_context.h',
+        'base/sdch_dictionary_disk_store.cc',
+        'base/sdch_dictionary_disk_store.h',
         'base/sdch_filter.cc',
         'base/sdch_filter.h',
         'base/sdch_manager.cc',
@@ -903,6 +907,7 @@
         'base/host_cache_unittest.cc',
         'base/host_mapping_rules_unittest.cc',
         'base/host_resolver_impl_unittest.cc',
+        'base/interned_url_unittest.cc',
         'base/ip_endpoint_unittest.cc',
         'base/keygen_handler_unittest.cc',
         'base/listen_socket_unittest.cc',
@@ -918,6 +923,7 @@
         'base/pem_tokenizer_unittest.cc',
         'base/registry_controlled_domain_unittest.cc',
         'base/run_all_unittests.cc',
+        'base/sdch_dictionary_disk_store_unittest.cc',
         'base/sdch_filter_unittest.cc',
         'base/ssl_cipher_suite_names_unittest.cc',
         'base/ssl_client_auth_cache_unittest.cc',
@@ -1106,10 +1112,14 @@
         '../base/base.gyp:base_i18n',
         '../base/base.gyp:test_support_perf',
         '../testing/gtest.gyp:gtest',
+        '../third_party/zlib/zlib.gyp:zlib',
       ],
       'msvs_guid': 'AAC78796-B9A2-4CD9-BF89-09B03E92BF73',
       'sources': [
         'base/cookie_monster_perftest.cc',
+        'base/filter_perftest.cc',
+        'base/interned_url_perftest.cc',
+        'base/sdch_filter_perftest.cc',
         'disk_cache/disk_cache_perftest.cc',
         'proxy/proxy_resolver_perftest.cc',
       ],
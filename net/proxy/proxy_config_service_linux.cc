@@ -884,7 +884,7 @@ class GConfSettingGetterImplKDE
   typedef std::map<std::string, std::vector<std::string> > strings_map_type;
 
   int inotify_fd_;
-  base::MessagePumpLibevent::FileDescriptorWatcher inotify_watcher_;
+  MessageLoopForIO::FileDescriptorWatcher inotify_watcher_;
   ProxyConfigServiceLinux::Delegate* notify_delegate_;
   base::OneShotTimer<GConfSettingGetterImplKDE> debounce_timer_;
   FilePath kde_config_dir_;
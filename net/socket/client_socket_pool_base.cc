@@ -46,6 +46,11 @@ bool g_cleanup_timer_enabled = true;
 // some conditions.  See http://crbug.com/4606.
 int kCleanupInterval = 2;  // DO NOT INCREASE THIS TIMEOUT.
 
+// How late the cleanup timer may fire, so that the timers of all the pools,
+// and other timers with some slack, fire together.  This is small next to the
+// interval, so that idle sockets are still closed promptly.
+const int kCleanupSlackMs = 250;
+
 // Indicate whether or not we should establish a new transport layer connection
 // after a certain timeout has passed without receiving an ACK.
 bool g_connect_backup_jobs_enabled = true;
@@ -786,6 +791,7 @@ bool ClientSocketPoolBaseHelper::set_cleanup_timer_enabled(bool enabled) {
 }
 
 void ClientSocketPoolBaseHelper::StartIdleSocketTimer() {
+  timer_.set_slack(TimeDelta::FromMilliseconds(kCleanupSlackMs));
   timer_.Start(TimeDelta::FromSeconds(kCleanupInterval), this,
                &ClientSocketPoolBaseHelper::OnCleanupTimerFired);
 }
@@ -14,6 +14,7 @@
 #include <netinet/in.h>
 #endif
 
+#include "base/debug/trace_recorder.h"
 #include "base/eintr_wrapper.h"
 #include "base/logging.h"
 #include "base/message_loop.h"
@@ -181,6 +182,7 @@ int TCPClientSocketLibevent::Connect(CompletionCallback* callback
   net_log_.BeginEvent(
       NetLog::TYPE_TCP_CONNECT,
       make_scoped_refptr(new AddressListNetLogParam(addresses_)));
+  TRACE_RECORD_ASYNC_BEGIN("net", "TCPClientSocket::Connect", this);
 
   // We will try to connect to each address in addresses_. Start with the
   // first one in the list.
@@ -548,6 +550,7 @@ int TCPClientSocketLibevent::SetupSocket() {
 }
 
 void TCPClientSocketLibevent::LogConnectCompletion(int net_error) {
+  TRACE_RECORD_ASYNC_END("net", "TCPClientSocket::Connect", this);
   if (net_error == OK)
     UpdateConnectionTypeHistograms(CONNECTION_ANY);
 
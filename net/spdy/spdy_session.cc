@@ -367,7 +367,7 @@ int SpdySession::GetPushStream(
     return ERR_SPDY_PROTOCOL_ERROR;
   }
 
-  *stream = GetActivePushStream(url.spec());
+  *stream = GetActivePushStream(url);
   if (stream->get()) {
     DCHECK(streams_pushed_and_claimed_count_ < streams_pushed_count_);
     streams_pushed_and_claimed_count_++;
@@ -1003,10 +1003,17 @@ void SpdySession::RemoveFromPool() {
 }
 
 scoped_refptr<SpdyStream> SpdySession::GetActivePushStream(
-    const std::string& path) {
+    const GURL& url) {
   base::StatsCounter used_push_streams("spdy.claimed_push_streams");
 
-  PushedStreamMap::iterator it = unclaimed_pushed_streams_.find(path);
+  // Every pushed URL is in the pool while we hold it, so a URL that isn't
+  // pooled wasn't pushed.
+  scoped_refptr<InternedURL> interned_url =
+      InternedURLPool::GetInstance()->Find(url);
+  if (!interned_url)
+    return NULL;
+
+  PushedStreamMap::iterator it = unclaimed_pushed_streams_.find(interned_url);
   if (it != unclaimed_pushed_streams_.end()) {
     net_log_.AddEvent(NetLog::TYPE_SPDY_STREAM_ADOPTED_PUSH_STREAM, NULL);
     scoped_refptr<SpdyStream> stream = it->second;
@@ -1147,7 +1154,9 @@ void SpdySession::OnSyn(const spdy::SpdySynStreamControlFrame& frame,
   }
 
   // There should not be an existing pushed stream with the same path.
-  PushedStreamMap::iterator it = unclaimed_pushed_streams_.find(url);
+  scoped_refptr<InternedURL> interned_url =
+      InternedURLPool::GetInstance()->Intern(gurl);
+  PushedStreamMap::iterator it = unclaimed_pushed_streams_.find(interned_url);
   if (it != unclaimed_pushed_streams_.end()) {
     LOG(WARNING) << "Received duplicate pushed stream with url: " << url;
     ResetStream(stream_id, spdy::PROTOCOL_ERROR);
@@ -1159,7 +1168,7 @@ void SpdySession::OnSyn(const spdy::SpdySynStreamControlFrame& frame,
 
   stream->set_path(gurl.PathForRequest());
 
-  unclaimed_pushed_streams_[url] = stream;
+  unclaimed_pushed_streams_[interned_url] = stream;
 
   ActivateStream(stream);
   stream->set_response_received();
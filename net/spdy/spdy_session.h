@@ -16,6 +16,7 @@
 #include "base/memory/linked_ptr.h"
 #include "base/memory/ref_counted.h"
 #include "base/task.h"
+#include "net/base/interned_url.h"
 #include "net/base/io_buffer.h"
 #include "net/base/load_states.h"
 #include "net/base/net_errors.h"
@@ -238,8 +239,10 @@ class SpdySession : public base::RefCounted<SpdySession>,
   typedef std::queue<PendingCreateStream, std::list< PendingCreateStream> >
       PendingCreateStreamQueue;
   typedef std::map<int, scoped_refptr<SpdyStream> > ActiveStreamMap;
-  // Only HTTP push a stream.
-  typedef std::map<std::string, scoped_refptr<SpdyStream> > PushedStreamMap;
+  // Only HTTP push a stream.  Keyed by the pushed URL, interned so that equal
+  // URLs are the same key and the map holds no copy of its own.
+  typedef std::map<scoped_refptr<InternedURL>, scoped_refptr<SpdyStream> >
+      PushedStreamMap;
   typedef std::priority_queue<SpdyIOBuffer> OutputQueue;
 
   struct CallbackResultPair {
@@ -349,7 +352,7 @@ class SpdySession : public base::RefCounted<SpdySession>,
   // Check if we have a pending pushed-stream for this url
   // Returns the stream if found (and returns it from the pending
   // list), returns NULL otherwise.
-  scoped_refptr<SpdyStream> GetActivePushStream(const std::string& url);
+  scoped_refptr<SpdyStream> GetActivePushStream(const GURL& url);
 
   // Calls OnResponseReceived().
   // Returns true if successful.
@@ -396,25 +396,24 @@ void URLRequestHttpJob::AddExtraHeaders() {
   // will be in the first transmitted packet.  This can sometimes make it easier
   // to filter and analyze the streams to assure that a proxy has not damaged
   // these headers.  Some proxies deliberately corrupt Accept-Encoding headers.
-  if (!advertise_sdch) {
-    // Tell the server what compression formats we support (other than SDCH).
+  // Decoders registered with Filter::RegisterDecoderFactory() are offered
+  // after the built-in ones.
+  std::string accept_encoding("gzip,deflate");
+  if (advertise_sdch)
+    accept_encoding.append(",sdch");
+  Filter::AppendRegisteredEncodings(&accept_encoding);
+  request_info_.extra_headers.SetHeader(
+      HttpRequestHeaders::kAcceptEncoding, accept_encoding);
+  if (advertise_sdch && !avail_dictionaries.empty()) {
     request_info_.extra_headers.SetHeader(
-        HttpRequestHeaders::kAcceptEncoding, "gzip,deflate");
-  } else {
-    // Include SDCH in acceptable list.
-    request_info_.extra_headers.SetHeader(
-        HttpRequestHeaders::kAcceptEncoding, "gzip,deflate,sdch");
-    if (!avail_dictionaries.empty()) {
-      request_info_.extra_headers.SetHeader(
-          kAvailDictionaryHeader,
-          avail_dictionaries);
-      sdch_dictionary_advertised_ = true;
-      // Since we're tagging this transaction as advertising a dictionary, we'll
-      // definately employ an SDCH filter (or tentative sdch filter) when we get
-      // a response.  When done, we'll record histograms via SDCH_DECODE or
-      // SDCH_PASSTHROUGH.  Hence we need to record packet arrival times.
-      packet_timing_enabled_ = true;
-    }
+        kAvailDictionaryHeader,
+        avail_dictionaries);
+    sdch_dictionary_advertised_ = true;
+    // Since we're tagging this transaction as advertising a dictionary, we'll
+    // definately employ an SDCH filter (or tentative sdch filter) when we get
+    // a response.  When done, we'll record histograms via SDCH_DECODE or
+    // SDCH_PASSTHROUGH.  Hence we need to record packet arrival times.
+    packet_timing_enabled_ = true;
   }
 
   URLRequestContext* context = request_->context();